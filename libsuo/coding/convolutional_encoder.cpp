@@ -1,4 +1,12 @@
 
+#include <algorithm> // min
+#include <array>
+#include <bit> // countl_zero, endian
+#include <cstring> // memcpy
+#include <map>
+#include <mutex>
+#include <tuple>
+
 #include "coding/convolutional_encoder.hpp"
 #include "framing/utils.hpp"
 
@@ -8,42 +16,115 @@ using namespace std;
 
 void ConvolutionalConfig::validate() const {
 
+	if (k < 2 || k > 10)
+		throw SuoError("Invalid convolution code constraint length");
+
 	if (rate < 2 || rate > 4)
 		throw SuoError("Invalid convolution coding rate");
 
 	if (polys.size() != rate)
 		throw SuoError("Given coding rate and generator polynomy count doesn't match.");
 
+	for (int poly : polys) {
+		if (poly == 0 || abs(poly) >= (1 << k))
+			throw SuoError("Generator polynomy doesn't match the constraint length");
+	}
+
 	if (puncturing.empty() == false) {
 		if (puncturing.size() != rate)
 			throw SuoError("Invalid puncturing vector count");
 
 		size_t s = puncturing[0].size();
+		if (s == 0)
+			throw SuoError("Empty puncturing vector");
 		for (auto& c : puncturing) {
-			if (puncturing.size() == s)
+			if (c.size() != s)
 				throw SuoError("Inconsistent puncturing vector size");
 		}
 	}
 
 }
 
+
+/* Cache for the lookup tables of each configuration. Keyed by the contents so that equal configurations share the tables. */
+typedef std::tuple<unsigned int, unsigned int, std::vector<int>, std::vector<std::vector<unsigned int>>> TablesKey;
+static std::map<TablesKey, std::shared_ptr<const ConvolutionalTables>> tables_cache;
+static std::mutex tables_cache_mutex;
+
+
+std::shared_ptr<const ConvolutionalTables> ConvolutionalEncoder::getTables(const ConvolutionalConfig& conf)
+{
+	std::lock_guard<std::mutex> lock(tables_cache_mutex);
+
+	const TablesKey key(conf.k, conf.rate, conf.polys, conf.puncturing);
+	auto iter = tables_cache.find(key);
+	if (iter != tables_cache.end())
+		return iter->second;
+
+	auto tables = std::make_shared<ConvolutionalTables>();
+	const unsigned int num_states = 1 << (conf.k - 1);
+	const unsigned int word_len = 8 * conf.rate;
+
+	/* Output words for every state and input byte */
+	tables->outputs.resize(num_states * 256);
+	for (uint32_t state = 0; state < num_states; state++) {
+		for (uint32_t byte = 0; byte < 256; byte++) {
+			uint32_t reg = state, word = 0;
+			for (int i = 7; i >= 0; i--) {
+				reg = (reg << 1) | ((byte >> i) & 1);
+				for (unsigned int j = 0; j < conf.rate; j++) {
+					// Invert output if polynom is negative
+					Bit g_out = bit_parity(reg & abs(conf.polys[j])) ^ (conf.polys[j] < 0);
+					word = (word << 1) | g_out;
+				}
+			}
+			tables->outputs[(state << 8) | byte] = word;
+		}
+	}
+
+	/* Masks of the kept output bits for each puncturing phase */
+	if (conf.puncturing.empty() == false) {
+		const unsigned int period = conf.puncturing[0].size();
+		tables->puncturing_period = period;
+		tables->puncturing_masks.resize(period);
+		for (unsigned int phase = 0; phase < period; phase++) {
+			uint32_t mask = 0;
+			for (unsigned int i = 0; i < 8; i++)
+				for (unsigned int j = 0; j < conf.rate; j++)
+					if (conf.puncturing[j][(phase + i) % period] != 0)
+						mask |= 1U << (word_len - 1 - (i * conf.rate + j));
+			tables->puncturing_masks[phase] = mask;
+		}
+	}
+	else {
+		tables->puncturing_period = 1;
+	}
+
+	tables_cache[key] = tables;
+	return tables;
+}
+
+
 ConvolutionalEncoder::ConvolutionalEncoder(const ConvolutionalConfig& conf) :
 	conf(conf),
 	puncturing_index(0),
-	shift_register(0)
-	//num_states(1 << (conf.k - 1)),
+	shift_register(0),
+	pending_idx(0)
 {
 	conf.validate();
 
+	tables = getTables(conf);
+	state_mask = (1 << (conf.k - 1)) - 1;
 	input.reserve(512);
-	encoderOutput.resize(conf.rate);
 }
 
 
 void ConvolutionalEncoder::reset(uint32_t start_state)
 {
-	shift_register = start_state;
+	shift_register = start_state & state_mask;
 	puncturing_index = 0;
+	pending.clear();
+	pending_idx = 0;
 }
 
 double ConvolutionalEncoder::real_rate() const
@@ -58,71 +139,112 @@ double ConvolutionalEncoder::real_rate() const
 				output_bits += (i != 0);
 		}
 
-		return (double)conf.rate / (double)output_bits;
+		return (double)conf.puncturing[0].size() / (double)output_bits;
 	}
 }
 
 
-void ConvolutionalEncoder::sourceSymbols(SymbolVector& symbols, Timestamp now)
+/* Unpacked symbols (MSB first) of each byte in memory order */
+static constexpr std::array<uint64_t, 256> generate_unpack_table()
 {
-	if (output_gen.running())
-		output_gen.sourceSymbols(symbols);
-	else {
-		sourceUncodedSymbols.emit(input, now);
-		if (input.empty() == false) {
-			//if (conf.puncturing.empty())
-			//	output_gen = generateSymbols();
-			//else
-			//	output_gen = generatePuncturedSymbols();
+	std::array<uint64_t, 256> table = {};
+	for (unsigned int byte = 0; byte < 256; byte++) {
+		for (unsigned int i = 0; i < 8; i++) {
+			const uint64_t bit = (byte >> (7 - i)) & 1;
+			const unsigned int pos = (std::endian::native == std::endian::little) ? i : (7 - i);
+			table[byte] |= bit << (8 * pos);
 		}
 	}
-	
+	return table;
 }
 
+static constexpr std::array<uint64_t, 256> unpack_table = generate_unpack_table();
 
-SymbolGenerator ConvolutionalEncoder::generateSymbols(SymbolGenerator& symbol_input)
-{
-	for (Symbol s: symbol_input)
-	{
-		shift_register = (shift_register << 1) | (s & 1);
 
-		for (unsigned int j = 0; j < conf.rate; j++) {
-
-			// Calculate generator output
-			Bit g_out = bit_parity(shift_register & abs(conf.polys[j]));
+/* Write the n first bits of the word (MSB aligned) as symbols */
+static inline void unpack_bits(uint32_t word, unsigned int n, Symbol* out)
+{
+	for (; n >= 8; n -= 8) {
+		memcpy(out, &unpack_table[word >> 24], 8);
+		out += 8;
+		word <<= 8;
+	}
+	for (; n > 0; n--) {
+		*out++ = word >> 31;
+		word <<= 1;
+	}
+}
 
-			// Invert output if polynom is negative
-			g_out = ((conf.polys[j] < 0) ^ g_out) != 0;
 
-			co_yield g_out;
+void ConvolutionalEncoder::encode_bits(uint8_t bits, unsigned int n, SymbolVector& output)
+{
+	const unsigned int word_len = 8 * conf.rate;
+	uint32_t word = tables->outputs[(shift_register << 8) | bits] << (32 - word_len);
+	unsigned int nout = n * conf.rate;
+
+	if (conf.puncturing.empty() == false) {
+		/* Compact the kept bits to the top of the word */
+		uint32_t mask = tables->puncturing_masks[puncturing_index] << (32 - word_len);
+		if (nout < 32)
+			mask &= ~(0xFFFFFFFF >> nout);
+		puncturing_index = (puncturing_index + n) % tables->puncturing_period;
+
+		uint32_t kept = 0;
+		nout = 0;
+		while (mask != 0) {
+			const unsigned int bit = 31 - std::countl_zero(mask);
+			kept |= ((word >> bit) & 1) << (31 - nout++);
+			mask ^= 1U << bit;
 		}
+		word = kept;
 	}
 
+	const size_t out_idx = output.size();
+	output.resize(out_idx + nout);
+	unpack_bits(word, nout, &output[out_idx]);
+
+	shift_register = ((shift_register << n) | (bits >> (8 - n))) & state_mask;
 }
 
-SymbolGenerator ConvolutionalEncoder::generatePuncturedSymbols(SymbolGenerator& symbol_input)
+
+void ConvolutionalEncoder::encode(const uint8_t* bytes, size_t len, SymbolVector& output)
 {
-	for (Symbol s: symbol_input)
-	{
-		shift_register = (shift_register << 1) | (s & 1);
+	output.reserve(output.size() + 8 * conf.rate * len);
+	for (size_t i = 0; i < len; i++)
+		encode_bits(bytes[i], 8, output);
+}
 
-		const std::vector<unsigned int>& c = conf.puncturing[puncturing_index];
-		if (++puncturing_index >= conf.puncturing.size())
-			puncturing_index = 0;
 
-		for (unsigned int j = 0; j < conf.rate; j++) {
-			if (c[j] == 0) continue;
+void ConvolutionalEncoder::encode(const SymbolVector& input, SymbolVector& output)
+{
+	output.reserve(output.size() + conf.rate * input.size());
+	for (size_t i = 0; i < input.size(); i += 8) {
+		const unsigned int n = std::min<size_t>(8, input.size() - i);
+		uint8_t bits = 0;
+		for (unsigned int j = 0; j < n; j++)
+			bits |= (input[i + j] & 1) << (7 - j);
+		encode_bits(bits, n, output);
+	}
+}
 
-			// Calculate generator output
-			Bit g_out = bit_parity(shift_register & abs(conf.polys[j]));
 
-			// Invert output if polynom is negative
-			g_out = ((conf.polys[j] < 0) ^ g_out) != 0;
+void ConvolutionalEncoder::sourceSymbols(SymbolVector& symbols, Timestamp now)
+{
+	if (pending_idx >= pending.size()) {
+		pending.clear();
+		pending_idx = 0;
 
-			co_yield g_out;
-		}
+		input.clear();
+		sourceUncodedSymbols.emit(input, now);
+		if (input.empty())
+			return;
+		encode(input, pending);
 	}
 
+	/* Copy as many encoded symbols as fit */
+	const size_t n = std::min(symbols.capacity() - symbols.size(), pending.size() - pending_idx);
+	symbols.insert(symbols.end(), pending.begin() + pending_idx, pending.begin() + pending_idx + n);
+	pending_idx += n;
 }
 
 
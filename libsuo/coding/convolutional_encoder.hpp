@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "suo.hpp"
 #include "generators.hpp"
 
@@ -22,13 +24,36 @@ struct ConvolutionalConfig {
 	/* Generator polynomies */
 	std::vector<int> polys;
 
-	/* Puncturing pattern */
+	/* Puncturing pattern: One vector per generator output, 0 removes the bit */
 	std::vector<std::vector<unsigned int>> puncturing;
 };
 
 
+/*
+ * Lookup tables for encoding 8 input bits at a time.
+ * Generated once per configuration.
+ */
+struct ConvolutionalTables {
+	/*
+	 * Output word indexed by the previous k - 1 input bits and the next 8 input bits.
+	 * rate * 8 output bits in transmission order, first one in the MSB.
+	 * The next state is the lowest k - 1 bits of the index.
+	 */
+	std::vector<uint32_t> outputs;
+
+	/* Puncturing masks of the output words for each puncturing phase */
+	std::vector<uint32_t> puncturing_masks;
+
+	/* Puncturing period in input bits */
+	unsigned int puncturing_period;
+};
+
+
 /*
  * Convolutional encoder
+ *
+ * Input bits are encoded 8 at a time using the lookup tables and the
+ * punctured output is written to the output vectors in bulk.
  */
 class ConvolutionalEncoder
 {
@@ -46,32 +71,38 @@ public:
 	 */
 	double real_rate() const;
 
+	/*
+	 * Encode uncoded bits (one bit per symbol) and append the coded bits to the output.
+	 */
+	void encode(const SymbolVector& input, SymbolVector& output);
+
+	/*
+	 * Encode packed bytes (MSB first) and append the coded bits to the output.
+	 */
+	void encode(const uint8_t* bytes, size_t len, SymbolVector& output);
+
 	void sourceSymbols(SymbolVector& symbols, Timestamp now);
 
 	Port<SymbolVector&, Timestamp> sourceUncodedSymbols;
 
 private:
 
+	/* Encode n (1-8) input bits given in the MSB end of a byte */
+	void encode_bits(uint8_t bits, unsigned int n, SymbolVector& output);
 
-	/*
-	 * Generator for non-punctured convolutional codings
-	 */
-	SymbolGenerator generateSymbols(SymbolGenerator& gen);
-
-	/*
-	 * Generator for punctured convolutional coding
-	 */
-	SymbolGenerator generatePuncturedSymbols(SymbolGenerator& gen);
+	static std::shared_ptr<const ConvolutionalTables> getTables(const ConvolutionalConfig& conf);
 
 	/* Config */
-	const ConvolutionalConfig& conf;
+	ConvolutionalConfig conf;
+	std::shared_ptr<const ConvolutionalTables> tables;
+	uint32_t state_mask;
 
 	/* State */
 	unsigned int puncturing_index;
 	uint32_t shift_register;
 	SymbolVector input;
-	SymbolVector encoderOutput;
-	SymbolGenerator output_gen;
+	SymbolVector pending; // Encoded symbols not yet sourced
+	size_t pending_idx;
 };
 
 namespace ConvolutionCodes {
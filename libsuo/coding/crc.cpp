@@ -2,8 +2,97 @@
 #include "coding/crc.hpp"
 #include "coding/crc_generic.hpp"
 
+#ifdef SUO_CRC_PCLMUL
+#include <immintrin.h>
+#endif
+
 using namespace suo;
 
+
+bool suo::crc_pclmul_available() {
+#ifdef SUO_CRC_PCLMUL
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+#else
+	return false;
+#endif
+}
+
+bool suo::crc_use_pclmul = suo::crc_pclmul_available();
+
+
+#ifdef SUO_CRC_PCLMUL
+
+/* Load 16 bytes. For non-reflected algorithms, bytes are swapped so that bit n of the lane is coefficient of x^n */
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i load_lane(const uint8_t* ptr, bool reflected) {
+	__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+	if (reflected)
+		return x;
+	return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+/* Fold 128-bit lane forward and add it to the data */
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i fold_lane(__m128i lane, __m128i k, __m128i data) {
+	__m128i lo = _mm_clmulepi64_si128(lane, k, 0x00);
+	__m128i hi = _mm_clmulepi64_si128(lane, k, 0x11);
+	return _mm_xor_si128(_mm_xor_si128(lo, hi), data);
+}
+
+__attribute__((target("pclmul,ssse3")))
+void suo::crc_fold_pclmul(const CRCFoldConstants& k, bool reflected, uint64_t init, const uint8_t* data, size_t len, uint8_t* remainder)
+{
+	assert(len >= 64 && (len % 16) == 0);
+
+	const __m128i k512 = _mm_set_epi64x(k.fold512[1], k.fold512[0]);
+	const __m128i k128 = _mm_set_epi64x(k.fold128[1], k.fold128[0]);
+
+	__m128i x0 = load_lane(data, reflected);
+	__m128i x1 = load_lane(data + 16, reflected);
+	__m128i x2 = load_lane(data + 32, reflected);
+	__m128i x3 = load_lane(data + 48, reflected);
+	data += 64;
+	len -= 64;
+
+	/* Initial register value is added to the beginning of the message */
+	x0 = _mm_xor_si128(x0, reflected ? _mm_set_epi64x(0, init) : _mm_set_epi64x(init, 0));
+
+	/* Fold 4 lanes in parallel */
+	while (len >= 64) {
+		x0 = fold_lane(x0, k512, load_lane(data, reflected));
+		x1 = fold_lane(x1, k512, load_lane(data + 16, reflected));
+		x2 = fold_lane(x2, k512, load_lane(data + 32, reflected));
+		x3 = fold_lane(x3, k512, load_lane(data + 48, reflected));
+		data += 64;
+		len -= 64;
+	}
+
+	/* Combine the lanes */
+	x0 = fold_lane(x0, k128, x1);
+	x0 = fold_lane(x0, k128, x2);
+	x0 = fold_lane(x0, k128, x3);
+
+	/* Fold remaining 16 byte blocks */
+	while (len >= 16) {
+		x0 = fold_lane(x0, k128, load_lane(data, reflected));
+		data += 16;
+		len -= 16;
+	}
+
+	if (!reflected)
+		x0 = _mm_shuffle_epi8(x0, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(remainder), x0);
+}
+
+#else
+
+void suo::crc_fold_pclmul(const CRCFoldConstants& k, bool reflected, uint64_t init, const uint8_t* data, size_t len, uint8_t* remainder) {
+	throw SuoError("crc_fold_pclmul: Not supported on this platform");
+}
+
+#endif
+
 CRC::CRC(const CRCAlgorithm& algo) :
 	algo(algo)
 { }
@@ -47,150 +136,6 @@ template<> CRC24::CacheType CRC24::cache = {};
 template<> CRC32::CacheType CRC32::cache = {};
 
 
-/*
- * ref: https://reveng.sourceforge.io/crc-catalogue/all.htm
- */
-namespace suo::CRCAlgorithms {
-
-const CRCAlgorithm CRC8 = {
-	.width = 8,
-	.poly = 0x07,
-	.init = 0x00,
-	.refIn = false,
-	.refOut = false,
-	.xorOut = 0x000,
-};
-
-const CRCAlgorithm CRC8_CDMA2000 = {
-	.width = 8,
-	.poly = 0x9B,
-	.init = 0xFF,
-	.refIn = false,
-	.refOut = false,
-	.xorOut = 0x000,
-};
-
-const CRCAlgorithm CRC8_DVB_S2 = {
-	.width = 8,
-	.poly = 0xD5,
-	.init = 0x00,
-	.refIn = false,
-	.refOut = false,
-	.xorOut = 0x000,
-};
-
-const CRCAlgorithm CRC8_ITU = {
-	.width = 8,
-	.poly = 0x07,
-	.init = 0x00,
-	.refIn = false,
-	.refOut = false,
-	.xorOut = 0x55,
-};
-
-const CRCAlgorithm CRC16_AUG_CCITT = {
-	.width = 16,
-	.poly = 0x1021,
-	.init = 0x1D0F,
-	.refIn = false,
-	.refOut = false,
-	.xorOut = 0x000,
-};
-
-const CRCAlgorithm CRC16_CCITT_FALSE = {
-	.width = 16,
-	.poly = 0x1021,
-	.init = 0xFFFF,
-	.refIn = false,
-	.refOut = false,
-	.xorOut = 0x000,
-};
-
-const CRCAlgorithm CRC16_CDMA2000 = {
-	.width = 16,
-	.poly = 0xC867,
-	.init = 0xFFFF,
-	.refIn = false,
-	.refOut = false,
-	.xorOut = 0x000,
-};
-
-const CRCAlgorithm CRC16_X25 = {
-	.width = 16,
-	.poly = 0x1021,
-	.init = 0xFFFF,
-	.refIn = true,
-	.refOut = true,
-	.xorOut = 0xFFFF,
-};
-
-const CRCAlgorithm CRC24_BLE = {
-	.width = 24,
-	.poly = 0x1021,
-	.init = 0xFFFF,
-	.refIn = true,
-	.refOut = true,
-	.xorOut = 0xFFFF,
-};
-
-const CRCAlgorithm CRC16_MODBUS = {
-	.width = 16,
-	.poly = 0x8005,
-	.init = 0xFFFF,
-	.refIn = true,
-	.refOut = true,
-	.xorOut = 0x0000,
-};
-
-const CRCAlgorithm CRC16_CMS = {
-	.width = 16,
-	.poly = 0x8005,
-	.init = 0xFFFF,
-	.refIn = false,
-	.refOut = false,
-	.xorOut = 0x0000,
-};
-
-const CRCAlgorithm CRC32 = {
-	.width = 32,
-	.poly = 0x04C11DB7,
-	.init = 0xFFFFFFFF,
-	.refIn = true,
-	.refOut = true,
-	.xorOut = 0xFFFFFFFF,
-};
-
-const CRCAlgorithm CRC32_POSIX = {
-	.width = 32,
-	.poly = 0x04C11DB7,
-	.init = 0x00000000,
-	.refIn = false,
-	.refOut = false,
-	.xorOut = 0xFFFFFFFF,
-};
-
-
-using namespace std::literals::string_view_literals;
-constexpr std::array<std::pair<std::string_view, const CRCAlgorithm&>, 12> algorithms{ {
-	{ "CRC-8"sv, CRC8 },
-	{ "CRC-8/CDMA2000"sv, CRC8_CDMA2000 },
-	{ "CRC-8/DVB-S2"sv, CRC8_DVB_S2 },
-	{ "CRC-8/ITU"sv, CRC8_ITU },
-
-	{ "CRC-16/AUG-CCITT"sv, CRC16_AUG_CCITT },
-	{ "CRC-16/CCITT_FALSE"sv, CRC16_CCITT_FALSE },
-	{ "CRC-16/CDMA2000"sv, CRC16_CDMA2000 },
-	{ "CRC-16/X25"sv, CRC16_X25 },
-	{ "CRC-16/MODBUS"sv, CRC16_MODBUS },
-	{ "CRC-16/CMS"sv, CRC16_CMS },
-
-	{ "CRC-32"sv, CRC32 },
-	{ "CRC-32/POSIX"sv, CRC32_POSIX },
-} };
-
-}; // namespace suo::CRCAlgorithms
-
-
 const CRCAlgorithm& suo::getCRC(const std::string_view name) {
 	static const auto map = std::map<std::string_view, const CRCAlgorithm&>{ 
 		CRCAlgorithms::algorithms.begin(), CRCAlgorithms::algorithms.end() };
@@ -198,7 +143,7 @@ const CRCAlgorithm& suo::getCRC(const std::string_view name) {
 		return map.at(name);
 	}
 	catch (std::out_of_range& e) {
-		throw SuoError("No such CRC code '%s'", name);
+		throw SuoError("No such CRC code '%s'", std::string(name).c_str());
 	}
 }
 
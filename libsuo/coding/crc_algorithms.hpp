@@ -3,6 +3,8 @@
 #include "suo.hpp"
 
 #include <array>
+#include <utility>
+#include <string_view>
 
 namespace suo
 {
@@ -27,27 +29,160 @@ struct CRCAlgorithm {
 
 	/* XOR output */
 	uint32_t xorOut;
+
+	constexpr bool operator==(const CRCAlgorithm&) const = default;
 };
 
 
+/*
+ * Predefined CRC algorithms.
+ * Defined here as constexpr so that their lookup tables can be generated at compile time.
+ * ref: https://reveng.sourceforge.io/crc-catalogue/all.htm
+ */
 namespace CRCAlgorithms {
 
-extern const CRCAlgorithm CRC8;
-extern const CRCAlgorithm CRC8_CDMA2000;
-extern const CRCAlgorithm CRC8_DVB_S2;
-extern const CRCAlgorithm CRC8_ITU;
+inline constexpr CRCAlgorithm CRC8 = {
+	.width = 8,
+	.poly = 0x07,
+	.init = 0x00,
+	.refIn = false,
+	.refOut = false,
+	.xorOut = 0x000,
+};
+
+inline constexpr CRCAlgorithm CRC8_CDMA2000 = {
+	.width = 8,
+	.poly = 0x9B,
+	.init = 0xFF,
+	.refIn = false,
+	.refOut = false,
+	.xorOut = 0x000,
+};
+
+inline constexpr CRCAlgorithm CRC8_DVB_S2 = {
+	.width = 8,
+	.poly = 0xD5,
+	.init = 0x00,
+	.refIn = false,
+	.refOut = false,
+	.xorOut = 0x000,
+};
+
+inline constexpr CRCAlgorithm CRC8_ITU = {
+	.width = 8,
+	.poly = 0x07,
+	.init = 0x00,
+	.refIn = false,
+	.refOut = false,
+	.xorOut = 0x55,
+};
+
+inline constexpr CRCAlgorithm CRC16_AUG_CCITT = {
+	.width = 16,
+	.poly = 0x1021,
+	.init = 0x1D0F,
+	.refIn = false,
+	.refOut = false,
+	.xorOut = 0x000,
+};
+
+inline constexpr CRCAlgorithm CRC16_CCITT_FALSE = {
+	.width = 16,
+	.poly = 0x1021,
+	.init = 0xFFFF,
+	.refIn = false,
+	.refOut = false,
+	.xorOut = 0x000,
+};
+
+inline constexpr CRCAlgorithm CRC16_CDMA2000 = {
+	.width = 16,
+	.poly = 0xC867,
+	.init = 0xFFFF,
+	.refIn = false,
+	.refOut = false,
+	.xorOut = 0x000,
+};
+
+inline constexpr CRCAlgorithm CRC16_X25 = {
+	.width = 16,
+	.poly = 0x1021,
+	.init = 0xFFFF,
+	.refIn = true,
+	.refOut = true,
+	.xorOut = 0xFFFF,
+};
+
+inline constexpr CRCAlgorithm CRC16_MODBUS = {
+	.width = 16,
+	.poly = 0x8005,
+	.init = 0xFFFF,
+	.refIn = true,
+	.refOut = true,
+	.xorOut = 0x0000,
+};
+
+inline constexpr CRCAlgorithm CRC16_CMS = {
+	.width = 16,
+	.poly = 0x8005,
+	.init = 0xFFFF,
+	.refIn = false,
+	.refOut = false,
+	.xorOut = 0x0000,
+};
+
+/* HDLC frame check sequence (ISO/IEC 13239) is the X.25 CRC */
+inline constexpr const CRCAlgorithm& CRC16_HDLC = CRC16_X25;
+
+inline constexpr CRCAlgorithm CRC24_BLE = {
+	.width = 24,
+	.poly = 0x00065B,
+	.init = 0x555555,
+	.refIn = true,
+	.refOut = true,
+	.xorOut = 0x000000,
+};
+
+inline constexpr CRCAlgorithm CRC32 = {
+	.width = 32,
+	.poly = 0x04C11DB7,
+	.init = 0xFFFFFFFF,
+	.refIn = true,
+	.refOut = true,
+	.xorOut = 0xFFFFFFFF,
+};
+
+inline constexpr CRCAlgorithm CRC32_POSIX = {
+	.width = 32,
+	.poly = 0x04C11DB7,
+	.init = 0x00000000,
+	.refIn = false,
+	.refOut = false,
+	.xorOut = 0xFFFFFFFF,
+};
+
+
+/* All predefined algorithms with their names */
+inline constexpr std::array<std::pair<std::string_view, const CRCAlgorithm&>, 15> algorithms{ {
+	{ "CRC-8", CRC8 },
+	{ "CRC-8/CDMA2000", CRC8_CDMA2000 },
+	{ "CRC-8/DVB-S2", CRC8_DVB_S2 },
+	{ "CRC-8/ITU", CRC8_ITU },
 
-extern const CRCAlgorithm CRC16_AUG_CCITT;
-extern const CRCAlgorithm CRC16_CCITT_FALSE;
-extern const CRCAlgorithm CRC16_CDMA2000;
-extern const CRCAlgorithm CRC16_X25;
-extern const CRCAlgorithm CRC16_MODBUS;
-extern const CRCAlgorithm CRC16_CMS;
+	{ "CRC-16/AUG-CCITT", CRC16_AUG_CCITT },
+	{ "CRC-16/CCITT_FALSE", CRC16_CCITT_FALSE },
+	{ "CRC-16/CDMA2000", CRC16_CDMA2000 },
+	{ "CRC-16/X25", CRC16_X25 },
+	{ "CRC-16/HDLC", CRC16_X25 },
+	{ "CRC-16/ISO-HDLC", CRC16_X25 },
+	{ "CRC-16/MODBUS", CRC16_MODBUS },
+	{ "CRC-16/CMS", CRC16_CMS },
 
-extern const CRCAlgorithm CRC24_BLE;
+	{ "CRC-24/BLE", CRC24_BLE },
 
-extern const CRCAlgorithm CRC32;
-extern const CRCAlgorithm CRC32_POSIX;
+	{ "CRC-32", CRC32 },
+	{ "CRC-32/POSIX", CRC32_POSIX },
+} };
 
 };
 
@@ -5,11 +5,56 @@
 #include "framing/utils.hpp"
 
 #include <array>
+#include <bit>
+#include <cassert>
 #include <iomanip>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SUO_CRC_PCLMUL
+#endif
 
 namespace suo
 {
 
+/* Constants for carry-less multiplication folding (see crc_fold_pclmul) */
+struct CRCFoldConstants {
+	uint64_t fold512[2]; // Constants for folding 512 bits forward (4 lanes)
+	uint64_t fold128[2]; // Constants for folding 128 bits forward (single lane)
+};
+
+/* Use PCLMULQDQ folding for long buffers. Initialized by CPU feature detection. */
+extern bool crc_use_pclmul;
+
+/* Is PCLMULQDQ supported by the CPU */
+bool crc_pclmul_available();
+
+/*
+ * Fold a buffer to a single 128-bit remainder which has the same CRC as the buffer.
+ * Args:
+ *   k: Fold constants of the algorithm
+ *   reflected: Reflected algorithm
+ *   init: Initial CRC register value XORed to the first 8 bytes (in message bit order)
+ *   data: Input data
+ *   len: Number of input bytes, multiple of 16 and at least 64
+ *   remainder: Output buffer for the 16 byte remainder
+ */
+void crc_fold_pclmul(const CRCFoldConstants& k, bool reflected, uint64_t init, const uint8_t* data, size_t len, uint8_t* remainder);
+
+
+/* Reverse the bit order of an integer (constexpr version of reverse_bits) */
+template<typename T>
+constexpr T crc_reflect(T value) {
+	T result = 0;
+	for (unsigned int i = 0; i < 8 * sizeof(T); i++) {
+		result = (T)(result << 1) | (value & 1);
+		value >>= 1;
+	}
+	return result;
+}
+
+
 /*
  * Type generic implementation of the CRC
  */
@@ -18,9 +63,22 @@ class CRCGeneric
 {
 public:
 	using TableType = std::array<T, 256>;
-	using CacheType = std::map<const CRCAlgorithm*, TableType>;
 	static const unsigned int TypeWidth = 8 * sizeof(T);
 
+	/* Minimum buffer length for carry-less multiplication folding */
+	static const size_t PCLMULThreshold = 128;
+
+	/* Lookup tables for slicing-by-8 and carry-less multiplication constants */
+	struct LookupTables {
+		TableType slices[8];
+		CRCFoldConstants fold;
+	};
+	using CacheType = std::map<const CRCAlgorithm*, LookupTables>;
+
+	/* Lookup tables for the predefined algorithms generated at compile time */
+	template<const CRCAlgorithm& Algo>
+	static const LookupTables preset_tables;
+
 
 	class Digest {
 	public:
@@ -35,53 +93,31 @@ public:
 
 	/* Initialize generic CRC implementation */
 	explicit CRCGeneric(const CRCAlgorithm& algo)
-		: algo(algo), table(getTable(algo)) { }
+		: algo(algo), tables(getTables(algo)), table(tables.slices[0]) { }
 
 	/* */
 	T init() const {
-		if (algo.refIn)
-			return reverse_bits((T)algo.init) >> (TypeWidth - Width);
-		else
-			return algo.init << (TypeWidth - Width);
+		return init(algo, algo.init);
 	}
 
 	/* */
 	T init(T initial) const {
-		if (algo.refIn)
-			return reverse_bits(initial) >> (TypeWidth - Width);
-		else
-			return initial << (TypeWidth - Width);
+		return init(algo, initial);
 	}
 
 	/* Update routine for ByteVector */
 	T update(T value, const ByteVector& bytes) const {
-		return update(value, bytes.data(), bytes.size());
+		return update(tables, algo.refIn, value, bytes.data(), bytes.size());
 	}
 
 	/* Update routine for uint8_t pointer. */
 	T update(T value, const uint8_t* bytes, size_t len) const {
-		if (algo.refIn) {
-			for (size_t i = 0; i < len; i++) {
-				T index = value ^ bytes[i];
-				value = table[index & 0xFF] ^ (value >> 8);
-			}
-		}
-		else {
-			for (size_t i = 0; i < len; i++) {
-				T index = (value >> (Width - 8)) ^ bytes[i];
-				value = table[index & 0xFF] ^ (value << 8);
-			}
-		}
-		return value;
+		return update(tables, algo.refIn, value, bytes, len);
 	}
 
 	/* */
 	T finalize(T value) const {
-		if (algo.refIn ^ algo.refOut)
-			value = reverse_bits(value);
-		if (!algo.refOut)
-			value >>= TypeWidth - algo.width;
-		return value ^ algo.xorOut;
+		return finalize(algo, value);
 	}
 
 	T calculate(const ByteVector& bytes) const {
@@ -108,28 +144,48 @@ public:
 		stream << "\n};\n";
 	}
 
-private:
-	const CRCAlgorithm& algo;
-	const TableType& table;
 
-	static CacheType cache;
+	/* Initial register value for given algorithm */
+	static constexpr T init(const CRCAlgorithm& algo, T initial) {
+		if (algo.refIn)
+			return crc_reflect(initial) >> (TypeWidth - Width);
+		else
+			return (T)(initial << (TypeWidth - Width));
+	}
 
-	static const TableType& getTable(const CRCAlgorithm& algo) {
-		
-		assert(sizeof(TableType) >= Width);
-		assert(algo.width == Width);
+	/* Final CRC value from the register value */
+	static constexpr T finalize(const CRCAlgorithm& algo, T value) {
+		if (algo.refIn ^ algo.refOut)
+			value = crc_reflect(value);
+		if (!algo.refOut)
+			value >>= TypeWidth - algo.width;
+		return value ^ algo.xorOut;
+	}
 
-		/* Try to find the lookup table from the cache */
-		auto iter = cache.find(&algo);
-		if (iter != cache.end())
-			return iter->second;
-		
+	/* Update the register value using given lookup tables */
+	static T update(const LookupTables& tables, bool refIn, T value, const uint8_t* bytes, size_t len) {
+#ifdef SUO_CRC_PCLMUL
+		if (len >= PCLMULThreshold && crc_use_pclmul) {
+			/* Fold the bulk of the buffer to 16 bytes and calculate the rest with tables */
+			const size_t fold_len = len & ~(size_t)15;
+			const uint64_t init = refIn ? (uint64_t)value : ((uint64_t)value << (64 - TypeWidth));
+			uint8_t remainder[16];
+			crc_fold_pclmul(tables.fold, refIn, init, bytes, fold_len, remainder);
+			value = update_sliced(tables, refIn, 0, remainder, 16);
+			bytes += fold_len;
+			len -= fold_len;
+		}
+#endif
+		return update_sliced(tables, refIn, value, bytes, len);
+	}
 
-		/* Generate new lookup table */
-		TableType& new_table = cache[&algo];
+	/* Generate lookup tables and folding constants for given algorithm */
+	static constexpr LookupTables generateTables(const CRCAlgorithm& algo) {
+		LookupTables new_tables = {};
+		TableType& new_table = new_tables.slices[0];
 		const T poly = algo.refIn ?
-			(reverse_bits((T)algo.poly) >> (TypeWidth - Width)) :
-			(algo.poly << (TypeWidth - Width));
+			(crc_reflect((T)algo.poly) >> (TypeWidth - Width)) :
+			(T)(algo.poly << (TypeWidth - Width));
 
 		for (unsigned int i = 0; i < 256; i++) {
 			T value = i;
@@ -140,16 +196,196 @@ private:
 			else {
 				value <<= (TypeWidth - 8);
 				for (unsigned int j = 0; j < 8; j++)
-					value = (value << 1) ^ (((value >> (Width - 1)) & 1) * poly);
+					value = (T)(value << 1) ^ (((value >> (TypeWidth - 1)) & 1) * poly);
 			}
 			new_table[i] = value;
 		}
 
-		return new_table;
+		/* Slice k gives the effect of a byte followed by k zero bytes */
+		for (unsigned int k = 1; k < 8; k++) {
+			for (unsigned int i = 0; i < 256; i++) {
+				T prev = new_tables.slices[k - 1][i];
+				if (algo.refIn)
+					new_tables.slices[k][i] = (prev >> 8) ^ new_table[prev & 0xFF];
+				else
+					new_tables.slices[k][i] = (T)(prev << 8) ^ new_table[(prev >> (TypeWidth - 8)) & 0xFF];
+			}
+		}
+
+		/* Folding constants. In the reflected domain carry-less product is one bit short
+		 * so the exponents are reduced by one. */
+		CRCFoldConstants& fold = new_tables.fold;
+		if (algo.refIn) {
+			fold.fold512[0] = crc_reflect(xpow_mod(algo, 512 + 64 - 1));
+			fold.fold512[1] = crc_reflect(xpow_mod(algo, 512 - 1));
+			fold.fold128[0] = crc_reflect(xpow_mod(algo, 128 + 64 - 1));
+			fold.fold128[1] = crc_reflect(xpow_mod(algo, 128 - 1));
+		}
+		else {
+			fold.fold512[0] = xpow_mod(algo, 512);
+			fold.fold512[1] = xpow_mod(algo, 512 + 64);
+			fold.fold128[0] = xpow_mod(algo, 128);
+			fold.fold128[1] = xpow_mod(algo, 128 + 64);
+		}
+
+		return new_tables;
+	}
+
+	/* Find compile-time generated lookup tables for a predefined algorithm */
+	static constexpr const LookupTables* findPresetTables(const CRCAlgorithm& algo) {
+		using namespace CRCAlgorithms;
+		return findPresetTables<CRC8, CRC8_CDMA2000, CRC8_DVB_S2, CRC8_ITU,
+			CRC16_AUG_CCITT, CRC16_CCITT_FALSE, CRC16_CDMA2000, CRC16_X25, CRC16_MODBUS, CRC16_CMS,
+			CRC24_BLE, CRC32, CRC32_POSIX>(algo);
+	}
+
+private:
+	const CRCAlgorithm& algo;
+	const LookupTables& tables;
+	const TableType& table;
+
+	/* Lookup tables for custom algorithms generated at runtime */
+	static CacheType cache;
+
+	template<const CRCAlgorithm&... Algos>
+	static constexpr const LookupTables* findPresetTables(const CRCAlgorithm& algo) {
+		const LookupTables* found = nullptr;
+		((found = (found == nullptr) ? presetTables<Algos>(algo) : found), ...);
+		return found;
+	}
+
+	template<const CRCAlgorithm& Algo>
+	static constexpr const LookupTables* presetTables(const CRCAlgorithm& algo) {
+		if constexpr (Algo.width == Width) {
+			if (algo == Algo)
+				return &preset_tables<Algo>;
+		}
+		return nullptr;
+	}
+
+	/* Slicing-by-8 update routine */
+	static T update_sliced(const LookupTables& tables, bool refIn, T value, const uint8_t* bytes, size_t len) {
+		const TableType* t = tables.slices;
+		if (refIn) {
+			/* The register is in the low bits so it lines up with the little-endian word */
+			while (len >= 8) {
+				uint64_t word;
+				memcpy(&word, bytes, 8);
+				if constexpr (std::endian::native == std::endian::big)
+					word = __builtin_bswap64(word);
+				word ^= value;
+				value = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^
+					t[5][(word >> 16) & 0xFF] ^ t[4][(word >> 24) & 0xFF] ^
+					t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^
+					t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+				bytes += 8;
+				len -= 8;
+			}
+			for (size_t i = 0; i < len; i++) {
+				T index = value ^ bytes[i];
+				value = t[0][index & 0xFF] ^ (value >> 8);
+			}
+		}
+		else {
+			/* The register is in the high bits so it lines up with the big-endian word */
+			while (len >= 8) {
+				uint64_t word;
+				memcpy(&word, bytes, 8);
+				if constexpr (std::endian::native == std::endian::little)
+					word = __builtin_bswap64(word);
+				word ^= (uint64_t)value << (64 - TypeWidth);
+				value = t[7][word >> 56] ^ t[6][(word >> 48) & 0xFF] ^
+					t[5][(word >> 40) & 0xFF] ^ t[4][(word >> 32) & 0xFF] ^
+					t[3][(word >> 24) & 0xFF] ^ t[2][(word >> 16) & 0xFF] ^
+					t[1][(word >> 8) & 0xFF] ^ t[0][word & 0xFF];
+				bytes += 8;
+				len -= 8;
+			}
+			for (size_t i = 0; i < len; i++) {
+				T index = (value >> (TypeWidth - 8)) ^ bytes[i];
+				value = t[0][index & 0xFF] ^ (T)(value << 8);
+			}
+		}
+		return value;
+	}
+
+	/* Calculate x^n mod P where P is the algorithm's polynomial */
+	static constexpr uint64_t xpow_mod(const CRCAlgorithm& algo, unsigned int n) {
+		const uint64_t top = (uint64_t)1 << (Width - 1);
+		uint64_t value = 1;
+		for (unsigned int i = 0; i < n; i++) {
+			bool carry = (value & top) != 0;
+			value <<= 1;
+			if (Width < 64)
+				value &= (top << 1) - 1;
+			if (carry)
+				value ^= algo.poly;
+		}
+		return value;
 	}
 
+	static const LookupTables& getTables(const CRCAlgorithm& algo) {
+
+		assert(sizeof(T) * 8 >= Width);
+		assert(algo.width == Width);
+
+		/* Predefined algorithms have their tables in read-only data */
+		const LookupTables* preset = findPresetTables(algo);
+		if (preset != nullptr)
+			return *preset;
+
+		/* Try to find the lookup table from the cache */
+		auto iter = cache.find(&algo);
+		if (iter != cache.end())
+			return iter->second;
+
+		/* Generate new lookup table */
+		return cache[&algo] = generateTables(algo);
+	}
+
+};
+
+template<typename T, unsigned int Width>
+template<const CRCAlgorithm& Algo>
+constexpr typename CRCGeneric<T, Width>::LookupTables CRCGeneric<T, Width>::preset_tables = CRCGeneric<T, Width>::generateTables(Algo);
+
+
+/*
+ * CRC digest for a predefined algorithm known at compile time.
+ * Holds only the CRC register value and the lookup tables are generated at compile time.
+ */
+template<const CRCAlgorithm& Algo>
+class CRCDigest
+{
+public:
+	using T = std::conditional_t<(Algo.width <= 8), uint8_t,
+		std::conditional_t<(Algo.width <= 16), uint16_t,
+		std::conditional_t<(Algo.width <= 32), uint32_t, uint64_t>>>;
+	using CRCType = CRCGeneric<T, Algo.width>;
+
+	constexpr CRCDigest() : value(CRCType::init(Algo, Algo.init)) { }
+	constexpr explicit CRCDigest(T initial) : value(CRCType::init(Algo, initial)) { }
+
+	void update(const ByteVector& bytes) { update(bytes.data(), bytes.size()); }
+	void update(const uint8_t* bytes, size_t len) {
+		value = CRCType::update(CRCType::template preset_tables<Algo>, Algo.refIn, value, bytes, len);
+	}
+
+	T finalize() const { return CRCType::finalize(Algo, value); }
+
+	/* Calculate CRC of the buffer in one go */
+	static T calculate(const uint8_t* bytes, size_t len) {
+		CRCDigest digest;
+		digest.update(bytes, len);
+		return digest.finalize();
+	}
+	static T calculate(const ByteVector& bytes) { return calculate(bytes.data(), bytes.size()); }
+
+private:
+	T value;
 };
 
+
 typedef CRCGeneric<uint8_t, 8> CRC8;
 typedef CRCGeneric<uint16_t, 16> CRC16;
 typedef CRCGeneric<uint32_t, 24> CRC24;
@@ -16,6 +16,7 @@
 #include "golay24.hpp"
 
 #include <bit> // std::popcount
+#include <cmath> // fabsf
 #include "framing/utils.hpp" // suo::bit_parity
 
 
@@ -24,7 +25,67 @@
 static const uint32_t H[N] = { 0x8008ed, 0x4001db, 0x2003b5, 0x100769, 0x80ed1, 0x40da3,
                                0x20b47,  0x1068f,  0x8d1d,   0x4a3b,   0x2477,  0x1ffe };
 
-#define B(i) (H[i] & 0xfff)
+/* Marks the syndromes of uncorrectable (weight 4) error patterns */
+static const uint32_t uncorrectable = 0xFFFFFFFF;
+
+/* Number of least reliable bits flipped by the Chase decoder */
+#define CHASE_BITS 4
+
+
+/*
+ * Lookup tables generated at compile time:
+ *   syndrome: Syndrome contribution of each byte of the received word
+ *   error: Error pattern of weight <= 3 for each syndrome. The code's minimum
+ *          distance is 8 so these are unique. The remaining 1771 syndromes
+ *          belong to weight 4 patterns which can only be detected.
+ */
+struct Golay24Tables {
+    uint16_t syndrome[3][256];
+    uint32_t error[1 << N];
+};
+
+static constexpr Golay24Tables generate_tables()
+{
+    Golay24Tables tables = {};
+
+    for (int b = 0; b < 3; b++) {
+        for (uint32_t v = 0; v < 256; v++) {
+            uint16_t s = 0;
+            for (int i = 0; i < N; i++)
+                s = (s << 1) | (std::popcount(H[i] & (v << (8 * b))) & 1);
+            tables.syndrome[b][v] = s;
+        }
+    }
+
+    auto syndrome = [&tables](uint32_t r) {
+        return tables.syndrome[0][r & 0xFF] ^ tables.syndrome[1][(r >> 8) & 0xFF] ^ tables.syndrome[2][r >> 16];
+    };
+
+    for (uint32_t s = 0; s < (1 << N); s++)
+        tables.error[s] = uncorrectable;
+    tables.error[0] = 0;
+    for (int i = 0; i < 2 * N; i++) {
+        for (int j = i + 1; j < 2 * N; j++) {
+            for (int k = j + 1; k < 2 * N; k++) {
+                const uint32_t e = (1 << i) | (1 << j) | (1 << k);
+                tables.error[syndrome(e)] = e;
+            }
+            const uint32_t e = (1 << i) | (1 << j);
+            tables.error[syndrome(e)] = e;
+        }
+        tables.error[syndrome(1 << i)] = 1 << i;
+    }
+    return tables;
+}
+
+static constexpr Golay24Tables tables = generate_tables();
+
+
+static inline uint32_t golay24_syndrome(uint32_t r)
+{
+    return tables.syndrome[0][r & 0xFF] ^ tables.syndrome[1][(r >> 8) & 0xFF] ^ tables.syndrome[2][(r >> 16) & 0xFF];
+}
+
 
 int encode_golay24(uint32_t* data)
 {
@@ -44,70 +105,66 @@ int encode_golay24(uint32_t* data)
 
 int decode_golay24(uint32_t* data)
 {
-    uint32_t r = *data;
-    uint16_t s; /* syndrome */
-    uint16_t q; /* modified syndrome */
-    uint32_t e; /* estimated error vector */
-    int i;
-    uint32_t count;
+    const uint32_t e = tables.error[golay24_syndrome(*data)];
+    if (e == uncorrectable)
+        return -1;
 
-    // Step 1. s = H*r
-    s = 0;
-    for (i = 0; i < N; i++) {
-        s <<= 1;
-        s |= suo::bit_parity(H[i] & r);
-    }
-
-    // Step 2. if w(s) <= 3, then e = (s, 0) and go to step 8
-    count = std::popcount(s);
-    if (count <= 3) {
-        e = s;
-        e <<= N;
-        goto step8;
-    }
+    *data ^= e;
+    return std::popcount(e);
+}
 
-    // Step 3. if w(s + B[i]) <= 2, then e = (s + B[i], e_{i+1}) and go to step 8
-    for (i = 0; i < N; i++) {
-        count = std::popcount(s ^ B(i));
-        if (count <= 2) {
-            e = s ^ B(i);
-            e <<= N;
-            e |= 1 << (N - i - 1);
-            goto step8;
+int decode_golay24_soft(const float* llr, uint32_t* data)
+{
+    /* Hard decisions and the least reliable positions */
+    uint32_t hard = 0;
+    int weakest[CHASE_BITS];
+    for (int i = 0; i < CHASE_BITS; i++)
+        weakest[i] = -1;
+
+    for (int i = 0; i < 2 * N; i++) {
+        hard = (hard << 1) | (llr[i] > 0.0f);
+
+        /* Insertion into the sorted list of the least reliable bits */
+        int pos = i;
+        for (int j = 0; j < CHASE_BITS; j++) {
+            if (weakest[j] < 0 || fabsf(llr[pos]) < fabsf(llr[weakest[j]])) {
+                const int tmp = weakest[j];
+                weakest[j] = pos;
+                pos = tmp;
+                if (pos < 0)
+                    break;
+            }
         }
     }
 
-    // Step 4. compute q = B*s
-    q = 0;
-    for (i = 0; i < N; i++) {
-        q <<= 1;
-        q |= suo::bit_parity(B(i) & s);
-    }
-
-    // Step 5. If w(q) <= 3, then e = (0, q) and go to step 8
-    count = std::popcount(q);
-    if (count <= 3) {
-        e = q;
-        goto step8;
-    }
-
-    // Step 6. If w(q + B[i]) <= 2, then e = (e_{i+1}, q + B[i]) and got to step 8
-    for (i = 0; i < N; i++) {
-        count = std::popcount(q ^ B(i));
-        if (count <= 2) {
-            e = 1 << (2 * N - i - 1);
-            e |= q ^ B(i);
-            goto step8;
+    /* Decode all test patterns and keep the codeword with the smallest soft distance */
+    float best_metric = INFINITY;
+    uint32_t best = 0;
+    for (unsigned int pattern = 0; pattern < (1 << CHASE_BITS); pattern++) {
+        uint32_t test = hard;
+        for (int j = 0; j < CHASE_BITS; j++)
+            if ((pattern >> j) & 1)
+                test ^= 1 << (2 * N - 1 - weakest[j]);
+
+        const uint32_t e = tables.error[golay24_syndrome(test)];
+        if (e == uncorrectable)
+            continue;
+
+        /* Soft distance: Sum of reliabilities of the bits which differ from the hard decisions */
+        const uint32_t diff = (test ^ e) ^ hard;
+        float metric = 0.0f;
+        for (uint32_t d = diff; d != 0; d &= d - 1)
+            metric += fabsf(llr[2 * N - 1 - std::countr_zero(d)]);
+
+        if (metric < best_metric) {
+            best_metric = metric;
+            best = test ^ e;
         }
     }
 
-    // Step 7. r is uncorrectable
-    return -1;
-
-step8:
-    // Step 8. c = r + e
-    *data = r ^ e;
+    if (best_metric == INFINITY)
+        return -1;
 
-    count = std::popcount(e);
-    return count;
+    *data = best;
+    return std::popcount(best ^ hard);
 }
@@ -17,8 +17,23 @@
 #define _GOLAY24_H
 
 #include <stdint.h>
+#include <stddef.h>
 
+/*
+ * Codeword layout: 12 parity bits in bits 23..12 and the 12 data bits in bits 11..0.
+ * The decoders return the number of corrected bits or -1 if the codeword is uncorrectable.
+ */
 int decode_golay24(uint32_t* data);
 int encode_golay24(uint32_t* data);
 
+/*
+ * Soft decision Chase-II decoder.
+ * llr[0..23] are the soft bits in the transmission order (bit 23 first),
+ * positive values meaning '1'. Hard decisions with the least reliable bits flipped
+ * are decoded and the codeword closest to the soft bits is selected.
+ * Returns the number of bits differing from the hard decisions or -1 if none of
+ * the test patterns was decodable.
+ */
+int decode_golay24_soft(const float* llr, uint32_t* data);
+
 #endif
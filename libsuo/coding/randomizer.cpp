@@ -1,6 +1,16 @@
 
+#include <algorithm> // min
+#include <bit>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <numeric> // lcm
+
 #include "coding/randomizer.hpp"
 
+using namespace suo;
+
+
 /*
  * Pseudo random sequence generated using the polynomial h(x) = x^8 + x^7 + x^5 + x^3 + 1.
  * Ref: CCSDS 131.0-B-4, 10.4.1
@@ -112,3 +122,104 @@ const uint8_t suo::pn9_randomizer[pn9_randomizer_len] = {
 };
 
 
+/* Cache for the generated sequences */
+static std::map<RandomizerAlgorithm, std::pair<std::shared_ptr<const ByteVector>, size_t>> sequence_cache;
+static std::mutex sequence_cache_mutex;
+
+/* Extra bytes after one period so that the sequence can be read in long runs */
+static const size_t sequence_overhang = 64;
+
+
+Randomizer::Randomizer(const RandomizerAlgorithm& algo) :
+	msb_first(algo.msb_first)
+{
+	sequence_ptr = getSequence(algo, sequence_period);
+	sequence = sequence_ptr->data();
+}
+
+
+static void validate(const RandomizerAlgorithm& algo)
+{
+	if (algo.width == 0 || algo.width > 24)
+		throw SuoError("Randomizer: Invalid LFSR width %d", algo.width);
+	const uint32_t mask = (1U << algo.width) - 1;
+	if ((algo.taps & 1) == 0 || (algo.taps & ~mask) != 0)
+		throw SuoError("Randomizer: Invalid taps 0x%x. Taps must include the x[n] term.", algo.taps);
+	if (algo.init == 0 || (algo.init & ~mask) != 0)
+		throw SuoError("Randomizer: Invalid initial state 0x%x", algo.init);
+}
+
+
+ByteVector Randomizer::generate(const RandomizerAlgorithm& algo, size_t len)
+{
+	validate(algo);
+
+	/* Fibonacci LFSR: Bit k of the state is the k:th next output bit */
+	ByteVector bytes(len);
+	uint32_t state = algo.init;
+	for (size_t i = 0; i < len; i++) {
+		uint8_t byte = 0;
+		for (unsigned int j = 0; j < 8; j++) {
+			const uint8_t bit = state & 1;
+			byte = algo.msb_first ? ((byte << 1) | bit) : (byte | (bit << j));
+			const uint32_t feedback = std::popcount(state & algo.taps) & 1;
+			state = (state >> 1) | (feedback << (algo.width - 1));
+		}
+		bytes[i] = byte;
+	}
+	return bytes;
+}
+
+
+std::shared_ptr<const ByteVector> Randomizer::getSequence(const RandomizerAlgorithm& algo, size_t& period)
+{
+	std::lock_guard<std::mutex> lock(sequence_cache_mutex);
+
+	auto iter = sequence_cache.find(algo);
+	if (iter != sequence_cache.end()) {
+		period = iter->second.second;
+		return iter->second.first;
+	}
+
+	/* Bit period of the sequence. The state update is invertible with the x[n] tap so the initial state is revisited. */
+	validate(algo);
+	size_t bit_period = 0;
+	uint32_t state = algo.init;
+	do {
+		const uint32_t feedback = std::popcount(state & algo.taps) & 1;
+		state = (state >> 1) | (feedback << (algo.width - 1));
+		bit_period++;
+	} while (state != algo.init);
+
+	/* One period in bytes and some extra */
+	period = std::lcm(bit_period, (size_t)8) / 8;
+	auto sequence = std::make_shared<const ByteVector>(generate(algo, period + sequence_overhang));
+	sequence_cache[algo] = { sequence, period };
+	return sequence;
+}
+
+
+void Randomizer::apply(uint8_t* data, size_t len, size_t offset) const
+{
+	size_t pos = offset % sequence_period;
+	while (len > 0) {
+		/* Longest contiguous run in the cached sequence */
+		const size_t run = std::min(len, sequence_period + sequence_overhang - pos);
+		const uint8_t* seq = &sequence[pos];
+
+		size_t i = 0;
+		for (; i + 8 <= run; i += 8) {
+			uint64_t a, b;
+			memcpy(&a, data + i, 8);
+			memcpy(&b, seq + i, 8);
+			a ^= b;
+			memcpy(data + i, &a, 8);
+		}
+		for (; i < run; i++)
+			data[i] ^= seq[i];
+
+		data += run;
+		len -= run;
+		pos = (pos + run) % sequence_period;
+	}
+}
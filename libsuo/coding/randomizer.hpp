@@ -2,6 +2,7 @@
 
 #include "suo.hpp"
 #include <cstdint>
+#include <memory>
 
 namespace suo {
 
@@ -12,4 +13,133 @@ extern const uint8_t ccsds_tc_randomizer[ccsds_randomizer_len];
 const size_t pn9_randomizer_len = 511;
 extern const uint8_t pn9_randomizer[pn9_randomizer_len];
 
+
+/*
+ * Additive (synchronous) randomizer definition.
+ * The sequence satisfies x[n + width] = XOR of x[n + k] for each bit k set in taps.
+ */
+struct RandomizerAlgorithm {
+
+	/* Number of bits in the linear feedback shift register. Maximum 24. */
+	unsigned int width;
+
+	/* Feedback taps of the recurrence (bit k is the term x[n + k]) */
+	uint32_t taps;
+
+	/* Initial state. Bit k is the k:th output bit. */
+	uint32_t init;
+
+	/* Sequence bits are packed to bytes MSB first (CCSDS) or LSB first (TI PN9 whitening) */
+	bool msb_first;
+
+	constexpr auto operator<=>(const RandomizerAlgorithm&) const = default;
+};
+
+
+namespace RandomizerAlgorithms {
+
+/*
+ * CCSDS TM randomizer h(x) = x^8 + x^7 + x^5 + x^3 + 1
+ * Ref: CCSDS 131.0-B-4, 10.4.1
+ */
+inline constexpr RandomizerAlgorithm CCSDS_TM = {
+	.width = 8,
+	.taps = 0xA9,
+	.init = 0xFF,
+	.msb_first = true,
+};
+
+/*
+ * CCSDS TC randomizer h(x) = x^8 + x^6 + x^4 + x^3 + x^2 + x + 1
+ * Ref: CCSDS 231.0-B-4, 6.3
+ */
+inline constexpr RandomizerAlgorithm CCSDS_TC = {
+	.width = 8,
+	.taps = 0x5F,
+	.init = 0xFF,
+	.msb_first = true,
+};
+
+/*
+ * PN9 whitening h(x) = x^9 + x^5 + 1
+ * Ref: Data Whitening and Random TX Mode https://www.ti.com/lit/an/swra322/swra322.pdf
+ */
+inline constexpr RandomizerAlgorithm PN9 = {
+	.width = 9,
+	.taps = 0x21,
+	.init = 0x1FF,
+	.msb_first = false,
+};
+
+};
+
+
+/*
+ * Randomizer/derandomizer for any length of data.
+ *
+ * One period of the sequence is generated once per algorithm and cached.
+ * The cached sequence has extra bytes after the period so that it can
+ * be XORed 64 bits at a time from any offset without wrapping.
+ */
+class Randomizer
+{
+public:
+	explicit Randomizer(const RandomizerAlgorithm& algo);
+
+	/* XOR the sequence starting from given byte offset in place */
+	void apply(uint8_t* data, size_t len, size_t offset = 0) const;
+	void apply(ByteVector& data, size_t offset = 0) const { apply(data.data(), data.size(), offset); }
+
+	/* Sequence period in bytes */
+	size_t period() const { return sequence_period; }
+
+	/* Sequence byte at given position */
+	uint8_t byte(size_t i) const { return sequence[i % sequence_period]; }
+
+
+	/*
+	 * Inline sequence generator which can be fused into a bit or byte serial deframer
+	 */
+	class Stream {
+	public:
+		explicit Stream(const Randomizer& randomizer) : randomizer(randomizer), pos(0), bit_idx(0) { }
+
+		void reset() { pos = 0; bit_idx = 0; }
+
+		/* XOR the next sequence byte to the given byte */
+		uint8_t next(uint8_t byte) {
+			return byte ^ randomizer.byte(pos++);
+		}
+
+		/* XOR the next sequence bit to the given bit. Bits are in transmission order. */
+		Symbol nextBit(Symbol bit) {
+			const uint8_t seq = randomizer.byte(pos);
+			const Symbol seq_bit = (randomizer.msb_first ? (seq >> (7 - bit_idx)) : (seq >> bit_idx)) & 1;
+			if (++bit_idx == 8) {
+				bit_idx = 0;
+				pos++;
+			}
+			return bit ^ seq_bit;
+		}
+
+	private:
+		const Randomizer& randomizer;
+		size_t pos;
+		unsigned int bit_idx;
+	};
+
+	Stream stream() const { return Stream(*this); }
+
+	/* Generate given number of sequence bytes without the cache */
+	static ByteVector generate(const RandomizerAlgorithm& algo, size_t len);
+
+private:
+	static std::shared_ptr<const ByteVector> getSequence(const RandomizerAlgorithm& algo, size_t& period);
+
+	std::shared_ptr<const ByteVector> sequence_ptr;
+	const uint8_t* sequence;
+	size_t sequence_period;
+	bool msb_first;
+};
+
 }; // namespace suo 
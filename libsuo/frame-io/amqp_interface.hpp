@@ -7,6 +7,7 @@
 #include <chrono>
 
 #include "suo.hpp"
+#include "misc/event_loop.hpp"
 
 #include <amqpcpp.h>
 #include <amqpcpp/linux_tcp.h>
@@ -30,8 +31,9 @@ public:
 
 	};
 
-	explicit AMQPInterface(const Config& conf = Config());
+	explicit AMQPInterface(const Config& conf = Config(), EventLoop& loop = EventLoop::getDefault());
 	~AMQPInterface();
+	/* Send AMQP heartbeats */
 	void tick(suo::Timestamp now);
 
 	void sinkFrame(const Frame& frame, Timestamp timestamp);
@@ -39,7 +41,7 @@ public:
 
 private:
 	Config conf;
-	std::set<int> fds;
+	EventLoop& loop;
 	AMQP::TcpConnection connection;
 	AMQP::TcpChannel channel;
 
@@ -3,6 +3,7 @@
 
 
 #include "zmq_interface.hpp"
+#include <sys/epoll.h>
 #include "registry.hpp"
 
 using namespace std;
@@ -91,8 +92,9 @@ ZMQSubscriber::Config::Config() {
 }
 
 
-ZMQSubscriber::ZMQSubscriber(const ZMQSubscriber::Config& conf):
-	conf(conf)
+ZMQSubscriber::ZMQSubscriber(const ZMQSubscriber::Config& conf, EventLoop& loop):
+	conf(conf),
+	loop(loop)
 {
 	if (conf.bind.empty() && conf.connect.empty())
 		throw SuoError("Either bind or connect adddres was provided!");
@@ -116,18 +118,67 @@ ZMQSubscriber::ZMQSubscriber(const ZMQSubscriber::Config& conf):
 	zmq_socket.setsockopt(ZMQ_SUBSCRIBE, conf.subscribe);
 #endif
 
+	/* Register the socket's notification fd to the event loop.
+	 * The fd only signals that socket state has changed so the socket needs to be drained. */
+#if CPPZMQ_VERSION >= 40700
+	socket_fd = zmq_socket.get(zmq::sockopt::fd);
+#else
+	socket_fd = zmq_socket.getsockopt<int>(ZMQ_FD);
+#endif
+	loop.add(socket_fd, EPOLLIN, [this](int fd, uint32_t events) {
+		(void)fd;
+		(void)events;
+		drainSocket();
+	});
 }
 
 
 ZMQSubscriber::~ZMQSubscriber()
 {
+	loop.remove(socket_fd);
 	zmq_socket.close();
 }
 
 
+void ZMQSubscriber::drainSocket()
+{
+	size_t queued = frame_queue.size();
+
+	while (1) {
+#if CPPZMQ_VERSION >= 40700
+		int events = zmq_socket.get(zmq::sockopt::events);
+#else
+		int events = zmq_socket.getsockopt<int>(ZMQ_EVENTS);
+#endif
+		if ((events & ZMQ_POLLIN) == 0)
+			break;
+
+		Frame frame;
+		int ret = 0;
+		switch (conf.msg_format) {
+		case ZMQMessageFormat::StructuredBinary:
+			ret = suo_zmq_recv_frame(zmq_socket, frame, zmq::recv_flags::dontwait);
+			break;
+		case ZMQMessageFormat::RawBinary:
+			ret = suo_zmq_recv_frame_raw(zmq_socket, frame, zmq::recv_flags::dontwait);
+			break;
+		case ZMQMessageFormat::JSON:
+			ret = suo_zmq_recv_frame_json(zmq_socket, frame, zmq::recv_flags::dontwait);
+			break;
+		}
+		if (ret == 1)
+			frame_queue.push(std::move(frame));
+	}
+
+	if (frame_queue.size() > queued)
+		frameAvailable.emit();
+}
+
+
 void ZMQSubscriber::reset()
 {
 	/* Flush possible queued frames */
+	frame_queue = std::queue<Frame>();
 	zmq::message_t msg;
 #if CPPZMQ_VERSION >= 40700
 	zmq_socket.set(zmq::sockopt::rcvtimeo, 500); // [ms]
@@ -147,18 +198,14 @@ void ZMQSubscriber::sourceFrame(Frame& frame, Timestamp now)
 {
 	(void)now; // Not used since protocol stack doesn't run here
 
-	int ret;
+	/* Normally the event loop has already queued the frames but check the socket
+	 * in case the main loop doesn't poll the event loop. */
+	if (frame_queue.empty())
+		drainSocket();
 
-	switch (conf.msg_format) {
-	case ZMQMessageFormat::StructuredBinary:
-		ret = suo_zmq_recv_frame(zmq_socket, frame, zmq::recv_flags::dontwait);
-		break;
-	case ZMQMessageFormat::RawBinary:
-		ret = suo_zmq_recv_frame_raw(zmq_socket, frame, zmq::recv_flags::dontwait);
-		break;
-	case ZMQMessageFormat::JSON:
-		ret = suo_zmq_recv_frame_json(zmq_socket, frame, zmq::recv_flags::dontwait);
-		break;
+	if (frame_queue.empty() == false) {
+		frame = std::move(frame_queue.front());
+		frame_queue.pop();
 	}
 #if 0
 	if (ret == 1) {
@@ -249,9 +296,10 @@ void suo::suo_zmq_send_frame_raw(zmq::socket_t& sock, const Frame& frame, zmq::s
 
 void suo::suo_zmq_send_frame_json(zmq::socket_t& sock, const Frame& frame, zmq::send_flags zmq_flags) {
 
-	/* Dump JSON object to string and send it */
+	/* Dump JSON object to a reusable buffer and send it */
+	thread_local string json_string;
 	try {
-		string json_string = frame.serialize_to_json();
+		frame.serialize_to_json(json_string);
 		sock.send(zmq::buffer(json_string), zmq::send_flags::dontwait);
 	}
 	catch (const zmq::error_t& e) {
@@ -383,7 +431,7 @@ int suo::suo_zmq_recv_frame_json(zmq::socket_t& sock, Frame& frame, zmq::recv_fl
 	}
 
 	try {
-		frame = Frame::deserialize_from_json(msg.to_string());
+		Frame::deserialize_from_json(msg.to_string_view(), frame);
 		return 1;
 	}
 	catch (const std::exception& e) {
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "suo.hpp"
+#include "misc/event_loop.hpp"
 #include <zmq.hpp>
+#include <queue>
 
 
 namespace suo
@@ -101,7 +103,7 @@ public:
 		std::string subscribe;
 	};
 
-	explicit ZMQSubscriber(const Config& conf = Config());
+	explicit ZMQSubscriber(const Config& conf = Config(), EventLoop& loop = EventLoop::getDefault());
 	~ZMQSubscriber();
 
 	/* */
@@ -110,10 +112,18 @@ public:
 	/* */
 	void sourceFrame(Frame& frame, Timestamp now);
 
+	/* Emitted from the event loop when new frame(s) have been queued */
+	Port<> frameAvailable;
 
 private:
 	Config conf;
+	EventLoop& loop;
 	zmq::socket_t zmq_socket;
+	int socket_fd;
+	std::queue<Frame> frame_queue;
+
+	/* Read all pending messages from the socket to the frame queue */
+	void drainSocket();
 };
 
 
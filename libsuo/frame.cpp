@@ -6,6 +6,8 @@
 
 #include <iomanip>
 #include <ctime>
+#include <charconv>
+#include <cmath>
 
 
 using namespace suo;
@@ -120,92 +122,394 @@ SymbolGenerator Frame::generateSymbols(Frame& frame) {
 }*/
 
 
-Frame Frame::deserialize_from_json(const std::string& json_string) {
+/*
+ * Lookup table for formatting bytes as lowercase hexadecimal
+ */
+static const char hex_table[513] =
+	"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+	"202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+	"404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+	"606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+	"808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+	"a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+	"c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+	"e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
 
-	try {
+/*
+ * Lookup table for parsing hexadecimal characters. Invalid characters are marked with 0xFF.
+ */
+struct HexDecodeTable {
+	uint8_t t[256];
+	constexpr HexDecodeTable() : t() {
+		for (unsigned int i = 0; i < 256; i++)
+			t[i] = 0xFF;
+		for (unsigned int i = 0; i < 10; i++)
+			t['0' + i] = i;
+		for (unsigned int i = 0; i < 6; i++) {
+			t['a' + i] = 10 + i;
+			t['A' + i] = 10 + i;
+		}
+	}
+};
+static constexpr HexDecodeTable hex_decode;
 
-		/* Parse string to dict */
-		json dict = json::parse(json_string);
-		if (dict.is_object() == false)
-			throw SuoError("Received JSON string was not a dict/object.");
 
-		Frame frame;
-		frame.id = dict.value("id", 0);
+/*
+ * Append an integer to the output buffer
+ */
+template<typename T>
+static inline void json_write_integer(std::string& out, T value) {
+	char buf[24];
+	auto res = std::to_chars(buf, buf + sizeof(buf), value);
+	out.append(buf, res.ptr - buf);
+}
 
-		if (dict.contains("timestamp")) {
-			frame.timestamp = dict["timestamp"];
-			frame.flags |= Frame::Flags::has_timestamp;
+/*
+ * Append a floating point number to the output buffer.
+ * Uses the same Grisu2 implementation as nlohmann::json::dump() so the output is identical.
+ */
+static inline void json_write_float(std::string& out, double value) {
+	if (!std::isfinite(value)) {
+		out.append("null", 4);
+		return;
+	}
+	char buf[64];
+	char* end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), value);
+	out.append(buf, end - buf);
+}
+
+/*
+ * Append a quoted and escaped string to the output buffer.
+ * Escaping rules follow nlohmann::json::dump() and invalid UTF-8 is rejected.
+ */
+static void json_write_string(std::string& out, const std::string& str) {
+	out.push_back('"');
+
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(str.data());
+	const uint8_t* end = p + str.size();
+	const uint8_t* run = p; // Start of the current run of characters not requiring escaping
+
+	while (p < end) {
+		uint8_t c = *p;
+
+		if (c >= 0x20 && c != '"' && c != '\\' && c < 0x80) {
+			p++;
+			continue;
 		}
 
-		if (dict.contains("metadata")) {
-			auto metas = dict["metadata"];
-			if (metas.is_object() == false)
-				throw SuoError("JSON metadata is not a dict/object.");
-			for (auto json_meta : metas.items()) {
-				auto value = json_meta.value();
-				if (value.is_string())
-					frame.setMetadata(json_meta.key(), value.get<std::string>());
-				else if (value.is_number_integer())
-					frame.setMetadata(json_meta.key(), value.get<int>());
-				else if (value.is_number_unsigned())
-					frame.setMetadata(json_meta.key(), value.get<unsigned int>());
-				else if (value.is_number_float())
-					frame.setMetadata(json_meta.key(), value.get<float>());
-				else
-					throw SuoError("Unsupport metadata datype in JSON message");
+		if (c >= 0x80) {
+			/* Validate the UTF-8 sequence (overlong forms and surrogates are rejected) */
+			size_t len;
+			uint8_t lo = 0x80, hi = 0xBF;
+			if (c >= 0xC2 && c <= 0xDF) len = 2;
+			else if (c >= 0xE0 && c <= 0xEF) {
+				len = 3;
+				if (c == 0xE0) lo = 0xA0;
+				else if (c == 0xED) hi = 0x9F;
+			}
+			else if (c >= 0xF0 && c <= 0xF4) {
+				len = 4;
+				if (c == 0xF0) lo = 0x90;
+				else if (c == 0xF4) hi = 0x8F;
 			}
+			else
+				throw SuoError("Invalid UTF-8 byte 0x%02x in JSON string", c);
+
+			if ((size_t)(end - p) < len || p[1] < lo || p[1] > hi)
+				throw SuoError("Invalid UTF-8 byte sequence in JSON string");
+			for (size_t i = 2; i < len; i++)
+				if ((p[i] & 0xC0) != 0x80)
+					throw SuoError("Invalid UTF-8 byte sequence in JSON string");
+			p += len;
+			continue;
+		}
+
+		/* Flush the pending run and write escape sequence */
+		out.append(reinterpret_cast<const char*>(run), p - run);
+		switch (c) {
+		case '\b': out.append("\\b", 2); break;
+		case '\t': out.append("\\t", 2); break;
+		case '\n': out.append("\\n", 2); break;
+		case '\f': out.append("\\f", 2); break;
+		case '\r': out.append("\\r", 2); break;
+		case '"': out.append("\\\"", 2); break;
+		case '\\': out.append("\\\\", 2); break;
+		default: {
+			char esc[6] = { '\\', 'u', '0', '0', hex_table[2 * c], hex_table[2 * c + 1] };
+			out.append(esc, 6);
 		}
+		}
+		run = ++p;
+	}
+
+	out.append(reinterpret_cast<const char*>(run), p - run);
+	out.push_back('"');
+}
+
 
-		if (dict.contains("data")) {
+/*
+ * SAX event handler for nlohmann's parser which fills the frame fields directly
+ * without building the intermediate JSON DOM.
+ */
+class FrameSAXHandler
+{
+public:
+	using number_integer_t = json::number_integer_t;
+	using number_unsigned_t = json::number_unsigned_t;
+	using number_float_t = json::number_float_t;
+	using string_t = json::string_t;
+	using binary_t = json::binary_t;
+
+	FrameSAXHandler(Frame& frame) :
+		has_data(false), frame(frame), depth(0), skip_depth(0), field(Field::none) { }
+
+	bool null() {
+		return scalar([&]() { return false; }, [&](uint64_t&) { return false; });
+	}
 
-			/* Parse ASCII hexadecimal string to bytes */
-			string hex_string = dict["data"];
-			if (hex_string.size() % 2 != 0)
-				throw SuoError("JSON data field has odd number of characters!");
+	bool boolean(bool val) {
+		return scalar([&]() { return false; }, [&](uint64_t& v) { v = val; return true; });
+	}
+
+	bool number_integer(number_integer_t val) {
+		return scalar(
+			[&]() { frame.setMetadata(meta_key, static_cast<int>(val)); return true; },
+			[&](uint64_t& v) { v = static_cast<uint64_t>(val); return true; });
+	}
 
-			size_t frame_len = hex_string.size() / 2;
-			frame.data.resize(frame_len);
-			for (size_t i = 0; i < frame_len; i++)
-				frame.data[i] = stoul(hex_string.substr(2 * i, 2), nullptr, 16);
+	bool number_unsigned(number_unsigned_t val) {
+		return scalar(
+			[&]() { frame.setMetadata(meta_key, static_cast<int>(val)); return true; },
+			[&](uint64_t& v) { v = static_cast<uint64_t>(val); return true; });
+	}
+
+	bool number_float(number_float_t val, const string_t&) {
+		return scalar(
+			[&]() { frame.setMetadata(meta_key, static_cast<float>(val)); return true; },
+			[&](uint64_t& v) { v = static_cast<uint64_t>(static_cast<int64_t>(val)); return true; });
+	}
+
+	bool string(string_t& val) {
+		if (skip_depth)
+			return true;
+		if (depth == 2 && field == Field::metadata) {
+			frame.setMetadata(meta_key, std::move(val));
+			return true;
 		}
-		else {
-			frame.flags |= Frame::Flags::control_frame;
+		if (depth == 1 && field == Field::data) {
+			parse_hex(val);
+			return true;
 		}
+		if (depth == 1 && field == Field::other)
+			return true;
+		return type_error();
+	}
 
-		return frame;
+	bool binary(binary_t&) {
+		return type_error();
 	}
-	catch (const json::exception& e) { //basic_json::type_error 
-		throw SuoError("Failed to parse JSON dictionary. %s", e.what());
+
+	bool start_object(std::size_t) {
+		if (skip_depth) {
+			skip_depth++;
+			return true;
+		}
+		if (depth == 0) {
+			depth = 1;
+			return true;
+		}
+		if (depth == 1 && field == Field::metadata) {
+			frame.metadata.clear();
+			depth = 2;
+			return true;
+		}
+		return start_nested();
 	}
-}
 
+	bool end_object() {
+		if (skip_depth) {
+			skip_depth--;
+			return true;
+		}
+		depth--;
+		return true;
+	}
 
-string Frame::serialize_to_json() const {
+	bool start_array(std::size_t) {
+		if (skip_depth) {
+			skip_depth++;
+			return true;
+		}
+		if (depth == 0)
+			throw SuoError("Received JSON string was not a dict/object.");
+		return start_nested();
+	}
 
-	json dict = json::object();
-	dict["id"] = id;
+	bool end_array() {
+		skip_depth--;
+		return true;
+	}
 
-	/* Format metadata to a JSON dictionary */
-	json meta_dict = json::object();
-	for (auto metadata : metadata) {
-		std::visit([&](auto const& a) {
-			meta_dict[metadata.first] = a;
-		}, metadata.second);
+	bool key(string_t& val) {
+		if (skip_depth)
+			return true;
+		if (depth == 2) {
+			meta_key = std::move(val);
+			return true;
+		}
+		if (val == "id") field = Field::id;
+		else if (val == "timestamp") field = Field::timestamp;
+		else if (val == "metadata") field = Field::metadata;
+		else if (val == "data") field = Field::data;
+		else field = Field::other;
+		return true;
 	}
-	dict["metadata"] = meta_dict;
 
+	bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) {
+		throw SuoError("Failed to parse JSON dictionary. %s", ex.what());
+	}
+
+	bool has_data;
+
+private:
+	enum class Field { none, id, timestamp, metadata, data, other };
+
+	/* Dispatch a scalar value to metadata handler or to a numeric top-level field */
+	template<typename MetaFunc, typename NumFunc>
+	bool scalar(MetaFunc meta_func, NumFunc num_func) {
+		if (skip_depth)
+			return true;
+		if (depth == 2) {
+			if (meta_func() == false)
+				throw SuoError("Unsupport metadata datype in JSON message");
+			return true;
+		}
+		if (depth == 0)
+			throw SuoError("Received JSON string was not a dict/object.");
 
-	if (1) // flags & Frame::Flags::has_timestamp)
-		dict["timestamp"] = timestamp;
+		uint64_t v;
+		switch (field) {
+		case Field::id:
+			if (num_func(v) == false)
+				return type_error();
+			frame.id = static_cast<uint32_t>(v);
+			return true;
+		case Field::timestamp:
+			if (num_func(v) == false)
+				return type_error();
+			frame.timestamp = v;
+			frame.flags |= Frame::Flags::has_timestamp;
+			return true;
+		case Field::other:
+			return true;
+		default:
+			return type_error();
+		}
+	}
+
+	/* Nested object or array inside a top-level field */
+	bool start_nested() {
+		if (depth == 2)
+			throw SuoError("Unsupport metadata datype in JSON message");
+		if (field != Field::other)
+			return type_error();
+		skip_depth = 1; // Skip unknown fields
+		return true;
+	}
+
+	bool type_error() {
+		if (field == Field::metadata)
+			throw SuoError("JSON metadata is not a dict/object.");
+		throw SuoError("Failed to parse JSON dictionary. Invalid type for a field");
+	}
+
+	void parse_hex(const std::string& hex_string) {
+		if (hex_string.size() % 2 != 0)
+			throw SuoError("JSON data field has odd number of characters!");
+
+		size_t frame_len = hex_string.size() / 2;
+		frame.data.resize(frame_len);
+		const uint8_t* s = reinterpret_cast<const uint8_t*>(hex_string.data());
+		for (size_t i = 0; i < frame_len; i++) {
+			uint8_t hi = hex_decode.t[s[2 * i]], lo = hex_decode.t[s[2 * i + 1]];
+			if ((hi | lo) & 0xF0)
+				throw SuoError("JSON data field has invalid character at %lu", 2 * i);
+			frame.data[i] = (hi << 4) | lo;
+		}
+		has_data = true;
+	}
 
-	/* Format binary data to hexadecimal string */
-	stringstream hexa_stream;
-	hexa_stream << setfill('0') << hex;
-	for (size_t i = 0; i < data.size(); i++)
-		hexa_stream << setw(2) << (int)data[i];
-	dict["data"] = hexa_stream.str();
+	Frame& frame;
+	unsigned int depth, skip_depth;
+	Field field;
+	std::string meta_key;
+};
 
-	return dict.dump();
+
+void Frame::deserialize_from_json(std::string_view json_string, Frame& frame) {
+	frame.clear();
+
+	FrameSAXHandler handler(frame);
+	json::sax_parse(json_string.begin(), json_string.end(), &handler);
+
+	if (handler.has_data == false)
+		frame.flags |= Frame::Flags::control_frame;
+}
+
+
+Frame Frame::deserialize_from_json(std::string_view json_string) {
+	Frame frame;
+	deserialize_from_json(json_string, frame);
+	return frame;
+}
+
+
+void Frame::serialize_to_json(std::string& out) const {
+
+	out.clear();
+	out.reserve(2 * data.size() + 32 * metadata.size() + 64);
+
+	/* Keys are written in sorted order to match output of nlohmann::json */
+	out.append("{\"data\":\"", 9);
+	size_t offset = out.size();
+	out.resize(offset + 2 * data.size());
+	char* hex = &out[offset];
+	for (size_t i = 0; i < data.size(); i++) {
+		hex[2 * i] = hex_table[2 * data[i]];
+		hex[2 * i + 1] = hex_table[2 * data[i] + 1];
+	}
+
+	out.append("\",\"id\":", 7);
+	json_write_integer(out, id);
+
+	/* Format metadata to a JSON dictionary */
+	out.append(",\"metadata\":{", 13);
+	bool first = true;
+	for (const auto& meta : metadata) {
+		if (!first)
+			out.push_back(',');
+		first = false;
+		json_write_string(out, meta.first);
+		out.push_back(':');
+		std::visit([&](auto const& a) {
+			using T = std::decay_t<decltype(a)>;
+			if constexpr (std::is_same_v<T, std::string>)
+				json_write_string(out, a);
+			else if constexpr (std::is_floating_point_v<T>)
+				json_write_float(out, a);
+			else
+				json_write_integer(out, a);
+		}, meta.second);
+	}
+
+	out.append("},\"timestamp\":", 14);
+	json_write_integer(out, timestamp);
+	out.push_back('}');
 }
 
 
+string Frame::serialize_to_json() const {
+	string out;
+	serialize_to_json(out);
+	return out;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <variant>
 #include <map>
@@ -79,9 +80,18 @@ public:
 
 	//static SymbolGenerator generateSymbols(Frame& frame);
 
-	static Frame deserialize_from_json(const std::string& json_string);
+	/* Parse a frame from a JSON string. */
+	static Frame deserialize_from_json(std::string_view json_string);
+
+	/* Parse a frame from a JSON string into an existing frame object to reuse its allocations. */
+	static void deserialize_from_json(std::string_view json_string, Frame& frame);
+
+	/* Serialize the frame to a JSON string. */
 	std::string serialize_to_json() const;
 
+	/* Serialize the frame to JSON into a reusable output buffer. */
+	void serialize_to_json(std::string& out) const;
+
 };
 
 
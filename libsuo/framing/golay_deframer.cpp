@@ -24,8 +24,15 @@ GolayDeframer::Config::Config() {
 
 GolayDeframer::GolayDeframer(const Config& conf) :
 	conf(conf),
-	rs(RSCodes::CCSDS_RS_255_223)
+	rs(RSCodes::CCSDS_RS_255_223),
+	randomizer(RandomizerAlgorithms::CCSDS_TM),
+	derandomizer(randomizer),
 //	viterbi(ConvolutionCodes::CCSDS_1_2_7)
+	metric_labels(MetricsRegistry::getDefault().blockLabels("GolayDeframer")),
+	metric_syncs(MetricsRegistry::getDefault().counter("suo_syncs_total", "Number of detected syncwords", metric_labels)),
+	metric_frames(MetricsRegistry::getDefault().counter("suo_frames_total", "Number of received frames", metric_labels)),
+	metric_golay_failures(MetricsRegistry::getDefault().counter("suo_golay_failures_total", "Number of uncorrectable Golay coded headers", metric_labels)),
+	metric_rs_failures(MetricsRegistry::getDefault().counter("suo_rs_failures_total", "Number of uncorrectable Reed-Solomon codewords", metric_labels))
 {
 	if (conf.syncword_len > 8 * sizeof(conf.syncword))
 		throw SuoError("Unrealistic syncword length");
@@ -39,6 +46,8 @@ void GolayDeframer::reset()
 	syncDetected.emit(false, 0);
 	state = Syncing;
 	latest_bits = 0;
+	soft_header = false;
+	derandomize = false;
 	frame.clear();
 	frame_len = 0;
 	coded_len = 0;
@@ -67,6 +76,7 @@ void GolayDeframer::findSyncword(Symbol bit, Timestamp now)
 	/* Syncword found, start saving bits when next bit arrives */
 	bit_idx = 0;
 	latest_bits = 0;
+	soft_header = false;
 
 	// Clear the frame and log metadata
 	frame.clear();
@@ -76,6 +86,7 @@ void GolayDeframer::findSyncword(Symbol bit, Timestamp now)
 	frame.setMetadata("sync_timestamp", now);
 	frame.setMetadata("sync_utc_timestamp", getCurrentISOTimestamp());
 
+	metric_syncs.inc();
 	syncDetected.emit(true, now);
 	state = ReceivingHeader;
 }
@@ -100,11 +111,13 @@ void GolayDeframer::receiveHeader(Symbol bit, Timestamp now)
 
 	// Decode Golay code
 	coded_len = latest_bits;
-	int golay_errors = decode_golay24(&coded_len);
+	int golay_errors = soft_header ? decode_golay24_soft(header_llrs, &coded_len) : decode_golay24(&coded_len);
 	if (golay_errors < 0)
 	{
 		cerr << "Golay decode failed! " << endl;
-		// TODO: Increase some counter
+		metric_golay_failures.inc();
+		frame.setMetadata("decode_failure", string("golay"));
+		frameFailed.emit(frame, now);
 		reset();
 		return;
 	}
@@ -137,6 +150,10 @@ void GolayDeframer::receiveHeader(Symbol bit, Timestamp now)
 		return;
 	}
 
+	// U482C mode signals the randomizer in the header
+	derandomize = conf.legacy_mode ? ((coded_len & GolayFramer::use_randomizer_flag) != 0) : conf.use_randomizer;
+	derandomizer.reset();
+
 	// Clear for next state
 	latest_bits = 0;
 	bit_idx = 0;
@@ -153,7 +170,8 @@ void GolayDeframer::receivePayload(Symbol bit, Timestamp now)
 	if (++bit_idx < 8)
 		return;
 
-	frame.data.push_back(latest_bits);
+	/* Derandomize the bytes as they arrive */
+	frame.data.push_back(derandomize ? derandomizer.next(latest_bits) : latest_bits);
 	latest_bits = 0;
 	bit_idx = 0;
 
@@ -172,14 +190,6 @@ void GolayDeframer::receivePayload(Symbol bit, Timestamp now)
 		return;
 	}
 
-	//if // U482C mode
-	if (conf.legacy_mode ? ((coded_len & GolayFramer::use_randomizer_flag) != 0) : conf.use_randomizer)
-	{
-		/* Scrambler the bytes */
-		for (size_t i = 0; i < frame.data.size(); i++)
-			frame.data[i] ^= ccsds_tm_randomizer[i];
-	}
-
 	if (conf.legacy_mode ? ((coded_len & GolayFramer::use_reed_solomon_flag) != 0) : conf.use_rs)
 	{
 		/* Decode Reed-Solomon */
@@ -191,14 +201,17 @@ void GolayDeframer::receivePayload(Symbol bit, Timestamp now)
 			frame.setMetadata("rs_bits_corrected", bits_corrected);
 		}
 		catch (SuoError& e) {
-			// TODO: Increment some statistics
 			cerr << "Reed-Solomon failed: " << e.what() << endl;
+			metric_rs_failures.inc();
+			frame.setMetadata("decode_failure", string("rs"));
+			frameFailed.emit(frame, now);
 			reset();
 			return;
 		}
 	}
 
 	syncDetected.emit(false, now);
+	metric_frames.inc();
 	sinkFrame.emit(frame, now);
 
 	reset();
@@ -230,6 +243,15 @@ void GolayDeframer::sinkSymbols(const SymbolVector& symbols, Timestamp now)
 		sinkSymbol(symbol, now);
 }
 
+void GolayDeframer::sinkSoftSymbol(SoftSymbol symbol, Timestamp now)
+{
+	if (state == ReceivingHeader) {
+		header_llrs[bit_idx] = symbol;
+		soft_header = true;
+	}
+	sinkSymbol(symbol > 0, now);
+}
+
 void GolayDeframer::setMetadata(const std::string& name, const MetadataValue& value) {
 	frame.setMetadata(name, value);
 }
@@ -3,7 +3,9 @@
 #include <memory>
 
 #include "suo.hpp"
+#include "misc/metrics.hpp"
 #include "coding/reed_solomon.hpp"
+#include "coding/randomizer.hpp"
 //#include "coding/viterbi_decoder.hpp"
 
 namespace suo
@@ -59,11 +61,20 @@ public:
 	void sinkSymbol(Symbol bit, Timestamp time);
 	void sinkSymbols(const SymbolVector& symbols, Timestamp timestamp);
 
+	/*
+	 * Soft bit input (positive meaning '1'). The header is decoded with
+	 * the soft decision Golay decoder and the rest are sliced to hard bits.
+	 */
+	void sinkSoftSymbol(SoftSymbol symbol, Timestamp time);
+
 	void setMetadata(const std::string& name, const MetadataValue& value);
 
 	Port<const Frame&, Timestamp> sinkFrame;
 	Port<bool, Timestamp> syncDetected;
 
+	/* Synchronized frames which failed to decode. Metadata field "decode_failure" tells the reason. */
+	Port<const Frame&, Timestamp> frameFailed;
+
 private:
 
 	void findSyncword(Symbol bit, Timestamp now);
@@ -73,6 +84,7 @@ private:
 	/* Configuration */
 	Config conf;
 	ReedSolomon rs;
+	Randomizer randomizer;
 	//ViterbiDecoder viterbi;
 	uint64_t syncword_mask;
 
@@ -80,11 +92,22 @@ private:
 	State state;
 	unsigned int latest_bits;
 	unsigned int bit_idx;
+	float header_llrs[24];
+	bool soft_header;
+	bool derandomize;
+	Randomizer::Stream derandomizer;
 
 	// Frame
 	Frame frame;
 	unsigned int frame_len;
 	unsigned int coded_len;
+
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_syncs;
+	Counter& metric_frames;
+	Counter& metric_golay_failures;
+	Counter& metric_rs_failures;
 };
 
 }; // namespace suo
@@ -27,6 +27,7 @@ GolayFramer::Config::Config() {
 GolayFramer::GolayFramer(const Config& conf) :
 	conf(conf),
 	rs(RSCodes::CCSDS_RS_255_223),
+	randomizer(RandomizerAlgorithms::CCSDS_TM),
 	conv_encoder(ConvolutionCodes::CCSDS_1_2_7)
 {
 	if (conf.syncword_len > 8 * sizeof(conf.syncword))
@@ -71,10 +72,8 @@ SymbolGenerator GolayFramer::symbolGenerator(Frame& frame)
 		rs.encode(data_buffer);
 
 	/* Scrambler the bytes */
-	if (conf.use_randomizer) {
-		for (size_t i = 0; i < data_buffer.size(); i++)
-			data_buffer[i] ^= ccsds_tm_randomizer[i];
-	}
+	if (conf.use_randomizer)
+		randomizer.apply(data_buffer);
 
 	/* Output Golay coded length (+coding flags) */
 	uint32_t coded_len = data_buffer.size();
@@ -91,8 +90,8 @@ SymbolGenerator GolayFramer::symbolGenerator(Frame& frame)
 	/* Viterbi decode all bits */
 	if (conf.use_viterbi) {
 		SymbolVector viterbi_buffer;
-		viterbi_buffer.reserve(2 * frame.size());
-		//conv_encoder.sourceSymbols(viterbi_buffer);
+		conv_encoder.reset();
+		conv_encoder.encode(data_buffer.data(), data_buffer.size(), viterbi_buffer);
 		co_yield viterbi_buffer;
 	}
 	else {
@@ -2,6 +2,7 @@
 
 #include "suo.hpp"
 #include "coding/reed_solomon.hpp"
+#include "coding/randomizer.hpp"
 #include "coding/convolutional_encoder.hpp"
 
 
@@ -70,6 +71,7 @@ private:
 	/* Configuration */
 	Config conf;
 	ReedSolomon rs;
+	Randomizer randomizer;
 	ConvolutionalEncoder conv_encoder;
 
 	/* Framer state */
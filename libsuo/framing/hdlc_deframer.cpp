@@ -1,6 +1,8 @@
 #include <iostream>
+#include <algorithm> // min
 
 #include "framing/hdlc_deframer.hpp"
+#include "coding/crc_generic.hpp"
 #include "registry.hpp"
 
 using namespace std;
@@ -10,21 +12,70 @@ using namespace suo;
 #define START_BYTE 0x7E
 
 
+/*
+ * Transition tables for processing 8 decoded bits at once.
+ * Indexed by the count of consecutive ones before the byte and the byte (MSB first).
+ *   hunt: Flag search. Event is a flag (6 ones followed by a zero). Counter saturates at 7.
+ *   frame: Destuffing inside a frame. Zeros after 5 ones are dropped and
+ *          the event is a sixth one (end flag or abort).
+ */
+struct HDLCStep {
+	bool event;       // Byte has to be processed bit-by-bit
+	uint8_t counter;  // Consecutive ones after the byte
+	uint8_t nbits;    // Number of data bits after destuffing
+	uint8_t bits;     // Destuffed data bits, LSB aligned
+};
+
+struct HDLCTables {
+	HDLCStep hunt[8][256];
+	HDLCStep frame[6][256];
+};
+
+static constexpr HDLCTables generate_tables()
+{
+	HDLCTables tables = {};
+	for (unsigned int byte = 0; byte < 256; byte++) {
+		for (unsigned int counter = 0; counter < 8; counter++) {
+			HDLCStep& step = tables.hunt[counter][byte];
+			unsigned int c = counter;
+			for (int i = 7; i >= 0; i--) {
+				const unsigned int bit = (byte >> i) & 1;
+				if (c == 6 && bit == 0)
+					step.event = true;
+				c = bit ? std::min(c + 1, 7u) : 0;
+			}
+			step.counter = c;
+		}
+
+		for (unsigned int counter = 0; counter < 6; counter++) {
+			HDLCStep& step = tables.frame[counter][byte];
+			unsigned int c = counter;
+			for (int i = 7; i >= 0; i--) {
+				const unsigned int bit = (byte >> i) & 1;
+				if (c >= 5) {
+					if (bit)
+						step.event = true;
+					c = 0; // Stuffing bit
+				}
+				else {
+					c = bit ? (c + 1) : 0;
+					step.bits = (step.bits << 1) | bit;
+					step.nbits++;
+				}
+			}
+			step.counter = c;
+		}
+	}
+	return tables;
+}
+
+static constexpr HDLCTables tables = generate_tables();
+
+
 uint16_t suo::crc16_ccitt(const uint8_t* data_p, size_t length)
 {
-	uint16_t crc = 0xFFFF;
-	const uint16_t crc16_table[] = {
-		0x0000, 0x1081, 0x2102, 0x3183, 0x4204, 0x5285, 0x6306, 0x7387,
-		0x8408, 0x9489, 0xa50a, 0xb58b,	0xc60c, 0xd68d, 0xe70e, 0xf78f
-	};
-	
-	while (length--) {
-		crc = (crc >> 4) ^ crc16_table[(crc & 0xf) ^ (*data_p & 0xf)];
-		crc = (crc >> 4) ^ crc16_table[(crc & 0xf) ^ (*data_p++ >> 4)];
-	}
-	
-	crc = (crc << 8) | ((crc >> 8) & 0xff); // Swap endianness
-	return (~crc);
+	const uint16_t value = CRCDigest<CRCAlgorithms::CRC16_HDLC>::calculate(data_p, length);
+	return (value << 8) | (value >> 8); // Swap endianness
 }
 
 
@@ -39,7 +90,11 @@ HDLCDeframer::Config::Config() {
 
 HDLCDeframer::HDLCDeframer(const Config& conf) :
 	conf(conf),
-	frame(256)
+	frame(256),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("HDLCDeframer")),
+	metric_syncs(MetricsRegistry::getDefault().counter("suo_syncs_total", "Number of detected syncwords", metric_labels)),
+	metric_frames(MetricsRegistry::getDefault().counter("suo_frames_total", "Number of received frames", metric_labels)),
+	metric_crc_failures(MetricsRegistry::getDefault().counter("suo_crc_failures_total", "Number of frames dropped due to CRC mismatch", metric_labels))
 {
 	if (conf.minimum_frame_length < 4)
 		throw SuoError("HDLCDeframer: minimum_frame_length < 4");
@@ -68,15 +123,12 @@ void HDLCDeframer::reset()
 Symbol HDLCDeframer::descramble_bit(Symbol bit)
 {
 	if (conf.mode == G3RUH) {
-		/* G3RUH descrambler */
-		unsigned int lfsr_hi = (scrambler & 1);
-		unsigned int lfsr_lo = ((scrambler >> 5) & 1);
+		/* G3RUH descrambler (1 + x^12 + x^17). Latest received bit is the LSB. */
+		unsigned int lfsr_hi = ((scrambler >> 16) & 1);
+		unsigned int lfsr_lo = ((scrambler >> 11) & 1);
 		unsigned int descrambled_bit = (bit ^ (lfsr_hi ^ lfsr_lo)) != 0;
 
-		scrambler = (scrambler >> 1);
-
-		if (bit != 0)
-			scrambler |= 0x00010000;
+		scrambler = ((scrambler << 1) | (bit != 0)) & 0x1FFFF;
 
 		bit = descrambled_bit;
 
@@ -108,6 +160,7 @@ void HDLCDeframer::findStartFlag(Symbol bit, Timestamp now)
 	// More than 5 continious 1's have been received.
 	if (stuffing_counter == 6 && bit == 0) { 
 		// Start/end flag!
+		metric_syncs.inc();
 		syncDetected.emit(true, now);
 
 		state = ReceivingFrame;
@@ -153,11 +206,18 @@ void HDLCDeframer::receivingFrame(Symbol bit, Timestamp now) {
 
 				if (received_crc == calculated_crc) {
 					frame.data.resize(len); // Remove CRC
+					metric_frames.inc();
 					sinkFrame.emit(frame, now);
 				}
+				else {
+					metric_crc_failures.inc();
+					frame.setMetadata("decode_failure", string("crc"));
+					frameFailed.emit(frame, now);
+				}
 
 			}
 			else {
+				metric_frames.inc();
 				sinkFrame.emit(frame, now);
 			}
 
@@ -237,10 +297,85 @@ void HDLCDeframer::sinkSymbol(Symbol bit, Timestamp now)
 
 }
 
+void HDLCDeframer::sinkByte(uint8_t byte, Timestamp now)
+{
+	/* Descramble and NRZI decode all 8 bits without committing the state yet */
+	uint32_t next_scrambler = scrambler;
+	Symbol next_last_bit = last_bit;
+	uint8_t bits = byte;
+	if (conf.mode == G3RUH) {
+		const uint32_t window = (scrambler << 8) | byte;
+		bits = byte ^ (window >> 12) ^ (window >> 17);
+		next_scrambler = window & 0x1FFFF;
+	}
+	if (conf.mode == G3RUH || conf.mode == NRZI) {
+		next_last_bit = bits & 1;
+		bits = ~(bits ^ (((last_bit << 8) | bits) >> 1));
+	}
+
+	switch (state)
+	{
+	case WaitingSync: {
+		const HDLCStep& step = tables.hunt[min(stuffing_counter, 7u)][bits];
+		if (step.event)
+			break;
+		stuffing_counter = step.counter;
+		scrambler = next_scrambler;
+		last_bit = next_last_bit;
+		return;
+	}
+	case ReceivingFrame: {
+		const HDLCStep& step = tables.frame[stuffing_counter][bits];
+		const bool completes_byte = (bit_idx + step.nbits >= 8);
+		if (step.event || (completes_byte && frame.data.size() >= conf.maximum_frame_length))
+			break;
+
+		shift = (shift << step.nbits) | step.bits;
+		bit_idx += step.nbits;
+		if (completes_byte) {
+			bit_idx -= 8;
+			frame.data.push_back(shift >> bit_idx);
+			shift &= (1 << bit_idx) - 1;
+		}
+		stuffing_counter = step.counter;
+		scrambler = next_scrambler;
+		last_bit = next_last_bit;
+		return;
+	}
+	case Trailer:
+		if (stuffing_counter >= 5 || silence_counter + 8 >= conf.minimum_silence)
+			break;
+		silence_counter += 8;
+		stuffing_counter = bits & 1;
+		scrambler = next_scrambler;
+		last_bit = next_last_bit;
+		return;
+	default:
+		break;
+	}
+
+	/* Something happens inside this byte so process it bit-by-bit */
+	for (int i = 7; i >= 0; i--)
+		sinkSymbol((byte >> i) & 1, now);
+}
+
 void HDLCDeframer::sinkSymbols(const SymbolVector& symbols, Timestamp now)
 {
-	for (const Symbol& symbol : symbols)
-		sinkSymbol(symbol, now);
+	const size_t whole_bytes = symbols.size() & ~7;
+	for (size_t i = 0; i < whole_bytes; i += 8) {
+		uint8_t byte = 0;
+		for (size_t j = 0; j < 8; j++)
+			byte = (byte << 1) | (symbols[i + j] & 1);
+		sinkByte(byte, now);
+	}
+	for (size_t i = whole_bytes; i < symbols.size(); i++)
+		sinkSymbol(symbols[i], now);
+}
+
+void HDLCDeframer::sinkBytes(const ByteVector& bytes, Timestamp now)
+{
+	for (uint8_t byte : bytes)
+		sinkByte(byte, now);
 }
 
 Block* createHDLCDeframer(const Kwargs& args)
@@ -2,12 +2,13 @@
 
 #include <memory>
 #include "suo.hpp"
+#include "misc/metrics.hpp"
 
 namespace suo
 {
 
 /*
- * CRC-16 CCITT algo
+ * HDLC frame check sequence (CRC-16/X25) with bytes in transmission order
  */
 extern uint16_t crc16_ccitt(const uint8_t* data_p, size_t length);
 
@@ -19,6 +20,13 @@ enum HDLCMode {
 
 
 /*
+ * HDLC deframer with NRZ-I and G3RUH line coding.
+ *
+ * sinkSymbol processes the bits one at a time. sinkSymbols and sinkBytes
+ * process 8 bits per step: The descrambling and NRZ-I decoding are done with
+ * word-wide XORs and the flag detection and bit destuffing with precomputed
+ * transition tables. Bytes containing a flag, an abort or a state change are
+ * passed to the bit-by-bit state machine so the output is identical.
  */
 class HDLCDeframer : public Block
 {
@@ -60,11 +68,18 @@ public:
 	void sinkSymbol(Symbol bit, Timestamp now);
 	void sinkSymbols(const SymbolVector& symbols, Timestamp now);
 
+	/* Packed input bits, MSB first */
+	void sinkBytes(const ByteVector& bytes, Timestamp now);
+
 	Port<const Frame&, Timestamp> sinkFrame;
 	Port<bool, Timestamp> syncDetected;
 
+	/* Synchronized frames which failed to decode. Metadata field "decode_failure" tells the reason. */
+	Port<const Frame&, Timestamp> frameFailed;
+
 private:
 	Symbol descramble_bit(Symbol bit);
+	void sinkByte(uint8_t byte, Timestamp now);
 	void findStartFlag(Symbol bit, Timestamp now);
 	void receivingFrame(Symbol bit, Timestamp now);
 	void receivingTrailer(Symbol bit, Timestamp now);
@@ -84,6 +99,11 @@ private:
 	uint32_t scrambler;
 	unsigned int stuffing_counter;
 
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_syncs;
+	Counter& metric_frames;
+	Counter& metric_crc_failures;
 };
 
 }; // namespace suo
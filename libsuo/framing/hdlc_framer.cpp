@@ -14,17 +14,76 @@ using namespace std;
 const uint8_t START_FLAG = 0x7E;
 
 
+/*
+ * Lookup tables generated at compile time:
+ *   stuffing: Bits of a byte (MSB first) with a zero inserted after every 5 consecutive ones.
+ *             Indexed by the number of ones before the byte (0-4) and the byte.
+ *   nrzi: NRZ-I encoded byte when the previous output bit was 0. A zero flips the state.
+ */
+struct HDLCStuffing {
+	uint16_t bits;    // Output bits, LSB aligned
+	uint8_t nbits;    // Number of output bits (8-10)
+	uint8_t counter;  // Consecutive ones after the byte
+};
+
+struct HDLCFramerTables {
+	HDLCStuffing stuffing[5][256];
+	uint8_t nrzi[256];
+};
+
+static constexpr HDLCFramerTables generate_tables()
+{
+	HDLCFramerTables tables = {};
+	for (unsigned int byte = 0; byte < 256; byte++) {
+		for (unsigned int counter = 0; counter < 5; counter++) {
+			HDLCStuffing& entry = tables.stuffing[counter][byte];
+			unsigned int c = counter;
+			for (int i = 7; i >= 0; i--) {
+				const unsigned int bit = (byte >> i) & 1;
+				entry.bits = (entry.bits << 1) | bit;
+				entry.nbits++;
+				c = bit ? (c + 1) : 0;
+				if (c == 5) {
+					entry.bits <<= 1;
+					entry.nbits++;
+					c = 0;
+				}
+			}
+			entry.counter = c;
+		}
+
+		unsigned int state = 0, out = 0;
+		for (int i = 7; i >= 0; i--) {
+			if (((byte >> i) & 1) == 0)
+				state ^= 1;
+			out = (out << 1) | state;
+		}
+		tables.nrzi[byte] = out;
+	}
+	return tables;
+}
+
+static constexpr HDLCFramerTables tables = generate_tables();
+
+
 HDLCFramer::Config::Config() {
 	mode = G3RUH;
 	preamble_length = 4;
 	trailer_length = 4;
+	append_crc = true;
 }
 
 HDLCFramer::HDLCFramer(const Config& conf) :
 	conf(conf)
 {
-	reset();
+	/* The preamble always starts from the reset state */
 	reset_scrambler();
+	for (unsigned int i = 0; i < conf.preamble_length; i++)
+		preamble.push_back(line_code(START_FLAG));
+	preamble_last_bit = last_bit;
+	preamble_scrambler = scrambler;
+
+	reset();
 }
 
 
@@ -32,6 +91,8 @@ void HDLCFramer::reset_scrambler() {
 	last_bit = 0;
 	scrambler = 0;
 	stuffing_counter = 0;
+	bit_buffer = 0;
+	bit_buffer_len = 0;
 }
 
 void HDLCFramer::reset() {
@@ -42,44 +103,73 @@ void HDLCFramer::reset() {
 }
 
 
-Symbol HDLCFramer::scramble_bit(Symbol bit) {
+uint8_t HDLCFramer::line_code(uint8_t byte) {
+
+	if (conf.mode == G3RUH || conf.mode == NRZI) {
+		// NRZ-I encoding: If one, state remains. If zero, state flips.
+		byte = tables.nrzi[byte] ^ (last_bit ? 0xFF : 0x00);
+		last_bit = byte & 1;
+	}
 
 	if (conf.mode == G3RUH) {
-		
-		// NRZ-I encoding
-		if (bit == 1) { // If one, state remains
-			bit = last_bit;
-		}
-		else { // If zero, state flips
-			bit = !last_bit;
-			last_bit = bit;
-		}
+		// G3RUH scrambling (1 + x^12 + x^17). Taps are always in the previous bytes.
+		// Latest output bit is the LSB of the register.
+		byte ^= (scrambler >> 4) ^ (scrambler >> 9);
+		scrambler = ((scrambler << 8) | byte) & 0x1FFFF;
+	}
 
-		// G3RUH scrambling
-		unsigned int lfsr_hi = (scrambler & 1);
-		unsigned int lfsr_lo = ((scrambler >> 5) & 1);
-		unsigned int scr_bit = (bit ^ (lfsr_hi ^ lfsr_lo)) != 0;
+	return byte;
+}
+
+
+void HDLCFramer::push_bits(uint32_t bits, unsigned int nbits, ByteVector& packed) {
+	bit_buffer = (bit_buffer << nbits) | bits;
+	bit_buffer_len += nbits;
+	while (bit_buffer_len >= 8) {
+		bit_buffer_len -= 8;
+		packed.push_back(line_code(bit_buffer >> bit_buffer_len));
+	}
+	bit_buffer &= (1 << bit_buffer_len) - 1;
+}
 
-		scrambler = (scrambler >> 1);
 
-		if (scr_bit)
-			scrambler |= 0x00010000;
+size_t HDLCFramer::encodeFrame(const Frame& frame, ByteVector& packed) {
+	packed.clear();
+	packed.reserve(conf.preamble_length + conf.trailer_length + frame.size() * 10 / 8 + 4);
 
-		return scr_bit;
+	/* Precomputed preamble */
+	reset_scrambler();
+	packed.insert(packed.end(), preamble.begin(), preamble.end());
+	last_bit = preamble_last_bit;
+	scrambler = preamble_scrambler;
+
+	/* Bit stuffed frame data */
+	for (Byte byte : frame.data) {
+		const HDLCStuffing& entry = tables.stuffing[stuffing_counter][byte];
+		push_bits(entry.bits, entry.nbits, packed);
+		stuffing_counter = entry.counter;
 	}
-	else if (conf.mode == NRZI) {
-		// NRZ-I encoding
-		if (bit == 1) { // If one, state remains
-			bit = last_bit;
-		}
-		else { // If zero, state flips
-			bit = !last_bit;
-			last_bit = bit;
+
+	/* Append CRC to end of frame */
+	if (conf.append_crc) {
+		uint16_t crc = crc16_ccitt(&frame.data[0], frame.size());
+		for (Byte byte : { (Byte)(crc >> 8), (Byte)crc }) {
+			const HDLCStuffing& entry = tables.stuffing[stuffing_counter][byte];
+			push_bits(entry.bits, entry.nbits, packed);
+			stuffing_counter = entry.counter;
 		}
-		return bit;
 	}
-	else
-		return bit;
+
+	/* Trailer flags */
+	for (unsigned int i = 0; i < conf.trailer_length; i++)
+		push_bits(START_FLAG, 8, packed);
+
+	/* Pad the last partial byte */
+	const size_t nbits = 8 * packed.size() + bit_buffer_len;
+	if (bit_buffer_len > 0)
+		push_bits(0, 8 - bit_buffer_len, packed);
+
+	return nbits;
 }
 
 
@@ -94,56 +184,17 @@ SymbolGenerator HDLCFramer::generateSymbols(Timestamp now) {
 
 SymbolGenerator HDLCFramer::symbolGenerator() // Frame& frame
 {
+	/* Encode the whole burst and yield it as one block */
+	ByteVector packed;
+	const size_t nbits = encodeFrame(frame, packed);
 
-	/* Append CRC to end of frame */
-	if (conf.append_crc) {
-		uint16_t crc = crc16_ccitt(&frame.data[0], frame.size());
-		frame.data.push_back((crc >> 8) & 0xff);
-		frame.data.push_back((crc >> 0) & 0xff);
-	}
-
-	reset_scrambler();
-
-	/* Generate preamble symbols/bits */
-	for (unsigned int i = 0; i < conf.preamble_length; i++) {
-		Byte byte = START_FLAG;
-		for (size_t bi = 8; bi > 0; bi--) {
-			Symbol bit = (byte & 0x80) != 0;
-			byte <<= 1;
-			co_yield scramble_bit(bit);
-		}
-	}
-
-	/* Generate symbols from the frame data */
-	for (Byte byte: frame.data)
-	{
-		// Foreach bit
-		for (size_t bi = 8; bi > 0; bi--)
-		{
-			Symbol bit = (byte & 0x80) != 0;
-			byte <<= 1;
-
-			if (stuffing_counter >= 5) {
-				stuffing_counter = 0;
-				co_yield scramble_bit(0);
-			}
-			stuffing_counter = bit ? (stuffing_counter + 1) : 0;
-
-			co_yield scramble_bit(bit);
-		}
-	}
+	SymbolVector symbols;
+	symbols.resize(nbits);
+	for (size_t i = 0; i < nbits; i++)
+		symbols[i] = (packed[i / 8] >> (7 - (i % 8))) & 1;
 
+	co_yield symbols;
 
-	/* Generate trailer symbols/bits */
-	for (unsigned int i = 0; i < conf.trailer_length; i++) {
-		Byte byte = START_FLAG;
-		for (size_t bi = 8; bi > 0; bi--) {
-			Symbol bit = (byte & 0x80) != 0;
-			byte <<= 1;
-			co_yield scramble_bit(bit);
-		}
-	}
-	
 	frame.clear();
 }
 
@@ -9,6 +9,12 @@ namespace suo
 {
 
 /*
+ * HDLC framer with NRZ-I and G3RUH line coding.
+ *
+ * The whole burst is encoded a byte at a time: Bit stuffing and NRZ-I
+ * use lookup tables and the G3RUH scrambler is applied to 8 bits at once.
+ * The preamble flags are always encoded from the reset state so they are
+ * precomputed in the constructor. The symbols are yielded as one block.
  */
 class HDLCFramer : public Block
 {
@@ -41,6 +47,12 @@ public:
 	/* */
 	SymbolGenerator generateSymbols(Timestamp now);
 
+	/*
+	 * Encode a frame to a packed bit stream (MSB first) including the flags.
+	 * CRC is appended if enabled. Returns the number of bits.
+	 */
+	size_t encodeFrame(const Frame& frame, ByteVector& packed);
+
 	/* */
 	Port<Frame&, Timestamp> sourceFrame;
 
@@ -49,19 +61,29 @@ private:
 	/* Coroutine for geneting symbol sequence */
 	SymbolGenerator symbolGenerator();
 
-	/* Bit scrambler */
-	Symbol scramble_bit(Symbol bit);
+	/* Line coding (NRZ-I + G3RUH) for 8 bits */
+	uint8_t line_code(uint8_t byte);
 	void reset_scrambler();
 
+	/* Append bits to the packed output. Line coded a byte at a time. */
+	void push_bits(uint32_t bits, unsigned int nbits, ByteVector& packed);
+
 	/* Configuration */
 	Config conf;
 
 	/* State */
 	Symbol last_bit;
-	unsigned int scrambler;
+	uint32_t scrambler;
 	unsigned int stuffing_counter;
+	uint32_t bit_buffer;
+	unsigned int bit_buffer_len;
 	SymbolGenerator symbol_gen;
 
+	/* Precomputed line coded preamble and the line coder state after it */
+	ByteVector preamble;
+	Symbol preamble_last_bit;
+	uint32_t preamble_scrambler;
+
 	Frame frame;
 };
 
@@ -16,7 +16,10 @@ SyncwordDeframer::Config::Config() {
 }
 
 SyncwordDeframer::SyncwordDeframer(const Config& conf) :
-	conf(conf)
+	conf(conf),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("SyncwordDeframer")),
+	metric_syncs(MetricsRegistry::getDefault().counter("suo_syncs_total", "Number of detected syncwords", metric_labels)),
+	metric_frames(MetricsRegistry::getDefault().counter("suo_frames_total", "Number of received frames", metric_labels))
 {
 	if (conf.syncword_len > 8 * sizeof(conf.syncword))
 		throw SuoError("Unrealistic syncword length");
@@ -58,6 +61,7 @@ void SyncwordDeframer::findSyncword(Symbol bit, Timestamp now) {
 	frame.setMetadata("sync_timestamp", now);
 	frame.setMetadata("sync_utc_timestamp", getCurrentISOTimestamp());
 
+	metric_syncs.inc();
 	syncDetected.emit(true, now);
 	state = ReceivingHeader;
 }
@@ -97,6 +101,7 @@ void SyncwordDeframer::receivePayload(Symbol bit, Timestamp now) {
 
 	syncDetected.emit(false, now);
 
+	metric_frames.inc();
 	sinkFrame.emit(frame, now);
 
 	frame.clear();
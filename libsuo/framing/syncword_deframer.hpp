@@ -1,6 +1,7 @@
 #pragma once
 
 #include "suo.hpp"
+#include "misc/metrics.hpp"
 
 namespace suo {
 
@@ -70,6 +71,11 @@ private:
 	unsigned int bit_idx;
 	Frame frame;
 	unsigned int frame_len;
+
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_syncs;
+	Counter& metric_frames;
 };
 
 } // namespace suo
@@ -187,6 +187,7 @@ void SymbolGenerator::sourceSymbols(SymbolVector& out)
 
 	/* Try to produce new samples */
 	try {
+		TraceScope trace("SymbolGenerator::resume");
 		promise.out = &out;
 
 		while (out.full() == false && coro_handle.done() == false) {
@@ -412,6 +413,7 @@ void SampleGenerator::sourceSamples(SampleVector& out)
 
 	/* Try to produce new samples */
 	try {
+		TraceScope trace("SampleGenerator::resume");
 		promise.out = &out;
 
 		while (out.full() == false && coro_handle.done() == false) {
@@ -477,10 +479,10 @@ SymbolGenerator SymbolGeneratorFromCallback::generator()
 }
 
 
-SymbolGenerator generator_from_vector(const SymbolVector& symbols) {
+SymbolGenerator suo::generator_from_vector(const SymbolVector& symbols) {
 	co_yield symbols;
 }
 
-SampleGenerator generator_from_vector(const SampleVector& samples) {
+SampleGenerator suo::generator_from_vector(const SampleVector& samples) {
 	co_yield samples;
 }
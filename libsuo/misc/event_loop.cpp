@@ -0,0 +1,104 @@
+#include "misc/event_loop.hpp"
+#include "suo.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+using namespace std;
+using namespace suo;
+
+
+EventLoop::EventLoop()
+{
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd < 0)
+		throw SuoError("EventLoop: epoll_create1 failed: %s", strerror(errno));
+
+	wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wakeup_fd < 0)
+		throw SuoError("EventLoop: eventfd failed: %s", strerror(errno));
+
+	add(wakeup_fd, EPOLLIN, [this](int fd, uint32_t events) {
+		(void)events;
+		uint64_t value;
+		while (read(fd, &value, sizeof(value)) > 0);
+	});
+}
+
+
+EventLoop::~EventLoop()
+{
+	close(wakeup_fd);
+	close(epoll_fd);
+}
+
+
+void EventLoop::add(int fd, uint32_t events, Callback callback)
+{
+	struct epoll_event ev;
+	ev.events = events;
+	ev.data.fd = fd;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+		throw SuoError("EventLoop: Failed to add fd %d: %s", fd, strerror(errno));
+	callbacks[fd] = callback;
+}
+
+
+void EventLoop::modify(int fd, uint32_t events)
+{
+	struct epoll_event ev;
+	ev.events = events;
+	ev.data.fd = fd;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0)
+		throw SuoError("EventLoop: Failed to modify fd %d: %s", fd, strerror(errno));
+}
+
+
+void EventLoop::remove(int fd)
+{
+	if (callbacks.erase(fd) == 0)
+		return;
+	/* The fd might be already closed in which case the kernel has removed it automatically */
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+
+int EventLoop::poll(int timeout_ms)
+{
+	struct epoll_event events[16];
+
+	int n = epoll_wait(epoll_fd, events, 16, timeout_ms);
+	if (n < 0) {
+		if (errno == EINTR)
+			return 0;
+		throw SuoError("EventLoop: epoll_wait failed: %s", strerror(errno));
+	}
+
+	for (int i = 0; i < n; i++) {
+		/* Callback might have been removed by an earlier callback during this round */
+		auto it = callbacks.find(events[i].data.fd);
+		if (it == callbacks.end())
+			continue;
+		Callback callback = it->second; // Copy in case the callback removes itself
+		callback(events[i].data.fd, events[i].events);
+	}
+
+	return n;
+}
+
+
+void EventLoop::wakeup()
+{
+	uint64_t value = 1;
+	if (write(wakeup_fd, &value, sizeof(value)) < 0) { }
+}
+
+
+EventLoop& EventLoop::getDefault()
+{
+	static EventLoop loop;
+	return loop;
+}
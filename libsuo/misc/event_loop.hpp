@@ -0,0 +1,60 @@
+#pragma once
+
+#include <map>
+#include <functional>
+#include <cstdint>
+
+namespace suo {
+
+/*
+ * Simple epoll based event loop.
+ * Control and frame I/O blocks register their file descriptors here so that
+ * the main loop (e.g. SoapySDRIO) can react to incoming data immediately
+ * instead of polling every block once per RX buffer.
+ */
+class EventLoop
+{
+public:
+	/* Callback called with the file descriptor and the triggered epoll event flags */
+	typedef std::function<void(int fd, uint32_t events)> Callback;
+
+	EventLoop();
+	~EventLoop();
+
+	EventLoop(const EventLoop&) = delete;
+	EventLoop& operator=(const EventLoop&) = delete;
+
+	/* Register a new file descriptor with given epoll event mask (EPOLLIN, EPOLLOUT...) */
+	void add(int fd, uint32_t events, Callback callback);
+
+	/* Change the event mask of an already registered file descriptor */
+	void modify(int fd, uint32_t events);
+
+	/* Unregister a file descriptor. Safe to call from inside a callback. */
+	void remove(int fd);
+
+	/* Is the file descriptor registered */
+	bool contains(int fd) const { return callbacks.find(fd) != callbacks.end(); }
+
+	/*
+	 * Wait for events and dispatch the callbacks.
+	 * Args:
+	 *   timeout_ms: Maximum time to wait in milliseconds. 0 returns immediately and -1 waits forever.
+	 * Returns:
+	 *   Number of dispatched events
+	 */
+	int poll(int timeout_ms = 0);
+
+	/* Interrupt a blocking poll() call. Can be called from any thread. */
+	void wakeup();
+
+	/* Shared event loop for the whole process */
+	static EventLoop& getDefault();
+
+private:
+	int epoll_fd;
+	int wakeup_fd;
+	std::map<int, Callback> callbacks;
+};
+
+}; // namespace suo
@@ -0,0 +1,303 @@
+#include <cmath>
+#include <cstring>
+
+#include "misc/gaussian_noise.hpp"
+
+#ifdef SUO_NOISE_SIMD
+#include <immintrin.h>
+#endif
+
+/* The kernels give identical output only if no multiply-adds are fused */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+using namespace std;
+using namespace suo;
+
+
+NoiseKernel suo::noise_kernel_available() {
+#ifdef SUO_NOISE_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return NoiseKernelAVX2;
+#endif
+	return NoiseKernelScalar;
+}
+
+NoiseKernel suo::noise_kernel = suo::noise_kernel_available();
+
+
+/* Polynomial coefficients (Cephes logf, sinf and cosf) */
+static const float log_c[9] = {
+	7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f, -1.2420140846e-1f, 1.4249322787e-1f,
+	-1.6668057665e-1f, 2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f
+};
+static const float log_q1 = -2.12194440e-4f;
+static const float log_q2 = 0.693359375f;
+static const float sqrt_half = 0.707106781f;
+static const float sin_c1 = -1.6666654611e-1f;
+static const float sin_c2 = 8.3321608736e-3f;
+static const float sin_c3 = -1.9515295891e-4f;
+static const float cos_c1 = 4.166664568298827e-2f;
+static const float cos_c2 = -1.388731625493765e-3f;
+static const float cos_c3 = 2.443315711809948e-5f;
+static const float quarter_pi = 0.785398163f;
+static const float half_pi = 1.570796327f;
+static const float inv_2_24 = 1.0f / (1 << 24);
+
+
+static inline uint64_t rotl(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+/* Scalar reference kernel. Calculates exactly the same operations as the SIMD kernels. */
+static void noise_scalar(uint64_t state[4][8], Sample* out, size_t rounds, float scale, bool add) {
+	for (size_t n = 0; n < rounds; n++) {
+		for (unsigned int lane = 0; lane < 8; lane++, out++) {
+
+			/* xoshiro256++ */
+			uint64_t& s0 = state[0][lane], & s1 = state[1][lane], & s2 = state[2][lane], & s3 = state[3][lane];
+			const uint64_t w = rotl(s0 + s3, 23) + s0;
+			const uint64_t t = s1 << 17;
+			s2 ^= s0;
+			s3 ^= s1;
+			s1 ^= s2;
+			s0 ^= s3;
+			s2 ^= t;
+			s3 = rotl(s3, 45);
+
+			const uint32_t hi = w >> 32, lo = (uint32_t)w;
+
+			/* Magnitude: sqrt(-2 ln(u1)), u1 in (0, 1] */
+			const float u1 = (float)(int32_t)((hi >> 8) + 1) * inv_2_24;
+			uint32_t bits;
+			memcpy(&bits, &u1, 4);
+			int32_t e = (int32_t)(bits >> 23) - 126;
+			bits = (bits & 0x7FFFFF) | 0x3F000000;
+			float m;
+			memcpy(&m, &bits, 4);
+			float x;
+			if (m < sqrt_half) {
+				e -= 1;
+				x = (m + m) - 1.0f;
+			}
+			else {
+				x = m - 1.0f;
+			}
+			const float fe = (float)e;
+			const float z = x * x;
+			float y = log_c[0];
+			for (unsigned int i = 1; i < 9; i++)
+				y = y * x + log_c[i];
+			y = (y * x) * z;
+			y = y + log_q1 * fe;
+			y = y - 0.5f * z;
+			const float ln = (x + y) + log_q2 * fe;
+			const float r = sqrtf(ln * -2.0f);
+
+			/* Angle: uniform quadrant and uniform phase in [-pi/4, pi/4) */
+			const float phi = (float)(int32_t)(lo >> 8) * inv_2_24 * half_pi - quarter_pi;
+			const float p2 = phi * phi;
+			const float s = (((sin_c3 * p2 + sin_c2) * p2 + sin_c1) * p2) * phi + phi;
+			const float c = ((((cos_c3 * p2 + cos_c2) * p2 + cos_c1) * p2) * p2 - 0.5f * p2) + 1.0f;
+
+			float re = (lo & 1) ? s : c;
+			float im = (lo & 1) ? c : s;
+			if ((lo ^ (lo >> 1)) & 1)
+				re = -re;
+			if ((lo >> 1) & 1)
+				im = -im;
+
+			const Sample noise((r * re) * scale, (r * im) * scale);
+			*out = add ? *out + noise : noise;
+		}
+	}
+}
+
+
+#ifdef SUO_NOISE_SIMD
+
+__attribute__((target("avx2")))
+static inline __m256i rotl_avx2(__m256i x, int k) {
+	return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+}
+
+__attribute__((target("avx2")))
+static void noise_avx2(uint64_t state[4][8], Sample* out, size_t rounds, float scale, bool add) {
+
+	/* Two vectors per state word: lanes 0-3 and 4-7 */
+	__m256i s0[2], s1[2], s2[2], s3[2];
+	for (unsigned int v = 0; v < 2; v++) {
+		s0[v] = _mm256_load_si256((const __m256i*)&state[0][4 * v]);
+		s1[v] = _mm256_load_si256((const __m256i*)&state[1][4 * v]);
+		s2[v] = _mm256_load_si256((const __m256i*)&state[2][4 * v]);
+		s3[v] = _mm256_load_si256((const __m256i*)&state[3][4 * v]);
+	}
+
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i sign = _mm256_set1_epi32(0x80000000);
+	const __m256 g = _mm256_set1_ps(scale);
+
+	for (size_t n = 0; n < rounds; n++, out += 8) {
+
+		/* xoshiro256++ */
+		__m256i w[2];
+		for (unsigned int v = 0; v < 2; v++) {
+			w[v] = _mm256_add_epi64(rotl_avx2(_mm256_add_epi64(s0[v], s3[v]), 23), s0[v]);
+			const __m256i t = _mm256_slli_epi64(s1[v], 17);
+			s2[v] = _mm256_xor_si256(s2[v], s0[v]);
+			s3[v] = _mm256_xor_si256(s3[v], s1[v]);
+			s1[v] = _mm256_xor_si256(s1[v], s2[v]);
+			s0[v] = _mm256_xor_si256(s0[v], s3[v]);
+			s2[v] = _mm256_xor_si256(s2[v], t);
+			s3[v] = rotl_avx2(s3[v], 45);
+		}
+
+		/* Split the words to upper and lower halves in lane order */
+		const __m256 wa = _mm256_castsi256_ps(w[0]), wb = _mm256_castsi256_ps(w[1]);
+		const __m256i lo = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(wa, wb, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0));
+		const __m256i hi = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(wa, wb, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0));
+
+		/* Magnitude: sqrt(-2 ln(u1)), u1 in (0, 1] */
+		const __m256 u1 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_srli_epi32(hi, 8), one)), _mm256_set1_ps(inv_2_24));
+		__m256i e = _mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(u1), 23), _mm256_set1_epi32(126));
+		const __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(_mm256_castps_si256(u1), _mm256_set1_epi32(0x7FFFFF)), _mm256_set1_epi32(0x3F000000)));
+		const __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(sqrt_half), _CMP_LT_OQ);
+		e = _mm256_add_epi32(e, _mm256_castps_si256(small)); // -1 when small
+		const __m256 x = _mm256_blendv_ps(_mm256_sub_ps(m, _mm256_set1_ps(1.0f)), _mm256_sub_ps(_mm256_add_ps(m, m), _mm256_set1_ps(1.0f)), small);
+		const __m256 fe = _mm256_cvtepi32_ps(e);
+		const __m256 z = _mm256_mul_ps(x, x);
+		__m256 y = _mm256_set1_ps(log_c[0]);
+		for (unsigned int i = 1; i < 9; i++)
+			y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(log_c[i]));
+		y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+		y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_set1_ps(log_q1), fe));
+		y = _mm256_sub_ps(y, _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+		const __m256 ln = _mm256_add_ps(_mm256_add_ps(x, y), _mm256_mul_ps(_mm256_set1_ps(log_q2), fe));
+		const __m256 r = _mm256_sqrt_ps(_mm256_mul_ps(ln, _mm256_set1_ps(-2.0f)));
+
+		/* Angle: uniform quadrant and uniform phase in [-pi/4, pi/4) */
+		const __m256 phi = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(lo, 8)), _mm256_set1_ps(inv_2_24)), _mm256_set1_ps(half_pi)), _mm256_set1_ps(quarter_pi));
+		const __m256 p2 = _mm256_mul_ps(phi, phi);
+		__m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(sin_c3), p2), _mm256_set1_ps(sin_c2));
+		s = _mm256_add_ps(_mm256_mul_ps(s, p2), _mm256_set1_ps(sin_c1));
+		s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, p2), phi), phi);
+		__m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(cos_c3), p2), _mm256_set1_ps(cos_c2));
+		c = _mm256_add_ps(_mm256_mul_ps(c, p2), _mm256_set1_ps(cos_c1));
+		c = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(c, p2), p2), _mm256_mul_ps(_mm256_set1_ps(0.5f), p2)), _mm256_set1_ps(1.0f));
+
+		const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(lo, one), one));
+		__m256 re = _mm256_blendv_ps(c, s, swap);
+		__m256 im = _mm256_blendv_ps(s, c, swap);
+		re = _mm256_xor_ps(re, _mm256_castsi256_ps(_mm256_and_si256(_mm256_slli_epi32(_mm256_xor_si256(lo, _mm256_srli_epi32(lo, 1)), 31), sign)));
+		im = _mm256_xor_ps(im, _mm256_castsi256_ps(_mm256_and_si256(_mm256_slli_epi32(_mm256_srli_epi32(lo, 1), 31), sign)));
+
+		re = _mm256_mul_ps(_mm256_mul_ps(r, re), g);
+		im = _mm256_mul_ps(_mm256_mul_ps(r, im), g);
+
+		/* Interleave to complex samples */
+		const __m256 l = _mm256_unpacklo_ps(re, im), h = _mm256_unpackhi_ps(re, im);
+		__m256 out0 = _mm256_permute2f128_ps(l, h, 0x20);
+		__m256 out1 = _mm256_permute2f128_ps(l, h, 0x31);
+		float* o = reinterpret_cast<float*>(out);
+		if (add) {
+			out0 = _mm256_add_ps(_mm256_loadu_ps(o), out0);
+			out1 = _mm256_add_ps(_mm256_loadu_ps(o + 8), out1);
+		}
+		_mm256_storeu_ps(o, out0);
+		_mm256_storeu_ps(o + 8, out1);
+	}
+
+	for (unsigned int v = 0; v < 2; v++) {
+		_mm256_store_si256((__m256i*)&state[0][4 * v], s0[v]);
+		_mm256_store_si256((__m256i*)&state[1][4 * v], s1[v]);
+		_mm256_store_si256((__m256i*)&state[2][4 * v], s2[v]);
+		_mm256_store_si256((__m256i*)&state[3][4 * v], s3[v]);
+	}
+}
+
+#endif
+
+
+static void noise_rounds(uint64_t state[4][8], Sample* out, size_t rounds, float scale, bool add) {
+#ifdef SUO_NOISE_SIMD
+	if (noise_kernel == NoiseKernelAVX2) {
+		noise_avx2(state, out, rounds, scale, add);
+		return;
+	}
+#endif
+	noise_scalar(state, out, rounds, scale, add);
+}
+
+
+GaussianNoise::GaussianNoise(uint64_t _seed) {
+	seed(_seed);
+}
+
+
+void GaussianNoise::seed(uint64_t seed) {
+	/* Expand the seed with SplitMix64 */
+	for (unsigned int word = 0; word < 4; word++) {
+		for (unsigned int lane = 0; lane < 8; lane++) {
+			uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			state[word][lane] = z ^ (z >> 31);
+		}
+	}
+	leftover_len = 0;
+}
+
+
+void GaussianNoise::generate(Sample* out, size_t len, float noise_std) {
+	for (size_t i = 0; i < len; i++)
+		out[i] = 0.0f;
+	add(out, len, noise_std);
+}
+
+
+void GaussianNoise::add(Sample* samples, size_t len, float noise_std) {
+	/* Unit variance normals per component are scaled to E{|n|^2} = noise_std^2 */
+	const float scale = noise_std * (float)M_SQRT1_2;
+
+	/* Samples left from the previous call */
+	size_t i = 0;
+	for (; i < len && leftover_len > 0; i++)
+		samples[i] += leftover[8 - leftover_len--] * scale;
+
+	const size_t rounds = (len - i) / 8;
+	noise_rounds(state, &samples[i], rounds, scale, true);
+	i += 8 * rounds;
+
+	if (i < len) {
+		noise_rounds(state, leftover, 1, 1.0f, false);
+		leftover_len = 8;
+		for (; i < len; i++)
+			samples[i] += leftover[8 - leftover_len--] * scale;
+	}
+}
+
+
+void GaussianNoise::generate(SampleVector& samples, size_t len, float noise_std) {
+	samples.resize(len);
+	generate(samples.data(), len, noise_std);
+}
+
+
+void GaussianNoise::add(SampleVector& samples, float noise_std) {
+	add(samples.data(), samples.size(), noise_std);
+}
+
+
+float GaussianNoise::esn0ToStd(float esn0, float samples_per_symbol, float signal_power) {
+	/* Es = signal_power * samples_per_symbol and N0 = noise power per sample */
+	return sqrtf(signal_power * samples_per_symbol / powf(10.0f, esn0 / 10.0f));
+}
+
+
+void GaussianNoise::addEsN0(SampleVector& samples, float esn0, float samples_per_symbol, float signal_power) {
+	add(samples, esn0ToStd(esn0, samples_per_symbol, signal_power));
+}
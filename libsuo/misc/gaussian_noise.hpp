@@ -0,0 +1,78 @@
+#pragma once
+
+#include "suo.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SUO_NOISE_SIMD
+#endif
+
+namespace suo
+{
+
+/* Instruction set used by the noise generator */
+enum NoiseKernel {
+	NoiseKernelScalar = 0,
+	NoiseKernelAVX2 = 1,
+};
+
+/* Kernel used by GaussianNoise. Initialized by CPU feature detection. */
+extern NoiseKernel noise_kernel;
+
+/* Best kernel supported by the CPU */
+NoiseKernel noise_kernel_available();
+
+
+/*
+ * Fast complex Gaussian noise generator for channel simulations.
+ *
+ * Eight interleaved xoshiro256++ generators produce one 64-bit word per
+ * complex sample. The upper half gives the magnitude and the lower half the
+ * angle for the Box-Muller transform, which is evaluated with polynomial
+ * log, sin and cos approximations (relative error < 1e-6) eight samples at a time.
+ *
+ * The kernels calculate exactly the same operations, so the output depends
+ * only on the seed and not on the kernel or on how the output is split to buffers.
+ */
+class GaussianNoise
+{
+public:
+	explicit GaussianNoise(uint64_t seed = 0);
+
+	/* Reset the generator state from a seed */
+	void seed(uint64_t seed);
+
+	/* Write len noise samples with E{|n|^2} = noise_std^2 to the buffer */
+	void generate(Sample* out, size_t len, float noise_std);
+
+	/* Add noise with E{|n|^2} = noise_std^2 to the buffer */
+	void add(Sample* samples, size_t len, float noise_std);
+
+	void generate(SampleVector& samples, size_t len, float noise_std);
+	void add(SampleVector& samples, float noise_std);
+
+	/*
+	 * Add noise to the buffer at given Es/N0.
+	 * Args:
+	 *   samples: Signal samples
+	 *   esn0: Symbol energy to noise density ratio in dB
+	 *   samples_per_symbol: Sample rate divided by the symbol rate
+	 *   signal_power: Average power of the signal samples
+	 */
+	void addEsN0(SampleVector& samples, float esn0, float samples_per_symbol, float signal_power = 1.0f);
+
+	/* Noise standard deviation per complex sample for given Es/N0 (dB) */
+	static float esn0ToStd(float esn0, float samples_per_symbol, float signal_power = 1.0f);
+
+private:
+	/* Generate one round of unit power samples to the output. Returns number of samples. */
+	size_t generateRound(Sample* out);
+
+	/* xoshiro256++ state: state[word][lane] */
+	alignas(32) uint64_t state[4][8];
+
+	/* Samples left over from the latest round */
+	Sample leftover[8];
+	unsigned int leftover_len;
+};
+
+}; // namespace suo
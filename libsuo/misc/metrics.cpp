@@ -0,0 +1,261 @@
+#include "metrics.hpp"
+#include "suo.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <charconv>
+#include <fstream>
+#include <limits>
+
+using namespace std;
+using namespace suo;
+
+
+std::atomic<bool> suo::metrics_enabled{false};
+std::atomic<unsigned int> suo::metrics_next_shard{0};
+
+
+uint64_t Counter::value() const {
+	uint64_t sum = 0;
+	for (const Shard& shard: shards)
+		sum += shard.value.load(memory_order_relaxed);
+	return sum;
+}
+
+
+Histogram::Histogram(const std::vector<double>& bounds) :
+	upper_bounds(bounds)
+{
+	for (size_t i = 1; i < upper_bounds.size(); i++)
+		if (upper_bounds[i] <= upper_bounds[i - 1])
+			throw SuoError("Histogram: Bucket bounds must be strictly increasing");
+
+	for (Shard& shard: shards) {
+		// Last bucket is the +Inf bucket
+		shard.buckets.reset(new atomic<uint64_t>[upper_bounds.size() + 1]);
+		for (size_t i = 0; i <= upper_bounds.size(); i++)
+			shard.buckets[i].store(0, memory_order_relaxed);
+	}
+}
+
+
+void Histogram::record(double value) {
+	Shard& shard = shards[metrics_shard()];
+
+	// Number of buckets is small so a linear search is the fastest
+	size_t i = 0;
+	while (i < upper_bounds.size() && value > upper_bounds[i])
+		i++;
+
+	shard.buckets[i].fetch_add(1, memory_order_relaxed);
+	shard.sum.fetch_add(value, memory_order_relaxed);
+}
+
+
+Histogram::Snapshot Histogram::snapshot() const {
+	Snapshot snap;
+	snap.buckets.resize(upper_bounds.size() + 1, 0);
+	snap.sum = 0.0;
+
+	for (const Shard& shard: shards) {
+		for (size_t i = 0; i <= upper_bounds.size(); i++)
+			snap.buckets[i] += shard.buckets[i].load(memory_order_relaxed);
+		snap.sum += shard.sum.load(memory_order_relaxed);
+	}
+
+	// Convert to cumulative counts
+	for (size_t i = 1; i < snap.buckets.size(); i++)
+		snap.buckets[i] += snap.buckets[i - 1];
+	snap.count = snap.buckets.back();
+
+	return snap;
+}
+
+
+std::vector<double> Histogram::exponentialBuckets(double start, double factor, unsigned int count) {
+	if (start <= 0.0 || factor <= 1.0)
+		throw SuoError("Histogram: Invalid exponential bucket parameters");
+	vector<double> bounds(count);
+	for (unsigned int i = 0; i < count; i++) {
+		bounds[i] = start;
+		start *= factor;
+	}
+	return bounds;
+}
+
+
+const std::vector<double>& MetricsRegistry::defaultTimeBuckets() {
+	static const vector<double> buckets = Histogram::exponentialBuckets(1e3, 2.0, 15);
+	return buckets;
+}
+
+
+MetricsRegistry::Family& MetricsRegistry::getFamily(const std::string& name, const std::string& help, const char* type) {
+	Family& family = families[name];
+	if (family.type.empty()) {
+		family.help = help;
+		family.type = type;
+	}
+	else if (family.type != type)
+		throw SuoError("Metric %s already registered as a %s", name.c_str(), family.type.c_str());
+	return family;
+}
+
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+	lock_guard<std::mutex> lock(mutex);
+	Family& family = getFamily(name, help, "counter");
+	unique_ptr<Counter>& c = family.counters[labels];
+	if (!c)
+		c.reset(new Counter());
+	return *c;
+}
+
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, const std::string& labels,
+	const std::vector<double>& bounds) {
+	lock_guard<std::mutex> lock(mutex);
+	Family& family = getFamily(name, help, "histogram");
+	if (family.histograms.empty())
+		family.bounds = bounds;
+	unique_ptr<Histogram>& h = family.histograms[labels];
+	if (!h)
+		h.reset(new Histogram(family.bounds));
+	return *h;
+}
+
+
+MetricLabels MetricsRegistry::blockLabels(const std::string& block_name) {
+	lock_guard<std::mutex> lock(mutex);
+	unsigned int instance = instances[block_name]++;
+	return MetricLabels(this, "block=\"" + block_name + "\",instance=\"" + to_string(instance) + "\"");
+}
+
+
+void MetricsRegistry::remove(const std::string& labels) {
+	lock_guard<std::mutex> lock(mutex);
+	for (auto iter = families.begin(); iter != families.end(); ) {
+		Family& family = iter->second;
+		family.counters.erase(labels);
+		family.histograms.erase(labels);
+		if (family.counters.empty() && family.histograms.empty())
+			iter = families.erase(iter);
+		else
+			++iter;
+	}
+}
+
+
+MetricLabels::~MetricLabels() {
+	if (registry != nullptr)
+		registry->remove(labels);
+}
+
+
+MetricLabels::MetricLabels(MetricLabels&& other) :
+	registry(other.registry),
+	labels(std::move(other.labels))
+{
+	other.registry = nullptr;
+}
+
+
+MetricLabels& MetricLabels::operator=(MetricLabels&& other) {
+	if (this != &other) {
+		if (registry != nullptr)
+			registry->remove(labels);
+		registry = other.registry;
+		labels = std::move(other.labels);
+		other.registry = nullptr;
+	}
+	return *this;
+}
+
+
+static void format_number(std::string& out, double value) {
+	if (std::isinf(value)) {
+		out += (value > 0) ? "+Inf" : "-Inf";
+		return;
+	}
+	if (std::isnan(value)) {
+		out += "NaN";
+		return;
+	}
+	char buf[32];
+	to_chars_result res;
+	if (value == std::floor(value) && std::fabs(value) < 1e15)
+		res = to_chars(buf, buf + sizeof(buf), static_cast<int64_t>(value));
+	else
+		res = to_chars(buf, buf + sizeof(buf), value);
+	out.append(buf, res.ptr);
+}
+
+
+static void format_sample(std::string& out, const std::string& name, const std::string& labels,
+	const char* extra_label, double extra_value, double value) {
+	out += name;
+	if (!labels.empty() || extra_label != nullptr) {
+		out += '{';
+		out += labels;
+		if (extra_label != nullptr) {
+			if (!labels.empty())
+				out += ',';
+			out += extra_label;
+			out += "=\"";
+			format_number(out, extra_value);
+			out += '"';
+		}
+		out += '}';
+	}
+	out += ' ';
+	format_number(out, value);
+	out += '\n';
+}
+
+
+std::string MetricsRegistry::formatPrometheus() const {
+	lock_guard<std::mutex> lock(mutex);
+	string out;
+
+	for (const auto& [name, family]: families) {
+		out += "# HELP " + name + " " + family.help + "\n";
+		out += "# TYPE " + name + " " + family.type + "\n";
+
+		for (const auto& [labels, counter]: family.counters)
+			format_sample(out, name, labels, nullptr, 0, counter->value());
+
+		for (const auto& [labels, histogram]: family.histograms) {
+			Histogram::Snapshot snap = histogram->snapshot();
+			const vector<double>& bounds = histogram->bounds();
+			for (size_t i = 0; i < snap.buckets.size(); i++) {
+				double le = (i < bounds.size()) ? bounds[i] : numeric_limits<double>::infinity();
+				format_sample(out, name + "_bucket", labels, "le", le, snap.buckets[i]);
+			}
+			format_sample(out, name + "_sum", labels, nullptr, 0, snap.sum);
+			format_sample(out, name + "_count", labels, nullptr, 0, snap.count);
+		}
+	}
+
+	return out;
+}
+
+
+void MetricsRegistry::writePrometheusFile(const std::string& path) const {
+	string tmp_path = path + ".tmp";
+	{
+		ofstream file(tmp_path, ios::out | ios::trunc);
+		if (!file)
+			throw SuoError("Failed to open metrics file %s", tmp_path.c_str());
+		file << formatPrometheus();
+		if (!file)
+			throw SuoError("Failed to write metrics file %s", tmp_path.c_str());
+	}
+	if (rename(tmp_path.c_str(), path.c_str()) != 0)
+		throw SuoError("Failed to rename metrics file to %s", path.c_str());
+}
+
+
+MetricsRegistry& MetricsRegistry::getDefault() {
+	static MetricsRegistry registry;
+	return registry;
+}
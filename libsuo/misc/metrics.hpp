@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace suo {
+
+/*
+ * Global switch for the metrics collection.
+ * While disabled every counter update and timer costs only a single relaxed load and a branch.
+ * Enabled automatically when a MetricsExporter block is created.
+ */
+extern std::atomic<bool> metrics_enabled;
+
+/* Number of independent shards per metric. Each thread updates its own shard to avoid cache line bouncing. */
+const unsigned int metrics_shards = 16;
+extern std::atomic<unsigned int> metrics_next_shard;
+
+/* Returns the shard index assigned to the calling thread */
+inline unsigned int metrics_shard() {
+	thread_local unsigned int shard = metrics_next_shard.fetch_add(1, std::memory_order_relaxed) % metrics_shards;
+	return shard;
+}
+
+
+/*
+ * Monotonically increasing counter (e.g. number of received samples or failed CRCs)
+ */
+class Counter
+{
+public:
+	Counter() = default;
+	Counter(const Counter&) = delete;
+	Counter& operator=(const Counter&) = delete;
+
+	void inc(uint64_t n = 1) {
+		if (metrics_enabled.load(std::memory_order_relaxed))
+			shards[metrics_shard()].value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	/* Sum of all shards */
+	uint64_t value() const;
+
+private:
+	struct alignas(64) Shard {
+		std::atomic<uint64_t> value{0};
+	};
+	Shard shards[metrics_shards];
+};
+
+
+/*
+ * Histogram with fixed bucket upper bounds (e.g. processing time per buffer)
+ */
+class Histogram
+{
+public:
+	explicit Histogram(const std::vector<double>& bounds);
+	Histogram(const Histogram&) = delete;
+	Histogram& operator=(const Histogram&) = delete;
+
+	void observe(double value) {
+		if (metrics_enabled.load(std::memory_order_relaxed))
+			record(value);
+	}
+
+	/* Record a value regardless of the global switch */
+	void record(double value);
+
+	struct Snapshot {
+		std::vector<uint64_t> buckets; // Cumulative counts, last one is +Inf
+		uint64_t count;
+		double sum;
+	};
+
+	/* Sum of all shards */
+	Snapshot snapshot() const;
+
+	const std::vector<double>& bounds() const { return upper_bounds; }
+
+	/* Generate `count` bucket bounds starting from `start` and each multiplied by `factor` */
+	static std::vector<double> exponentialBuckets(double start, double factor, unsigned int count);
+
+private:
+	struct alignas(64) Shard {
+		std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+		std::atomic<double> sum{0.0};
+	};
+
+	std::vector<double> upper_bounds;
+	Shard shards[metrics_shards];
+};
+
+
+/*
+ * Record the wall time spent inside the scope to a histogram in nanoseconds.
+ * The clock is not read at all if the metrics are disabled.
+ */
+class ScopedTimer
+{
+public:
+	explicit ScopedTimer(Histogram& h) :
+		histogram(metrics_enabled.load(std::memory_order_relaxed) ? &h : nullptr)
+	{
+		if (histogram)
+			start = std::chrono::steady_clock::now();
+	}
+
+	~ScopedTimer() {
+		if (histogram) {
+			std::chrono::nanoseconds dt = std::chrono::steady_clock::now() - start;
+			histogram->record(dt.count());
+		}
+	}
+
+	ScopedTimer(const ScopedTimer&) = delete;
+	ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+	Histogram* histogram;
+	std::chrono::steady_clock::time_point start;
+};
+
+
+class MetricsRegistry;
+
+/*
+ * Labels of one block instance returned by MetricsRegistry::blockLabels().
+ * All the series created with the labels are removed from the registry when the
+ * handle is destroyed, so blocks rebuilt over and over (e.g. for every batch of a
+ * simulation) don't grow the registry. Must not outlive the registry.
+ */
+class MetricLabels
+{
+public:
+	MetricLabels() : registry(nullptr) { }
+	MetricLabels(MetricsRegistry* registry, const std::string& labels) : registry(registry), labels(labels) { }
+	~MetricLabels();
+
+	MetricLabels(MetricLabels&& other);
+	MetricLabels& operator=(MetricLabels&& other);
+	MetricLabels(const MetricLabels&) = delete;
+	MetricLabels& operator=(const MetricLabels&) = delete;
+
+	const std::string& str() const { return labels; }
+	operator const std::string&() const { return labels; }
+
+private:
+	MetricsRegistry* registry;
+	std::string labels;
+};
+
+
+/*
+ * Registry holding all the metrics of the process.
+ * Metrics are created once when blocks are constructed and updated lock-free after that.
+ * Metric names follow the Prometheus conventions and labels are given as preformatted
+ * strings such as `block="HDLCDeframer",instance="0"`.
+ */
+class MetricsRegistry
+{
+public:
+	MetricsRegistry() = default;
+	MetricsRegistry(const MetricsRegistry&) = delete;
+	MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+	/* Get or create a counter */
+	Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+
+	/* Get or create a histogram. All histograms with the same name share the bounds given on the first call. */
+	Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels = "",
+		const std::vector<double>& bounds = defaultTimeBuckets());
+
+	/* Returns label string `block="<name>",instance="<n>"` with an unique instance number for each call.
+	 * The series created with the labels live as long as the returned handle. */
+	MetricLabels blockLabels(const std::string& block_name);
+
+	/* Remove all the series with exactly the given labels */
+	void remove(const std::string& labels);
+
+	/* Format all metrics in the Prometheus text exposition format */
+	std::string formatPrometheus() const;
+
+	/* Atomically replace the given file with the current metrics (e.g. for node_exporter's textfile collector) */
+	void writePrometheusFile(const std::string& path) const;
+
+	/* Default bucket bounds for buffer processing times: 1 us ... ~16 ms */
+	static const std::vector<double>& defaultTimeBuckets();
+
+	/* Process wide default registry */
+	static MetricsRegistry& getDefault();
+
+private:
+	struct Family {
+		std::string help;
+		std::string type;
+		std::vector<double> bounds;
+		std::map<std::string, std::unique_ptr<Counter>> counters;
+		std::map<std::string, std::unique_ptr<Histogram>> histograms;
+	};
+
+	Family& getFamily(const std::string& name, const std::string& help, const char* type);
+
+	mutable std::mutex mutex;
+	std::map<std::string, Family> families;
+	std::map<std::string, unsigned int> instances;
+};
+
+}; // namespace suo
@@ -0,0 +1,71 @@
+#include "metrics_exporter.hpp"
+#include "frame-io/zmq_interface.hpp"
+#include "registry.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+MetricsExporter::Config::Config() {
+	interval = 10.0f;
+}
+
+
+MetricsExporter::MetricsExporter(const Config& conf, MetricsRegistry& registry) :
+	conf(conf),
+	registry(registry),
+	next_export(0)
+{
+	if (conf.interval <= 0.0f)
+		throw SuoError("MetricsExporter: Invalid export interval");
+
+	if (conf.zmq_bind.empty() == false) {
+		zmq_socket = zmq::socket_t(zmq_ctx, zmq::socket_type::pub);
+		zmq_socket.bind(conf.zmq_bind);
+	}
+
+	metrics_enabled = true;
+}
+
+
+MetricsExporter::~MetricsExporter() {
+	// Flush the final values so that short runs (e.g. from files) are recorded too
+	try {
+		exportMetrics();
+	}
+	catch (const exception& e) {
+		cerr << "MetricsExporter: " << e.what() << endl;
+	}
+}
+
+
+void MetricsExporter::tick(Timestamp now) {
+	if (now < next_export)
+		return;
+	next_export = now + (Timestamp)(1e9 * conf.interval);
+	exportMetrics();
+}
+
+
+void MetricsExporter::exportMetrics() {
+	if (conf.prometheus_file.empty() == false)
+		registry.writePrometheusFile(conf.prometheus_file);
+
+	if (zmq_socket) {
+		string text = registry.formatPrometheus();
+		zmq::message_t msg(text.data(), text.size());
+		try {
+			zmq_socket.send(msg, zmq::send_flags::dontwait);
+		}
+		catch (const zmq::error_t& e) {
+			cerr << "MetricsExporter: " << e.what() << endl;
+		}
+	}
+}
+
+
+Block* createMetricsExporter(const Kwargs& args) {
+	return new MetricsExporter();
+}
+
+static Registry registerMetricsExporter("MetricsExporter", &createMetricsExporter);
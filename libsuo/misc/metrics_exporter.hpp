@@ -0,0 +1,49 @@
+#pragma once
+
+#include "suo.hpp"
+#include "misc/metrics.hpp"
+#include <zmq.hpp>
+
+namespace suo {
+
+/*
+ * Block to periodically export the performance counters of all blocks.
+ * The metrics are written in the Prometheus text format to a file (for node_exporter's
+ * textfile collector) and/or published as a single ZMQ message.
+ * Creating the exporter enables the metrics collection.
+ */
+class MetricsExporter : public Block
+{
+public:
+
+	struct Config
+	{
+		Config();
+
+		/* Path of the Prometheus text file. Empty disables the file output. */
+		std::string prometheus_file;
+
+		/* ZMQ address where the metrics are published. Empty disables the ZMQ output. */
+		std::string zmq_bind;
+
+		/* Export interval in seconds */
+		float interval;
+	};
+
+	explicit MetricsExporter(const Config& conf = Config(), MetricsRegistry& registry = MetricsRegistry::getDefault());
+	~MetricsExporter();
+
+	/* Export the metrics if the export interval has passed */
+	void tick(Timestamp now);
+
+	/* Export the metrics immediately */
+	void exportMetrics();
+
+private:
+	const Config conf;
+	MetricsRegistry& registry;
+	zmq::socket_t zmq_socket;
+	Timestamp next_export;
+};
+
+}; // namespace suo
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <memory>
 #include <algorithm> // max
+#include <sys/epoll.h>
 
 #include "json.hpp"
 
@@ -17,8 +18,9 @@ PorthouseTracker::Config::Config() {
 	center_frequency = 437.5e6;
 }
 
-PorthouseTracker::PorthouseTracker(const Config& conf_) :
+PorthouseTracker::PorthouseTracker(const Config& conf_, EventLoop& loop) :
 	conf(conf_),
+	loop(loop),
 	connection(this, AMQP::Address(conf.amqp_url)),
 	channel(&connection),
 	heartbeat_interval(30)
@@ -47,8 +49,6 @@ PorthouseTracker::PorthouseTracker(const Config& conf_) :
 void PorthouseTracker::tick(Timestamp _now)
 {
 	(void)_now;
-	for (int fd : fds)
-		connection.process(fd, AMQP::readable | AMQP::writable);
 
 	// Check hearthbeat timeout
 	auto now = std::chrono::steady_clock::now();
@@ -146,10 +146,26 @@ void PorthouseTracker::monitor(AMQP::TcpConnection *connection, int fd, int flag
 	(void)connection;
 	//cout << "AMQP Monitor " << fd << " " << flags << endl;
 
-	if (flags == 0)
-		fds.erase(fd);
-	else 
-		fds.insert(fd);
+	if (flags == 0) {
+		loop.remove(fd);
+		return;
+	}
+
+	/* Register the connection fd to the event loop so that it gets processed as soon as data arrives */
+	uint32_t events = ((flags & AMQP::readable) ? EPOLLIN : 0) | ((flags & AMQP::writable) ? EPOLLOUT : 0);
+	if (loop.contains(fd)) {
+		loop.modify(fd, events);
+		return;
+	}
+
+	loop.add(fd, events, [this](int fd, uint32_t events) {
+		int flags = 0;
+		if (events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+			flags |= AMQP::readable;
+		if (events & EPOLLOUT)
+			flags |= AMQP::writable;
+		connection.process(fd, flags);
+	});
 }
 
 uint16_t PorthouseTracker::onNegotiate(AMQP::TcpConnection* connection, uint16_t interval)
@@ -7,6 +7,7 @@
 #include <chrono>
 
 #include "suo.hpp"
+#include "misc/event_loop.hpp"
 
 #include <amqpcpp.h>
 #include <amqpcpp/linux_tcp.h>
@@ -30,7 +31,8 @@ public:
 		float center_frequency;
 	};
 
-	explicit PorthouseTracker(const Config &conf = Config());
+	explicit PorthouseTracker(const Config &conf = Config(), EventLoop& loop = EventLoop::getDefault());
+	/* Send AMQP heartbeats */
 	void tick(Timestamp now);
 
 	Port<float> setUplinkFrequency;
@@ -38,7 +40,7 @@ public:
 
 private:
 	Config conf;
-	std::set<int> fds;
+	EventLoop& loop;
 	AMQP::TcpConnection connection;
 	AMQP::TcpChannel channel;
 	unsigned int heartbeat_interval;
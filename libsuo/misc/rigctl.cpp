@@ -4,6 +4,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <errno.h>
@@ -18,10 +19,11 @@ RigCtl::Config::Config() {
 	port = 4532;
 }
 
-RigCtl::RigCtl(const Config& conf) {
-	//
+RigCtl::RigCtl(const Config& conf, EventLoop& loop) :
+	loop(loop)
+{
 
-	listening_fd = socket(AF_INET, SOCK_STREAM, 0);
+	listening_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
 	if (listening_fd < 0)
 		throw runtime_error("Failed to create listening socket for rigctl");
 
@@ -37,65 +39,68 @@ RigCtl::RigCtl(const Config& conf) {
 	if (listen(listening_fd, SOMAXCONN) < 0)
 		throw runtime_error("Failed to start listening rigctl listening socket");
 
+	loop.add(listening_fd, EPOLLIN, [this](int fd, uint32_t events) {
+		(void)fd;
+		(void)events;
+		acceptClient();
+	});
 }
 
 RigCtl::~RigCtl()
 {
 	// Close all sockets
+	loop.remove(listening_fd);
 	close(listening_fd);
-	for (int fd : client_fds)
+	for (int fd : client_fds) {
+		loop.remove(fd);
 		close(fd);
+	}
 }
 
 
 void RigCtl::tick(Timestamp now) {
 	(void)now;
+	loop.poll(0);
+}
 
-	int nfds = listening_fd;
-	fd_set rset;
-	FD_ZERO(&rset);
-	FD_SET(listening_fd, &rset);
 
-	for (int fd : client_fds)
-	{
-		FD_SET(fd, &rset);
-		nfds = max(nfds, fd);
-	}
+void RigCtl::acceptClient()
+{
+	sockaddr_in client;
+	socklen_t clientSize = sizeof(client);
+	int client_fd = accept4(listening_fd, (struct sockaddr *)&client, &clientSize, SOCK_CLOEXEC);
+	if (client_fd < 0)
+		return;
+
+	client_fds.insert(client_fd);
+	loop.add(client_fd, EPOLLIN, [this](int fd, uint32_t events) {
+		(void)events;
+		receiveClient(fd);
+	});
+	cout << "Rigctl: Client " << inet_ntoa(client.sin_addr) << ":" << ntohs(client.sin_port) << " connected" << endl;
+}
 
-	struct timeval timeout = {0, 0}; // Non-blocking select
-	if (select(nfds, &rset, NULL, NULL, &timeout) > 0)
-	{
 
-		if (FD_ISSET(listening_fd, &rset))
-		{
-			sockaddr_in client;
-			socklen_t clientSize = sizeof(client);
-			int clientSocket = accept(listening_fd, (struct sockaddr *)&client, &clientSize);
-			client_fds.insert(clientSocket);
-			cout << "Rigctl: Client " << inet_ntoa(client.sin_addr) << ":" << client.sin_port << " connected" << endl;
-		}
-
-		char buffer[1024];
-
-		for (int client_fd : client_fds)
-		{
-			if (FD_ISSET(client_fd, &rset))
-			{
-				int bytesRecv = recv(client_fd, buffer, size(buffer), 0);
-				if (bytesRecv < 0) {
-					if (errno == ECONNRESET) {
-						client_fds.erase(client_fd);
-						cout << "Rigctl: Client disconnected" << endl;
-					}
-				}
-
-				string response;
-				handleCommand(string(buffer, 0, bytesRecv), response);
-				if (response.empty() == false)
-					send(client_fd, response.c_str(), response.size(), 0);
-			}
-		}
+void RigCtl::receiveClient(int client_fd)
+{
+	char buffer[1024];
+	int bytesRecv = recv(client_fd, buffer, size(buffer), 0);
+	if (bytesRecv <= 0) {
+		if (bytesRecv < 0 && (errno == EAGAIN || errno == EINTR))
+			return;
+
+		/* Connection closed or reset */
+		loop.remove(client_fd);
+		client_fds.erase(client_fd);
+		close(client_fd);
+		cout << "Rigctl: Client disconnected" << endl;
+		return;
 	}
+
+	string response;
+	handleCommand(string(buffer, 0, bytesRecv), response);
+	if (response.empty() == false)
+		send(client_fd, response.c_str(), response.size(), MSG_NOSIGNAL);
 }
 
 void RigCtl::handleCommand(const string& command, string& response_str)
@@ -3,6 +3,8 @@
 #include <suo.hpp>
 #include <set>
 
+#include "misc/event_loop.hpp"
+
 namespace suo {
 
 class RigCtl : public Block
@@ -17,18 +19,22 @@ public:
 		unsigned int port;
 	};
 
-	explicit RigCtl(const Config &conf = Config());
+	explicit RigCtl(const Config &conf = Config(), EventLoop& loop = EventLoop::getDefault());
 	~RigCtl();
 
+	/* Poll the event loop. Only needed if the main loop doesn't poll the event loop itself. */
 	void tick(Timestamp now);
 
 	Port<float> setUplinkFrequency;
 	Port<float> setDownlinkFrequency;
 
 private:
+	EventLoop& loop;
 	int listening_fd;
 	std::set<int> client_fds;
 
+	void acceptClient();
+	void receiveClient(int client_fd);
 	void handleCommand(const std::string &command, std::string &response);
 };
 
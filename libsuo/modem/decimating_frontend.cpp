@@ -0,0 +1,127 @@
+#include <cmath>
+#include <algorithm>
+
+#include "modem/decimating_frontend.hpp"
+
+
+using namespace std;
+using namespace suo;
+
+
+DecimatingFrontend::DecimatingFrontend(float sample_rate, float output_rate, float bandwidth, float attenuation) :
+	sample_rate(sample_rate),
+	frequency(0.0f),
+	delay(0.0f),
+	nco_step(0.0)
+{
+	if (sample_rate <= 0 || output_rate <= 0)
+		throw SuoError("DecimatingFrontend: Invalid sample rate!");
+	if (bandwidth >= sample_rate)
+		throw SuoError("DecimatingFrontend: Signal bandwidth larger than the sample rate!");
+
+	const float kaiser_beta = (attenuation > 50.0f) ? 0.1102f * (attenuation - 8.7f) : 0.5842f * powf(attenuation - 21.0f, 0.4f) + 0.07886f * (attenuation - 21.0f);
+
+	/*
+	 * Add decimate-by-2 stages as long as the output rate stays above the
+	 * requested rate and the transition band is wide enough for a short filter.
+	 * The passband is the signal bandwidth and the stopband starts where the
+	 * aliases would fall on the signal after the decimation.
+	 */
+	float rate = sample_rate;
+	while (rate / 2 >= output_rate) {
+		const float transition = 0.5f - bandwidth / rate; // Normalized to the stage input rate
+		if (transition < 0.05f)
+			break;
+
+		/* Kaiser's formula for the filter length; halfband length is 4K - 1 */
+		const float length = (attenuation - 7.95f) / (14.36f * transition) + 1;
+		const unsigned int K = max(1, (int)ceilf((length + 1) / 4));
+		const int center = 2 * K - 1;
+
+		HalfbandStage stage;
+		stage.taps.resize(K);
+		float sum = 0.0f;
+		for (unsigned int j = 0; j < K; j++) {
+			const int m = 2 * j + 1; // Offset from the center
+			const float x = (float)m / center;
+			const float window = cyl_bessel_if(0, kaiser_beta * sqrtf(max(0.0f, 1.0f - x * x))) / cyl_bessel_if(0, kaiser_beta);
+			stage.taps[j] = sinf(0.5f * M_PI * m) / (M_PI * m) * window;
+			sum += 2 * stage.taps[j];
+		}
+
+		/* Normalize to unity DC gain */
+		for (float& tap: stage.taps)
+			tap *= 0.5f / sum;
+
+		stages.push_back(move(stage));
+		delay += center / rate; // Linear phase: delay of the center tap at the stage input rate
+		rate /= 2;
+	}
+
+	stage_output.resize(stages.size());
+	reset();
+}
+
+
+void DecimatingFrontend::reset() {
+	nco_phase = 0.0;
+	for (HalfbandStage& stage: stages) {
+		stage.buffer.assign(4 * stage.taps.size() - 2, 0.0f);
+		stage.position = stage.buffer.size();
+	}
+}
+
+
+void DecimatingFrontend::setFrequency(float frequency) {
+	this->frequency = frequency;
+	nco_step = 2 * M_PI * frequency / sample_rate;
+}
+
+
+void DecimatingFrontend::HalfbandStage::execute(const Sample* input, size_t len, vector<Sample>& output) {
+	const size_t K = taps.size(), center = 2 * K - 1;
+	buffer.insert(buffer.end(), input, input + len);
+
+	/* position is the index of the newest sample of the next output */
+	output.clear();
+	for (; position < buffer.size(); position += 2) {
+		const Sample* x = &buffer[position - center];
+		Sample y = 0.5f * x[0];
+		for (size_t j = 0; j < K; j++)
+			y += taps[j] * (x[2 * j + 1] + x[-(ptrdiff_t)(2 * j + 1)]);
+		output.push_back(y);
+	}
+
+	/* Keep only the history needed for the next output */
+	const size_t keep_from = position - 2 * center;
+	buffer.erase(buffer.begin(), buffer.begin() + keep_from);
+	position -= keep_from;
+}
+
+
+void DecimatingFrontend::execute(const SampleVector& input, SampleVector& output) {
+
+	/*
+	 * Block NCO: Rotate with a complex phasor and recalculate the phasor
+	 * from the double precision phase once per block to keep it from drifting.
+	 */
+	mixed.resize(input.size());
+	const Sample step = polar(1.0f, (float)-nco_step);
+	Sample phasor = polar(1.0f, (float)-nco_phase);
+	for (size_t i = 0; i < input.size(); i++) {
+		mixed[i] = input[i] * phasor;
+		phasor *= step;
+	}
+	nco_phase = fmod(nco_phase + input.size() * nco_step, 2 * M_PI);
+
+	/* Run the halfband cascade */
+	const Sample* data = mixed.data();
+	size_t len = mixed.size();
+	for (size_t i = 0; i < stages.size(); i++) {
+		stages[i].execute(data, len, stage_output[i]);
+		data = stage_output[i].data();
+		len = stage_output[i].size();
+	}
+
+	output.assign(data, data + len);
+}
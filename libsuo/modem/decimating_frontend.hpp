@@ -0,0 +1,79 @@
+#pragma once
+
+#include "suo.hpp"
+
+namespace suo {
+
+/*
+ * Decimating receiver front-end.
+ *
+ * Mixes the input signal to baseband with a block NCO and decimates it by
+ * the largest power of two allowed by the signal bandwidth using cascaded
+ * halfband filters. The demodulator's fractional resampler then only has to
+ * handle the remaining small ratio at the decimated sample rate instead of
+ * filtering every full rate input sample.
+ *
+ * Only the odd taps and the center tap of a halfband filter are nonzero and
+ * only every second output is computed, so each stage costs about
+ * (taps + 1) / 4 multiplications per input sample.
+ */
+class DecimatingFrontend
+{
+public:
+
+	/*
+	 * Args:
+	 *   sample_rate: Input sample rate
+	 *   output_rate: Lowest acceptable output sample rate (e.g. the resampler's output rate)
+	 *   bandwidth: Two sided bandwidth of the signal which must be kept alias free (Hz)
+	 *   attenuation: Stopband attenuation of the halfband filters (dB)
+	 */
+	DecimatingFrontend(float sample_rate, float output_rate, float bandwidth, float attenuation = 60.0f);
+
+	DecimatingFrontend(const DecimatingFrontend&) = delete;
+	DecimatingFrontend& operator=(const DecimatingFrontend&) = delete;
+
+	/* Reset the filter states and the NCO phase */
+	void reset();
+
+	/* Set the mixing frequency (Hz). The signal at this frequency is moved to DC. */
+	void setFrequency(float frequency);
+	float getFrequency() const { return frequency; }
+
+	/* Total decimation factor of the cascade */
+	unsigned int getDecimation() const { return 1 << stages.size(); }
+
+	/* Sample rate after the decimation */
+	float getOutputRate() const { return sample_rate / getDecimation(); }
+
+	/* Group delay of the halfband cascade (s) */
+	float getDelay() const { return delay; }
+
+	/* Mix and decimate a block of samples. The output vector is overwritten. */
+	void execute(const SampleVector& input, SampleVector& output);
+
+private:
+
+	struct HalfbandStage {
+		/* Nonzero odd taps from the center outwards. The center tap is 0.5. */
+		std::vector<float> taps;
+		/* History + samples waiting to be filtered */
+		std::vector<Sample> buffer;
+		size_t position;
+
+		void execute(const Sample* input, size_t len, std::vector<Sample>& output);
+	};
+
+	float sample_rate;
+	float frequency;
+	float delay;
+
+	/* Block NCO */
+	double nco_phase, nco_step;
+
+	std::vector<HalfbandStage> stages;
+	std::vector<Sample> mixed;
+	std::vector<std::vector<Sample>> stage_output;
+};
+
+}; // namespace suo
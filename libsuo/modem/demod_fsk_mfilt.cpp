@@ -28,7 +28,9 @@ FSKMatchedFilterDemodulator::Config::Config() {
 
 
 FSKMatchedFilterDemodulator::FSKMatchedFilterDemodulator(const Config& _conf) :
-	conf(_conf)
+	conf(_conf),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("FSKMatchedFilterDemodulator")),
+	metric_symbols(MetricsRegistry::getDefault().counter("suo_symbols_total", "Number of demodulated symbols", metric_labels))
 {
 	if (conf.sample_rate <= 0)
 		throw SuoError("FSKMatchedFilterDemodulator: Negative or zero sample rate! %f", conf.sample_rate);
@@ -51,17 +53,20 @@ FSKMatchedFilterDemodulator::FSKMatchedFilterDemodulator(const Config& _conf) :
 		throw SuoError("FSKMatchedFilterDemodulator: samples_per_symbol < 1! %f", conf.samples_per_symbol);
 
 
-	/* Configure a resampler for a fixed conf.samples_per_symbol ratio */
-	float resamprate = conf.symbol_rate * conf.samples_per_symbol / conf.sample_rate;
-	if (resamprate > 1)
-		throw SuoError("FSKMatchedFilterDemodulator: resamprate > 1! %f", resamprate);
-
-
 	// Carson bandwidth rule: Bandwidth = 2 * (deviation + symbol_rate) 
 	float signal_bandwidth = 2 * (conf.bits_per_symbol * conf.modindex * conf.symbol_rate + conf.symbol_rate); // [Hz]
 	if ((abs(conf.center_frequency) + 0.5 * signal_bandwidth) / conf.sample_rate > 0.5)
 		throw SuoError("FSKMatchedFilterDemodulator: Center frequency too large for given sample rate!");
 
+	/* Mix to baseband and decimate by the largest possible factor before the resampler */
+	frontend = std::make_unique<DecimatingFrontend>(conf.sample_rate, conf.symbol_rate * conf.samples_per_symbol, signal_bandwidth);
+	const float decimated_rate = frontend->getOutputRate();
+
+	/* Configure a resampler for a fixed conf.samples_per_symbol ratio */
+	float resamprate = conf.symbol_rate * conf.samples_per_symbol / decimated_rate;
+	if (resamprate > 1)
+		throw SuoError("FSKMatchedFilterDemodulator: resamprate > 1! %f", resamprate);
+
 	// Resampler
 	double bw = 0.4 * resamprate / conf.samples_per_symbol;
 	int semilen = lroundf(1.0f / bw);
@@ -73,12 +78,13 @@ FSKMatchedFilterDemodulator::FSKMatchedFilterDemodulator(const Config& _conf) :
 	/* Calculate maximum number of output samples after feeding one sample
 	 * to the resampler. This is needed to allocate a big enough array. */
 	resampint = ceilf(1 / resamprate);
-	sample_ns = roundf(1.0e9 / conf.sample_rate);
+	sample_ns = roundf(1.0e9 / (conf.symbol_rate * conf.samples_per_symbol)); // Resampled rate
 
 	/* NCO:
+	 * Tracks the residual frequency after the front-end's coarse mixing.
 	 * Limit AFC range to half of symbol rate to keep it
 	 * from wandering too far */
-	nco_1Hz = pi2f / conf.sample_rate;
+	nco_1Hz = pi2f / decimated_rate;
 	l_nco = nco_crcf_create(LIQUID_NCO);
 	nco_crcf_pll_set_bandwidth(l_nco, nco_1Hz * conf.pll_bandwidth0 / conf.samples_per_symbol);
 	update_nco();
@@ -86,7 +92,7 @@ FSKMatchedFilterDemodulator::FSKMatchedFilterDemodulator(const Config& _conf) :
 	/* afc_speed is maximum adjustment of frequency per input sample.
 	 * Convert Hz/sec into it. */
 	float afc_hzsec = 0.01f * conf.symbol_rate * conf.symbol_rate;
-	afc_speed = nco_1Hz * afc_hzsec / conf.sample_rate;
+	afc_speed = nco_1Hz * afc_hzsec / decimated_rate;
 
 	constellation_size = 1 << conf.bits_per_symbol;
 
@@ -151,15 +157,12 @@ FSKMatchedFilterDemodulator::FSKMatchedFilterDemodulator(const Config& _conf) :
 
 	l_sync_window = windowcf_create(conf.samples_per_symbol);
 
-#if 1
-	unsigned int m = 5;                 // filter delay (symbols)
-	float        beta = 0.5f;           // filter excess bandwidth factor
-	unsigned int num_filters = 32;      // number of filters in the bank
-	unsigned int num_symbols = 400;     // number of data symbols
-
-	l_symsync = symsync_rrrf_create_rnyquist(LIQUID_FIRFILT_ARKAISER, conf.samples_per_symbol, m, beta, num_filters);
-	symsync_rrrf_set_lf_bw(l_symsync, 0.02f); // loop filter bandwidth
-#endif
+	/* Symbol synchronizer. The matched filters have already shaped the pulses. */
+	SymbolSync<float>::Config sync_conf;
+	sync_conf.detector = SymbolSync<float>::Gardner;
+	sync_conf.samples_per_symbol = conf.samples_per_symbol;
+	sync_conf.bandwidth = 0.02f; // loop filter bandwidth
+	symsync = std::make_unique<SymbolSync<float>>(sync_conf);
 	reset();
 }
 
@@ -171,27 +174,27 @@ FSKMatchedFilterDemodulator::~FSKMatchedFilterDemodulator()
 	matched_filters.clear();
 
 	firfilt_rrrf_destroy(l_eqfir);
-	symsync_rrrf_destroy(l_symsync);
 }
 
 void FSKMatchedFilterDemodulator::reset() {
 	receiver_lock = false;
 	conf.frequency_offset = 0;
+	frontend->reset();
 	update_nco();
 	firfilt_rrrf_reset(l_eqfir);
-	symsync_rrrf_reset(l_symsync);
+	symsync->reset();
 }
 
 
 void FSKMatchedFilterDemodulator::update_nco()
 {
-	float old_freq = nco_crcf_get_frequency(l_nco);
-
+	/* The front-end moves the center frequency to DC and the NCO tracks the residual */
 	float center_frequency = (conf.center_frequency + conf.frequency_offset);
-	nco_crcf_set_frequency(l_nco, nco_1Hz * center_frequency);
+	frontend->setFrequency(center_frequency);
+	nco_crcf_set_frequency(l_nco, 0.0f);
 
-	freq_min = nco_1Hz * (center_frequency - 0.5f * conf.symbol_rate);
-	freq_max = nco_1Hz * (center_frequency + 0.5f * conf.symbol_rate);
+	freq_min = nco_1Hz * (-0.5f * conf.symbol_rate);
+	freq_max = nco_1Hz * (+0.5f * conf.symbol_rate);
 
 	conf_dirty = false;
 }
@@ -211,12 +214,16 @@ void FSKMatchedFilterDemodulator::sinkSamples(const SampleVector& samples, Times
 	std::vector<double> plot2; plot2.reserve(plot_size);
 	std::vector<double> plot3; plot3.reserve(plot_size);
 	std::vector<double> plot4; plot4.reserve(plot_size);
+	/* Coarse mixing and decimation for the whole buffer */
+	frontend->execute(samples, decimated);
+	demodulated.clear();
+
 	size_t si;
-	for (si = 0; si < samples.size(); si++) {
+	for (si = 0; si < decimated.size(); si++) {
 		unsigned nsamp2 = 0, si2;
-		Sample s = samples[si];
+		Sample s = decimated[si];
 
-		/* Downconvert and resample one input sample at a time */
+		/* Downconvert and resample one decimated sample at a time */
 		nco_crcf_step(l_nco);
 		nco_crcf_mix_down(l_nco, s, &s);
 		resamp_crcf_execute(l_resamp, s, samples2, &nsamp2);
@@ -356,30 +363,23 @@ void FSKMatchedFilterDemodulator::sinkSamples(const SampleVector& samples, Times
 				}
 			}
 #else
+			demodulated.push_back(demod);
+#endif
+			demod_prev = demod;
+		}
+	}
 
-			/* Run symbols sync */
-			float synced_symbols[4];
-			unsigned int output_symbols = 0;
-			symsync_rrrf_execute(l_symsync, &demod, 1, synced_symbols, &output_symbols);
-			//cout << "output_symbols " <<  output_symbols << endl;
-
-			//assert(output_symbols <= 1);
-			if (output_symbols == 0)
-				continue;
-
-			/* Process one output symbol from synchronizer */
-			Timestamp symbol_time = 0; // now + si * sample_ns;
-			//now -= conf.filter_delay * resampint; // or / resamprate
+	/* Run symbols sync for the whole buffer */
+	symsync->execute(demodulated.data(), demodulated.size(), synced_symbols, symbol_positions);
 
-			Symbol decision = (synced_symbols[0] >= 0) ? 1 : 0;
-			cout << (int)decision << " ";
-			sinkSymbol.emit(decision, symbol_time);
+	for (size_t i = 0; i < synced_symbols.size(); i++) {
 
+		/* Process one output symbol from synchronizer */
+		Timestamp symbol_time = timestamp + (int64_t)(symbol_positions[i] * sample_ns);
 
-#endif
-			demod_prev = demod;
-		}
-		timestamp += sample_ns;
+		Symbol decision = (synced_symbols[i] >= 0) ? 1 : 0;
+		metric_symbols.inc();
+		sinkSymbol.emit(decision, symbol_time);
 	}
 }
 
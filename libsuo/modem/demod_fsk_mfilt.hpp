@@ -1,6 +1,10 @@
 #pragma once
 
+#include <memory>
 #include "suo.hpp"
+#include "misc/metrics.hpp"
+#include "modem/decimating_frontend.hpp"
+#include "modem/symbol_sync.hpp"
 #include <liquid/liquid.h>
 
 namespace suo {
@@ -111,16 +115,29 @@ private:
 	/* General metadata */
 	float est_power; // Running estimate of the signal power
 
+	/* Coarse mixing and decimation */
+	std::unique_ptr<DecimatingFrontend> frontend;
+
+	/* Symbol timing recovery */
+	std::unique_ptr<SymbolSync<float>> symsync;
+
 	/* liquid-dsp objects */
 	nco_crcf l_nco;
 	resamp_crcf l_resamp;
 	std::vector<firfilt_cccf> matched_filters;
 	firfilt_rrrf l_eqfir;
 	windowcf l_sync_window;
-	symsync_rrrf l_symsync;
 
 	/* Buffers */
 	Frame frame;
+	SampleVector decimated;
+	std::vector<float> demodulated;
+	std::vector<float> synced_symbols;
+	std::vector<float> symbol_positions;
+
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_symbols;
 
 };
 
@@ -0,0 +1,247 @@
+#include <iostream>
+#include <algorithm> // min, max_element
+
+#include "modem/demod_fsk_noncoherent.hpp"
+#include "registry.hpp"
+
+
+using namespace std;
+using namespace suo;
+
+
+FSKNoncoherentDemodulator::Config::Config() {
+	sample_rate = 1e6;
+	symbol_rate = 9600;
+	modindex = 0;
+	deviation = 0;
+	bits_per_symbol = 2;
+	samples_per_symbol = 8;
+	timing_phases = 4;
+	center_frequency = 100000;
+	frequency_offset = 0.0f;
+	symsync_bandwidth0 = 0.1f;
+	symsync_bandwidth1 = 0.02f;
+}
+
+
+FSKNoncoherentDemodulator::FSKNoncoherentDemodulator(const Config& _conf) :
+	conf(_conf),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("FSKNoncoherentDemodulator")),
+	metric_symbols(MetricsRegistry::getDefault().counter("suo_symbols_total", "Number of demodulated symbols", metric_labels))
+{
+	if (conf.sample_rate <= 0)
+		throw SuoError("FSKNoncoherentDemodulator: Negative or zero sample rate! %f", conf.sample_rate);
+	if (conf.symbol_rate <= 0)
+		throw SuoError("FSKNoncoherentDemodulator: Negative or zero symbol rate! %f", conf.symbol_rate);
+
+	if (conf.modindex < 0)
+		throw SuoError("FSKNoncoherentDemodulator: Negative modindex! %f", conf.modindex);
+	if (conf.deviation < 0)
+		throw SuoError("FSKNoncoherentDemodulator: Negative deviation! %f", conf.deviation);
+	if (conf.modindex != 0 && conf.deviation != 0)
+		throw SuoError("FSKNoncoherentDemodulator: Both modindex and deviation defined!");
+
+	if (conf.deviation != 0)
+		conf.modindex = 2 * conf.deviation / conf.symbol_rate;
+	else if (conf.modindex == 0)
+		throw SuoError("FSKNoncoherentDemodulator: Neither mod_index or deviation given!");
+
+	if (conf.bits_per_symbol < 1 || conf.bits_per_symbol > 8)
+		throw SuoError("FSKNoncoherentDemodulator: Unsupported bits per symbol %d", conf.bits_per_symbol);
+	if (conf.timing_phases == 0 || conf.samples_per_symbol % conf.timing_phases != 0)
+		throw SuoError("FSKNoncoherentDemodulator: timing_phases must divide samples_per_symbol");
+
+	constellation_size = 1 << conf.bits_per_symbol;
+
+	// Tones span (M - 1) * tone spacing + main lobes of the outermost tones
+	float signal_bandwidth = ((constellation_size - 1) * conf.modindex + 2) * conf.symbol_rate; // [Hz]
+	if ((abs(conf.center_frequency) + 0.5 * signal_bandwidth) / conf.sample_rate > 0.5)
+		throw SuoError("FSKNoncoherentDemodulator: Center frequency too large for given sample rate!");
+
+	/* Mix to baseband and decimate by the largest possible factor before the resampler */
+	frontend = std::make_unique<DecimatingFrontend>(conf.sample_rate, conf.symbol_rate * conf.samples_per_symbol, signal_bandwidth);
+	const float decimated_rate = frontend->getOutputRate();
+
+	/* Configure a resampler for a fixed samples per symbol ratio */
+	float resamprate = conf.symbol_rate * conf.samples_per_symbol / decimated_rate;
+	double bw = min(0.5 * signal_bandwidth / decimated_rate, 0.45 * min(resamprate, 1.0f));
+	int semilen = lroundf(1.0f / bw);
+	l_resamp = resamp_crcf_create(resamprate, semilen, bw, 60.0f, 16);
+	sample_ns = round(1.0e9 / (conf.symbol_rate * conf.samples_per_symbol)); // Resampled rate
+
+	/*
+	 * DFT:
+	 * With a symbol long window the bins are spaced by the symbol rate.
+	 * Find the smallest zero padding which puts all the tones on the bins.
+	 */
+	unsigned int padding = 0;
+	for (unsigned int p = 1; p <= 8 && padding == 0; p++) {
+		padding = p;
+		for (unsigned int m = 0; m < constellation_size; m++) {
+			float bin = (m - 0.5f * (constellation_size - 1)) * conf.modindex * p;
+			if (abs(bin - roundf(bin)) > 1e-3f)
+				padding = 0;
+		}
+	}
+	if (padding == 0)
+		throw SuoError("FSKNoncoherentDemodulator: Tones don't fall on DFT bins with modindex %f", conf.modindex);
+
+	fft_len = conf.samples_per_symbol * padding;
+	if (0.5f * (constellation_size - 1) * conf.modindex * padding >= 0.5f * fft_len)
+		throw SuoError("FSKNoncoherentDemodulator: Too few samples per symbol for %d tones", constellation_size);
+
+	for (unsigned int m = 0; m < constellation_size; m++) {
+		int bin = lroundf((m - 0.5f * (constellation_size - 1)) * conf.modindex * padding);
+		tone_bins.push_back((bin + fft_len) % fft_len);
+	}
+
+	fft_in.resize(fft_len, 0.0f);
+	fft_out.resize(fft_len);
+	plan = fft_create_plan(fft_len, fft_in.data(), fft_out.data(), LIQUID_FFT_FORWARD, 0);
+
+	hop = conf.samples_per_symbol / conf.timing_phases;
+	phase_energy.resize(conf.timing_phases);
+	energies.resize(constellation_size);
+
+	reset();
+}
+
+
+FSKNoncoherentDemodulator::~FSKNoncoherentDemodulator()
+{
+	fft_destroy_plan(plan);
+	resamp_crcf_destroy(l_resamp);
+}
+
+
+void FSKNoncoherentDemodulator::reset() {
+	receiver_lock = false;
+	frontend->reset();
+	update_nco();
+	resamp_crcf_reset(l_resamp);
+
+	buffer.clear();
+	next_window = conf.samples_per_symbol;
+	fill(phase_energy.begin(), phase_energy.end(), 0.0f);
+	hop_phase = 0;
+	hops_to_symbol = conf.timing_phases;
+	symsync_alpha = conf.symsync_bandwidth0;
+	est_power = 0.0f;
+}
+
+
+void FSKNoncoherentDemodulator::update_nco()
+{
+	/* The front-end moves the center frequency to DC */
+	frontend->setFrequency(conf.center_frequency + conf.frequency_offset);
+	conf_dirty = false;
+}
+
+
+void FSKNoncoherentDemodulator::sinkSamples(const SampleVector& samples, Timestamp timestamp)
+{
+	if (conf_dirty && receiver_lock == false)
+		update_nco();
+
+	/* Coarse mixing and decimation for the whole buffer */
+	frontend->execute(samples, decimated);
+
+	/* Resample the whole buffer after the samples left from the previous call */
+	const size_t base = buffer.size(); // Index of the first new sample
+	unsigned int nresampled = 0;
+	buffer.resize(base + (size_t)ceilf(decimated.size() * resamp_crcf_get_rate(l_resamp)) + 4);
+	resamp_crcf_execute_block(l_resamp, decimated.data(), decimated.size(), &buffer[base], &nresampled);
+	buffer.resize(base + nresampled);
+
+	const unsigned int sps = conf.samples_per_symbol;
+	const float center_offset = 0.5f * (sps + 1); // From the end of the window to its center
+
+	while (next_window <= buffer.size()) {
+		const Sample* window = &buffer[next_window - sps];
+
+		/* Calculate all tone energies with one DFT */
+		copy(window, window + sps, fft_in.begin());
+		fft_execute(plan);
+
+		float total_energy = 0.0f;
+		for (unsigned int m = 0; m < constellation_size; m++) {
+			energies[m] = norm(fft_out[tone_bins[m]]);
+			total_energy += energies[m];
+		}
+		const unsigned int decision = max_element(energies.begin(), energies.end()) - energies.begin();
+
+		/* Average the strongest tone's energy for each timing phase */
+		phase_energy[hop_phase] += symsync_alpha * (energies[decision] - phase_energy[hop_phase]);
+
+		if (--hops_to_symbol == 0) {
+
+			Timestamp symbol_time = timestamp + (int64_t)((next_window - center_offset - base) * sample_ns);
+
+			metric_symbols.inc();
+			sinkSymbol.emit(decision, symbol_time);
+
+			if (sinkSoftSymbol.has_connections()) {
+				const float norm_energy = 1.0f / max(total_energy, 1e-20f);
+				for (int bit = conf.bits_per_symbol - 1; bit >= 0; bit--) {
+					float max0 = 0.0f, max1 = 0.0f;
+					for (unsigned int m = 0; m < constellation_size; m++) {
+						if ((m >> bit) & 1)
+							max1 = max(max1, energies[m]);
+						else
+							max0 = max(max0, energies[m]);
+					}
+					sinkSoftSymbol.emit((max1 - max0) * norm_energy, symbol_time);
+				}
+			}
+
+			float window_power = 0.0f;
+			for (unsigned int i = 0; i < sps; i++)
+				window_power += norm(window[i]);
+			est_power += 0.05f * (window_power / sps - est_power);
+
+			/* Move the timing towards the strongest phase. Small hysteresis keeps it from dithering. */
+			const int phases = conf.timing_phases;
+			const int best = max_element(phase_energy.begin(), phase_energy.end()) - phase_energy.begin();
+			int shift = (best - (int)hop_phase + phases + phases / 2) % phases - phases / 2;
+			hops_to_symbol = phases;
+			if (shift != 0 && phase_energy[best] > 1.1f * phase_energy[hop_phase])
+				hops_to_symbol += shift;
+		}
+
+		hop_phase = (hop_phase + 1) % conf.timing_phases;
+		next_window += hop;
+	}
+
+	/* Keep the samples needed for the next windows */
+	const size_t keep_from = next_window - sps;
+	buffer.erase(buffer.begin(), buffer.begin() + keep_from);
+	next_window -= keep_from;
+}
+
+
+void FSKNoncoherentDemodulator::lockReceiver(bool locked, Timestamp now) {
+	(void)now;
+	receiver_lock = locked;
+	if (locked) {
+		setMetadata.emit("cfo", frontend->getFrequency());
+		setMetadata.emit("rssi", 10.0f * log10f(max(est_power, 1e-12f))); // Floor at -120 dB
+		symsync_alpha = conf.symsync_bandwidth1;
+	}
+	else {
+		symsync_alpha = conf.symsync_bandwidth0;
+	}
+}
+
+
+void FSKNoncoherentDemodulator::setFrequencyOffset(float frequency_offset) {
+	conf.frequency_offset = frequency_offset;
+	conf_dirty = true;
+}
+
+
+Block* createFSKNoncoherentDemodulator(const Kwargs &args)
+{
+	return new FSKNoncoherentDemodulator();
+}
+
+static Registry registerFSKNoncoherentDemodulator("FSKNoncoherentDemodulator", &createFSKNoncoherentDemodulator);
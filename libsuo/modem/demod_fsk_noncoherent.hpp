@@ -0,0 +1,148 @@
+#pragma once
+
+#include <memory>
+#include "suo.hpp"
+#include "misc/metrics.hpp"
+#include "modem/decimating_frontend.hpp"
+#include <liquid/liquid.h>
+
+namespace suo {
+
+/*
+ * Noncoherent M-FSK demodulator
+ *
+ * The energies of all tones are calculated with one DFT over a symbol long
+ * window. The window hops a fraction of a symbol at a time and the tone energies
+ * are evaluated for each timing phase. The phase giving on average the strongest
+ * tone is used for the decisions. Because all tones come from the same FFT, the
+ * cost per sample grows as log(M) instead of M like with a bank of matched filters.
+ *
+ * The DFT is zero padded so that the tones (spaced by modindex * symbol_rate)
+ * fall exactly on the bins. Symbols are mapped to tones linearly like in liquid-dsp's
+ * CPFSK modulator, i.e. symbol 0 is the lowest tone.
+ *
+ * Hard decisions are emitted as tone indices. Soft decisions are emitted as
+ * bits_per_symbol soft bits per symbol, MSB first, positive meaning a '1'.
+ * Soft bit is the difference of the strongest tone energies with the bit set
+ * and cleared normalized by the total energy, so it is in range [-1, 1].
+ */
+class FSKNoncoherentDemodulator : public Block
+{
+public:
+
+	/* Configuration struct for the noncoherent FSK demod */
+	struct Config {
+		Config();
+
+		/*
+		 * Input IQ sample rate as samples per second.
+		 */
+		float sample_rate;
+
+		/*
+		 * Symbol rate as symbols per second
+		 */
+		float symbol_rate;
+
+		/* Modulation index: Tone spacing divided by the symbol rate */
+		float modindex;
+
+		/* Frequency deviation: Half of the tone spacing (Hz) */
+		float deviation;
+
+		/*
+		 * Number of bit in one symbol (symbol complexity)
+		 */
+		unsigned int bits_per_symbol;
+
+		/*
+		 * Number of samples per symbol after decimation.
+		 * The DFT length is this multiplied by the zero padding factor.
+		 */
+		unsigned int samples_per_symbol;
+
+		/*
+		 * Number of timing phases evaluated per symbol.
+		 * Must divide samples_per_symbol.
+		 */
+		unsigned int timing_phases;
+
+		/*
+		 * Signal center frequency as Hz
+		 */
+		float center_frequency;
+
+		/*
+		 * Frequency offset from the center frequency (Hz)
+		 */
+		float frequency_offset;
+
+		/* Averaging coefficient of the timing phase energies per symbol */
+		float symsync_bandwidth0;
+		float symsync_bandwidth1;
+	};
+
+	explicit FSKNoncoherentDemodulator(const Config& conf = Config());
+	~FSKNoncoherentDemodulator();
+
+	FSKNoncoherentDemodulator(const FSKNoncoherentDemodulator&) = delete;
+	FSKNoncoherentDemodulator& operator=(const FSKNoncoherentDemodulator&) = delete;
+
+	void reset();
+	void sinkSamples(const SampleVector& samples, Timestamp timestamp);
+	void lockReceiver(bool locked, Timestamp now);
+
+	void setFrequencyOffset(float frequency_offset);
+
+	Port<Symbol, Timestamp> sinkSymbol;
+	Port<SoftSymbol, Timestamp> sinkSoftSymbol;
+	Port<const std::string&, const MetadataValue&> setMetadata;
+
+private:
+
+	void update_nco();
+
+	/* Configuration */
+	Config conf;
+	bool conf_dirty;
+	bool receiver_lock;
+
+	Timestamp sample_ns;
+	unsigned int constellation_size;
+	unsigned int hop;
+	float symsync_alpha;
+
+	/* DFT */
+	unsigned int fft_len;
+	std::vector<unsigned int> tone_bins;
+	std::vector<Sample> fft_in;
+	std::vector<Sample> fft_out;
+	fftplan plan;
+
+	/* Timing state */
+	std::vector<float> phase_energy;
+	unsigned int hop_phase;
+	unsigned int hops_to_symbol;
+	size_t next_window; // End of the next DFT window in the buffer
+
+	/* General metadata */
+	float est_power; // Running estimate of the signal power
+
+	/* Coarse mixing and decimation */
+	std::unique_ptr<DecimatingFrontend> frontend;
+
+	/* liquid-dsp objects */
+	resamp_crcf l_resamp;
+
+	/* Buffers */
+	SampleVector decimated;
+	SampleVector buffer;
+	std::vector<float> energies;
+
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_symbols;
+
+};
+
+}; // namespace suo
@@ -1,4 +1,5 @@
 #include "demod_gmsk.hpp"
+#include "modem/fm_discriminator.hpp"
 #include "registry.hpp"
 
 #include <string>
@@ -41,8 +42,12 @@ GMSKDemodulator::GMSKDemodulator(const Config& conf) :
 	//syncmask = (1ULL << conf.synclen) - 1;
 	//framepos = conf.framelen;
 
+	/* Mix to baseband and decimate by the largest possible factor before the resampler */
+	frontend = std::make_unique<DecimatingFrontend>(conf.sample_rate, conf.symbol_rate * conf.samples_per_symbol, signal_bandwidth);
+	const float decimated_rate = frontend->getOutputRate();
+
 	/* Configure a resampler for a fixed oversampling ratio */
-	float resamprate = conf.symbol_rate * conf.samples_per_symbol / conf.sample_rate;
+	float resamprate = conf.symbol_rate * conf.samples_per_symbol / decimated_rate;
 	double bw = 0.4 * resamprate / conf.samples_per_symbol;
 	int semilen = lroundf(1.0f / bw);
 	l_resamp = resamp_crcf_create(resamprate, 25, 0.4f / conf.samples_per_symbol, 60.0f, 32);
@@ -52,11 +57,8 @@ GMSKDemodulator::GMSKDemodulator(const Config& conf) :
 
 
 	center_frequency = conf.center_frequency;
-	nco_1Hz = pi2f / conf.sample_rate;
-
-	l_nco = nco_crcf_create(LIQUID_NCO);
-	nco_crcf_pll_set_bandwidth(l_nco, 0.5 * nco_1Hz);
-	nco_crcf_set_frequency(l_nco, nco_1Hz * center_frequency);
+	nco_1Hz = pi2f / decimated_rate;
+	frontend->setFrequency(center_frequency);
 
 
 	/*
@@ -274,7 +276,8 @@ void GMSKDemodulator::pushpn()
 void GMSKDemodulator::update_fi(Complex _x)
 {
 	// compute differential phase
-	fi_hat = arg(conj(x_prime) * _x) * conf.samples_per_symbol;
+	Complex d = conj(x_prime) * _x;
+	fi_hat = fast_atan2f(d.imag(), d.real()) * conf.samples_per_symbol;
 
 	// update internal state
 	x_prime = _x;
@@ -400,16 +403,17 @@ void GMSKDemodulator::sinkSamples(const SampleVector& samples, Timestamp timesta
 	/* Allocate small buffers from stack */
 	Sample samples2[resampint];
 
-	Timestamp sample_ns = roundf(1.0e9f / conf.sample_rate);
+	Timestamp sample_ns = roundf(1.0e9f / frontend->getOutputRate());
+
+	/* Downconvert and decimate the whole buffer */
+	frontend->execute(samples, decimated);
 
 	size_t si;
-	for(si = 0; si < samples.size(); si++) {
+	for(si = 0; si < decimated.size(); si++) {
 		unsigned nsamp2 = 0, si2;
-		Sample s = samples[si];
+		Sample s = decimated[si];
 
-		/* Downconvert and resample one input sample at a time */
-		nco_crcf_step(l_nco);
-		nco_crcf_mix_down(l_nco, s, &s);
+		/* Resample one decimated sample at a time */
 		resamp_crcf_execute(l_resamp, s, samples2, &nsamp2);
 		assert(nsamp2 <= resampint);
 
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <memory>
 #include "suo.hpp"
+#include "modem/decimating_frontend.hpp"
 #include <liquid/liquid.h>
 
 namespace suo {
@@ -97,8 +99,10 @@ private:
 	float nco_1Hz;
 	float center_frequency; // Currently set center frequency
 
+	/* Mixing and decimation */
+	std::unique_ptr<DecimatingFrontend> frontend;
+
 	/* liquid-dsp objects */
-	nco_crcf l_nco;
 	resamp_crcf l_resamp;
 	gmskdem l_demod;
 
@@ -132,6 +136,7 @@ private:
 
 	/* Buffers */
 	Frame* frame;
+	SampleVector decimated;
 
 };
 
@@ -4,6 +4,7 @@
 #include <algorithm> // clamp
 
 #include "modem/demod_gmsk_cont.hpp"
+#include "modem/fm_discriminator.hpp"
 #include "registry.hpp"
 
 
@@ -34,7 +35,9 @@ GMSKContinousDemodulator::Config::Config() {
 }
 
 GMSKContinousDemodulator::GMSKContinousDemodulator(const Config& conf) :
-	conf(conf)
+	conf(conf),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("GMSKContinousDemodulator")),
+	metric_symbols(MetricsRegistry::getDefault().counter("suo_symbols_total", "Number of demodulated symbols", metric_labels))
 {
 
 
@@ -44,8 +47,12 @@ GMSKContinousDemodulator::GMSKContinousDemodulator(const Config& conf) :
 		throw SuoError("GMSKContinousDemodulator: Center frequency too large for given sample rate!");
 
 
+	/* Mix to baseband and decimate by the largest possible factor before the resampler */
+	frontend = std::make_unique<DecimatingFrontend>(conf.sample_rate, conf.symbol_rate * conf.samples_per_symbol, signal_bandwidth);
+	const float decimated_rate = frontend->getOutputRate();
+
 	/* Configure a resampler for a fixed oversampling ratio */
-	float resamprate = conf.symbol_rate * conf.samples_per_symbol / conf.sample_rate;
+	float resamprate = conf.symbol_rate * conf.samples_per_symbol / decimated_rate;
 	double bw = 0.75 * resamprate / conf.samples_per_symbol;
 	int semilen = lroundf(1.0f / bw);
 	l_resamp = resamp_crcf_create(resamprate, semilen, bw, 60.0f, 16);
@@ -53,13 +60,14 @@ GMSKContinousDemodulator::GMSKContinousDemodulator(const Config& conf) :
 	/* Calculate maximum number of output samples after feeding one sample
 	 * to the resampler. This is needed to allocate a big enough array. */
 	resampint = ceil(1 / resamprate);
-	sample_ns = round(1.0e9 / conf.sample_rate);
+	sample_ns = round(1.0e9 / (conf.symbol_rate * conf.samples_per_symbol)); // Resampled rate
 
 	/* 
 	 * NCO:
+	 * Tracks the residual frequency after the front-end's coarse mixing.
 	 * Limit AFC range to half of symbol rate to keep it from wandering too far
 	 */
-	nco_1Hz = pi2f / conf.sample_rate;
+	nco_1Hz = pi2f / decimated_rate;
 	l_nco = nco_crcf_create(LIQUID_NCO);
 	nco_crcf_pll_set_bandwidth(l_nco, conf.pll_bandwidth0 * nco_1Hz);
 	update_nco();
@@ -84,8 +92,14 @@ GMSKContinousDemodulator::GMSKContinousDemodulator(const Config& conf) :
 	 * - Runs polyphase filter bank for symbol timing recovery 
 	 * - Decimates to symbol rate
 	 */
-	l_symsync = symsync_rrrf_create_rnyquist(LIQUID_FIRFILT_GMSKRX, conf.samples_per_symbol, conf.filter_delay, conf.bt, 16);
-	symsync_rrrf_set_lf_bw(l_symsync, conf.symsync_bandwidth0 / conf.samples_per_symbol);
+	SymbolSync<float>::Config sync_conf;
+	sync_conf.detector = SymbolSync<float>::Polyphase;
+	sync_conf.samples_per_symbol = conf.samples_per_symbol;
+	sync_conf.bandwidth = conf.symsync_bandwidth0 / conf.samples_per_symbol;
+	sync_conf.phases = 16;
+	sync_conf.filter.resize(2 * conf.samples_per_symbol * conf.filter_delay + 1);
+	liquid_firdes_gmskrx(conf.samples_per_symbol, conf.filter_delay, conf.bt, 0.0f, sync_conf.filter.data());
+	symsync = std::make_unique<SymbolSync<float>>(sync_conf);
 
 	reset();
 }
@@ -94,13 +108,15 @@ GMSKContinousDemodulator::GMSKContinousDemodulator(const Config& conf) :
 GMSKContinousDemodulator::~GMSKContinousDemodulator()
 {
 	agc_crcf_destroy(l_agc);
-	symsync_rrrf_destroy(l_symsync);
 }
 
 
 void GMSKContinousDemodulator::reset() {
 	x_prime = 0.0f;
-	nco_crcf_set_frequency(l_nco, nco_1Hz * (conf.center_frequency + conf.frequency_offset));
+	frontend->reset();
+	frontend->setFrequency(conf.center_frequency + conf.frequency_offset);
+	nco_crcf_set_frequency(l_nco, 0.0f);
+	symsync->reset();
 	receiver_lock = false;
 }
 
@@ -109,18 +125,25 @@ void GMSKContinousDemodulator::update_nco()
 {
 	conf_dirty = false;
 
-	// Calclate new frequency limits
+	// Move the coarse mixing to the new center frequency
 	float center_frequency = (conf.center_frequency + conf.frequency_offset);
-	freq_min = nco_1Hz * (center_frequency - 0.5f * conf.symbol_rate);
-	freq_max = nco_1Hz * (center_frequency + 0.5f * conf.symbol_rate);
+	float center_change = center_frequency - frontend->getFrequency();
+	frontend->setFrequency(center_frequency);
+
+	// NCO frequency limits relative to the new center
+	freq_min = nco_1Hz * (-0.5f * conf.symbol_rate);
+	freq_max = nco_1Hz * (+0.5f * conf.symbol_rate);
 
 #if 1
-	// Clamp the NCO frequency between new limits
-	float old_freq = nco_crcf_get_frequency(l_nco);
-	nco_crcf_set_frequency(l_nco, clamp(old_freq, freq_min, freq_max));
+	/* Keep the absolute NCO frequency if it's still inside the new limits.
+	 * Otherwise (e.g. a new offset from the FrequencyAcquisition) retune to the new center. */
+	float old_freq = nco_crcf_get_frequency(l_nco) - nco_1Hz * center_change;
+	if (old_freq < freq_min || old_freq > freq_max)
+		old_freq = 0.0f;
+	nco_crcf_set_frequency(l_nco, old_freq);
 #else
 	// Set new NCO frequency 
-	nco_crcf_set_frequency(l_nco, nco_1Hz * center_frequency);
+	nco_crcf_set_frequency(l_nco, 0.0f);
 #endif
 }
 
@@ -138,13 +161,16 @@ void GMSKContinousDemodulator::sinkSamples(const SampleVector& samples, Timestam
 	size_t symbol_phase = 0;
 	Sample null;
 
+	/* Coarse mixing and decimation for the whole buffer */
+	frontend->execute(samples, decimated);
+	resampled.clear();
 
-	for (size_t si = 0; si < samples.size(); si++) {
+	for (size_t si = 0; si < decimated.size(); si++) {
 		unsigned nsamp2 = 0, si2;
-		Sample s = samples[si];
+		Sample s = decimated[si];
 
 
-		/* Downconvert and resample one input sample at a time */
+		/* Downconvert and resample one decimated sample at a time */
 		nco_crcf_step(l_nco);
 		nco_crcf_mix_down(l_nco, s, &s);
 		resamp_crcf_execute(l_resamp, s, samples2, &nsamp2);
@@ -159,7 +185,8 @@ void GMSKContinousDemodulator::sinkSamples(const SampleVector& samples, Timestam
 
 #if 1
 			/*  */
-			float phase_error = arg(conj(x_primee) * s2) * k_ref;
+			Sample d = conj(x_primee) * s2;
+			float phase_error = fast_atan2f(d.imag(), d.real()) * k_ref;
 			x_primee = s2;
 			nco_crcf_mix_up(l_nco, x_primee, &x_primee);
 			nco_crcf_pll_step(l_nco, phase_error);
@@ -180,46 +207,43 @@ void GMSKContinousDemodulator::sinkSamples(const SampleVector& samples, Timestam
 			if (freq < freq_min)
 				nco_crcf_set_frequency(l_nco, freq_min);
 
+			resampled.push_back(s2);
+		}
+	}
 
-			/* Quadrature FM-demodulation */
-			float phi = arg(conj(x_prime) * s2) * k_ref;
-			x_prime = s2;
+	/* Quadrature FM-demodulation for the whole buffer */
+	phi.resize(resampled.size());
+	fm_discriminate(resampled.data(), resampled.size(), phi.data(), x_prime, k_ref);
 
-			/* Run symbols synchronization.
-			 * This has also gaussian undistortion and decimation */
-			float synced_symbol;
-			unsigned int output_symbols = 0;
-			symsync_rrrf_execute(l_symsync, &phi, 1, &synced_symbol, &output_symbols);
+	/* Run symbols synchronization for the whole buffer.
+	 * This has also gaussian undistortion and decimation */
+	symsync->execute(phi.data(), phi.size(), synced_symbols, symbol_positions);
 
-			if (output_symbols == 0)
-				continue;
+	for (size_t si = 0; si < synced_symbols.size(); si++) {
+		float synced_symbol = synced_symbols[si];
 
-			assert(output_symbols == 1);
+		/* Process one output symbol from synchronizer */
+		Timestamp symbol_time = now + (int64_t)(symbol_positions[si] * sample_ns);
 
-		
-			/* Process one output symbol from synchronizer */
-			Timestamp symbol_time = now + si * sample_ns;
-			//now -= conf.filter_delay * resampint; // or / resamprate
+		Symbol decision = (synced_symbol >= 0) ? 1 : 0;
+		//cout << (int)decision << " ";
+		metric_symbols.inc();
+		sinkSymbol.emit(decision, symbol_time);
 
-			Symbol decision = (synced_symbol >= 0) ? 1 : 0;
-			//cout << (int)decision << " ";
-			sinkSymbol.emit(decision, symbol_time);
-
-			//SoftSymbol soft_bit = synced_symbol;
-			//sinkSoftSymbol.emit
+		//SoftSymbol soft_bit = synced_symbol;
+		//sinkSoftSymbol.emit
 
 #if 0
-			//SinkSymbol(decision, timestamp)) {
-			if (0) { 
-				receiver_lock = true;
-			}
-			else {
-				/* No sync, no lock */
-				receiver_lock = false;
-			}
+		//SinkSymbol(decision, timestamp)) {
+		if (0) { 
+			receiver_lock = true;
+		}
+		else {
+			/* No sync, no lock */
+			receiver_lock = false;
+		}
 #endif
 
-		}
 	}
 }
 
@@ -227,17 +251,17 @@ void GMSKContinousDemodulator::lockReceiver(bool locked, Timestamp now) {
 	receiver_lock = locked;
 	if (locked) {
 		
-		setMetadata.emit("cfo", nco_crcf_get_frequency(l_nco) / nco_1Hz);
+		setMetadata.emit("cfo", frontend->getFrequency() + nco_crcf_get_frequency(l_nco) / nco_1Hz);
 		setMetadata.emit("rssi", agc_crcf_get_rssi(l_agc));
 		setMetadata.emit("bg_rssi", agc_crcf_get_rssi(l_bg_agc));
 
-		symsync_rrrf_set_lf_bw(l_symsync, conf.symsync_bandwidth1 / conf.samples_per_symbol);
+		symsync->setBandwidth(conf.symsync_bandwidth1 / conf.samples_per_symbol);
 		nco_crcf_pll_set_bandwidth(l_nco, conf.pll_bandwidth1 * nco_1Hz);
 		agc_crcf_set_bandwidth(l_agc, conf.agc_bandwidth1 / conf.samples_per_symbol);
 		agc_crcf_lock(l_bg_agc);
 	}
 	else {
-		symsync_rrrf_set_lf_bw(l_symsync, conf.symsync_bandwidth0 / conf.samples_per_symbol);
+		symsync->setBandwidth(conf.symsync_bandwidth0 / conf.samples_per_symbol);
 		nco_crcf_pll_set_bandwidth(l_nco, conf.pll_bandwidth0 * nco_1Hz);
 		agc_crcf_set_bandwidth(l_agc, conf.agc_bandwidth0 / conf.samples_per_symbol);
 		agc_crcf_unlock(l_bg_agc);
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <memory>
 #include "suo.hpp"
+#include "misc/metrics.hpp"
+#include "modem/decimating_frontend.hpp"
+#include "modem/symbol_sync.hpp"
 #include <liquid/liquid.h>
 #include "plotter.hpp"
 
@@ -96,15 +100,29 @@ private:
 	float freq_min, freq_max;
 	float k_ref;
 
+	/* Coarse mixing and decimation */
+	std::unique_ptr<DecimatingFrontend> frontend;
+
+	/* Symbol timing recovery */
+	std::unique_ptr<SymbolSync<float>> symsync;
+
 	/* liquid-dsp objects */
 	nco_crcf l_nco;
 	resamp_crcf l_resamp;
-	symsync_rrrf l_symsync;
 	agc_crcf l_agc;
 	agc_crcf l_bg_agc;
 
 	/* Buffers */
 	Frame* frame;
+	SampleVector decimated;
+	SampleVector resampled;
+	std::vector<float> phi;
+	std::vector<float> synced_symbols;
+	std::vector<float> symbol_positions;
+
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_symbols;
 
 };
 
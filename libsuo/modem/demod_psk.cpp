@@ -1,8 +1,9 @@
 #include <string>
-#include <assert.h>
 #include <iostream>
+#include <algorithm> // clamp
 
 #include "modem/demod_psk.hpp"
+#include "modem/fm_discriminator.hpp"
 #include "registry.hpp"
 
 
@@ -10,73 +11,91 @@ using namespace std;
 using namespace suo;
 
 
-/*
-
+PSKDemodulator::Config::Config() {
+	sample_rate = 1e6;
+	symbol_rate = 9600;
+	center_frequency = 100e3;
+	frequency_offset = 0.0f;
+	maximum_frequency_offset = 500.0f;
+	bits_per_symbol = 1;
+	differential = false;
+	samples_per_symbol = 4;
 
-https://github.com/jgaeddert/liquid-dsp/blob/master/examples/nco_pll_modem_example.c
-https://github.com/jgaeddert/liquid-dsp/blob/master/examples/symsync_crcf_example.c#L100
+	pll_bandwidth0 = 0.02f;
+	pll_bandwidth1 = 0.005f;
 
-*/
+	agc_bandwidth0 = 1e-2f;
+	agc_bandwidth1 = 1e-3f;
 
-PSKDemodulator::Config::Config() {
-	center_frequency = 100;
-	samples_per_symbol = 4;
-	filter_delay = 5;
-	bt = 0.3;
+	symsync_bandwidth0 = 0.01f;
+	symsync_bandwidth1 = 0.005f;
 }
 
 
 PSKDemodulator::PSKDemodulator(const Config& conf) :
-	conf(conf)
+	conf(conf),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("PSKDemodulator")),
+	metric_symbols(MetricsRegistry::getDefault().counter("suo_symbols_total", "Number of demodulated symbols", metric_labels))
 {
+	if (conf.bits_per_symbol < 1 || conf.bits_per_symbol > 3)
+		throw SuoError("PSKDemodulator: Unsupported bits per symbol %d", conf.bits_per_symbol);
+	if (conf.samples_per_symbol < 2)
+		throw SuoError("PSKDemodulator: At least 2 samples per symbol required");
 
-	float signal_bandwidth = conf.symbol_rate; // [Hz]   For BPSK!!!
+	float signal_bandwidth = 2 * conf.symbol_rate; // [Hz] Main lobe of the rectangular pulse
 	if ((abs(conf.center_frequency) + 0.5 * signal_bandwidth) / conf.sample_rate > 0.5)
 		throw SuoError("PSKDemodulator: Center frequency too large for given sample rate!");
 
+	/* Mix to baseband and decimate by the largest possible factor before the resampler */
+	frontend = std::make_unique<DecimatingFrontend>(conf.sample_rate, conf.symbol_rate * conf.samples_per_symbol, signal_bandwidth);
+	const float decimated_rate = frontend->getOutputRate();
+
 	/* Configure a resampler for a fixed oversampling ratio */
-	float resamprate = conf.symbol_rate * conf.samples_per_symbol / conf.sample_rate;
+	float resamprate = conf.symbol_rate * conf.samples_per_symbol / decimated_rate;
 	double bw = 0.4 * resamprate / conf.samples_per_symbol;
 	int semilen = lroundf(1.0f / bw);
 	l_resamp = resamp_crcf_create(resamprate, semilen, bw, 60.0f, 16);
-	resamp_crcf_print(l_resamp);
-
-	/* Calculate maximum number of output samples after feeding one sample
-	 * to the resampler. This is needed to allocate a big enough array. */
-	resampint = ceilf(1 / resamprate);
-	sample_ns = roundf(1.0e9 / conf.sample_rate);
-
-	/* NCO:
-	 * Limit AFC range to half of symbol rate to keep it
-	 * from wandering too far */
-	nco_1Hz = pi2f / conf.sample_rate;
-	l_nco = nco_crcf_create(LIQUID_NCO);
-	nco_crcf_pll_set_bandwidth(l_nco, 0.5 * nco_1Hz);
-	update_nco();
+	sample_ns = round(1.0e9 / (conf.symbol_rate * conf.samples_per_symbol)); // Resampled rate
 
+	/* Symbol timestamps are corrected by the delay of the front-end and the resampler (semilen input samples) */
+	group_delay_ns = llround(1.0e9 * (frontend->getDelay() + semilen / decimated_rate));
 
 	/*
 	 * AGC: Automatic gain control
 	 */
 	l_agc = agc_crcf_create();
-	agc_crcf_set_bandwidth(l_agc, 1e-3f);
-	//agc_crcf_set_gain_limits(l_agc, 1e-2f, 1e2f);
-
-	l_demod_delay = windowcf_create(4 * conf.samples_per_symbol);
-
+	agc_crcf_set_bandwidth(l_agc, conf.agc_bandwidth0 / conf.samples_per_symbol);
 
-	l_mod = modem_create(LIQUID_MODEM_PSK2);
-
-	/* Symbol synchroniser */
-	unsigned int m = 5;                 // filter delay (symbols)
-	float        beta = 0.5f;           // filter excess bandwidth factor
-	unsigned int num_filters = 32;      // number of filters in the bank
-	unsigned int num_symbols = 400;     // number of data symbols
-
-	l_sync = symsync_crcf_create_rnyquist(LIQUID_FIRFILT_ARKAISER,
-		conf.samples_per_symbol, m, beta, num_filters);
+	/*
+	 * Matched filter for the rectangular pulse
+	 */
+	vector<float> taps(conf.samples_per_symbol, 1.0f / conf.samples_per_symbol);
+	l_mfilt = firfilt_crcf_create(taps.data(), taps.size());
+	mfilt_delay = 0.5f * (conf.samples_per_symbol - 1);
+
+	/* Symbol synchronizer */
+	SymbolSync<Sample>::Config sync_conf;
+	sync_conf.detector = SymbolSync<Sample>::Gardner;
+	sync_conf.samples_per_symbol = conf.samples_per_symbol;
+	sync_conf.bandwidth = conf.symsync_bandwidth0;
+	symsync = std::make_unique<SymbolSync<Sample>>(sync_conf);
+
+	/* Constellation: Gray mapped symbols at angles 2*pi*k/M like liquid-dsp's PSK modems */
+	constellation_size = 1 << conf.bits_per_symbol;
+	constellation.resize(constellation_size);
+	for (unsigned int k = 0; k < constellation_size; k++)
+		constellation[k ^ (k >> 1)] = polar(1.0f, pi2f * k / constellation_size);
+
+	const CostasLoopOrder orders[] = { CostasLoopBPSK, CostasLoopQPSK, CostasLoop8PSK };
+	pll_order = orders[conf.bits_per_symbol - 1];
 
-	symsync_crcf_set_lf_bw(l_sync, conf.symsync_bw0); // loop filter bandwidth
+	/*
+	 * Costas loop:
+	 * Tracks the residual frequency after the front-end's coarse mixing.
+	 * The frequency is limited to keep it from wandering too far.
+	 */
+	nco_1Hz = pi2f / conf.symbol_rate;
+	update_pll(conf.pll_bandwidth0);
 
 	reset();
 }
@@ -84,16 +103,25 @@ PSKDemodulator::PSKDemodulator(const Config& conf) :
 
 PSKDemodulator::~PSKDemodulator()
 {
+	resamp_crcf_destroy(l_resamp);
 	agc_crcf_destroy(l_agc);
-	symsync_crcf_destroy(l_sync);
-	windowcf_destroy(l_demod_delay);
-	modemcf_destroy(l_mod);
+	firfilt_crcf_destroy(l_mfilt);
 }
 
 
 void PSKDemodulator::reset() {
+	frontend->reset();
+	resamp_crcf_reset(l_resamp);
 	agc_crcf_reset(l_agc);
-	nco_crcf_reset(l_nco);
+	firfilt_crcf_reset(l_mfilt);
+	symsync->reset();
+
+	pll_phase = 0.0f;
+	pll_freq = 0.0f;
+	prev_symbol = 1.0f;
+	prev_index = 0;
+	receiver_lock = false;
+	update_nco();
 }
 
 
@@ -101,124 +129,152 @@ void PSKDemodulator::update_nco()
 {
 	conf_dirty = false;
 
-	// Calclate new frequency limits
+	// Move the coarse mixing to the new center frequency
 	float center_frequency = (conf.center_frequency + conf.frequency_offset);
-	freq_min = nco_1Hz * (center_frequency - 0.5f * conf.symbol_rate);
-	freq_max = nco_1Hz * (center_frequency + 0.5f * conf.symbol_rate);
-
-#if 1
-	// Clamp the NCO frequency between new limits
-	float old_freq = nco_crcf_get_frequency(l_nco);
-	nco_crcf_set_frequency(l_nco, clamp(old_freq, freq_min, freq_max));
-#else
-	// Set new NCO frequency 
-	nco_crcf_set_frequency(l_nco, nco_1Hz * center_frequency);
-#endif
+	float center_change = center_frequency - frontend->getFrequency();
+	frontend->setFrequency(center_frequency);
+
+	// Costas loop frequency limits relative to the new center
+	freq_min = nco_1Hz * -conf.maximum_frequency_offset;
+	freq_max = nco_1Hz * +conf.maximum_frequency_offset;
+
+	/* Keep the absolute frequency if it's still inside the new limits.
+	 * Otherwise (e.g. a new offset from the FrequencyAcquisition) retune to the new center. */
+	pll_freq -= nco_1Hz * center_change;
+	if (pll_freq < freq_min || pll_freq > freq_max)
+		pll_freq = 0.0f;
 }
 
 
-void PSKDemodulator::sinkSamples(const SampleVector& samples, Timestamp timestamp)
+void PSKDemodulator::update_pll(float bandwidth)
 {
-	float phase_error;
-	
-	/* Allocate small buffers from stack */
-	Sample samples2[resampint];
+	/* Proportional-integral loop filter gains for given noise bandwidth with damping of 0.707 */
+	const float zeta = 0.707f;
+	const float theta = bandwidth / (zeta + 0.25f / zeta);
+	const float d = 1 + 2 * zeta * theta + theta * theta;
+	pll_alpha = 4 * zeta * theta / d;
+	pll_beta = 4 * theta * theta / d;
+}
+
 
+void PSKDemodulator::sinkSamples(const SampleVector& samples, Timestamp now)
+{
 	if (conf_dirty && receiver_lock == false)
 		update_nco();
 
-	size_t si;
-	for (si = 0; si < samples.size(); si++) {
-		unsigned nsamp2 = 0, si2;
-		Sample s = samples[si];
+	/* Coarse mixing and decimation for the whole buffer */
+	frontend->execute(samples, decimated);
+
+	/* Resample, AGC and matched filter the whole buffer */
+	unsigned int nresampled = 0;
+	resampled.resize((size_t)ceilf(decimated.size() * resamp_crcf_get_rate(l_resamp)) + 4);
+	resamp_crcf_execute_block(l_resamp, decimated.data(), decimated.size(), resampled.data(), &nresampled);
+	resampled.resize(nresampled);
+
+	agc_crcf_execute_block(l_agc, resampled.data(), resampled.size(), resampled.data());
+	firfilt_crcf_execute_block(l_mfilt, resampled.data(), resampled.size(), resampled.data());
 
-		/* Downconvert and resample one input sample at a time */
-		nco_crcf_step(l_nco);
-		nco_crcf_mix_down(l_nco, s, &s);
+	/* Run symbol synchronization for the whole buffer */
+	symsync->execute(resampled.data(), resampled.size(), synced_symbols, symbol_positions);
 
-		Sample r, x_hat;
+	const float k = sqrt(2.f) - 1.f;
+	const Sample rotation = polar(1.0f, 0.5f * pi2f / constellation_size);
+	const float sector = constellation_size / pi2f;
 
-		enum CostasLoopOrder pll_order = CostasLoopBPSK;
-		const float k = sqrt(2.f) - 1.f;
+	for (size_t si = 0; si < synced_symbols.size(); si++) {
 
-		switch(pll_order) {
+		/* Remove the carrier phase */
+		const Sample z = synced_symbols[si] * polar(1.0f, -pll_phase);
+
+		/* Costas loop phase error. QPSK and 8PSK detectors expect the constellation rotated by pi/M. */
+		const Sample r = (pll_order == CostasLoopBPSK) ? z : z * rotation;
+		float phase_error;
+		switch (pll_order) {
 		case CostasLoopBPSK:
 			phase_error = r.real() * r.imag();
 			break;
 
 		case CostasLoopQPSK:
 		case CostasLoopGMSK:
-			phase_error = copysign(r.imag(), r.real()) - copysign(r.real(), r.imag());
+			phase_error = copysignf(1.0f, r.real()) * r.imag() - copysignf(1.0f, r.imag()) * r.real();
 			break;
 
 		case CostasLoop8PSK:
+		default:
 			if (abs(r.real()) >= abs(r.imag()))
-				phase_error = copysign(r.imag(), r.real()) - k * copysign(r.real(), r.imag());
+				phase_error = copysignf(1.0f, r.real()) * r.imag() - k * copysignf(1.0f, r.imag()) * r.real();
 			else
-				phase_error = k * copysign(r.imag(), r.real()) - copysign(r.real(), r.imag());
-			break;
-			
-		default:
-			//phase_error = arg(r * conj(x_hat)); // FM demod
-			phase_error = (r * conj(x_hat)).imag(); // Dunno: modemcf_get_demodulator_phase_error
+				phase_error = k * copysignf(1.0f, r.real()) * r.imag() - copysignf(1.0f, r.imag()) * r.real();
 			break;
 		}
 
-		nco_crcf_pll_step(l_nco, -phase_error);
-
-		/* Clamp the PLL frequency between min and max */
-		float freq = nco_crcf_get_frequency(l_nco);
-		if (freq > freq_max)
-			nco_crcf_set_frequency(l_nco, freq_max);
-		if (freq < freq_min)
-			nco_crcf_set_frequency(l_nco, freq_min);
-
-
-		resamp_crcf_execute(l_resamp, s, samples2, &nsamp2);
-
-		/* Process output from the resampler one sample at a time */
-		for(si2 = 0; si2 < nsamp2; si2++) {
-			Sample s2 = samples2[si2];
-
-			/* AGC */
-			agc_crcf_execute(l_agc, s2, &s2);
-
-
-			/* Run symbols sync */
-			Complex synced_symbols[4];
-			unsigned int output_symbols = 0;
-			symsync_crcf_execute(l_sync, &s2, 1, synced_symbols, &output_symbols);
-			//symsync_crcf_step(l_sync, s2, synced_symbols, &output_symbols);
-
-			Sample s3 = synced_symbols[0];
-			
-
+		/* Loop filter. The frequency is clamped between min and max. */
+		pll_freq = clamp(pll_freq + pll_beta * phase_error, freq_min, freq_max);
+		pll_phase += pll_freq + pll_alpha * phase_error;
+		if (pll_phase > 0.5f * pi2f)
+			pll_phase -= pi2f;
+		else if (pll_phase < -0.5f * pi2f)
+			pll_phase += pi2f;
+
+		/* Hard decision: nearest constellation point */
+		int index = lroundf(fast_atan2f(z.imag(), z.real()) * sector);
+		index = (index + constellation_size) % constellation_size;
+
+		Sample soft = z;
+		unsigned int decision_index = index;
+		if (conf.differential) {
+			decision_index = (index + constellation_size - prev_index) % constellation_size;
+			const float prev_mag = abs(prev_symbol);
+			soft = z * conj(prev_symbol) / max(prev_mag, 1e-6f);
+			prev_symbol = z;
+			prev_index = index;
+		}
 
+		Timestamp symbol_time = now + (int64_t)((symbol_positions[si] - mfilt_delay) * sample_ns) - group_delay_ns;
+
+		Symbol decision = decision_index ^ (decision_index >> 1);
+		metric_symbols.inc();
+		sinkSymbol.emit(decision, symbol_time);
+
+		/* Max-log soft bits: difference of the squared distances to the nearest '0' and '1' points */
+		if (sinkSoftSymbol.has_connections()) {
+			float dist[8];
+			for (unsigned int c = 0; c < constellation_size; c++)
+				dist[c] = norm(soft - constellation[c]);
+
+			for (int bit = conf.bits_per_symbol - 1; bit >= 0; bit--) {
+				float min0 = 1e30f, min1 = 1e30f;
+				for (unsigned int c = 0; c < constellation_size; c++) {
+					if ((c >> bit) & 1)
+						min1 = min(min1, dist[c]);
+					else
+						min0 = min(min0, dist[c]);
+				}
+				sinkSoftSymbol.emit(0.25f * (min0 - min1), symbol_time);
+			}
 		}
-		timestamp += sample_ns;
 	}
 }
 
 
 void PSKDemodulator::lockReceiver(bool locked, Timestamp now) {
+	(void)now;
 	receiver_lock = locked;
-#if 0
 	if (locked) {
-		setMetadata.emit("cfo", nco_crcf_get_frequency(l_nco) / nco_1Hz);
+		setMetadata.emit("cfo", pll_freq / nco_1Hz);
 		setMetadata.emit("rssi", agc_crcf_get_rssi(l_agc));
 
 		// Sync acquired
-		symsync_crcf_set_lf_bw(l_sync, conf.symsync_bandwidth1);
-		nco_crcf_pll_set_bandwidth(l_nco, conf.pll_bandwidth1);
-		agc_crcf_set_bandwidth(l_agc, conf.agc_bandwidth1);
+		symsync->setBandwidth(conf.symsync_bandwidth1);
+		update_pll(conf.pll_bandwidth1);
+		agc_crcf_set_bandwidth(l_agc, conf.agc_bandwidth1 / conf.samples_per_symbol);
 	}
 	else {
 		// Sync lost
-		symsync_crcf_set_lf_bw(l_sync, conf.symsync_bandwidth0);
-		nco_crcf_pll_set_bandwidth(l_nco, conf.pll_bandwidth0);
-		agc_crcf_set_bandwidth(l_agc, conf.agc_bandwidth0);
+		symsync->setBandwidth(conf.symsync_bandwidth0);
+		update_pll(conf.pll_bandwidth0);
+		agc_crcf_set_bandwidth(l_agc, conf.agc_bandwidth0 / conf.samples_per_symbol);
 	}
-#endif
 }
 
 void PSKDemodulator::setFrequencyOffset(float frequency_offset) {
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <memory>
 #include "suo.hpp"
+#include "misc/metrics.hpp"
+#include "modem/decimating_frontend.hpp"
+#include "modem/symbol_sync.hpp"
 #include <liquid/liquid.h>
 
 
@@ -15,13 +19,29 @@ enum CostasLoopOrder {
 };
 
 /*
- * GMSK demodulator
+ * PSK demodulator
+ *
+ * Block based coherent receiver for BPSK, QPSK and 8PSK with rectangular pulses.
+ * Each buffer goes through the decimating front-end, fractional resampler,
+ * AGC and matched filter as whole, after which the symbol synchronizer
+ * picks one sample per symbol. Carrier phase and residual frequency are
+ * tracked with a Costas loop running at the symbol rate.
+ *
+ * Constellation and Gray mapping are the same as in liquid-dsp's PSK modems.
+ * The Costas loop has an M-fold phase ambiguity, so unless the link layer can resolve
+ * it, differential encoding should be used (see PSKModulator::Config::differential).
+ *
+ * Hard decisions are emitted as symbol indices. Soft decisions are emitted as
+ * bits_per_symbol soft bits per symbol, MSB first, positive meaning a '1'.
+ * Symbol timestamps are compensated for the front-end, resampler and matched filter delays.
+ * The "cfo" metadata is the residual offset (Hz) tracked by the Costas loop
+ * relative to center_frequency + frequency_offset.
  */
 class PSKDemodulator : public Block
 {
 public:
 
-	/* Configuration struct for the FSK demod */
+	/* Configuration struct for the PSK demod */
 	struct Config {
 		Config();
 
@@ -46,29 +66,35 @@ public:
 		float frequency_offset;
 
 		/* 
-		 * Maximum allowed frequency offset (Hz)
+		 * Maximum allowed frequency offset tracked by the Costas loop (Hz)
 		 */
 		float maximum_frequency_offset;
 
 		/*
-		 * Number of samples per symbol/bit after decimation.
+		 * Bits per symbol: 1 = BPSK, 2 = QPSK, 3 = 8PSK
 		 */
-		unsigned int samples_per_symbol;
-		unsigned int filter_delay;
+		unsigned int bits_per_symbol;
+
 		/*
-		 * Gaussian filter bandwidth-time product / excess bandwidth factor.
-		 * Usually 0.3 or 0.5
+		 * Differentially encoded symbols
 		 */
-		float bt;
+		bool differential;
+
+		/*
+		 * Number of samples per symbol/bit after decimation.
+		 */
+		unsigned int samples_per_symbol;
+
+		/* Costas loop noise bandwidth normalized to the symbol rate */
+		float pll_bandwidth0;
+		float pll_bandwidth1;
 
 		float agc_bandwidth0;
 		float agc_bandwidth1;
 
-		float afc_speed0;
-		float afc_speed1;
-
-		float symsync_bw0;
-		float symsync_bw1;
+		/* Symbol synchronizer loop bandwidth normalized to the symbol rate */
+		float symsync_bandwidth0;
+		float symsync_bandwidth1;
 	};
 
 	explicit PSKDemodulator(const Config& conf = Config());
@@ -92,32 +118,51 @@ public:
 private:
 
 	void update_nco();
+	void update_pll(float bandwidth);
 
 	/* Configuration */
 	Config conf;
 	bool conf_dirty;
 
-	// float resamprate;
 	Timestamp sample_ns;
-	unsigned resampint;
-	float nco_1Hz;
-	float afc_speed;
+	Timestamp group_delay_ns;
+	unsigned int constellation_size;
+	CostasLoopOrder pll_order;
+	float mfilt_delay;
 	bool receiver_lock;
 
+	/* Costas loop state. Phase and frequency are in radians per symbol. */
+	float nco_1Hz;
+	float pll_phase, pll_freq;
+	float pll_alpha, pll_beta;
 	float freq_min, freq_max;
 
+	/* Decision state */
+	std::vector<Sample> constellation;
+	Sample prev_symbol;
+	unsigned int prev_index;
+
+	/* Coarse mixing and decimation */
+	std::unique_ptr<DecimatingFrontend> frontend;
+
+	/* Symbol timing recovery */
+	std::unique_ptr<SymbolSync<Sample>> symsync;
+
 	/* liquid-dsp objects */
-	nco_crcf l_nco;
-	modemcf l_mod;
 	resamp_crcf l_resamp;
 	agc_crcf l_agc;
-	symsync_crcf l_sync;
-	windowcf l_demod_delay;
+	firfilt_crcf l_mfilt;
 
 	/* Buffers */
-	Frame* frame;
+	SampleVector decimated;
+	SampleVector resampled;
+	std::vector<Sample> synced_symbols;
+	std::vector<float> symbol_positions;
+
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_symbols;
 
 };
 
 }; // namespace suo
-
@@ -0,0 +1,161 @@
+#include <cmath>
+#include <algorithm>
+
+#include "modem/energy_squelch.hpp"
+#include "registry.hpp"
+
+
+using namespace std;
+using namespace suo;
+
+
+EnergySquelch::Config::Config() {
+	sample_rate = 1e6;
+	block_size = 256;
+	open_threshold = 6.0f;
+	close_threshold = 3.0f;
+	hang_time = 0.05f;
+	pretrigger_time = 0.01f;
+	noise_time_constant = 2.0f;
+}
+
+
+EnergySquelch::EnergySquelch(const Config& conf) :
+	conf(conf),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("EnergySquelch")),
+	metric_samples(MetricsRegistry::getDefault().counter("suo_samples_in_total", "Number of received samples", metric_labels)),
+	metric_active_samples(MetricsRegistry::getDefault().counter("suo_squelch_active_samples_total", "Number of samples passed through the squelch", metric_labels))
+{
+	if (conf.sample_rate <= 0)
+		throw SuoError("EnergySquelch: Invalid sample rate");
+	if (conf.block_size == 0)
+		throw SuoError("EnergySquelch: Zero block size");
+	if (conf.close_threshold > conf.open_threshold)
+		throw SuoError("EnergySquelch: Close threshold above the open threshold");
+
+	sample_ns = round(1.0e9 / conf.sample_rate);
+	open_ratio = powf(10.0f, conf.open_threshold / 10.0f);
+	close_ratio = powf(10.0f, conf.close_threshold / 10.0f);
+
+	const float block_time = conf.block_size / conf.sample_rate;
+	hang_blocks = ceilf(conf.hang_time / block_time);
+	noise_alpha = min(1.0f, block_time / conf.noise_time_constant);
+
+	ring.resize(max<size_t>(1, lroundf(conf.pretrigger_time * conf.sample_rate)));
+
+	reset();
+}
+
+
+void EnergySquelch::reset() {
+	open = false;
+	hang_counter = 0;
+	noise_floor = -1.0f; // Initialized from the first block
+	block_power = 0.0f;
+	block_idx = 0;
+	ring_head = 0;
+	ring_count = 0;
+	output.clear();
+	output_time = 0;
+	total_samples = 0;
+	active_samples = 0;
+}
+
+
+void EnergySquelch::flushOutput() {
+	if (output.empty())
+		return;
+	active_samples += output.size();
+	metric_active_samples.inc(output.size());
+	gatedSamples.emit(output, output_time);
+	output.clear();
+}
+
+
+void EnergySquelch::sinkSamples(const SampleVector& samples, Timestamp now) {
+
+	total_samples += samples.size();
+	metric_samples.inc(samples.size());
+	if (output.capacity() < samples.size() + ring.size())
+		output.reserve(samples.size() + ring.size());
+
+	for (size_t i = 0; i < samples.size(); i++) {
+		const Sample s = samples[i];
+
+		if (open) {
+			if (output.empty())
+				output_time = now + i * sample_ns;
+			output.push_back(s);
+		}
+		else {
+			ring[ring_head] = s;
+			ring_head = (ring_head + 1) % ring.size();
+			ring_count = min(ring_count + 1, ring.size());
+		}
+
+		block_power += norm(s);
+		if (++block_idx < conf.block_size)
+			continue;
+
+		/* Power measurement block completed */
+		const float power = block_power / conf.block_size;
+		block_power = 0.0f;
+		block_idx = 0;
+
+		if (noise_floor < 0.0f)
+			noise_floor = power;
+
+		if (open) {
+			if (power < close_ratio * noise_floor) {
+				if (++hang_counter >= hang_blocks) {
+					/* Close the squelch */
+					open = false;
+					flushOutput();
+					squelchChanged.emit(false, now + (i + 1) * sample_ns);
+				}
+			}
+			else {
+				hang_counter = 0;
+			}
+		}
+		else if (power > open_ratio * noise_floor) {
+			/* Open the squelch and release the pre-trigger samples (oldest first) */
+			open = true;
+			hang_counter = 0;
+
+			const Timestamp current_time = now + (i + 1) * sample_ns;
+			squelchChanged.emit(true, current_time);
+
+			output_time = current_time - ring_count * sample_ns;
+			size_t idx = (ring_head + ring.size() - ring_count) % ring.size();
+			for (size_t j = 0; j < ring_count; j++) {
+				output.push_back(ring[idx]);
+				idx = (idx + 1) % ring.size();
+			}
+			ring_count = 0;
+		}
+		else {
+			/* Track the noise floor only while closed. Fall fast and rise slowly
+			 * so that a long weak signal doesn't lift the floor too quickly. */
+			const float alpha = (power < noise_floor) ? min(1.0f, 8 * noise_alpha) : noise_alpha;
+			noise_floor += alpha * (power - noise_floor);
+		}
+	}
+
+	flushOutput();
+}
+
+
+float EnergySquelch::dutyCycle() const {
+	if (total_samples == 0)
+		return 0.0f;
+	return (float)active_samples / total_samples;
+}
+
+
+Block* createEnergySquelch(const Kwargs& args)
+{
+	return new EnergySquelch();
+}
+
+static Registry registerEnergySquelch("EnergySquelch", &createEnergySquelch);
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "suo.hpp"
+#include "misc/metrics.hpp"
+
+namespace suo {
+
+/*
+ * Energy detecting squelch.
+ *
+ * Measures the signal power in blocks of samples and compares it to a slowly
+ * tracked noise floor. Samples are passed to the demodulator only while the
+ * squelch is open, so idle channels cost only the power measurement.
+ * The squelch opens when the block SNR exceeds open_threshold and closes after
+ * the SNR has stayed below close_threshold for hang_time. The samples of the
+ * pre-trigger time before the opening are kept in a ring buffer and are passed
+ * on first so that the start of a burst (preamble) is not lost.
+ */
+class EnergySquelch : public Block
+{
+public:
+
+	struct Config {
+		Config();
+
+		/* Input IQ sample rate as samples per second. */
+		float sample_rate;
+
+		/* Number of samples in one power measurement block */
+		unsigned int block_size;
+
+		/* SNR (dB) above the noise floor to open the squelch */
+		float open_threshold;
+
+		/* SNR (dB) above the noise floor under which the squelch is closed */
+		float close_threshold;
+
+		/* Time the SNR has to stay under the close threshold before closing (seconds) */
+		float hang_time;
+
+		/* Length of the pre-trigger buffer (seconds) */
+		float pretrigger_time;
+
+		/* Time constant of the noise floor tracking (seconds) */
+		float noise_time_constant;
+	};
+
+	explicit EnergySquelch(const Config& conf = Config());
+
+	void reset();
+
+	void sinkSamples(const SampleVector& samples, Timestamp now);
+
+	/* Is the squelch currently open */
+	bool isOpen() const { return open; }
+
+	/* Fraction of the input samples passed through */
+	float dutyCycle() const;
+
+	/* Current noise floor estimate (power per sample) */
+	float noiseFloor() const { return noise_floor; }
+
+	/* Gated samples for the demodulator. Timestamp is the time of the first sample. */
+	Port<const SampleVector&, Timestamp> gatedSamples;
+
+	/* Emitted when the squelch opens (true) or closes (false). Can be used to reset the demodulator. */
+	Port<bool, Timestamp> squelchChanged;
+
+private:
+	void flushOutput();
+
+	/* Configuration */
+	const Config conf;
+	Timestamp sample_ns;
+	float open_ratio, close_ratio;
+	unsigned int hang_blocks;
+	float noise_alpha;
+
+	/* State */
+	bool open;
+	unsigned int hang_counter;
+	float noise_floor;
+	float block_power;
+	unsigned int block_idx;
+
+	/* Pre-trigger ring buffer */
+	std::vector<Sample> ring;
+	size_t ring_head, ring_count;
+
+	/* Output buffer */
+	SampleVector output;
+	Timestamp output_time;
+
+	/* Statistics */
+	uint64_t total_samples, active_samples;
+	MetricLabels metric_labels;
+	Counter& metric_samples;
+	Counter& metric_active_samples;
+};
+
+}; // namespace suo
@@ -0,0 +1,207 @@
+#include "modem/fm_discriminator.hpp"
+
+#ifdef SUO_FM_SIMD
+#include <immintrin.h>
+#endif
+
+using namespace suo;
+
+
+FMKernel suo::fm_kernel_available() {
+#ifdef SUO_FM_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return FMKernelAVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return FMKernelSSE;
+#endif
+	return FMKernelScalar;
+}
+
+FMKernel suo::fm_kernel = suo::fm_kernel_available();
+
+
+/* Polynomial coefficients and constants shared by all kernels */
+static const float atan_c1 = 0.99997726f;
+static const float atan_c3 = -0.33262347f;
+static const float atan_c5 = 0.19354346f;
+static const float atan_c7 = -0.11643287f;
+static const float atan_c9 = 0.05265332f;
+static const float atan_c11 = -0.01172120f;
+static const float half_pi = 1.57079637f;
+static const float pi = 3.14159274f;
+
+
+#ifdef SUO_FM_SIMD
+
+/* Four atan2s with SSE2. Quadrant corrections are made with masks because SSE2 has no blend. */
+__attribute__((target("sse2")))
+static inline __m128 atan2_sse(__m128 y, __m128 x) {
+	const __m128 sign_mask = _mm_set1_ps(-0.0f);
+	const __m128 ax = _mm_andnot_ps(sign_mask, x);
+	const __m128 ay = _mm_andnot_ps(sign_mask, y);
+	const __m128 mx = _mm_max_ps(ax, ay);
+	const __m128 mn = _mm_min_ps(ax, ay);
+
+	/* a = mn / mx, zero when both are zero */
+	const __m128 nonzero = _mm_cmpgt_ps(mx, _mm_setzero_ps());
+	const __m128 a = _mm_and_ps(_mm_div_ps(mn, _mm_or_ps(mx, _mm_andnot_ps(nonzero, _mm_set1_ps(1.0f)))), nonzero);
+	const __m128 s = _mm_mul_ps(a, a);
+
+	__m128 p = _mm_set1_ps(atan_c11);
+	p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(atan_c9));
+	p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(atan_c7));
+	p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(atan_c5));
+	p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(atan_c3));
+	p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(atan_c1));
+	__m128 r = _mm_mul_ps(a, p);
+
+	/* |y| > |x|: r = pi/2 - r */
+	__m128 mask = _mm_cmpgt_ps(ay, ax);
+	r = _mm_or_ps(_mm_and_ps(mask, _mm_sub_ps(_mm_set1_ps(half_pi), r)), _mm_andnot_ps(mask, r));
+
+	/* x negative (incl. -0): r = pi - r */
+	mask = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(x), 31));
+	r = _mm_or_ps(_mm_and_ps(mask, _mm_sub_ps(_mm_set1_ps(pi), r)), _mm_andnot_ps(mask, r));
+
+	/* Copy the sign of y */
+	return _mm_or_ps(r, _mm_and_ps(sign_mask, y));
+}
+
+
+/* Eight atan2s with AVX2 and FMA */
+__attribute__((target("avx2,fma")))
+static inline __m256 atan2_avx2(__m256 y, __m256 x) {
+	const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+	const __m256 ax = _mm256_andnot_ps(sign_mask, x);
+	const __m256 ay = _mm256_andnot_ps(sign_mask, y);
+	const __m256 mx = _mm256_max_ps(ax, ay);
+	const __m256 mn = _mm256_min_ps(ax, ay);
+
+	const __m256 nonzero = _mm256_cmp_ps(mx, _mm256_setzero_ps(), _CMP_GT_OQ);
+	const __m256 a = _mm256_and_ps(_mm256_div_ps(mn, _mm256_blendv_ps(_mm256_set1_ps(1.0f), mx, nonzero)), nonzero);
+	const __m256 s = _mm256_mul_ps(a, a);
+
+	__m256 p = _mm256_set1_ps(atan_c11);
+	p = _mm256_fmadd_ps(p, s, _mm256_set1_ps(atan_c9));
+	p = _mm256_fmadd_ps(p, s, _mm256_set1_ps(atan_c7));
+	p = _mm256_fmadd_ps(p, s, _mm256_set1_ps(atan_c5));
+	p = _mm256_fmadd_ps(p, s, _mm256_set1_ps(atan_c3));
+	p = _mm256_fmadd_ps(p, s, _mm256_set1_ps(atan_c1));
+	__m256 r = _mm256_mul_ps(a, p);
+
+	r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(half_pi), r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+	r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(pi), r), x); // blendv uses only the sign bit of x
+	return _mm256_or_ps(r, _mm256_and_ps(sign_mask, y));
+}
+
+
+__attribute__((target("sse2")))
+static size_t atan2_buffer_sse(const float* y, const float* x, float* out, size_t len) {
+	size_t i = 0;
+	for (; i + 4 <= len; i += 4)
+		_mm_storeu_ps(&out[i], atan2_sse(_mm_loadu_ps(&y[i]), _mm_loadu_ps(&x[i])));
+	return i;
+}
+
+__attribute__((target("avx2,fma")))
+static size_t atan2_buffer_avx2(const float* y, const float* x, float* out, size_t len) {
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8)
+		_mm256_storeu_ps(&out[i], atan2_avx2(_mm256_loadu_ps(&y[i]), _mm256_loadu_ps(&x[i])));
+	return i;
+}
+
+
+/*
+ * Discriminator kernels. cur points to in[i] and prv to in[i - 1].
+ * conj(p) * c = (p.re * c.re + p.im * c.im) + j (p.re * c.im - p.im * c.re)
+ */
+__attribute__((target("sse2")))
+static size_t discriminate_sse(const Sample* in, size_t len, float* out, float gain) {
+	const __m128 g = _mm_set1_ps(gain);
+	size_t i = 1;
+	for (; i + 4 <= len; i += 4) {
+		const float* cur = reinterpret_cast<const float*>(&in[i]);
+		const float* prv = reinterpret_cast<const float*>(&in[i - 1]);
+
+		/* Deinterleave four complex samples to real and imaginary parts */
+		const __m128 c0 = _mm_loadu_ps(cur), c1 = _mm_loadu_ps(cur + 4);
+		const __m128 p0 = _mm_loadu_ps(prv), p1 = _mm_loadu_ps(prv + 4);
+		const __m128 cre = _mm_shuffle_ps(c0, c1, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 cim = _mm_shuffle_ps(c0, c1, _MM_SHUFFLE(3, 1, 3, 1));
+		const __m128 pre = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 pim = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1));
+
+		const __m128 re = _mm_add_ps(_mm_mul_ps(pre, cre), _mm_mul_ps(pim, cim));
+		const __m128 im = _mm_sub_ps(_mm_mul_ps(pre, cim), _mm_mul_ps(pim, cre));
+		_mm_storeu_ps(&out[i], _mm_mul_ps(atan2_sse(im, re), g));
+	}
+	return i;
+}
+
+__attribute__((target("avx2,fma")))
+static size_t discriminate_avx2(const Sample* in, size_t len, float* out, float gain) {
+	const __m256 g = _mm256_set1_ps(gain);
+	size_t i = 1;
+	for (; i + 8 <= len; i += 8) {
+		const float* cur = reinterpret_cast<const float*>(&in[i]);
+		const float* prv = reinterpret_cast<const float*>(&in[i - 1]);
+
+		/* Deinterleaving within 128-bit lanes gives the order 0 1 4 5 2 3 6 7 */
+		const __m256 c0 = _mm256_loadu_ps(cur), c1 = _mm256_loadu_ps(cur + 8);
+		const __m256 p0 = _mm256_loadu_ps(prv), p1 = _mm256_loadu_ps(prv + 8);
+		const __m256 cre = _mm256_shuffle_ps(c0, c1, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m256 cim = _mm256_shuffle_ps(c0, c1, _MM_SHUFFLE(3, 1, 3, 1));
+		const __m256 pre = _mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m256 pim = _mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1));
+
+		const __m256 re = _mm256_fmadd_ps(pre, cre, _mm256_mul_ps(pim, cim));
+		const __m256 im = _mm256_fmsub_ps(pre, cim, _mm256_mul_ps(pim, cre));
+		__m256 r = _mm256_mul_ps(atan2_avx2(im, re), g);
+
+		/* Restore the sample order */
+		r = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0)));
+		_mm256_storeu_ps(&out[i], r);
+	}
+	return i;
+}
+
+#endif
+
+
+void suo::fast_atan2f(const float* y, const float* x, float* out, size_t len) {
+	size_t i = 0;
+#ifdef SUO_FM_SIMD
+	if (fm_kernel == FMKernelAVX2)
+		i = atan2_buffer_avx2(y, x, out, len);
+	else if (fm_kernel == FMKernelSSE)
+		i = atan2_buffer_sse(y, x, out, len);
+#endif
+	for (; i < len; i++)
+		out[i] = fast_atan2f(y[i], x[i]);
+}
+
+
+void suo::fm_discriminate(const Sample* in, size_t len, float* out, Sample& prev, float gain) {
+	if (len == 0)
+		return;
+
+	/* First sample needs the sample from the previous buffer */
+	const Sample d = conj(prev) * in[0];
+	out[0] = gain * fast_atan2f(d.imag(), d.real());
+
+	size_t i = 1;
+#ifdef SUO_FM_SIMD
+	if (fm_kernel == FMKernelAVX2)
+		i = discriminate_avx2(in, len, out, gain);
+	else if (fm_kernel == FMKernelSSE)
+		i = discriminate_sse(in, len, out, gain);
+#endif
+	for (; i < len; i++) {
+		const Sample d = conj(in[i - 1]) * in[i];
+		out[i] = gain * fast_atan2f(d.imag(), d.real());
+	}
+
+	prev = in[len - 1];
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "suo.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SUO_FM_SIMD
+#endif
+
+namespace suo
+{
+
+/* Instruction set used by the buffer kernels */
+enum FMKernel {
+	FMKernelScalar = 0,
+	FMKernelSSE = 1,
+	FMKernelAVX2 = 2,
+};
+
+/* Kernel used by fast_atan2f() and fm_discriminate(). Initialized by CPU feature detection. */
+extern FMKernel fm_kernel;
+
+/* Best kernel supported by the CPU */
+FMKernel fm_kernel_available();
+
+/*
+ * Polynomial approximation of atan2.
+ * The argument is reduced to [0, 1] where atan is approximated with
+ * an 11th order odd minimax polynomial.
+ * Maximum error is about 2e-6 radians. atan2(0, 0) returns 0 like std::arg.
+ */
+inline float fast_atan2f(float y, float x) {
+	const float ax = std::abs(x), ay = std::abs(y);
+	const float mx = std::max(ax, ay), mn = std::min(ax, ay);
+	const float a = (mx > 0.0f) ? mn / mx : 0.0f;
+	const float s = a * a;
+	float r = a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f + s * (0.05265332f + s * -0.01172120f)))));
+	if (ay > ax)
+		r = 1.57079637f - r;
+	if (std::signbit(x))
+		r = 3.14159274f - r;
+	return std::copysign(r, y);
+}
+
+/*
+ * Calculate atan2 for whole buffers: out[i] = atan2(y[i], x[i])
+ */
+void fast_atan2f(const float* y, const float* x, float* out, size_t len);
+
+/*
+ * Quadrature FM discriminator for a buffer of samples:
+ *   out[i] = gain * arg(conj(in[i - 1]) * in[i])
+ * Args:
+ *   in: Input samples
+ *   len: Number of input samples
+ *   out: Output buffer for len discriminator values
+ *   prev: Last sample of the previous buffer. Updated to the last input sample.
+ *   gain: Output scaling (e.g. samples per symbol / (pi * modindex))
+ */
+void fm_discriminate(const Sample* in, size_t len, float* out, Sample& prev, float gain = 1.0f);
+
+}; // namespace suo
@@ -0,0 +1,259 @@
+#include <cmath>
+#include <iostream>
+
+#include "modem/frequency_acquisition.hpp"
+#include "registry.hpp"
+
+
+using namespace std;
+using namespace suo;
+
+
+FrequencyAcquisition::Config::Config() {
+	sample_rate = 1e6;
+	symbol_rate = 9600;
+	modindex = 0.5f;
+	center_frequency = 0.0f;
+	max_offset = 20e3f;
+	sync_pattern = 0xAAAA1ACFFC1D;
+	sync_pattern_len = 48;
+	threshold = 0.4f;
+	lag_step = 0.5f;
+	holdoff_time = 0.5f;
+	threads = 1;
+}
+
+
+FrequencyAcquisition::FrequencyAcquisition(const Config& conf) :
+	conf(conf),
+	search_round(0),
+	busy(0),
+	stopping(false)
+{
+	if (conf.sample_rate <= 0 || conf.symbol_rate <= 0)
+		throw SuoError("FrequencyAcquisition: Invalid sample or symbol rate!");
+	if (conf.sync_pattern_len == 0 || conf.sync_pattern_len > 64)
+		throw SuoError("FrequencyAcquisition: Invalid sync pattern length %d", conf.sync_pattern_len);
+	if (abs(conf.center_frequency) + conf.max_offset >= 0.5f * conf.sample_rate)
+		throw SuoError("FrequencyAcquisition: Searched frequency range exceeds the sample rate!");
+	if (conf.threads == 0)
+		throw SuoError("FrequencyAcquisition: Zero threads");
+
+	sample_ns = round(1.0e9 / conf.sample_rate);
+	const float samples_per_symbol = conf.sample_rate / conf.symbol_rate;
+	lag_step = max<size_t>(1, lroundf(conf.lag_step * samples_per_symbol));
+
+	/*
+	 * Generate the reference waveform as a continuous phase FSK signal
+	 * with rectangular pulses. Gaussian filtering of GMSK is ignored because
+	 * it has only a small effect on the correlation peak.
+	 */
+	const size_t ref_len = lroundf(conf.sync_pattern_len * samples_per_symbol);
+	reference.resize(ref_len);
+	float phase = 0.0f;
+	for (size_t i = 0; i < ref_len; i++) {
+		unsigned int bit_idx = min<size_t>(i / samples_per_symbol, conf.sync_pattern_len - 1);
+		bool bit = (conf.sync_pattern >> (conf.sync_pattern_len - 1 - bit_idx)) & 1;
+		phase += (bit ? 1.0f : -1.0f) * M_PI * conf.modindex / samples_per_symbol;
+		reference[i] = polar(1.0f, -phase); // Conjugated
+	}
+
+	/* Zero pad the FFT to at least twice the reference length to reduce scalloping */
+	fft_len = 1;
+	while (fft_len < 2 * ref_len)
+		fft_len <<= 1;
+
+	const float bin_hz = conf.sample_rate / fft_len;
+	bin_min = (int)floorf((conf.center_frequency - conf.max_offset) / bin_hz);
+	bin_max = (int)ceilf((conf.center_frequency + conf.max_offset) / bin_hz);
+
+	workers.resize(conf.threads);
+	for (Worker& worker: workers) {
+		worker.fft_in.resize(fft_len, 0.0f);
+		worker.fft_out.resize(fft_len);
+		worker.plan = fft_create_plan(fft_len, worker.fft_in.data(), worker.fft_out.data(), LIQUID_FFT_FORWARD, 0);
+	}
+
+	reset();
+
+	for (unsigned int w = 1; w < workers.size(); w++)
+		threads.emplace_back(&FrequencyAcquisition::workerThread, this, w);
+}
+
+
+FrequencyAcquisition::~FrequencyAcquisition() {
+	stopping.store(true, memory_order_release);
+	search_round.fetch_add(1, memory_order_release);
+	search_round.notify_all();
+	for (thread& t: threads)
+		t.join();
+
+	for (Worker& worker: workers)
+		fft_destroy_plan(worker.plan);
+}
+
+
+void FrequencyAcquisition::reset() {
+	history.clear();
+	energy.assign(1, 0.0);
+	history_start = 0;
+	next_lag = 0;
+	receiver_locked = false;
+	holdoff_until = 0;
+}
+
+
+FrequencyAcquisition::Detection FrequencyAcquisition::search(Worker& worker, size_t lag_begin, size_t lag_end) const {
+	Detection best = { -1.0f, 0.0f, 0 };
+	const size_t ref_len = reference.size();
+	const int n = fft_len;
+
+	for (size_t lag = lag_begin; lag < lag_end; lag += lag_step) {
+
+		const double window_energy = energy[lag + ref_len] - energy[lag];
+		if (window_energy <= 0.0)
+			continue;
+
+		/* Remove the reference modulation; the rest is a tone at the carrier offset */
+		const Sample* x = &history[lag];
+		for (size_t i = 0; i < ref_len; i++)
+			worker.fft_in[i] = x[i] * reference[i];
+		fft_execute(worker.plan);
+
+		/* Find the strongest frequency hypothesis */
+		float peak = -1.0f;
+		int peak_bin = 0;
+		for (int k = bin_min; k <= bin_max; k++) {
+			float mag = norm(worker.fft_out[(k + n) % n]);
+			if (mag > peak) {
+				peak = mag;
+				peak_bin = k;
+			}
+		}
+
+		const float metric = peak / (window_energy * ref_len);
+		if (metric > best.metric) {
+			/* Parabolic interpolation between the neighbouring bins */
+			float a = abs(worker.fft_out[(peak_bin - 1 + n) % n]);
+			float b = abs(worker.fft_out[(peak_bin + n) % n]);
+			float c = abs(worker.fft_out[(peak_bin + 1 + n) % n]);
+			float denom = a - 2 * b + c;
+			float delta = (denom != 0.0f) ? 0.5f * (a - c) / denom : 0.0f;
+
+			best.metric = metric;
+			best.frequency = (peak_bin + delta) * conf.sample_rate / fft_len;
+			best.lag = lag;
+		}
+	}
+
+	return best;
+}
+
+
+void FrequencyAcquisition::workerThread(unsigned int index) {
+	Worker& worker = workers[index];
+	uint32_t seen = 0;
+	while (true) {
+		search_round.wait(seen, memory_order_acquire);
+		seen = search_round.load(memory_order_acquire);
+		if (stopping.load(memory_order_acquire))
+			return;
+
+		worker.result = search(worker, worker.lag_begin, worker.lag_end);
+		if (busy.fetch_sub(1, memory_order_acq_rel) == 1)
+			busy.notify_one();
+	}
+}
+
+
+void FrequencyAcquisition::sinkSamples(const SampleVector& samples, Timestamp now) {
+
+	if (receiver_locked || now < holdoff_until) {
+		history.clear();
+		energy.assign(1, 0.0);
+		next_lag = 0;
+		return;
+	}
+
+	/* Append new samples and their cumulative energy */
+	if (history.empty())
+		history_start = now;
+	history.insert(history.end(), samples.begin(), samples.end());
+	energy.reserve(history.size() + 1);
+	for (size_t i = energy.size() - 1; i < history.size(); i++)
+		energy.push_back(energy.back() + norm(history[i]));
+
+	const size_t ref_len = reference.size();
+	if (history.size() < ref_len)
+		return;
+
+	/* Split the lags of this round evenly between the workers */
+	const size_t lag_end = history.size() - ref_len + 1;
+	const size_t num_lags = (lag_end > next_lag) ? (lag_end - next_lag + lag_step - 1) / lag_step : 0;
+	const size_t lags_per_worker = (num_lags + workers.size() - 1) / workers.size();
+
+	Detection best = { -1.0f, 0.0f, 0 };
+	if (num_lags > 0) {
+		/* Wake up the worker threads for their share and search the first one here */
+		if (!threads.empty()) {
+			for (size_t w = 1; w < workers.size(); w++) {
+				workers[w].lag_begin = next_lag + w * lags_per_worker * lag_step;
+				workers[w].lag_end = min(lag_end, workers[w].lag_begin + lags_per_worker * lag_step);
+			}
+			busy.store(threads.size(), memory_order_relaxed);
+			search_round.fetch_add(1, memory_order_release);
+			search_round.notify_all();
+		}
+
+		best = search(workers[0], next_lag, min(lag_end, next_lag + lags_per_worker * lag_step));
+
+		if (!threads.empty()) {
+			unsigned int remaining;
+			while ((remaining = busy.load(memory_order_acquire)) != 0)
+				busy.wait(remaining, memory_order_acquire);
+			for (size_t w = 1; w < workers.size(); w++)
+				if (workers[w].result.metric > best.metric)
+					best = workers[w].result;
+		}
+	}
+	next_lag += num_lags * lag_step;
+
+	if (best.metric >= conf.threshold) {
+		const Timestamp detection_time = history_start + best.lag * sample_ns;
+		const float offset = best.frequency - conf.center_frequency;
+
+		setFrequencyOffset.emit(offset);
+		frequencyAcquired.emit(offset, best.metric, detection_time);
+
+		holdoff_until = detection_time + (Timestamp)(1e9 * conf.holdoff_time);
+		history.clear();
+		energy.assign(1, 0.0);
+		next_lag = 0;
+		return;
+	}
+
+	/* Drop the samples which are not needed anymore */
+	if (next_lag > 0) {
+		const double dropped_energy = energy[next_lag];
+		history.erase(history.begin(), history.begin() + next_lag);
+		energy.erase(energy.begin(), energy.begin() + next_lag);
+		for (double& e: energy)
+			e -= dropped_energy;
+		history_start += next_lag * sample_ns;
+		next_lag = 0;
+	}
+}
+
+
+void FrequencyAcquisition::lockReceiver(bool locked, Timestamp now) {
+	(void)now;
+	receiver_locked = locked;
+}
+
+
+Block* createFrequencyAcquisition(const Kwargs& args)
+{
+	return new FrequencyAcquisition();
+}
+
+static Registry registerFrequencyAcquisition("FrequencyAcquisition", &createFrequencyAcquisition);
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "suo.hpp"
+#include <atomic>
+#include <thread>
+#include <liquid/liquid.h>
+
+namespace suo {
+
+/*
+ * Fast frequency acquisition using a bank of frequency hypotheses.
+ *
+ * The received signal is correlated against a known (G)FSK modulated bit pattern
+ * (e.g. the end of the preamble and the syncword). For every time lag the received
+ * window is multiplied with the conjugated reference and the product is FFT'd,
+ * which evaluates all frequency offset hypotheses at once. The lags of one buffer
+ * are split between the calling thread and persistent worker threads.
+ *
+ * When the normalized correlation exceeds the threshold, the estimated carrier
+ * frequency offset is emitted through setFrequencyOffset so that the tracking
+ * demodulator (whose AFC covers only a fraction of the symbol rate) can start
+ * from the right frequency already for the first frame of a pass.
+ */
+class FrequencyAcquisition : public Block
+{
+public:
+
+	struct Config {
+		Config();
+
+		/* Input IQ sample rate as samples per second. */
+		float sample_rate;
+
+		/* Symbol rate as symbols per second */
+		float symbol_rate;
+
+		/* Modulation index of the reference waveform. 0.5 for (G)MSK */
+		float modindex;
+
+		/* Signal center frequency as Hz */
+		float center_frequency;
+
+		/* Maximum searched frequency offset from the center frequency (Hz) */
+		float max_offset;
+
+		/* Known bit pattern in the beginning of the frame (e.g. end of the preamble and the syncword) */
+		uint64_t sync_pattern;
+		unsigned int sync_pattern_len;
+
+		/* Normalized correlation threshold between 0 and 1 */
+		float threshold;
+
+		/* Time lag step in symbols */
+		float lag_step;
+
+		/* Time after a detection during which no new detections are made (seconds) */
+		float holdoff_time;
+
+		/* Number of worker threads */
+		unsigned int threads;
+	};
+
+	explicit FrequencyAcquisition(const Config& conf = Config());
+	~FrequencyAcquisition();
+
+	FrequencyAcquisition(const FrequencyAcquisition&) = delete;
+	FrequencyAcquisition& operator=(const FrequencyAcquisition&) = delete;
+
+	void reset();
+
+	void sinkSamples(const SampleVector& samples, Timestamp now);
+
+	/* Stop searching while the receiver is locked to a frame (connect to deframer's syncDetected) */
+	void lockReceiver(bool locked, Timestamp now);
+
+	/* Estimated frequency offset from the center frequency (Hz). Connect to demodulator's setFrequencyOffset. */
+	Port<float> setFrequencyOffset;
+
+	/* Emitted for every detection with the frequency offset (Hz) and the normalized correlation */
+	Port<float, float, Timestamp> frequencyAcquired;
+
+private:
+
+	/* Best correlation found by a worker */
+	struct Detection {
+		float metric;
+		float frequency;
+		size_t lag;
+	};
+
+	/* Per thread FFT state and the lags of the current round */
+	struct Worker {
+		std::vector<Sample> fft_in;
+		std::vector<Sample> fft_out;
+		fftplan plan;
+		size_t lag_begin, lag_end;
+		Detection result;
+	};
+
+	Detection search(Worker& worker, size_t lag_begin, size_t lag_end) const;
+	void workerThread(unsigned int index);
+
+	/* Configuration */
+	const Config conf;
+	Timestamp sample_ns;
+	size_t lag_step;
+	unsigned int fft_len;
+	int bin_min, bin_max;          // Searched FFT bins (can be negative)
+	std::vector<Sample> reference; // Conjugated reference waveform
+
+	/* State */
+	std::vector<Sample> history;   // Received samples not yet fully searched
+	Timestamp history_start;       // Timestamp of the first history sample
+	std::vector<double> energy;    // Cumulative energy of the history samples
+	size_t next_lag;
+	bool receiver_locked;
+	Timestamp holdoff_until;
+
+	std::vector<Worker> workers;
+
+	/* Threads for workers[1:]. The first worker runs in the calling thread. */
+	std::vector<std::thread> threads;
+	std::atomic<uint32_t> search_round; // Incremented to start a search round
+	std::atomic<unsigned int> busy;     // Number of threads still searching
+	std::atomic<bool> stopping;
+};
+
+}; // namespace suo
@@ -13,6 +13,8 @@ PSKModulator::Config::Config() {
 	center_frequency = 100e3f;
 	frequency_offset = 0.0f;
 	amplitude = 1.0f;
+	bits_per_symbol = 1;
+	differential = false;
 	ramp_up_duration = 0;
 	ramp_down_duration = 0;
 }
@@ -41,7 +43,13 @@ PSKModulator::PSKModulator(const Config &_conf):
 
 
 	/* Init liquid modem object to create complex symbols from bits */ 
-	l_mod = modemcf_create(LIQUID_MODEM_PSK2);
+	const modulation_scheme schemes[2][3] = {
+		{ LIQUID_MODEM_PSK2, LIQUID_MODEM_PSK4, LIQUID_MODEM_PSK8 },
+		{ LIQUID_MODEM_DPSK2, LIQUID_MODEM_DPSK4, LIQUID_MODEM_DPSK8 },
+	};
+	if (conf.bits_per_symbol < 1 || conf.bits_per_symbol > 3)
+		throw SuoError("PSKModulator: Unsupported bits per symbol %d", conf.bits_per_symbol);
+	l_mod = modemcf_create(schemes[conf.differential][conf.bits_per_symbol - 1]);
 
 	/*
 	 * Init NCO for carrier generation/up mixing
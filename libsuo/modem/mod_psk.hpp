@@ -30,6 +30,12 @@ public:
 		/* */
 		float amplitude;
 
+		/* Bits per symbol: 1 = BPSK, 2 = QPSK, 3 = 8PSK */
+		unsigned int bits_per_symbol;
+
+		/* Differentially encode the symbols to resolve the receiver's phase ambiguity */
+		bool differential;
+
 		/* Length of the start/stop ramp in symbols */
 		unsigned int ramp_up_duration, ramp_down_duration;
 
@@ -0,0 +1,214 @@
+#include <cmath>
+#include <algorithm>
+
+#include "modem/symbol_sync.hpp"
+
+
+using namespace std;
+using namespace suo;
+
+
+/* Helpers to write the detectors once for real and complex samples */
+static inline float mul_conj(float a, float b) { return a * b; }
+static inline float mul_conj(Sample a, Sample b) { return (a * conj(b)).real(); }
+static inline float decision(float x) { return copysignf(1.0f, x); }
+static inline Sample decision(Sample x) { return Sample(copysignf(1.0f, x.real()), copysignf(1.0f, x.imag())); }
+static inline float power_of(float x) { return x * x; }
+static inline float power_of(Sample x) { return norm(x); }
+
+
+/* Cubic Lagrange interpolation of the prototype filter between the taps */
+static float interpolate_filter(const vector<float>& h, float tau) {
+	const int i = (int)floorf(tau);
+	const float f = tau - i;
+	auto tap = [&](int n) { return (n >= 0 && n < (int)h.size()) ? h[n] : 0.0f; };
+	return tap(i - 1) * (-f * (f - 1) * (f - 2) / 6)
+		+ tap(i) * ((f + 1) * (f - 1) * (f - 2) / 2)
+		+ tap(i + 1) * (-(f + 1) * f * (f - 2) / 2)
+		+ tap(i + 2) * ((f + 1) * f * (f - 1) / 6);
+}
+
+
+template<typename T>
+SymbolSync<T>::Config::Config() {
+	detector = Gardner;
+	samples_per_symbol = 4.0f;
+	bandwidth = 0.01f;
+	damping = 0.707f;
+	max_rate_deviation = 0.02f;
+	phases = 32;
+}
+
+
+template<typename T>
+SymbolSync<T>::SymbolSync(const Config& conf) :
+	conf(conf)
+{
+	if (conf.samples_per_symbol < 1.0f)
+		throw SuoError("SymbolSync: Less than one sample per symbol");
+	if (conf.detector == Gardner && conf.samples_per_symbol < 2.0f)
+		throw SuoError("SymbolSync: Gardner detector needs at least 2 samples per symbol");
+
+	filter_delay = 0.0f;
+	const float max_sps = conf.samples_per_symbol * (1 + conf.max_rate_deviation);
+	if (conf.detector == Polyphase) {
+		if (conf.filter.empty() || conf.phases == 0)
+			throw SuoError("SymbolSync: Polyphase detector needs a matched filter");
+
+		/* Build the interpolated filter and derivative banks from the prototype */
+		const size_t len = conf.filter.size() + 1;
+		const float delta = 1e-3f;
+		bank.resize(conf.phases, vector<float>(len));
+		dbank.resize(conf.phases, vector<float>(len));
+		for (unsigned int p = 0; p < conf.phases; p++) {
+			const float mu = (float)p / conf.phases;
+			for (size_t j = 0; j < len; j++) {
+				bank[p][j] = interpolate_filter(conf.filter, j + mu);
+				dbank[p][j] = (interpolate_filter(conf.filter, j + mu + delta) - interpolate_filter(conf.filter, j + mu - delta)) / (2 * delta);
+			}
+		}
+		filter_delay = 0.5f * (conf.filter.size() - 1);
+		history_len = len + 2;
+	}
+	else if (conf.detector == Gardner) {
+		history_len = (size_t)ceilf(0.5f * max_sps) + 3;
+	}
+	else {
+		history_len = 3;
+	}
+
+	updateLoopFilter();
+	reset();
+}
+
+
+template<typename T>
+void SymbolSync<T>::reset() {
+	rate_integrator = 0.0f;
+	power = 0.0f;
+	buffer.assign(history_len, T());
+	next_strobe = history_len;
+	prev_symbol = T();
+	prev_decision = T();
+}
+
+
+template<typename T>
+void SymbolSync<T>::setBandwidth(float bandwidth) {
+	conf.bandwidth = bandwidth;
+	updateLoopFilter();
+}
+
+
+template<typename T>
+void SymbolSync<T>::updateLoopFilter() {
+	/* Proportional-integral loop filter gains for given noise bandwidth and damping */
+	const float zeta = conf.damping;
+	const float theta = conf.bandwidth / (zeta + 0.25f / zeta);
+	const float d = 1 + 2 * zeta * theta + theta * theta;
+	kp = 4 * zeta * theta / d;
+	ki = 4 * theta * theta / d;
+}
+
+
+template<typename T>
+T SymbolSync<T>::interpolate(double t) const {
+	size_t i = (size_t)t;
+
+	if (conf.detector == Polyphase) {
+		unsigned int p = lround((t - i) * conf.phases);
+		if (p == conf.phases) {
+			p = 0;
+			i++;
+		}
+		const vector<float>& h = bank[p];
+		T y = T();
+		for (size_t j = 0; j < h.size(); j++)
+			y += h[j] * buffer[i - j];
+		return y;
+	}
+
+	/* Cubic Farrow interpolator */
+	const float mu = t - i;
+	const T x0 = buffer[i - 1], x1 = buffer[i], x2 = buffer[i + 1], x3 = buffer[i + 2];
+	const T c0 = x1;
+	const T c1 = -(1.0f / 3) * x0 - 0.5f * x1 + x2 - (1.0f / 6) * x3;
+	const T c2 = 0.5f * (x0 + x2) - x1;
+	const T c3 = (1.0f / 6) * (x3 - x0) + 0.5f * (x1 - x2);
+	return ((c3 * mu + c2) * mu + c1) * mu + c0;
+}
+
+
+template<typename T>
+T SymbolSync<T>::interpolateDerivative(double t) const {
+	size_t i = (size_t)t;
+	unsigned int p = lround((t - i) * conf.phases);
+	if (p == conf.phases) {
+		p = 0;
+		i++;
+	}
+	const vector<float>& dh = dbank[p];
+	T y = T();
+	for (size_t j = 0; j < dh.size(); j++)
+		y += dh[j] * buffer[i - j];
+	return y;
+}
+
+
+template<typename T>
+void SymbolSync<T>::execute(const T* input, size_t len, vector<T>& symbols, vector<float>& positions) {
+	symbols.clear();
+	positions.clear();
+
+	const size_t base = buffer.size(); // Index of input[0] in the buffer
+	buffer.insert(buffer.end(), input, input + len);
+
+	const float sps = conf.samples_per_symbol;
+	const float max_deviation = conf.max_rate_deviation * sps;
+
+	while ((size_t)next_strobe + 3 < buffer.size()) {
+		const double t = next_strobe;
+		const T y = interpolate(t);
+		const T d = decision(y);
+		power += 0.05f * (power_of(y) - power);
+
+		/* Timing error: positive when the strobe is late */
+		float error;
+		switch (conf.detector) {
+		case Gardner: {
+			const T mid = interpolate(t - 0.5 * (sps + rate_integrator));
+			error = mul_conj(y - prev_symbol, mid);
+			break;
+		}
+		case MuellerMuller:
+			error = mul_conj(prev_symbol, d) - mul_conj(y, prev_decision);
+			break;
+		case Polyphase:
+		default:
+			error = -mul_conj(y, interpolateDerivative(t));
+			break;
+		}
+		error = clamp(error / max(power, 1e-12f), -1.0f, 1.0f);
+
+		/* Loop filter */
+		rate_integrator = clamp(rate_integrator - ki * sps * error, -max_deviation, max_deviation);
+		const float step = clamp(sps + rate_integrator - kp * sps * error, 0.5f * sps, 1.5f * sps);
+
+		symbols.push_back(y);
+		positions.push_back((float)(t - base - filter_delay));
+		prev_symbol = y;
+		prev_decision = d;
+		next_strobe = t + step;
+	}
+
+	/* Drop the samples which are not needed anymore */
+	const size_t keep_from = min((size_t)next_strobe, buffer.size()) - history_len;
+	buffer.erase(buffer.begin(), buffer.begin() + keep_from);
+	next_strobe -= keep_from;
+}
+
+
+namespace suo {
+	template class SymbolSync<float>;
+	template class SymbolSync<Sample>;
+};
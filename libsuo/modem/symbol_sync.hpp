@@ -0,0 +1,109 @@
+#pragma once
+
+#include "suo.hpp"
+
+namespace suo {
+
+/*
+ * Block based symbol timing recovery.
+ *
+ * Processes whole buffers of oversampled soft samples (real discriminator
+ * output or complex baseband) and outputs one interpolated sample per symbol.
+ * For every symbol, the fractional position of the symbol center in the input
+ * buffer is also given so that accurate timestamps can be calculated.
+ *
+ * The timing error detector is one of:
+ *   Gardner: Non-data-aided, uses the sample between the symbols. Needs >= 2 samples per symbol.
+ *   MuellerMuller: Decision directed, uses only the symbol samples.
+ *   Polyphase: Maximum likelihood detector with a polyphase matched filter bank
+ *              and its derivative (like liquid-dsp's symsync). The matched filter is
+ *              given in the configuration and it is applied to the output.
+ *
+ * Gardner and Mueller-Muller use cubic (Farrow) interpolation between the input samples.
+ * The loop is a 2nd order PI loop whose bandwidth can be changed on the fly,
+ * e.g. narrowed when the receiver locks to a frame.
+ */
+template<typename T>
+class SymbolSync
+{
+public:
+
+	enum Detector {
+		Gardner,
+		MuellerMuller,
+		Polyphase,
+	};
+
+	struct Config {
+		Config();
+
+		/* Timing error detector */
+		Detector detector;
+
+		/* Number of input samples per symbol. Doesn't need to be an integer. */
+		float samples_per_symbol;
+
+		/* Loop noise bandwidth normalized to the symbol rate */
+		float bandwidth;
+
+		/* Loop damping factor */
+		float damping;
+
+		/* Maximum deviation of the symbol rate (fraction of the nominal) */
+		float max_rate_deviation;
+
+		/* Polyphase: Matched filter taps at the input sample rate */
+		std::vector<float> filter;
+
+		/* Polyphase: Number of filters in the bank */
+		unsigned int phases;
+	};
+
+	explicit SymbolSync(const Config& conf = Config());
+
+	void reset();
+
+	/* Change the loop bandwidth (normalized to the symbol rate) */
+	void setBandwidth(float bandwidth);
+
+	/* Current estimate of the samples per symbol */
+	float getSamplesPerSymbol() const { return conf.samples_per_symbol + rate_integrator; }
+
+	/*
+	 * Process a buffer of samples.
+	 * Args:
+	 *   input: Input samples
+	 *   len: Number of input samples
+	 *   symbols: Output symbols. Overwritten.
+	 *   positions: Fractional position of each symbol's center in samples relative
+	 *     to input[0]. Can be negative when the symbol was started in the previous buffer.
+	 */
+	void execute(const T* input, size_t len, std::vector<T>& symbols, std::vector<float>& positions);
+
+private:
+	void updateLoopFilter();
+	T interpolate(double t) const;
+	T interpolateDerivative(double t) const;
+
+	Config conf;
+
+	/* Loop filter */
+	float kp, ki;
+	float rate_integrator;
+	float power; // Symbol power estimate for normalizing the timing error
+
+	/* Polyphase filter banks: bank[phase][tap] */
+	std::vector<std::vector<float>> bank, dbank;
+	float filter_delay;
+
+	/* History + new samples */
+	std::vector<T> buffer;
+	size_t history_len;
+
+	/* Position of the next symbol strobe in the buffer */
+	double next_strobe;
+	T prev_symbol;
+	T prev_decision;
+};
+
+}; // namespace suo
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "suo.hpp"
+#include <type_traits>
+#include <typeinfo>
+
+namespace suo {
+
+/*
+ * Compile-time pipeline composition.
+ *
+ * pipeline(demod, deframer, publisher) connects each block to the next one by
+ * their concrete types. For every pair the matching port/sink pairs are
+ * searched at compile time:
+ *
+ *   sinkSamples port -> sinkSamples(const SampleVector&, Timestamp)
+ *   sinkSymbol port -> sinkSymbol(Symbol, Timestamp)
+ *   sinkSoftSymbol port -> sinkSoftSymbol(SoftSymbol, Timestamp) (only if no hard symbol link)
+ *   sinkFrame port -> sinkFrame(const Frame&, Timestamp)
+ *
+ * The sink is called with a qualified (non-virtual) call from a stateless
+ * trampoline, so the compiler can inline the sink into the trampoline and the
+ * per-symbol hop costs a single indirect call instead of going through
+ * std::function and a capturing lambda. The hop itself is not inlined into the
+ * emitting block nor fused with it: the connections are ordinary Port slots
+ * resolved at runtime, so they can be mixed with connect()/connect_member() wiring.
+ */
+
+namespace pipeline_detail {
+
+/* Check that a sink is implemented by the block itself and not only the throwing default of the Block base class */
+template<typename... Args>
+struct Sink {
+	template<typename C>
+	static constexpr bool implemented(void (C::*)(Args...)) {
+		return std::is_same_v<C, Block> == false;
+	}
+};
+
+template<typename A, typename B>
+concept SampleLink = requires(A& a, B& b, const SampleVector& samples, Timestamp now) {
+	a.sinkSamples.emit(samples, now);
+	b.B::sinkSamples(samples, now);
+	requires Sink<const SampleVector&, Timestamp>::implemented(&B::sinkSamples);
+};
+
+template<typename A, typename B>
+concept SymbolLink = requires(A& a, B& b, Symbol symbol, Timestamp now) {
+	a.sinkSymbol.emit(symbol, now);
+	b.B::sinkSymbol(symbol, now);
+	requires Sink<Symbol, Timestamp>::implemented(&B::sinkSymbol);
+};
+
+template<typename A, typename B>
+concept SoftSymbolLink = requires(A& a, B& b, SoftSymbol symbol, Timestamp now) {
+	a.sinkSoftSymbol.emit(symbol, now);
+	b.B::sinkSoftSymbol(symbol, now);
+	requires Sink<SoftSymbol, Timestamp>::implemented(&B::sinkSoftSymbol);
+};
+
+template<typename A, typename B>
+concept FrameLink = requires(A& a, B& b, Frame& frame, Timestamp now) {
+	a.sinkFrame.emit(frame, now);
+	b.B::sinkFrame(frame, now);
+	requires Sink<const Frame&, Timestamp>::implemented(&B::sinkFrame);
+};
+
+/*
+ * Connect port to the sink called by the stateless `Call` object.
+ * Call is a captureless lambda and hence default constructible.
+ */
+template<typename B, typename Call, typename... Args>
+void connect(Port<Args...>& port, B& b, Call) {
+	port.connect_direct(+[](void* inst, Args... args) {
+		Call{}(*static_cast<B*>(inst), args...);
+	}, &b, Tracer::typeLabel(typeid(B)));
+}
+
+}; // namespace pipeline_detail
+
+
+/* Connect two blocks by their concrete types. Fails to compile if the blocks have nothing to connect. */
+template<typename A, typename B>
+void pipeline(A& a, B& b) {
+	using namespace pipeline_detail;
+
+	static_assert(SampleLink<A, B> || SymbolLink<A, B> || SoftSymbolLink<A, B> || FrameLink<A, B>,
+		"pipeline: Blocks have no matching ports and sinks");
+
+	if constexpr (SampleLink<A, B>)
+		connect(a.sinkSamples, b, [](B& b, const SampleVector& samples, Timestamp now) { b.B::sinkSamples(samples, now); });
+
+	if constexpr (SymbolLink<A, B>)
+		connect(a.sinkSymbol, b, [](B& b, Symbol symbol, Timestamp now) { b.B::sinkSymbol(symbol, now); });
+	else if constexpr (SoftSymbolLink<A, B>)
+		connect(a.sinkSoftSymbol, b, [](B& b, SoftSymbol symbol, Timestamp now) { b.B::sinkSoftSymbol(symbol, now); });
+
+	if constexpr (FrameLink<A, B>)
+		connect(a.sinkFrame, b, [](B& b, const Frame& frame, Timestamp now) { b.B::sinkFrame(frame, now); });
+}
+
+
+/* Connect a chain of blocks: pipeline(a, b, c) == pipeline(a, b) + pipeline(b, c) */
+template<typename A, typename B, typename C, typename... Rest>
+void pipeline(A& a, B& b, C& c, Rest&... rest) {
+	pipeline(a, b);
+	pipeline(b, c, rest...);
+}
+
+}; // namespace suo
@@ -4,6 +4,9 @@
 
 #include <functional>
 #include <map>
+#include <typeinfo>
+
+#include "tracer.hpp"
 
 namespace suo {
 
@@ -12,6 +15,10 @@ namespace suo {
 // which will be called when the emit() method on the
 // Port object is invoked. Any argument passed to emit()
 // will be passed to the given functions.
+//
+// Each connected slot carries a label (the class name of the
+// connected block) which is used to name the timeline trace
+// events when tracing is enabled.
 
 template <typename... Args>
 class Port {
@@ -47,18 +54,34 @@ public:
 
 	// Connects a std::function to the Port. The returned
 	// value can be used to disconnect the function again.
-	int connect(std::function<void(Args...)> const& slot) const {
-		_slots.insert(std::make_pair(++_current_id, slot));
+	int connect(std::function<void(Args...)> const& slot, const char* label = "slot") const {
+		_slots.insert(std::make_pair(++_current_id, Slot{ slot, nullptr, nullptr, label }));
+		return _current_id;
+	}
+
+	// Connects a plain function pointer called with the given
+	// instance pointer. Skips the std::function indirection, but
+	// emit() still makes one indirect call to the function.
+	int connect_direct(void (*func)(void*, Args...), void* inst, const char* label = "slot") const {
+		_slots.insert(std::make_pair(++_current_id, Slot{ nullptr, func, inst, label }));
 		return _current_id;
 	}
 
+	// Connects a member function given as a template argument.
+	// The member function call is resolved at compile time inside
+	// a generated trampoline. See also pipeline.hpp.
+	template <auto Func, typename T>
+	int connect_static(T* inst) const {
+		return connect_direct(&trampoline<Func, T>, inst, Tracer::typeLabel(typeid(T)));
+	}
+
 	// Convenience method to connect a member function of an
 	// object to this Port.
 	template <typename T>
 	int connect_member(T* inst, void (T::* func)(Args...)) {
 		return connect([=](Args... args) {
 			(inst->*func)(args...);
-			});
+			}, Tracer::typeLabel(typeid(T)));
 	}
 
 	// Convenience method to connect a const member function
@@ -67,7 +90,7 @@ public:
 	int connect_member(T* inst, void (T::* func)(Args...) const) {
 		return connect([=](Args... args) {
 			(inst->*func)(args...);
-			});
+			}, Tracer::typeLabel(typeid(T)));
 	}
 
 	// Disconnects a previously connected function.
@@ -83,7 +106,8 @@ public:
 	// Calls all connected functions.
 	void emit(Args... p) {
 		for (auto const& it : _slots) {
-			it.second(p...);
+			TraceScope trace(it.second.label);
+			it.second.call(p...);
 		}
 	}
 
@@ -91,7 +115,8 @@ public:
 	void emit_for_all_but_one(int excludedConnectionID, Args... p) {
 		for (auto const& it : _slots) {
 			if (it.first != excludedConnectionID) {
-				it.second(p...);
+				TraceScope trace(it.second.label);
+				it.second.call(p...);
 			}
 		}
 	}
@@ -100,7 +125,8 @@ public:
 	void emit_for(int connectionID, Args... p) {
 		auto const& it = _slots.find(connectionID);
 		if (it != _slots.end()) {
-			it->second(p...);
+			TraceScope trace(it->second.label);
+			it->second.call(p...);
 		}
 	}
 
@@ -109,7 +135,26 @@ public:
 	}
 
 private:
-	mutable std::map<int, std::function<void(Args...)>> _slots;
+	struct Slot {
+		std::function<void(Args...)> func;
+		void (*direct)(void*, Args...);
+		void* inst;
+		const char* label;
+
+		inline void call(Args... p) const {
+			if (direct != nullptr)
+				direct(inst, p...);
+			else
+				func(p...);
+		}
+	};
+
+	template <auto Func, typename T>
+	static void trampoline(void* inst, Args... p) {
+		(static_cast<T*>(inst)->*Func)(p...);
+	}
+
+	mutable std::map<int, Slot> _slots;
 	mutable int _current_id{ 0 };
 };
 
@@ -149,8 +194,8 @@ public:
 
 	// Connects a std::function to the SourcePort. The returned
 	// value can be used to disconnect the function again.
-	int connect(std::function<Ret(Args...)> const& slot) const {
-		_slots.insert(std::make_pair(++_current_id, slot));
+	int connect(std::function<Ret(Args...)> const& slot, const char* label = "slot") const {
+		_slots.insert(std::make_pair(++_current_id, Slot{ slot, label }));
 		return _current_id;
 	}
 
@@ -160,7 +205,7 @@ public:
 	int connect_member(T* inst, Ret (T::* func)(Args...)) {
 		return connect([=](Args... args) -> Ret {
 			return (inst->*func)(args...);
-			});
+			}, Tracer::typeLabel(typeid(T)));
 	}
 
 	// Convenience method to connect a const member function
@@ -169,7 +214,7 @@ public:
 	int connect_member(T* inst, Ret (T::* func)(Args...) const) {
 		return connect([=](Args... args) -> Ret {
 			return (inst->*func)(args...);
-			});
+			}, Tracer::typeLabel(typeid(T)));
 	}
 
 	// Disconnects a previously connected function.
@@ -185,7 +230,8 @@ public:
 	// Calls all connected functions.
 	Ret emit(Args... p) {
 		for (auto const& it : _slots) {
-			Ret ret = it.second(p...);
+			TraceScope trace(it.second.label);
+			Ret ret = it.second.func(p...);
 			if (ret)
 				return ret;
 		}
@@ -196,7 +242,8 @@ public:
 	Ret emit_for(int connectionID, Args... p) {
 		auto const& it = _slots.find(connectionID);
 		if (it != _slots.end()) {
-			return it->second(p...);
+			TraceScope trace(it->second.label);
+			return it->second.func(p...);
 		}
 	}
 
@@ -205,7 +252,12 @@ public:
 	}
 
 private:
-	mutable std::map<int, std::function<Ret(Args...)>> _slots;
+	struct Slot {
+		std::function<Ret(Args...)> func;
+		const char* label;
+	};
+
+	mutable std::map<int, Slot> _slots;
 	mutable int _current_id{ 0 };
 };
 
@@ -0,0 +1,203 @@
+#include <cmath>
+#include <algorithm>
+
+#include "signal-io/channel_emulator.hpp"
+#include "registry.hpp"
+
+
+using namespace std;
+using namespace suo;
+
+
+ChannelEmulator::Config::Config() {
+	sample_rate = 1e6;
+	buffer_len = 4096;
+	duration = 0.0f;
+	snr = 20.0f;
+	frequency_offset = 0.0f;
+	doppler_rate = 0.0f;
+	max_frequency_offset = 0.0f;
+	clock_offset = 0.0f;
+	clock_drift = 0.0f;
+	burst_gap = 0.1f;
+	burst_gap_jitter = 0.0f;
+	seed = 0;
+}
+
+
+ChannelEmulator::ChannelEmulator(const Config& _conf) :
+	conf(_conf),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("ChannelEmulator")),
+	metric_samples(MetricsRegistry::getDefault().counter("suo_samples_total", "Number of emulated samples", metric_labels)),
+	metric_bursts(MetricsRegistry::getDefault().counter("suo_bursts_total", "Number of transmitted bursts", metric_labels))
+{
+	if (conf.sample_rate <= 0)
+		throw SuoError("ChannelEmulator: Negative or zero sample rate! %f", conf.sample_rate);
+	if (conf.buffer_len == 0)
+		throw SuoError("ChannelEmulator: Zero buffer length!");
+	if (conf.burst_gap < 0 || conf.burst_gap_jitter < 0)
+		throw SuoError("ChannelEmulator: Negative burst gap!");
+	if (abs(conf.clock_offset) > 1e5)
+		throw SuoError("ChannelEmulator: Too large clock offset %f ppm", conf.clock_offset);
+
+	sample_ns = 1.0e9 / conf.sample_rate;
+	noise_std = powf(10.0f, -conf.snr / 20.0f);
+
+	tx_buffer.reserve(conf.buffer_len);
+	rx_buffer.reserve(conf.buffer_len + conf.buffer_len / 8 + 4);
+
+	reset();
+}
+
+
+void ChannelEmulator::reset() {
+	now = 0;
+	next_burst = 0;
+	burst_active = false;
+	sample_gen = SampleGenerator();
+	elapsed = 0.0;
+	bursts = 0;
+	samples_out = 0;
+
+	history.assign(3, 0.0f);
+	position = 1.0;
+	phase = 0.0;
+
+	noise.seed(conf.seed);
+	rng.seed(conf.seed);
+}
+
+
+float ChannelEmulator::getFrequencyOffset() const {
+	float frequency = conf.frequency_offset + conf.doppler_rate * elapsed;
+	if (conf.max_frequency_offset > 0)
+		frequency = clamp(frequency, -conf.max_frequency_offset, conf.max_frequency_offset);
+	return frequency;
+}
+
+
+float ChannelEmulator::getClockOffset() const {
+	return conf.clock_offset + conf.clock_drift * elapsed;
+}
+
+
+void ChannelEmulator::sourceTransmit() {
+	tx_buffer.clear();
+
+	/* Start a new burst */
+	if (burst_active == false && now >= next_burst && generateSamples.has_connections()) {
+		sample_gen = generateSamples.emit(now);
+		burst_active = sample_gen.running();
+		if (burst_active) {
+			bursts++;
+			metric_bursts.inc();
+		}
+	}
+
+	if (burst_active) {
+		sample_gen.sourceSamples(tx_buffer);
+
+		if (sample_gen.running() == false || (tx_buffer.flags & VectorFlags::end_of_burst) != 0) {
+			burst_active = false;
+
+			/* Schedule the next burst after the gap */
+			double gap = conf.burst_gap;
+			if (conf.burst_gap_jitter > 0)
+				gap += uniform_real_distribution<double>(0.0, conf.burst_gap_jitter)(rng);
+			next_burst = now + (Timestamp)(tx_buffer.size() * sample_ns + 1e9 * gap);
+		}
+	}
+
+	/* Silence for rest of the buffer */
+	tx_buffer.resize(conf.buffer_len, 0.0f);
+}
+
+
+void ChannelEmulator::resample() {
+	/* Transmitter samples per receiver sample */
+	const double step = 1.0 + 1e-6 * getClockOffset();
+
+	history.insert(history.end(), tx_buffer.begin(), tx_buffer.end());
+	rx_buffer.clear();
+
+	/* Cubic Farrow interpolator */
+	while (position + 2 < history.size()) {
+		const size_t i = (size_t)position;
+		const float mu = position - i;
+		const Sample x0 = history[i - 1], x1 = history[i], x2 = history[i + 1], x3 = history[i + 2];
+		const Sample c1 = -(1.0f / 3) * x0 - 0.5f * x1 + x2 - (1.0f / 6) * x3;
+		const Sample c2 = 0.5f * (x0 + x2) - x1;
+		const Sample c3 = (1.0f / 6) * (x3 - x0) + 0.5f * (x1 - x2);
+		rx_buffer.push_back(((c3 * mu + c2) * mu + c1) * mu + x1);
+		position += step;
+	}
+
+	/* Keep the samples needed for the next outputs */
+	const size_t keep_from = (size_t)position - 1;
+	history.erase(history.begin(), history.begin() + keep_from);
+	position -= keep_from;
+}
+
+
+void ChannelEmulator::step() {
+
+	sourceTransmit();
+	resample();
+
+	/* Frequency offset with a linear ramp over the buffer */
+	const float frequency = getFrequencyOffset();
+	const size_t n = rx_buffer.size();
+	size_t ramp_len = (conf.doppler_rate != 0) ? n : 0; // Number of samples before the ramp stops at the limit
+	if (conf.max_frequency_offset > 0 && conf.doppler_rate != 0) {
+		const float limit = copysignf(conf.max_frequency_offset, conf.doppler_rate);
+		ramp_len = min(n, (size_t)max(0.0f, (limit - frequency) / conf.doppler_rate * conf.sample_rate));
+	}
+	if (frequency != 0.0f || ramp_len > 0) {
+		const double w0 = 2 * M_PI * frequency / conf.sample_rate; // [rad/sample]
+		const double dw = 2 * M_PI * conf.doppler_rate / (conf.sample_rate * conf.sample_rate); // [rad/sample^2]
+		Sample rotator = polar(1.0f, (float)phase);
+		Sample rotator_step = polar(1.0f, (float)w0);
+		Sample rotator_chirp = polar(1.0f, (float)dw);
+		for (size_t i = 0; i < n; i++) {
+			if (i == ramp_len)
+				rotator_chirp = 1.0f;
+			rx_buffer[i] *= rotator;
+			rotator *= rotator_step;
+			rotator_step *= rotator_chirp;
+			if ((i & 0xFF) == 0xFF) { // Keep the magnitudes from drifting
+				rotator /= abs(rotator);
+				rotator_step /= abs(rotator_step);
+			}
+		}
+
+		/* Calculate the phase exactly to avoid accumulating errors */
+		phase += w0 * ramp_len + dw * ramp_len * (ramp_len - 1.0) / 2;
+		phase += (w0 + dw * ramp_len) * (n - ramp_len);
+		phase = fmod(phase, 2 * M_PI);
+	}
+
+	if (isfinite(conf.snr))
+		noise.add(rx_buffer, noise_std);
+
+	rx_buffer.timestamp = now;
+	sinkSamples.emit(rx_buffer, now);
+
+	samples_out += rx_buffer.size();
+	metric_samples.inc(rx_buffer.size());
+	elapsed = samples_out / (double)conf.sample_rate;
+	now = (Timestamp)(samples_out * sample_ns);
+}
+
+
+void ChannelEmulator::execute() {
+	while (conf.duration <= 0 || elapsed < conf.duration)
+		step();
+}
+
+
+Block* createChannelEmulator(const Kwargs& args)
+{
+	return new ChannelEmulator();
+}
+
+static Registry registerChannelEmulator("ChannelEmulator", &createChannelEmulator);
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <random>
+#include "suo.hpp"
+#include "misc/metrics.hpp"
+#include "misc/gaussian_noise.hpp"
+
+namespace suo {
+
+/*
+ * Streaming radio channel emulator.
+ *
+ * Replaces the radio between a modulator and a demodulator: transmit bursts
+ * are sourced from generateSamples and a continuous stream of received samples
+ * is emitted to sinkSamples as fast as possible, so long passes can be simulated
+ * many times faster than real time.
+ *
+ * The transmitted signal goes through following impairments in this order:
+ *   1. Timing: Sample clock offset and drift, applied with a cubic interpolator
+ *   2. Frequency: Carrier frequency offset with a linear Doppler ramp
+ *   3. AWGN
+ *
+ * Between the bursts the channel carries only noise. A new burst is requested
+ * after burst_gap (+ random jitter) seconds from the end of the previous burst.
+ */
+class ChannelEmulator : public Block
+{
+public:
+
+	struct Config {
+		Config();
+
+		/* Sample rate of the stream */
+		float sample_rate;
+
+		/* Number of samples emitted per sinkSamples call */
+		unsigned int buffer_len;
+
+		/* Simulated duration in seconds for execute(). 0 runs forever. */
+		float duration;
+
+		/* Signal to noise ratio per sample (dB) for unit power signal. Infinity disables the noise. */
+		float snr;
+
+		/* Carrier frequency offset at the start (Hz) */
+		float frequency_offset;
+
+		/* Doppler rate (Hz/s) */
+		float doppler_rate;
+
+		/* Maximum absolute frequency offset with the Doppler ramp (Hz). 0 for unlimited. */
+		float max_frequency_offset;
+
+		/* Transmitter sample clock offset (ppm). Positive means the transmitter clock is fast. */
+		float clock_offset;
+
+		/* Change of the clock offset (ppm/s) */
+		float clock_drift;
+
+		/* Minimum time between the end of a burst and the start of the next (s) */
+		float burst_gap;
+
+		/* Maximum additional random time between the bursts (s) */
+		float burst_gap_jitter;
+
+		/* Seed for the noise and the burst gaps */
+		uint64_t seed;
+	};
+
+	explicit ChannelEmulator(const Config& conf = Config());
+
+	ChannelEmulator(const ChannelEmulator&) = delete;
+	ChannelEmulator& operator=(const ChannelEmulator&) = delete;
+
+	void reset();
+
+	/* Run the emulator for the configured duration */
+	void execute();
+
+	/* Emulate and emit one buffer of samples */
+	void step();
+
+	/* Current simulation time */
+	Timestamp getTime() const { return now; }
+
+	/* Number of transmitted bursts and emitted samples since the reset */
+	uint64_t getBurstCount() const { return bursts; }
+	uint64_t getSampleCount() const { return samples_out; }
+
+	/* Current frequency offset (Hz) and sample clock offset (ppm) */
+	float getFrequencyOffset() const;
+	float getClockOffset() const;
+
+	Port<const SampleVector&, Timestamp> sinkSamples;
+	SourcePort<SampleGenerator, Timestamp> generateSamples;
+
+private:
+
+	/* Source transmit samples (or silence) to tx_buffer */
+	void sourceTransmit();
+
+	/* Resample tx_buffer to rx_buffer with the current clock offset */
+	void resample();
+
+	/* Configuration */
+	Config conf;
+	double sample_ns;
+	float noise_std;
+
+	/* State */
+	Timestamp now;
+	Timestamp next_burst;
+	bool burst_active;
+	SampleGenerator sample_gen;
+	double elapsed;             // Emulated time in seconds
+	uint64_t bursts, samples_out;
+
+	/* Timing */
+	SampleVector history;       // Input samples for the interpolator
+	double position;            // Position of the next output sample in the history
+
+	/* Frequency */
+	double phase;               // Carrier phase in radians
+
+	/* Noise */
+	GaussianNoise noise;
+	std::mt19937_64 rng;
+
+	/* Buffers */
+	SampleVector tx_buffer;
+	SampleVector rx_buffer;
+
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_samples;
+	Counter& metric_bursts;
+};
+
+}; // namespace suo
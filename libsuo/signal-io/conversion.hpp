@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include "base_types.hpp"
 
 namespace suo {
@@ -25,14 +26,13 @@ static inline size_t cu8_to_cf(cu8_t *in, Sample *out, size_t n)
 }
 
 
-static inline size_t cf_to_cs16(Sample *in, cs16_t *out, size_t n)
+static inline size_t cf_to_cs16(const Sample *in, cs16_t *out, size_t n)
 {
 	size_t i;
 	const float scale = 0x8000;
-	// TODO: clip
 	for (i = 0; i < n; i++) {
-		out[i][0] = in[i].real() * scale;
-		out[i][1] = in[i].imag() * scale;
+		out[i][0] = (int16_t)std::clamp(in[i].real() * scale, -32768.0f, 32767.0f);
+		out[i][1] = (int16_t)std::clamp(in[i].imag() * scale, -32768.0f, 32767.0f);
 	}
 	return n;
 }
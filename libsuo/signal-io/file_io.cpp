@@ -25,7 +25,10 @@ FileIO::Config::Config() {
 
 
 FileIO::FileIO(const Config& _conf) :
-	conf(_conf)
+	conf(_conf),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("FileIO")),
+	metric_samples(MetricsRegistry::getDefault().counter("suo_samples_in_total", "Number of received samples", metric_labels)),
+	metric_processing(MetricsRegistry::getDefault().histogram("suo_buffer_processing_ns", "Time spent processing one received buffer in nanoseconds", metric_labels))
 {
 	/* Setup input stream */
 	if (conf.input == "-")
@@ -102,6 +105,8 @@ void FileIO::execute()
 			buffer.resize(new_samples);
 			
 			// Feed
+			metric_samples.inc(new_samples);
+			ScopedTimer timer(metric_processing);
 			sinkSamples.emit(buffer, now);
 		}
 
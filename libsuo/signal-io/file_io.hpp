@@ -1,6 +1,7 @@
 #pragma once
 
 #include "suo.hpp"
+#include "misc/metrics.hpp"
 #include <ios>
 #include <fstream>
 #include <memory>
@@ -46,6 +47,11 @@ private:
 	const Config conf;
 	std::shared_ptr<std::istream> in;
 	std::shared_ptr<std::ostream> out;
+
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_samples;
+	Histogram& metric_processing;
 };
 
 
@@ -0,0 +1,257 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "signal-io/iq_recorder.hpp"
+#include "signal-io/conversion.hpp"
+#include "registry.hpp"
+
+
+using namespace std;
+using namespace suo;
+
+
+/* O_DIRECT requires the buffer address, file offset and length to be aligned to the logical block size */
+static const size_t direct_alignment = 4096;
+
+
+IQRecorder::Config::Config() {
+	format = "CF32";
+	sigmf = true;
+	sample_rate = 1e6;
+	center_frequency = 0;
+	ring_size = 256 << 20;
+	chunk_size = 4 << 20;
+	direct_io = true;
+}
+
+
+IQRecorder::IQRecorder(const Config& _conf) :
+	conf(_conf),
+	fd(-1),
+	direct(false),
+	ring(nullptr),
+	head(0),
+	written(0),
+	wakeups(0),
+	stopping(false),
+	failed(false),
+	write_errno(0),
+	recorded_samples(0),
+	dropped_samples(0),
+	next_timestamp(0),
+	epoch(0),
+	discontinuity(true),
+	closed(false),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("IQRecorder")),
+	metric_samples(MetricsRegistry::getDefault().counter("suo_recorded_samples_total", "Number of samples written to the recording", metric_labels)),
+	metric_dropped(MetricsRegistry::getDefault().counter("suo_recorder_dropped_samples_total", "Number of samples dropped because the recording fell behind", metric_labels)),
+	metric_bytes(MetricsRegistry::getDefault().counter("suo_recorder_written_bytes_total", "Number of bytes written to the disk", metric_labels))
+{
+	if (conf.format == "CF32")
+		sample_size = sizeof(Sample);
+	else if (conf.format == "CS16")
+		sample_size = sizeof(cs16_t);
+	else
+		throw SuoError("IQRecorder: Unsupported format %s", conf.format.c_str());
+	if (conf.sample_rate <= 0)
+		throw SuoError("IQRecorder: Negative or zero sample rate! %f", conf.sample_rate);
+	if (conf.filename.empty())
+		throw SuoError("IQRecorder: No filename given!");
+	if (conf.chunk_size == 0 || conf.chunk_size % direct_alignment != 0)
+		throw SuoError("IQRecorder: Chunk size must be a multiple of %u bytes", (unsigned int)direct_alignment);
+
+	/* Ring holds a whole number of chunks so that a chunk never wraps around */
+	conf.ring_size -= conf.ring_size % conf.chunk_size;
+	if (conf.ring_size < 2 * conf.chunk_size)
+		throw SuoError("IQRecorder: Ring buffer must hold at least two chunks");
+	sample_ns = 1.0e9 / conf.sample_rate;
+
+	const string path = conf.sigmf ? conf.filename + ".sigmf-data" : conf.filename;
+	const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+	if (conf.direct_io) {
+		fd = open(path.c_str(), flags | O_DIRECT, 0644);
+		direct = (fd >= 0);
+	}
+	if (fd < 0) // Not requested or not supported by the file system (e.g. tmpfs)
+		fd = open(path.c_str(), flags, 0644);
+	if (fd < 0)
+		throw SuoError("IQRecorder: Failed to open %s: %s", path.c_str(), strerror(errno));
+
+	ring = static_cast<char*>(aligned_alloc(direct_alignment, conf.ring_size));
+	if (ring == nullptr) {
+		::close(fd);
+		throw SuoError("IQRecorder: Failed to allocate %zu bytes ring buffer", conf.ring_size);
+	}
+	memset(ring, 0, conf.ring_size); // Fault the pages in now instead of in the receiver thread
+
+	captures.reserve(64);
+	writer = thread(&IQRecorder::writerThread, this);
+}
+
+
+IQRecorder::~IQRecorder() {
+	try {
+		close();
+	}
+	catch (const SuoError& e) {
+		cerr << e.what() << endl;
+	}
+}
+
+
+void IQRecorder::close() {
+	if (closed)
+		return;
+	closed = true;
+
+	stopping.store(true, memory_order_release);
+	wakeups.fetch_add(1, memory_order_release);
+	wakeups.notify_one();
+	writer.join();
+
+	::close(fd);
+	free(ring);
+	ring = nullptr;
+
+	if (conf.sigmf) {
+		SigMFWriter::Config meta_conf;
+		meta_conf.datatype = (conf.format == "CS16") ? "ci16_le" : "cf32_le";
+		meta_conf.sample_rate = conf.sample_rate;
+		meta_conf.hw = "suo IQRecorder";
+		sigmf_write_meta(conf.filename, meta_conf, captures, {});
+	}
+
+	if (failed.load(memory_order_acquire))
+		throw SuoError("IQRecorder: Failed to write %s: %s", conf.filename.c_str(), strerror(write_errno));
+}
+
+
+void IQRecorder::sinkSamples(const SampleVector& samples, Timestamp timestamp) {
+	if (closed)
+		throw SuoError("IQRecorder: Recording already closed!");
+	if (samples.empty())
+		return;
+
+	const size_t n = samples.size();
+	const size_t bytes = n * sample_size;
+	const uint64_t h = head.load(memory_order_relaxed);
+
+	/* Drop the whole buffer rather than wait if the writer has fallen behind */
+	if (failed.load(memory_order_relaxed) || h + bytes - written.load(memory_order_acquire) > conf.ring_size) {
+		dropped_samples += n;
+		metric_dropped.inc(n);
+		discontinuity = true;
+		return;
+	}
+
+	/* Start a new capture segment if samples were lost */
+	if (discontinuity || abs((double)timestamp - (double)next_timestamp) > 2 * sample_ns) {
+		if (epoch == 0) {
+			const Timestamp wall = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+			epoch = wall - timestamp;
+		}
+		captures.push_back({ recorded_samples, timestamp, epoch + timestamp, conf.center_frequency });
+		discontinuity = false;
+	}
+
+	/* Convert directly to the ring in at most two parts */
+	const size_t pos = h % conf.ring_size;
+	const size_t first = min(n, (conf.ring_size - pos) / sample_size);
+	if (conf.format == "CS16") {
+		cf_to_cs16(samples.data(), reinterpret_cast<cs16_t*>(ring + pos), first);
+		cf_to_cs16(samples.data() + first, reinterpret_cast<cs16_t*>(ring), n - first);
+	}
+	else {
+		memcpy(ring + pos, samples.data(), first * sizeof(Sample));
+		memcpy(ring, samples.data() + first, (n - first) * sizeof(Sample));
+	}
+	head.store(h + bytes, memory_order_release);
+
+	/* Wake up the writer only when a chunk has been completed */
+	if (h / conf.chunk_size != (h + bytes) / conf.chunk_size) {
+		wakeups.fetch_add(1, memory_order_release);
+		wakeups.notify_one();
+	}
+
+	recorded_samples += n;
+	metric_samples.inc(n);
+	next_timestamp = timestamp + (Timestamp)llround(n * sample_ns);
+}
+
+
+bool IQRecorder::writeChunk(uint64_t position, size_t len) {
+	const char* data = ring + position % conf.ring_size;
+	size_t done = 0;
+	while (done < len) {
+		ssize_t ret = pwrite(fd, data + done, len - done, position + done);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EINVAL && direct) {
+				/* Some file systems accept O_DIRECT on open but not on write */
+				fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+				direct = false;
+				continue;
+			}
+			write_errno = errno;
+			return false;
+		}
+		done += ret;
+	}
+	metric_bytes.inc(len);
+	return true;
+}
+
+
+void IQRecorder::writerThread() {
+	uint64_t tail = 0;
+
+	while (true) {
+		const uint32_t seq = wakeups.load(memory_order_acquire);
+		const bool stop = stopping.load(memory_order_acquire);
+		const uint64_t h = head.load(memory_order_acquire);
+
+		if (h - tail >= conf.chunk_size) {
+			if (writeChunk(tail, conf.chunk_size) == false) {
+				failed.store(true, memory_order_release);
+				return;
+			}
+			tail += conf.chunk_size;
+			written.store(tail, memory_order_release);
+			continue;
+		}
+
+		if (stop) {
+			/* Flush the partial chunk. With O_DIRECT the write is padded and the file truncated after. */
+			const size_t remaining = h - tail;
+			if (remaining > 0) {
+				const size_t len = direct ? (remaining + direct_alignment - 1) / direct_alignment * direct_alignment : remaining;
+				if (writeChunk(tail, len) == false || ftruncate(fd, h) != 0) {
+					if (write_errno == 0)
+						write_errno = errno;
+					failed.store(true, memory_order_release);
+					return;
+				}
+				written.store(h, memory_order_release);
+			}
+			return;
+		}
+
+		wakeups.wait(seq, memory_order_acquire);
+	}
+}
+
+
+Block* createIQRecorder(const Kwargs& args)
+{
+	return new IQRecorder();
+}
+
+static Registry registerIQRecorder("IQRecorder", &createIQRecorder);
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "suo.hpp"
+#include "misc/metrics.hpp"
+#include "signal-io/sigmf.hpp"
+
+namespace suo {
+
+/*
+ * Full rate IQ recorder.
+ *
+ * Received buffers are converted straight into a preallocated ring buffer
+ * and a background thread writes the ring to disk in large aligned chunks
+ * using O_DIRECT, bypassing the page cache. The receiving thread never waits
+ * for the disk: if the ring is full the whole buffer is dropped and counted,
+ * and the recording continues as a new SigMF capture segment.
+ *
+ * Connect sinkSamples e.g. to SoapySDRIO::sinkSamples next to the demodulators.
+ */
+class IQRecorder : public Block
+{
+public:
+	struct Config {
+		Config();
+
+		/* Output file name. With sigmf enabled the .sigmf-data/.sigmf-meta extensions are added. */
+		std::string filename;
+
+		/* Sample format on disk: CF32 or CS16 */
+		std::string format;
+
+		/* Write SigMF metadata next to the data when the recording is closed */
+		bool sigmf;
+
+		/* Sample rate and center frequency for the metadata (Hz) */
+		double sample_rate;
+		double center_frequency;
+
+		/* Size of the ring buffer (bytes). Decides how long disk stalls can be tolerated. */
+		size_t ring_size;
+
+		/* Size of a single disk write (bytes, multiple of 4096) */
+		size_t chunk_size;
+
+		/* Use O_DIRECT if the file system supports it */
+		bool direct_io;
+	};
+
+	explicit IQRecorder(const Config& conf = Config());
+	~IQRecorder();
+
+	IQRecorder(const IQRecorder&) = delete;
+	IQRecorder& operator=(const IQRecorder&) = delete;
+
+	/* Flush the ring, close the file and write the metadata. Throws if any write failed. */
+	void close();
+
+	void sinkSamples(const SampleVector& samples, Timestamp timestamp);
+
+	uint64_t getRecordedSamples() const { return recorded_samples; }
+	uint64_t getDroppedSamples() const { return dropped_samples; }
+	uint64_t getWrittenBytes() const { return written.load(std::memory_order_acquire); }
+	bool usingDirectIO() const { return direct.load(std::memory_order_relaxed); }
+
+private:
+	void writerThread();
+	bool writeChunk(uint64_t position, size_t len);
+
+	Config conf;
+	size_t sample_size;
+	double sample_ns;
+
+	int fd;
+	std::atomic<bool> direct;
+	std::thread writer;
+
+	/* Single producer single consumer ring. Positions are total bytes and only increase. */
+	char* ring;
+	alignas(64) std::atomic<uint64_t> head;     // Written by the receiver
+	alignas(64) std::atomic<uint64_t> written;  // Written by the writer thread
+	std::atomic<uint32_t> wakeups;
+	std::atomic<bool> stopping;
+	std::atomic<bool> failed;
+	int write_errno;
+
+	/* Receiver side state */
+	uint64_t recorded_samples;
+	uint64_t dropped_samples;
+	Timestamp next_timestamp;
+	Timestamp epoch;
+	bool discontinuity;
+	bool closed;
+	std::vector<SigMFCapture> captures;
+
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_samples;
+	Counter& metric_dropped;
+	Counter& metric_bytes;
+};
+
+}; // namespace suo
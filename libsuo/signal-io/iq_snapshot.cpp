@@ -0,0 +1,347 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#include "signal-io/iq_snapshot.hpp"
+#include "registry.hpp"
+
+
+using namespace std;
+using namespace suo;
+
+
+template<typename T>
+IQSnapshot::Queue<T>::Queue(size_t size) :
+	head(0),
+	tail(0)
+{
+	size_t capacity = 1;
+	while (capacity < size)
+		capacity <<= 1;
+	items.resize(capacity, nullptr);
+	mask = capacity - 1;
+}
+
+template<typename T>
+bool IQSnapshot::Queue<T>::push(T* item) {
+	const size_t h = head.load(memory_order_relaxed);
+	if (h - tail.load(memory_order_acquire) == items.size())
+		return false;
+	items[h & mask] = item;
+	head.store(h + 1, memory_order_release);
+	return true;
+}
+
+template<typename T>
+T* IQSnapshot::Queue<T>::pop() {
+	const size_t t = tail.load(memory_order_relaxed);
+	if (t == head.load(memory_order_acquire))
+		return nullptr;
+	T* item = items[t & mask];
+	tail.store(t + 1, memory_order_release);
+	return item;
+}
+
+
+IQSnapshot::Config::Config() {
+	datatype = "cf32_le";
+	sample_rate = 1e6;
+	center_frequency = 0;
+	pre_trigger = 0.1f;
+	post_trigger = 0.5f;
+	history_buffers = 1024;
+	max_pending = 4;
+	trigger_on_sync = true;
+	trigger_on_failure = true;
+	trigger_on_frame = false;
+}
+
+
+IQSnapshot::IQSnapshot(const Config& _conf) :
+	conf(_conf),
+	history_idx(0),
+	collecting(nullptr),
+	spare_job(nullptr),
+	next_id(0),
+	epoch(0),
+	snapshots_dropped(0),
+	snapshots_truncated(0),
+	pending_jobs(_conf.max_pending),
+	free_jobs(_conf.max_pending),
+	free_slots(2 * _conf.history_buffers),
+	wakeups(0),
+	stopping(false),
+	snapshots_queued(0),
+	snapshots_written(0),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("IQSnapshot")),
+	metric_snapshots(MetricsRegistry::getDefault().counter("suo_snapshots_total", "Number of saved IQ snapshots", metric_labels)),
+	metric_dropped(MetricsRegistry::getDefault().counter("suo_snapshots_dropped_total", "Number of IQ snapshots dropped because the writer fell behind", metric_labels)),
+	metric_truncated(MetricsRegistry::getDefault().counter("suo_snapshots_truncated_total", "Number of IQ snapshots cut short because the history didn't cover the window", metric_labels))
+{
+	if (conf.datatype != "cf32_le" && conf.datatype != "ci16_le")
+		throw SuoError("IQSnapshot: Unsupported datatype %s", conf.datatype.c_str());
+	if (conf.sample_rate <= 0)
+		throw SuoError("IQSnapshot: Negative or zero sample rate! %f", conf.sample_rate);
+	if (conf.filename_prefix.empty())
+		throw SuoError("IQSnapshot: No filename prefix given!");
+	if (conf.pre_trigger < 0 || conf.post_trigger < 0)
+		throw SuoError("IQSnapshot: Negative trigger window!");
+	if (conf.history_buffers == 0 || conf.max_pending == 0)
+		throw SuoError("IQSnapshot: Zero history or pending snapshots!");
+
+	sample_ns = 1.0e9 / conf.sample_rate;
+	pre_ns = (Timestamp)llround(lround(conf.pre_trigger * conf.sample_rate) * sample_ns);
+	post_ns = (Timestamp)llround(lround(conf.post_trigger * conf.sample_rate) * sample_ns);
+
+	/* History and an equal number of spare buffers to replace the ones being written */
+	for (unsigned int i = 0; i < 2 * conf.history_buffers; i++) {
+		slot_storage.emplace_back(new Slot());
+		if (i < conf.history_buffers)
+			history.push_back(slot_storage.back().get());
+		else
+			free_slots.push(slot_storage.back().get());
+	}
+
+	for (unsigned int i = 0; i < conf.max_pending; i++) {
+		job_storage.emplace_back(new Job());
+		job_storage.back()->slots.reserve(conf.history_buffers);
+		job_storage.back()->annotations.reserve(16);
+		free_jobs.push(job_storage.back().get());
+	}
+
+	writer = thread(&IQSnapshot::writerThread, this);
+}
+
+
+IQSnapshot::~IQSnapshot() {
+	flush();
+	stopping.store(true, memory_order_release);
+	wakeups.fetch_add(1, memory_order_release);
+	wakeups.notify_one();
+	writer.join();
+}
+
+
+void IQSnapshot::sinkSamples(const SampleVector& samples, Timestamp timestamp) {
+	if (epoch == 0) {
+		const Timestamp wall = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+		epoch = wall - timestamp;
+
+		/* Buffer length is known only now */
+		const double history_ns = history.size() * samples.size() * sample_ns;
+		if (history_ns < pre_ns + post_ns)
+			cerr << "Warning: IQSnapshot: History of " << history.size() << " buffers covers only " << history_ns * 1e-9
+				<< " s of the " << (pre_ns + post_ns) * 1e-9 << " s window! Snapshots will be truncated." << endl;
+	}
+
+	/* Overwrite the oldest buffer, or take a spare one if it was handed to the writer */
+	Slot*& slot = history[history_idx];
+	if (slot != nullptr && collecting != nullptr && slot->end > collecting->start && slot->timestamp < collecting->end) {
+		/* The oldest buffer is still inside the window: save what is left before losing it */
+		snapshots_truncated++;
+		metric_truncated.inc();
+		complete(collecting);
+	}
+	history_idx = (history_idx + 1) % history.size();
+	if (slot == nullptr)
+		slot = free_slots.pop();
+	if (slot == nullptr)
+		return; // Writer has all the spare buffers, leave a gap to the history
+
+	slot->samples.assign(samples.begin(), samples.end());
+	slot->timestamp = timestamp;
+	slot->end = timestamp + (Timestamp)llround(samples.size() * sample_ns);
+
+	if (collecting != nullptr && slot->end >= collecting->end)
+		complete(collecting);
+}
+
+
+void IQSnapshot::trigger(Timestamp timestamp, const string& label, const Frame* frame) {
+
+	/* Start a new snapshot unless the window overlaps with the current one */
+	const Timestamp start = (timestamp > pre_ns) ? timestamp - pre_ns : 0;
+	if (collecting != nullptr && start > collecting->end)
+		complete(collecting);
+
+	if (collecting == nullptr) {
+		Job* job = spare_job ? spare_job : free_jobs.pop();
+		spare_job = nullptr;
+		if (job == nullptr) {
+			snapshots_dropped++;
+			metric_dropped.inc();
+			return;
+		}
+		job->id = next_id++;
+		job->epoch = epoch;
+		job->start = start;
+		job->end = 0;
+		job->slots.clear();
+		job->annotations.clear();
+		job->description.clear();
+		collecting = job;
+	}
+
+	/* Frames only annotate the window unless they are triggers themselves */
+	const bool triggering = (label != "frame" || conf.trigger_on_frame);
+	if (triggering) {
+		collecting->start = min(collecting->start, start);
+		collecting->end = max(collecting->end, timestamp + post_ns);
+		if (collecting->description.find(label) == string::npos)
+			collecting->description += (collecting->description.empty() ? "" : ", ") + label;
+	}
+
+	Annotation a;
+	a.timestamp = timestamp;
+	a.annotation.label = label;
+	a.annotation.sample_start = 0;
+	a.annotation.sample_count = 0;
+	if (frame != nullptr) {
+		/* Frame duration from sync to the last bit */
+		auto completed = frame->metadata.find("completed_timestamp");
+		if (completed != frame->metadata.end() && holds_alternative<Timestamp>(completed->second) && get<Timestamp>(completed->second) > timestamp)
+			a.annotation.sample_count = llround((get<Timestamp>(completed->second) - timestamp) / sample_ns);
+
+		auto failure = frame->metadata.find("decode_failure");
+		if (failure != frame->metadata.end() && holds_alternative<string>(failure->second))
+			a.annotation.comment = get<string>(failure->second);
+
+		a.annotation.frame = frame->serialize_to_json();
+	}
+	collecting->annotations.push_back(a);
+}
+
+
+/* Syncword timestamp of the frame */
+static Timestamp frame_start(const Frame& frame, Timestamp timestamp) {
+	auto sync = frame.metadata.find("sync_timestamp");
+	if (sync != frame.metadata.end() && holds_alternative<Timestamp>(sync->second))
+		return get<Timestamp>(sync->second);
+	return timestamp;
+}
+
+
+void IQSnapshot::syncDetected(bool sync, Timestamp timestamp) {
+	if (sync && conf.trigger_on_sync)
+		trigger(timestamp, "sync");
+}
+
+
+void IQSnapshot::frameFailed(const Frame& frame, Timestamp timestamp) {
+	if (conf.trigger_on_failure)
+		trigger(frame_start(frame, timestamp), "failure", &frame);
+}
+
+
+void IQSnapshot::sinkFrame(const Frame& frame, Timestamp timestamp) {
+	const Timestamp start = frame_start(frame, timestamp);
+	if (conf.trigger_on_frame || (collecting != nullptr && start >= collecting->start && start <= collecting->end))
+		trigger(start, "frame", &frame);
+}
+
+
+void IQSnapshot::complete(Job* job) {
+	collecting = nullptr;
+
+	/* Hand the buffers inside the window over to the writer, oldest first */
+	for (size_t i = 0; i < history.size(); i++) {
+		Slot*& slot = history[(history_idx + i) % history.size()];
+		if (slot != nullptr && slot->end > job->start && slot->timestamp < job->end) {
+			job->slots.push_back(slot);
+			slot = nullptr;
+		}
+	}
+
+	if (job->slots.empty()) {
+		spare_job = job;
+		return;
+	}
+
+	pending_jobs.push(job); // Never full: the queue can hold all the jobs
+	snapshots_queued.fetch_add(1, memory_order_relaxed);
+	wakeups.fetch_add(1, memory_order_release);
+	wakeups.notify_one();
+}
+
+
+void IQSnapshot::flush() {
+	if (collecting != nullptr)
+		complete(collecting);
+
+	const uint64_t queued = snapshots_queued.load(memory_order_relaxed);
+	uint64_t written;
+	while ((written = snapshots_written.load(memory_order_acquire)) < queued)
+		snapshots_written.wait(written, memory_order_acquire);
+}
+
+
+void IQSnapshot::writeSnapshot(Job& job) {
+	SigMFWriter::Config writer_conf;
+	writer_conf.filename = conf.filename_prefix + "_" + to_string(job.id);
+	writer_conf.datatype = conf.datatype;
+	writer_conf.sample_rate = conf.sample_rate;
+	writer_conf.center_frequency = conf.center_frequency;
+	writer_conf.epoch = job.epoch;
+	writer_conf.description = "Triggered by " + job.description;
+	SigMFWriter recording(writer_conf);
+
+	/* Cut the first and the last buffer to the window */
+	SampleVector part;
+	for (Slot* slot: job.slots) {
+		const size_t n = slot->samples.size();
+		const size_t first = (job.start > slot->timestamp) ? min<size_t>(n, ceil((job.start - slot->timestamp) / sample_ns)) : 0;
+		const size_t last = (job.end < slot->end) ? min<size_t>(n, ceil((job.end - slot->timestamp) / sample_ns)) : n;
+		if (first >= last)
+			continue;
+		part.assign(slot->samples.begin() + first, slot->samples.begin() + last);
+		recording.sinkSamples(part, slot->timestamp + (Timestamp)llround(first * sample_ns));
+	}
+
+	for (Annotation& a: job.annotations) {
+		a.annotation.sample_start = recording.sampleIndex(a.timestamp);
+		recording.addAnnotation(a.annotation);
+	}
+
+	recording.close();
+	metric_snapshots.inc();
+}
+
+
+void IQSnapshot::writerThread() {
+	while (true) {
+		const uint32_t seq = wakeups.load(memory_order_acquire);
+		const bool stop = stopping.load(memory_order_acquire);
+
+		Job* job = pending_jobs.pop();
+		if (job != nullptr) {
+			try {
+				writeSnapshot(*job);
+			}
+			catch (const exception& e) {
+				cerr << e.what() << endl;
+			}
+
+			for (Slot* slot: job->slots)
+				free_slots.push(slot);
+			job->slots.clear();
+			free_jobs.push(job);
+
+			snapshots_written.fetch_add(1, memory_order_release);
+			snapshots_written.notify_all();
+			continue;
+		}
+
+		if (stop)
+			return;
+		wakeups.wait(seq, memory_order_acquire);
+	}
+}
+
+
+Block* createIQSnapshot(const Kwargs& args)
+{
+	return new IQSnapshot();
+}
+
+static Registry registerIQSnapshot("IQSnapshot", &createIQSnapshot);
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "suo.hpp"
+#include "misc/metrics.hpp"
+#include "signal-io/sigmf.hpp"
+
+namespace suo {
+
+/*
+ * Triggered IQ snapshots.
+ *
+ * Keeps the latest received buffers in a circular history and, when triggered
+ * (syncword detected or a frame failed to decode), saves the samples from
+ * pre_trigger before the trigger to post_trigger after it as a SigMF recording.
+ * Triggers whose windows overlap are merged to the same snapshot and every
+ * trigger and received frame inside the window is stored as an annotation
+ * with the frame metadata.
+ *
+ * The buffers are never copied after the history: buffers of a completed
+ * snapshot are handed to a background thread writing the recording, and
+ * the history continues with spare buffers returned by the writer. If the
+ * writer has fallen behind the snapshot is dropped instead of waiting.
+ *
+ * All the inputs must be called from the receiver thread.
+ */
+class IQSnapshot : public Block
+{
+public:
+	struct Config {
+		Config();
+
+		/* Recording name prefix. Snapshots are named <prefix>_<n>.sigmf-{data,meta}. */
+		std::string filename_prefix;
+
+		/* Sample datatype: cf32_le or ci16_le */
+		std::string datatype;
+
+		/* Sample rate (Hz) */
+		double sample_rate;
+
+		/* Center frequency (Hz) */
+		double center_frequency;
+
+		/* Length of the window before and after the trigger (s) */
+		float pre_trigger;
+		float post_trigger;
+
+		/* Number of received buffers kept in the history. Must cover the whole window,
+		 * otherwise the snapshots are cut short when the oldest buffer of the window is overwritten. */
+		unsigned int history_buffers;
+
+		/* Maximum number of snapshots waiting to be written */
+		unsigned int max_pending;
+
+		/* Trigger sources */
+		bool trigger_on_sync;
+		bool trigger_on_failure;
+		bool trigger_on_frame;
+	};
+
+	explicit IQSnapshot(const Config& conf = Config());
+	~IQSnapshot();
+
+	IQSnapshot(const IQSnapshot&) = delete;
+	IQSnapshot& operator=(const IQSnapshot&) = delete;
+
+	void sinkSamples(const SampleVector& samples, Timestamp timestamp);
+
+	/* Connect to the deframer's syncDetected */
+	void syncDetected(bool sync, Timestamp timestamp);
+
+	/* Connect to the deframer's sinkFrame. Annotates the frame if a snapshot is being collected. */
+	void sinkFrame(const Frame& frame, Timestamp timestamp);
+
+	/* Connect to the deframer's frameFailed */
+	void frameFailed(const Frame& frame, Timestamp timestamp);
+
+	/* Trigger a snapshot at the given time. Frame is added to the annotation if given. */
+	void trigger(Timestamp timestamp, const std::string& label, const Frame* frame = nullptr);
+
+	/* Save the pending snapshots with the samples received so far and wait until all are written */
+	void flush();
+
+	uint64_t getSnapshotCount() const { return snapshots_written.load(std::memory_order_acquire); }
+	uint64_t getDroppedCount() const { return snapshots_dropped; }
+	uint64_t getTruncatedCount() const { return snapshots_truncated; }
+
+private:
+	struct Slot {
+		SampleVector samples;
+		Timestamp timestamp = 0;
+		Timestamp end = 0;
+	};
+
+	struct Annotation {
+		Timestamp timestamp;
+		SigMFAnnotation annotation;
+	};
+
+	struct Job {
+		unsigned int id;
+		Timestamp epoch;
+		Timestamp start, end;
+		std::vector<Slot*> slots;
+		std::vector<Annotation> annotations;
+		std::string description;
+	};
+
+	/* Fixed size lock-free single producer single consumer queue of pointers */
+	template<typename T>
+	class Queue {
+	public:
+		explicit Queue(size_t size);
+		bool push(T* item);
+		T* pop();
+	private:
+		std::vector<T*> items;
+		size_t mask;
+		alignas(64) std::atomic<size_t> head;
+		alignas(64) std::atomic<size_t> tail;
+	};
+
+	void complete(Job* job);
+	void writerThread();
+	void writeSnapshot(Job& job);
+
+	Config conf;
+	double sample_ns;
+	Timestamp pre_ns, post_ns;
+
+	/* Storage for the buffers and the snapshots */
+	std::vector<std::unique_ptr<Slot>> slot_storage;
+	std::vector<std::unique_ptr<Job>> job_storage;
+
+	/* Receiver side state */
+	std::vector<Slot*> history;
+	size_t history_idx;
+	Job* collecting;
+	Job* spare_job;
+	unsigned int next_id;
+	Timestamp epoch;
+	uint64_t snapshots_dropped;
+	uint64_t snapshots_truncated;
+
+	/* Receiver -> writer */
+	Queue<Job> pending_jobs;
+	/* Writer -> receiver */
+	Queue<Job> free_jobs;
+	Queue<Slot> free_slots;
+
+	std::thread writer;
+	std::atomic<uint32_t> wakeups;
+	std::atomic<bool> stopping;
+	std::atomic<uint64_t> snapshots_queued;
+	std::atomic<uint64_t> snapshots_written;
+
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_snapshots;
+	Counter& metric_dropped;
+	Counter& metric_truncated;
+};
+
+}; // namespace suo
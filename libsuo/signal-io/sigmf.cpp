@@ -0,0 +1,408 @@
+#include <iostream>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+#include "signal-io/sigmf.hpp"
+#include "signal-io/conversion.hpp"
+#include "registry.hpp"
+#include "json.hpp"
+
+
+using namespace std;
+using namespace suo;
+using json = nlohmann::ordered_json;
+
+
+/* Samples of timestamp jitter tolerated before a new capture segment is started */
+static const double capture_tolerance = 2.0;
+
+
+/* Remove known SigMF extension from the filename */
+static string recording_name(const string& filename) {
+	for (const char* ext: { ".sigmf-meta", ".sigmf-data", ".sigmf" }) {
+		const size_t len = strlen(ext);
+		if (filename.size() > len && filename.compare(filename.size() - len, len, ext) == 0)
+			return filename.substr(0, filename.size() - len);
+	}
+	return filename;
+}
+
+
+string suo::sigmf_format_datetime(Timestamp t) {
+	const time_t seconds = t / 1000000000;
+	struct tm tm;
+	gmtime_r(&seconds, &tm);
+	char buf[64];
+	size_t len = strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+	snprintf(buf + len, sizeof(buf) - len, ".%09uZ", (unsigned int)(t % 1000000000));
+	return buf;
+}
+
+
+Timestamp suo::sigmf_parse_datetime(const string& datetime) {
+	struct tm tm = {};
+	int consumed = 0;
+	if (sscanf(datetime.c_str(), "%d-%d-%dT%d:%d:%d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+		&tm.tm_hour, &tm.tm_min, &tm.tm_sec, &consumed) != 6)
+		throw SuoError("SigMF: Invalid datetime '%s'", datetime.c_str());
+	tm.tm_year -= 1900;
+	tm.tm_mon -= 1;
+
+	/* Fraction of seconds with any number of digits */
+	uint64_t ns = 0;
+	const char* p = datetime.c_str() + consumed;
+	if (*p == '.') {
+		uint64_t scale = 100000000;
+		for (p++; isdigit(*p); p++, scale /= 10)
+			ns += (*p - '0') * scale;
+	}
+
+	return (Timestamp)timegm(&tm) * 1000000000 + ns;
+}
+
+
+SigMFWriter::Config::Config() {
+	datatype = "cf32_le";
+	sample_rate = 1e6;
+	center_frequency = 0;
+	epoch = 0;
+	annotation_duration = 0.0f;
+}
+
+
+SigMFWriter::SigMFWriter(const Config& _conf) :
+	conf(_conf),
+	sample_count(0),
+	next_timestamp(0)
+{
+	if (conf.datatype != "cf32_le" && conf.datatype != "ci16_le")
+		throw SuoError("SigMFWriter: Unsupported datatype %s", conf.datatype.c_str());
+	if (conf.sample_rate <= 0)
+		throw SuoError("SigMFWriter: Negative or zero sample rate! %f", conf.sample_rate);
+	if (conf.filename.empty())
+		throw SuoError("SigMFWriter: No filename given!");
+
+	conf.filename = recording_name(conf.filename);
+	sample_ns = 1.0e9 / conf.sample_rate;
+
+	data.open(conf.filename + ".sigmf-data", ios::out | ios::binary | ios::trunc);
+	if (data.is_open() == false)
+		throw SuoError("SigMFWriter: Failed to open %s.sigmf-data", conf.filename.c_str());
+}
+
+
+SigMFWriter::~SigMFWriter() {
+	close();
+}
+
+
+void SigMFWriter::close() {
+	if (data.is_open() == false)
+		return;
+	data.close();
+	writeMeta();
+}
+
+
+void SigMFWriter::sinkSamples(const SampleVector& samples, Timestamp timestamp) {
+	if (data.is_open() == false)
+		throw SuoError("SigMFWriter: Recording already closed!");
+	if (samples.empty())
+		return;
+
+	/* Start a new capture segment if the timestamps are not continuous */
+	if (captures.empty() || abs((double)timestamp - (double)next_timestamp) > capture_tolerance * sample_ns) {
+		if (conf.epoch == 0) {
+			const Timestamp wall = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+			conf.epoch = wall - timestamp;
+		}
+		captures.push_back({ sample_count, timestamp, conf.epoch + timestamp, conf.center_frequency });
+	}
+
+	if (conf.datatype == "ci16_le") {
+		convert_buffer.resize(2 * samples.size());
+		cf_to_cs16(samples.data(), reinterpret_cast<cs16_t*>(convert_buffer.data()), samples.size());
+		data.write(reinterpret_cast<const char*>(convert_buffer.data()), convert_buffer.size() * sizeof(int16_t));
+	}
+	else {
+		data.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(Sample));
+	}
+	if (!data)
+		throw SuoError("SigMFWriter: Failed to write samples");
+
+	sample_count += samples.size();
+
+	const SigMFCapture& capture = captures.back();
+	next_timestamp = capture.timestamp + (Timestamp)llround((sample_count - capture.sample_start) * sample_ns);
+}
+
+
+uint64_t SigMFWriter::sampleIndex(Timestamp timestamp) const {
+	if (captures.empty())
+		return 0;
+
+	/* Last capture segment starting before the timestamp */
+	auto capture = captures.rbegin();
+	while (next(capture) != captures.rend() && capture->timestamp > timestamp)
+		capture++;
+	if (timestamp < capture->timestamp)
+		return capture->sample_start;
+	return capture->sample_start + (uint64_t)llround((timestamp - capture->timestamp) / sample_ns);
+}
+
+
+void SigMFWriter::sinkFrame(const Frame& frame, Timestamp timestamp) {
+	/* Frame starts from the syncword */
+	Timestamp start = timestamp;
+	auto sync = frame.metadata.find("sync_timestamp");
+	if (sync != frame.metadata.end() && holds_alternative<Timestamp>(sync->second))
+		start = get<Timestamp>(sync->second);
+	else if (frame.timestamp != 0)
+		start = frame.timestamp;
+
+	SigMFAnnotation annotation;
+	annotation.sample_start = sampleIndex(start);
+	annotation.sample_count = (uint64_t)llround(conf.annotation_duration * conf.sample_rate);
+	annotation.label = "frame";
+	annotation.frame = frame.serialize_to_json();
+	addAnnotation(annotation);
+}
+
+
+void SigMFWriter::addAnnotation(const SigMFAnnotation& annotation) {
+	annotations.push_back(annotation);
+}
+
+
+void SigMFWriter::writeMeta() {
+	sigmf_write_meta(conf.filename, conf, captures, annotations);
+}
+
+
+void suo::sigmf_write_meta(const string& filename, const SigMFWriter::Config& conf,
+	const vector<SigMFCapture>& captures, vector<SigMFAnnotation> annotations)
+{
+	json meta;
+	meta["global"]["core:datatype"] = conf.datatype;
+	meta["global"]["core:sample_rate"] = conf.sample_rate;
+	meta["global"]["core:version"] = "1.0.0";
+	meta["global"]["core:recorder"] = "suo";
+	if (conf.description.empty() == false)
+		meta["global"]["core:description"] = conf.description;
+	if (conf.author.empty() == false)
+		meta["global"]["core:author"] = conf.author;
+	if (conf.hw.empty() == false)
+		meta["global"]["core:hw"] = conf.hw;
+
+	meta["captures"] = json::array();
+	for (const SigMFCapture& capture: captures) {
+		json c;
+		c["core:sample_start"] = capture.sample_start;
+		c["core:datetime"] = sigmf_format_datetime(capture.datetime);
+		c["core:frequency"] = capture.frequency;
+		c["suo:timestamp"] = capture.timestamp;
+		meta["captures"].push_back(c);
+	}
+
+	/* Annotations must be sorted by the start sample */
+	stable_sort(annotations.begin(), annotations.end(), [](const SigMFAnnotation& a, const SigMFAnnotation& b) {
+		return a.sample_start < b.sample_start;
+	});
+	meta["annotations"] = json::array();
+	for (const SigMFAnnotation& annotation: annotations) {
+		json a;
+		a["core:sample_start"] = annotation.sample_start;
+		if (annotation.sample_count > 0)
+			a["core:sample_count"] = annotation.sample_count;
+		if (annotation.label.empty() == false)
+			a["core:label"] = annotation.label;
+		if (annotation.comment.empty() == false)
+			a["core:comment"] = annotation.comment;
+		if (annotation.frame.empty() == false)
+			a["suo:frame"] = json::parse(annotation.frame);
+		meta["annotations"].push_back(a);
+	}
+
+	ofstream file(filename + ".sigmf-meta", ios::out | ios::trunc);
+	if (file.is_open() == false)
+		throw SuoError("SigMF: Failed to open %s.sigmf-meta", filename.c_str());
+	file << meta.dump(2) << endl;
+}
+
+
+
+SigMFReader::Config::Config() {
+	buffer_len = 4096;
+	segment_margin = 0.1f;
+	start_sample = 0;
+	sample_count = 0;
+}
+
+
+SigMFReader::SigMFReader(const Config& _conf) :
+	conf(_conf)
+{
+	if (conf.buffer_len == 0)
+		throw SuoError("SigMFReader: Zero buffer length!");
+	const string name = recording_name(conf.filename);
+
+	/* Parse the metadata */
+	ifstream meta_file(name + ".sigmf-meta");
+	if (meta_file.is_open() == false)
+		throw SuoError("SigMFReader: Failed to open %s.sigmf-meta", name.c_str());
+
+	json meta;
+	try {
+		meta = json::parse(meta_file);
+		datatype = meta.at("global").at("core:datatype").get<string>();
+		sample_rate = meta.at("global").at("core:sample_rate").get<double>();
+
+		for (const json& c: meta.value("captures", json::array())) {
+			SigMFCapture capture;
+			capture.sample_start = c.value("core:sample_start", (uint64_t)0);
+			capture.datetime = c.contains("core:datetime") ? sigmf_parse_datetime(c["core:datetime"].get<string>()) : 0;
+			capture.timestamp = c.value("suo:timestamp", capture.datetime);
+			capture.frequency = c.value("core:frequency", 0.0);
+			captures.push_back(capture);
+		}
+
+		for (const json& a: meta.value("annotations", json::array())) {
+			SigMFAnnotation annotation;
+			annotation.sample_start = a.at("core:sample_start").get<uint64_t>();
+			annotation.sample_count = a.value("core:sample_count", (uint64_t)0);
+			annotation.label = a.value("core:label", "");
+			annotation.comment = a.value("core:comment", "");
+			if (a.contains("suo:frame"))
+				annotation.frame = a["suo:frame"].dump();
+			annotations.push_back(annotation);
+		}
+	}
+	catch (const json::exception& e) {
+		throw SuoError("SigMFReader: Invalid metadata in %s.sigmf-meta: %s", name.c_str(), e.what());
+	}
+
+	if (datatype == "cf32_le")
+		sample_size = sizeof(Sample);
+	else if (datatype == "ci16_le")
+		sample_size = sizeof(cs16_t);
+	else if (datatype == "cu8")
+		sample_size = sizeof(cu8_t);
+	else
+		throw SuoError("SigMFReader: Unsupported datatype %s", datatype.c_str());
+	if (sample_rate <= 0)
+		throw SuoError("SigMFReader: Invalid sample rate %f", sample_rate);
+	sample_ns = 1.0e9 / sample_rate;
+
+	if (captures.empty() || captures[0].sample_start != 0)
+		captures.insert(captures.begin(), { 0, 0, 0, 0.0 });
+
+	/* Open the data */
+	data.open(name + ".sigmf-data", ios::in | ios::binary);
+	if (data.is_open() == false)
+		throw SuoError("SigMFReader: Failed to open %s.sigmf-data", name.c_str());
+	data.seekg(0, ios::end);
+	total_samples = data.tellg() / sample_size;
+
+	read_buffer.resize(conf.buffer_len * sample_size);
+	buffer.reserve(conf.buffer_len);
+}
+
+
+Timestamp SigMFReader::sampleTimestamp(uint64_t sample) const {
+	auto capture = upper_bound(captures.begin(), captures.end(), sample, [](uint64_t s, const SigMFCapture& c) {
+		return s < c.sample_start;
+	});
+	capture--;
+	return capture->timestamp + (Timestamp)llround((sample - capture->sample_start) * sample_ns);
+}
+
+
+vector<pair<uint64_t, uint64_t>> SigMFReader::getSegments() const {
+	vector<pair<uint64_t, uint64_t>> segments;
+
+	if (conf.segment_label.empty()) {
+		const uint64_t start = min(conf.start_sample, total_samples);
+		const uint64_t count = (conf.sample_count == 0) ? total_samples - start : min(conf.sample_count, total_samples - start);
+		if (count > 0)
+			segments.push_back({ start, count });
+		return segments;
+	}
+
+	/* Annotated segments with the margins. Overlapping segments are merged. */
+	const uint64_t margin = (uint64_t)llround(conf.segment_margin * sample_rate);
+	for (const SigMFAnnotation& annotation: annotations) {
+		if (annotation.label != conf.segment_label)
+			continue;
+		const uint64_t start = (annotation.sample_start > margin) ? annotation.sample_start - margin : 0;
+		const uint64_t end = min(total_samples, annotation.sample_start + annotation.sample_count + margin);
+		if (start >= end)
+			continue;
+		if (segments.empty() == false && start <= segments.back().first + segments.back().second)
+			segments.back().second = max(segments.back().second, end - segments.back().first);
+		else
+			segments.push_back({ start, end - start });
+	}
+	return segments;
+}
+
+
+void SigMFReader::replay(uint64_t start, uint64_t count) {
+	if (start + count > total_samples)
+		throw SuoError("SigMFReader: Segment past the end of the recording");
+
+	data.clear();
+	data.seekg(start * sample_size);
+
+	while (count > 0) {
+		/* Don't let a buffer span over capture segments because the timestamps jump */
+		size_t len = min<uint64_t>(count, conf.buffer_len);
+		auto next_capture = upper_bound(captures.begin(), captures.end(), start, [](uint64_t s, const SigMFCapture& c) {
+			return s < c.sample_start;
+		});
+		if (next_capture != captures.end())
+			len = min<uint64_t>(len, next_capture->sample_start - start);
+
+		data.read(read_buffer.data(), len * sample_size);
+		if ((size_t)data.gcount() != len * sample_size)
+			throw SuoError("SigMFReader: Failed to read samples");
+
+		buffer.resize(len);
+		if (datatype == "cf32_le")
+			memcpy(buffer.data(), read_buffer.data(), len * sizeof(Sample));
+		else if (datatype == "ci16_le")
+			cs16_to_cf(reinterpret_cast<cs16_t*>(read_buffer.data()), buffer.data(), len);
+		else
+			cu8_to_cf(reinterpret_cast<cu8_t*>(read_buffer.data()), buffer.data(), len);
+
+		const Timestamp timestamp = sampleTimestamp(start);
+		buffer.timestamp = timestamp;
+		sinkSamples.emit(buffer, timestamp);
+
+		start += len;
+		count -= len;
+	}
+}
+
+
+void SigMFReader::execute() {
+	for (const auto& segment: getSegments())
+		replay(segment.first, segment.second);
+}
+
+
+Block* createSigMFReader(const Kwargs& args)
+{
+	return new SigMFReader();
+}
+
+static Registry registerSigMFReader("SigMFReader", &createSigMFReader);
+
+Block* createSigMFWriter(const Kwargs& args)
+{
+	return new SigMFWriter();
+}
+
+static Registry registerSigMFWriter("SigMFWriter", &createSigMFWriter);
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <fstream>
+#include <vector>
+#include "suo.hpp"
+
+namespace suo {
+
+/*
+ * SigMF (Signal Metadata Format) recordings.
+ *
+ * A recording is a pair of files: <name>.sigmf-data containing the raw samples
+ * and <name>.sigmf-meta containing JSON metadata. Supported datatypes are
+ * cf32_le, ci16_le and cu8 (read only).
+ *
+ * Every capture segment stores the suo stream timestamp of its first sample
+ * as "suo:timestamp" in addition to core:datetime. On replay the same timestamps
+ * are reproduced, so e.g. sync_timestamp metadata of the decoded frames can be
+ * compared between replays and with the live run.
+ */
+
+/* Capture segment: Continuous samples starting from sample_start */
+struct SigMFCapture {
+	uint64_t sample_start;
+	Timestamp timestamp;   // Stream timestamp of the first sample
+	Timestamp datetime;    // UTC time of the first sample as nanoseconds since the Unix epoch
+	double frequency;      // Center frequency (Hz)
+};
+
+/* Annotation of a sample range, e.g. a received frame */
+struct SigMFAnnotation {
+	uint64_t sample_start;
+	uint64_t sample_count; // 0 if not given
+	std::string label;
+	std::string comment;
+	std::string frame;     // Frame as JSON (suo:frame) or empty
+};
+
+
+/* Format nanoseconds since the Unix epoch as an ISO 8601 UTC string used by core:datetime */
+std::string sigmf_format_datetime(Timestamp t);
+
+/* Parse an ISO 8601 UTC string to nanoseconds since the Unix epoch */
+Timestamp sigmf_parse_datetime(const std::string& datetime);
+
+
+/*
+ * SigMF recording sink.
+ * Samples are written to the data file as they come. A new capture segment is
+ * started whenever the timestamps jump. Frames given to sinkFrame are annotated
+ * starting from their sync_timestamp. Metadata file is written when the recording is closed.
+ */
+class SigMFWriter : public Block
+{
+public:
+	struct Config {
+		Config();
+
+		/* Recording name. The .sigmf-data and .sigmf-meta extensions are added. */
+		std::string filename;
+
+		/* Sample datatype: cf32_le or ci16_le */
+		std::string datatype;
+
+		/* Sample rate (Hz) */
+		double sample_rate;
+
+		/* Center frequency (Hz) */
+		double center_frequency;
+
+		/* Wall clock time (ns since the Unix epoch) at stream timestamp 0. 0 uses the system clock at the first sample. */
+		Timestamp epoch;
+
+		/* Length of the frame annotations (s). 0 leaves the sample count out. */
+		float annotation_duration;
+
+		/* Free text fields of the global metadata */
+		std::string description;
+		std::string author;
+		std::string hw;
+	};
+
+	explicit SigMFWriter(const Config& conf = Config());
+	~SigMFWriter();
+
+	SigMFWriter(const SigMFWriter&) = delete;
+	SigMFWriter& operator=(const SigMFWriter&) = delete;
+
+	/* Write the metadata and close the files */
+	void close();
+
+	void sinkSamples(const SampleVector& samples, Timestamp timestamp);
+	void sinkFrame(const Frame& frame, Timestamp timestamp);
+
+	void addAnnotation(const SigMFAnnotation& annotation);
+
+	/* Sample index of given stream timestamp in the recording */
+	uint64_t sampleIndex(Timestamp timestamp) const;
+
+	uint64_t getSampleCount() const { return sample_count; }
+
+private:
+	void writeMeta();
+
+	Config conf;
+	double sample_ns;
+	std::ofstream data;
+	std::vector<SigMFCapture> captures;
+	std::vector<SigMFAnnotation> annotations;
+	uint64_t sample_count;
+	Timestamp next_timestamp;  // Expected timestamp of the next buffer
+	std::vector<int16_t> convert_buffer;
+};
+
+
+/*
+ * Write <filename>.sigmf-meta. Global fields are taken from the writer configuration.
+ * Used also by the other recorders producing SigMF compatible data files.
+ */
+void sigmf_write_meta(const std::string& filename, const SigMFWriter::Config& conf,
+	const std::vector<SigMFCapture>& captures, std::vector<SigMFAnnotation> annotations);
+
+
+/*
+ * SigMF recording source.
+ * Replays the whole recording, a range of samples or only the annotated segments
+ * with the original stream timestamps.
+ */
+class SigMFReader : public Block
+{
+public:
+	struct Config {
+		Config();
+
+		/* Recording name with or without the .sigmf-meta/.sigmf-data extension */
+		std::string filename;
+
+		/* Number of samples per emitted buffer */
+		unsigned int buffer_len;
+
+		/* Replay only the annotations with this label (e.g. "frame"). Empty replays the sample range. */
+		std::string segment_label;
+
+		/* Margin added before and after the annotated segments (s) */
+		float segment_margin;
+
+		/* Sample range to replay when no segment label is given. Count 0 replays to the end. */
+		uint64_t start_sample;
+		uint64_t sample_count;
+	};
+
+	explicit SigMFReader(const Config& conf = Config());
+
+	SigMFReader(const SigMFReader&) = delete;
+	SigMFReader& operator=(const SigMFReader&) = delete;
+
+	/* Replay the configured segments */
+	void execute();
+
+	/* Replay count samples starting from the given sample */
+	void replay(uint64_t start, uint64_t count);
+
+	/* Sample ranges (start, count) selected by the configuration */
+	std::vector<std::pair<uint64_t, uint64_t>> getSegments() const;
+
+	/* Stream timestamp of given sample */
+	Timestamp sampleTimestamp(uint64_t sample) const;
+
+	const std::string& getDatatype() const { return datatype; }
+	double getSampleRate() const { return sample_rate; }
+	uint64_t getSampleCount() const { return total_samples; }
+	const std::vector<SigMFCapture>& getCaptures() const { return captures; }
+	const std::vector<SigMFAnnotation>& getAnnotations() const { return annotations; }
+
+	Port<const SampleVector&, Timestamp> sinkSamples;
+
+private:
+	Config conf;
+	std::string datatype;
+	size_t sample_size;
+	double sample_rate;
+	double sample_ns;
+	uint64_t total_samples;
+	std::vector<SigMFCapture> captures;
+	std::vector<SigMFAnnotation> annotations;
+
+	std::ifstream data;
+	std::vector<char> read_buffer;
+	SampleVector buffer;
+};
+
+}; // namespace suo
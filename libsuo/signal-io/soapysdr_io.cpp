@@ -8,6 +8,7 @@
 #include <signal.h>
 #include <unistd.h> // usleep
 #include <assert.h>
+#include <algorithm>
 
 #include <SoapySDR/Device.hpp>
 #include <SoapySDR/Version.hpp>
@@ -66,8 +67,14 @@ SoapySDRIO::Config::Config() {
 }
 
 
-SoapySDRIO::SoapySDRIO(const Config& conf) :
+SoapySDRIO::SoapySDRIO(const Config& conf, EventLoop& loop) :
 	conf(conf),
+	loop(loop),
+	metric_labels(MetricsRegistry::getDefault().blockLabels("SoapySDRIO")),
+	metric_rx_samples(MetricsRegistry::getDefault().counter("suo_samples_in_total", "Number of received samples", metric_labels)),
+	metric_tx_samples(MetricsRegistry::getDefault().counter("suo_samples_out_total", "Number of transmitted samples", metric_labels)),
+	metric_rx_overflows(MetricsRegistry::getDefault().counter("suo_rx_overflows_total", "Number of receiver overflows", metric_labels)),
+	metric_rx_processing(MetricsRegistry::getDefault().histogram("suo_buffer_processing_ns", "Time spent processing one received buffer in nanoseconds", metric_labels)),
 	sdr(NULL),
 	rxstream(NULL),
 	txstream(NULL)
@@ -110,6 +117,8 @@ void SoapySDRIO::execute()
 	const long timeout_us = (sample_ns * rx_buflen) * 0.1;
 	// Used for lost sample detection
 	const long long timediff_max = sample_ns * 0.5;
+	// Maximum time to wait for events when not receiving, one buffer length
+	const int idle_timeout_ms = max(1, (int)(sample_ns * rx_buflen * 1e-6));
 
 	//if (conf.rx_on && (sample_sink == NULL || sample_sink_arg == NULL))
 	///	throw SuoError("RX is enabled but no sample sink provided");
@@ -266,27 +275,36 @@ void SoapySDRIO::execute()
 				}
 
 				// Pass the samples to other blocks
-				if (!(tx_active && conf.half_duplex))
+				metric_rx_samples.inc(new_samples);
+				if (!(tx_active && conf.half_duplex)) {
+					ScopedTimer timer(metric_rx_processing);
 					sinkSamples.emit(rxbuf, rx_timestamp);
+				}
 
 			}
 			else if (ret == SOAPY_SDR_OVERFLOW) {
 				cerr << "RX OVERFLOW" << endl;
+				metric_rx_overflows.inc();
 			} else if(ret < 0) {
 				throw SuoError("sdr->readStream: %d", ret);
 			}
 
+			/* Handle pending control and frame I/O events (e.g. uplink frames)
+			 * so that the TX generation below sees them during this round. */
+			loop.poll(0);
+
 		}
 		else {
-			/* TX-only case */
+			/* TX-only case:
+			 * Wait for the event loop instead of spinning, so that a new uplink
+			 * frame wakes up the TX generation immediately. */
+			loop.poll(tx_active ? 0 : idle_timeout_ms);
+
 			if (conf.use_time) {
-				/* There should be a blocking call somewhere, so maybe
-				 * there should be some kind of a sleep here.
-				 * When use_time == 0, however, the TX buffer is written
-				 * until it's full and writeStream blocks, so the buffer
-				 * "back-pressure" works for timing in that case.
-				 * For now, in TX-only use, it's recommended to set
-				 * use_time=0 and tx_cont=1. */
+				/* When idle, the event loop wait above paces the loop.
+				 * During a burst, the TX buffer is written until it's full
+				 * and writeStream blocks, so the buffer "back-pressure"
+				 * works for timing in that case. */
 				current_time = sdr->getHardwareTime();
 			} else {
 				current_time += sample_ns * conf.buffer + 0.5;
@@ -336,6 +354,7 @@ void SoapySDRIO::execute()
 				cout << " sdr->writeStream " << ret << endl;
 				if (ret <= 0)
 					throw SuoError("sdr->writeStream %d", ret);
+				metric_tx_samples.inc(ret);
 
 				// Deactivate txstream
 				if ((tx_flags & SOAPY_SDR_END_BURST) != 0) {
@@ -382,6 +401,7 @@ void SoapySDRIO::execute()
 					cout << " sdr->writeStream " << ret << endl;
 					if ((size_t)ret != txbuf.size())
 						throw SuoError("sdr->writeStream %d", ret);
+					metric_tx_samples.inc(ret);
 						
 				}
 
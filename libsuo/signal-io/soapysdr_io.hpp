@@ -1,6 +1,8 @@
 #pragma once
 
 #include "suo.hpp"
+#include "misc/event_loop.hpp"
+#include "misc/metrics.hpp"
 
 
 namespace SoapySDR {
@@ -81,7 +83,7 @@ public:
 		Kwargs tx_args;
 	};
 
-	explicit SoapySDRIO(const Config& args = Config());
+	explicit SoapySDRIO(const Config& args = Config(), EventLoop& loop = EventLoop::getDefault());
 	~SoapySDRIO();
 
 	void execute();
@@ -97,6 +99,16 @@ public:
 private:
 	Config conf;
 
+	/* Event loop of control and frame I/O blocks, polled from the main loop */
+	EventLoop& loop;
+
+	/* Performance counters */
+	MetricLabels metric_labels;
+	Counter& metric_rx_samples;
+	Counter& metric_tx_samples;
+	Counter& metric_rx_overflows;
+	Histogram& metric_rx_processing;
+
 	SoapySDR::Device *sdr;
 	SoapySDR::Stream *rxstream;
 	SoapySDR::Stream *txstream;
@@ -0,0 +1,160 @@
+#include "tracer.hpp"
+#include "suo.hpp"
+
+#include <set>
+#include <cstdio>
+#include <fstream>
+#include <cxxabi.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+using namespace std;
+using namespace suo;
+
+
+std::atomic<bool> suo::tracing_enabled{false};
+
+
+Tracer::Tracer() :
+	capacity(0),
+	generation(0),
+	start_ns(0)
+{
+}
+
+
+void Tracer::start(size_t _capacity) {
+	if (_capacity == 0)
+		throw SuoError("Tracer: Zero capacity");
+
+	lock_guard<std::mutex> lock(mutex);
+	capacity = 1;
+	while (capacity < _capacity)
+		capacity <<= 1;
+
+	// Threads notice the new generation and allocate new buffers
+	buffers.clear();
+	generation++;
+	start_ns = now();
+	tracing_enabled = true;
+}
+
+
+void Tracer::stop() {
+	tracing_enabled = false;
+}
+
+
+void Tracer::clear() {
+	lock_guard<std::mutex> lock(mutex);
+	buffers.clear();
+	generation++;
+}
+
+
+std::shared_ptr<Tracer::ThreadBuffer> Tracer::newThreadBuffer() {
+	lock_guard<std::mutex> lock(mutex);
+	shared_ptr<ThreadBuffer> buffer = make_shared<ThreadBuffer>();
+	buffer->tid = syscall(SYS_gettid);
+	buffer->events.resize(capacity);
+	buffer->generation = generation.load(memory_order_relaxed);
+	buffers.push_back(buffer);
+	return buffer;
+}
+
+
+void Tracer::record(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+	/* The thread keeps a reference to its buffer so that a concurrent start() or clear() cannot free it */
+	thread_local shared_ptr<ThreadBuffer> buffer;
+	thread_local const Tracer* buffer_owner = nullptr;
+
+	/* The mutex is taken only when the thread records its first event after start() */
+	if (!buffer || buffer_owner != this || buffer->generation != generation.load(memory_order_acquire)) {
+		buffer = newThreadBuffer();
+		buffer_owner = this;
+	}
+
+	uint64_t head = buffer->head.load(memory_order_relaxed);
+	buffer->events[head & (buffer->events.size() - 1)] = TraceEvent{ name, begin_ns, end_ns };
+	buffer->head.store(head + 1, memory_order_release);
+}
+
+
+static void append_escaped(std::string& out, const char* str) {
+	for (; *str != '\0'; str++) {
+		if (*str == '"' || *str == '\\')
+			out += '\\';
+		out += *str;
+	}
+}
+
+
+std::string Tracer::formatChromeTrace() const {
+	lock_guard<std::mutex> lock(mutex);
+
+	string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool first = true;
+	char buf[128];
+
+	for (const shared_ptr<ThreadBuffer>& buffer: buffers) {
+
+		// Thread name metadata event
+		snprintf(buf, sizeof(buf), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"suo-%u\"}}",
+			first ? "" : ",", (int)getpid(), buffer->tid, buffer->tid);
+		out += buf;
+		first = false;
+
+		const uint64_t head = buffer->head.load(memory_order_acquire);
+		const uint64_t size = buffer->events.size();
+		const uint64_t n = (head < size) ? head : size;
+
+		for (uint64_t i = head - n; i < head; i++) {
+			const TraceEvent& ev = buffer->events[i & (size - 1)];
+			if (ev.begin_ns < start_ns)
+				continue;
+
+			out += ",{\"name\":\"";
+			append_escaped(out, ev.name);
+			snprintf(buf, sizeof(buf), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u}",
+				1e-3 * (ev.begin_ns - start_ns), 1e-3 * (ev.end_ns - ev.begin_ns), (int)getpid(), buffer->tid);
+			out += buf;
+		}
+	}
+
+	out += "]}\n";
+	return out;
+}
+
+
+void Tracer::writeChromeTrace(const std::string& path) const {
+	ofstream file(path, ios::out | ios::trunc);
+	if (!file)
+		throw SuoError("Failed to open trace file %s", path.c_str());
+	file << formatChromeTrace();
+	if (!file)
+		throw SuoError("Failed to write trace file %s", path.c_str());
+}
+
+
+const char* Tracer::typeLabel(const std::type_info& type) {
+	static std::mutex labels_mutex;
+	static set<string> labels;
+
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+	string label = (status == 0 && demangled != nullptr) ? demangled : type.name();
+	free(demangled);
+
+	// Strip the namespace to keep the trace readable
+	if (label.compare(0, 5, "suo::") == 0)
+		label.erase(0, 5);
+
+	lock_guard<std::mutex> lock(labels_mutex);
+	return labels.insert(label).first->c_str();
+}
+
+
+Tracer& Tracer::getDefault() {
+	static Tracer tracer;
+	return tracer;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace suo {
+
+/*
+ * Global switch for the timeline tracing.
+ * While disabled every traced scope costs only a single relaxed load and a branch.
+ */
+extern std::atomic<bool> tracing_enabled;
+
+
+/* Single traced scope, written as a Chrome trace "complete" event */
+struct TraceEvent {
+	const char* name;
+	uint64_t begin_ns;
+	uint64_t end_ns;
+};
+
+
+/*
+ * Timeline tracer recording the time spent in port emissions and generator resumes.
+ * Every thread writes its events to its own ring buffer without locking. When a ring
+ * fills up, the oldest events are overwritten, so the trace always holds the latest
+ * activity before it was stopped. The result can be opened in chrome://tracing or
+ * in Perfetto UI (https://ui.perfetto.dev).
+ */
+class Tracer
+{
+public:
+	Tracer();
+	Tracer(const Tracer&) = delete;
+	Tracer& operator=(const Tracer&) = delete;
+
+	/* Start tracing. `capacity` is the number of events kept per thread (rounded up to power of two). */
+	void start(size_t capacity = 65536);
+
+	/* Stop tracing. Recorded events are kept until the next start() or clear(). */
+	void stop();
+
+	/* Drop all recorded events */
+	void clear();
+
+	/*
+	 * Write the recorded events in the Chrome trace event JSON format.
+	 * Should be called after stop() so that no thread is modifying its buffer.
+	 */
+	void writeChromeTrace(const std::string& path) const;
+	std::string formatChromeTrace() const;
+
+	/* Record an event for the calling thread */
+	void record(const char* name, uint64_t begin_ns, uint64_t end_ns);
+
+	/* Current trace time in nanoseconds */
+	static uint64_t now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/* Returns a persistent human readable label for a type (e.g. the block class owning a slot) */
+	static const char* typeLabel(const std::type_info& type);
+
+	/* Process wide default tracer */
+	static Tracer& getDefault();
+
+private:
+	struct ThreadBuffer {
+		unsigned int tid;
+		uint64_t generation;
+		std::vector<TraceEvent> events;
+		std::atomic<uint64_t> head{0};
+	};
+
+	std::shared_ptr<ThreadBuffer> newThreadBuffer();
+
+	mutable std::mutex mutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	size_t capacity;
+	std::atomic<uint64_t> generation;
+	uint64_t start_ns;
+};
+
+
+/*
+ * Record the time spent inside the scope to the default tracer.
+ * The clock is not read at all if the tracing is disabled.
+ */
+class TraceScope
+{
+public:
+	explicit TraceScope(const char* _name) :
+		name(tracing_enabled.load(std::memory_order_relaxed) ? _name : nullptr)
+	{
+		if (name)
+			begin_ns = Tracer::now();
+	}
+
+	~TraceScope() {
+		if (name)
+			Tracer::getDefault().record(name, begin_ns, Tracer::now());
+	}
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	const char* name;
+	uint64_t begin_ns;
+};
+
+}; // namespace suo
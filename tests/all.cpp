@@ -5,6 +5,7 @@
 //#include "coding/test_convolutional.cpp"
 #include "coding/test_crc.cpp"
 #include "coding/test_reed_solomon.cpp"
+#include "coding/test_golay24.cpp"
 
 #include "test_golay_framing.cpp"
 #include "test_hdlc_framing.cpp"
@@ -25,6 +26,7 @@ int main(int argc, char** argv)
 	//runner.addTest(ConvolutionalTest::suite());
 	runner.addTest(CRCTest::suite());
 	runner.addTest(ReedSolomonTest::suite());
+	runner.addTest(Golay24Test::suite());
 
 	// Framing tests
 	runner.addTest(GolayFramingTest::suite());
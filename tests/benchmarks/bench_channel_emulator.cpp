@@ -0,0 +1,132 @@
+/*
+ * Soak benchmark: BPSK Golay link through the streaming channel emulator.
+ * Simulates a long pass (default 600 s, or given in seconds as the first argument)
+ * with Doppler and clock drift, and reports the speed relative to real time,
+ * frame loss and resident memory as the simulation goes on.
+ */
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <unistd.h>
+
+#include "suo.hpp"
+#include "modem/mod_psk.hpp"
+#include "modem/demod_psk.hpp"
+#include "framing/golay_framer.hpp"
+#include "framing/golay_deframer.hpp"
+#include "signal-io/channel_emulator.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+/* Current resident set size in MiB */
+static double resident_memory() {
+	size_t pages = 0, resident = 0;
+	ifstream statm("/proc/self/statm");
+	statm >> pages >> resident;
+	return (double)resident * sysconf(_SC_PAGESIZE) / (1 << 20);
+}
+
+
+int main(int argc, char** argv) {
+	const float duration = (argc > 1) ? atof(argv[1]) : 600.0f; // [s]
+
+	/* Transmitter */
+	GolayFramer::Config framer_conf;
+	framer_conf.syncword = 0xC9D08A7B;
+	framer_conf.syncword_len = 32;
+	framer_conf.preamble_len = 3 * 16 * 8;
+	framer_conf.use_viterbi = false;
+	framer_conf.use_randomizer = true;
+	framer_conf.use_rs = false;
+	GolayFramer framer(framer_conf);
+
+	mt19937 rng(1);
+	unsigned int frames_sent = 0;
+	framer.sourceFrame.connect([&](Frame& frame, Timestamp now) {
+		frame.clear();
+		frame.timestamp = now;
+		frame.data.resize(64);
+		for (size_t i = 0; i < frame.data.size(); i++)
+			frame.data[i] = rng() & 0xFF;
+		frame.data[0] = frames_sent++;
+	});
+
+	PSKModulator::Config mod_conf;
+	mod_conf.sample_rate = 50e3;
+	mod_conf.symbol_rate = 9600;
+	mod_conf.center_frequency = 10e3;
+	mod_conf.ramp_up_duration = 3;
+	mod_conf.ramp_down_duration = 3;
+	mod_conf.differential = true;
+	PSKModulator mod(mod_conf);
+	mod.generateSymbols.connect_member(&framer, &GolayFramer::generateSymbols);
+
+	/* Channel: 2 kHz Doppler swing and 20 ppm clock offset drifting during the pass */
+	ChannelEmulator::Config channel_conf;
+	channel_conf.sample_rate = mod_conf.sample_rate;
+	channel_conf.duration = duration;
+	channel_conf.snr = 15.0f;
+	channel_conf.frequency_offset = 1000.0f;
+	channel_conf.doppler_rate = -2000.0f / duration;
+	channel_conf.clock_offset = 20.0f;
+	channel_conf.clock_drift = -20.0f / duration;
+	channel_conf.burst_gap = 0.05f;
+	channel_conf.burst_gap_jitter = 0.05f;
+	channel_conf.seed = 1;
+	ChannelEmulator channel(channel_conf);
+	channel.generateSamples.connect_member(&mod, &PSKModulator::generateSamples);
+
+	/* Receiver */
+	GolayDeframer::Config deframer_conf;
+	deframer_conf.syncword = framer_conf.syncword;
+	deframer_conf.syncword_len = framer_conf.syncword_len;
+	deframer_conf.sync_threshold = 3;
+	deframer_conf.use_viterbi = framer_conf.use_viterbi;
+	deframer_conf.use_randomizer = framer_conf.use_randomizer;
+	deframer_conf.use_rs = framer_conf.use_rs;
+	GolayDeframer deframer(deframer_conf);
+
+	unsigned int frames_received = 0;
+	deframer.sinkFrame.connect([&](const Frame& frame, Timestamp now) {
+		(void)frame;
+		(void)now;
+		frames_received++;
+	});
+
+	PSKDemodulator::Config demod_conf;
+	demod_conf.sample_rate = mod_conf.sample_rate;
+	demod_conf.symbol_rate = mod_conf.symbol_rate;
+	demod_conf.center_frequency = mod_conf.center_frequency;
+	demod_conf.samples_per_symbol = 8;
+	demod_conf.differential = mod_conf.differential;
+	PSKDemodulator demod(demod_conf);
+	demod.sinkSymbol.connect_member(&deframer, &GolayDeframer::sinkSymbol);
+	deframer.syncDetected.connect_member(&demod, &PSKDemodulator::lockReceiver);
+	channel.sinkSamples.connect_member(&demod, &PSKDemodulator::sinkSamples);
+
+	cout << right << setw(10) << "Time [s]" << setw(12) << "x realtime" << setw(10) << "Sent" << setw(10) << "Received"
+		<< setw(10) << "Loss" << setw(12) << "RSS [MiB]" << endl;
+
+	auto start = chrono::steady_clock::now();
+	const double report_interval = duration / 10;
+	double next_report = report_interval;
+	while (channel.getTime() < 1e9 * duration) {
+		channel.step();
+
+		const double t = 1e-9 * channel.getTime();
+		if (t >= next_report) {
+			next_report += report_interval;
+			const double wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			cout << setw(10) << fixed << setprecision(1) << t << setw(12) << t / wall
+				<< setw(10) << frames_sent << setw(10) << frames_received
+				<< setw(9) << setprecision(2) << 100.0 * (1.0 - (double)frames_received / max(1u, frames_sent)) << "%"
+				<< setw(12) << resident_memory() << endl;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * Benchmark convolutional encoder throughput.
+ * Compares a bit-by-bit parity loop to the table driven encoder.
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+#include "suo.hpp"
+#include "coding/convolutional_encoder.hpp"
+#include "framing/utils.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+/* Plain bit-by-bit encoder as the baseline */
+static void bitwise_encode(const ConvolutionalConfig& conf, const SymbolVector& input, SymbolVector& output)
+{
+	uint32_t shift_register = 0;
+	for (size_t n = 0; n < input.size(); n++) {
+		shift_register = (shift_register << 1) | input[n];
+		for (unsigned int j = 0; j < conf.rate; j++) {
+			if (conf.puncturing.empty() == false && conf.puncturing[j][n % conf.puncturing[j].size()] == 0)
+				continue;
+			output.push_back(bit_parity(shift_register & abs(conf.polys[j])) ^ (conf.polys[j] < 0));
+		}
+	}
+}
+
+
+template<typename Func>
+static double throughput(size_t bits, Func func) {
+	const unsigned int rounds = 200;
+	auto start = chrono::steady_clock::now();
+	for (unsigned int i = 0; i < rounds; i++)
+		func();
+	auto end = chrono::steady_clock::now();
+	return (double)rounds * bits / chrono::duration<double>(end - start).count() / 1e6;
+}
+
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+
+	ByteVector bytes(8192);
+	SymbolVector bits(8 * bytes.size());
+	for (size_t i = 0; i < bytes.size(); i++) {
+		bytes[i] = rand() & 0xFF;
+		for (size_t j = 0; j < 8; j++)
+			bits[8 * i + j] = (bytes[i] >> (7 - j)) & 1;
+	}
+
+	cout << left << setw(20) << "Code" << right << setw(12) << "Bitwise" << setw(12) << "Table" << setw(12) << "Packed" << "  [Mbit/s input]" << endl;
+
+	for (const char* name : { "CCSDS r=1/2 k=7", "CCSDS r=3/4 k=7", "CCSDS r=1/3 k=7" }) {
+		const ConvolutionalConfig& conf = ConvolutionCodes::getConfig(name);
+		ConvolutionalEncoder encoder(conf);
+		SymbolVector output;
+		output.reserve(4 * bits.size());
+
+		double bitwise_speed = throughput(bits.size(), [&]() {
+			output.clear();
+			bitwise_encode(conf, bits, output);
+		});
+		double table_speed = throughput(bits.size(), [&]() {
+			output.clear();
+			encoder.encode(bits, output);
+		});
+		double packed_speed = throughput(bits.size(), [&]() {
+			output.clear();
+			encoder.encode(bytes.data(), bytes.size(), output);
+		});
+
+		cout << left << setw(20) << name << right << fixed << setprecision(1);
+		cout << setw(12) << bitwise_speed << setw(12) << table_speed << setw(12) << packed_speed << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * Benchmark CRC throughput for all predefined algorithms.
+ * Compares byte-wise table lookup, slicing-by-8 and carry-less multiplication folding.
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+#include "suo.hpp"
+#include "coding/crc_generic.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+/* Plain byte-at-a-time table implementation as the baseline */
+template<typename T, unsigned int Width>
+class BytewiseCRC
+{
+public:
+	static const unsigned int TypeWidth = 8 * sizeof(T);
+
+	BytewiseCRC(const CRCAlgorithm& algo) : algo(algo) {
+		const T poly = algo.refIn ?
+			(reverse_bits((T)algo.poly) >> (TypeWidth - Width)) :
+			(algo.poly << (TypeWidth - Width));
+		for (unsigned int i = 0; i < 256; i++) {
+			T value = i;
+			if (algo.refIn) {
+				for (unsigned int j = 0; j < 8; j++)
+					value = (value >> 1) ^ ((value & 1) * poly);
+			}
+			else {
+				value <<= (TypeWidth - 8);
+				for (unsigned int j = 0; j < 8; j++)
+					value = (T)(value << 1) ^ (((value >> (TypeWidth - 1)) & 1) * poly);
+			}
+			table[i] = value;
+		}
+	}
+
+	T update(T value, const uint8_t* bytes, size_t len) const {
+		if (algo.refIn) {
+			for (size_t i = 0; i < len; i++)
+				value = table[(value ^ bytes[i]) & 0xFF] ^ (value >> 8);
+		}
+		else {
+			for (size_t i = 0; i < len; i++)
+				value = table[((value >> (TypeWidth - 8)) ^ bytes[i]) & 0xFF] ^ (T)(value << 8);
+		}
+		return value;
+	}
+
+private:
+	const CRCAlgorithm& algo;
+	T table[256];
+};
+
+
+template<typename Func>
+static double throughput(const ByteVector& data, Func func) {
+	const unsigned int rounds = (64 << 20) / data.size();
+	unsigned int sink = 0;
+	auto start = chrono::steady_clock::now();
+	for (unsigned int i = 0; i < rounds; i++)
+		sink += func();
+	auto end = chrono::steady_clock::now();
+	if (sink == 0x12345678)
+		cout << " ";
+	return (double)rounds * data.size() / chrono::duration<double>(end - start).count() / 1e6;
+}
+
+
+template<typename T, unsigned int Width>
+static void benchmark(const string_view name, const CRCAlgorithm& algo, const ByteVector& data) {
+	CRCGeneric<T, Width> crc(algo);
+	BytewiseCRC<T, Width> bytewise(algo);
+
+	double bytewise_speed = throughput(data, [&]() { return bytewise.update(0, data.data(), data.size()); });
+
+	crc_use_pclmul = false;
+	double sliced_speed = throughput(data, [&]() { return crc.update(0, data.data(), data.size()); });
+
+	crc_use_pclmul = crc_pclmul_available();
+	double pclmul_speed = throughput(data, [&]() { return crc.update(0, data.data(), data.size()); });
+
+	cout << left << setw(20) << name << right << setw(8) << data.size();
+	cout << fixed << setprecision(0) << setw(12) << bytewise_speed << setw(12) << sliced_speed << setw(12) << pclmul_speed << endl;
+}
+
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+
+	cout << "PCLMULQDQ available: " << (crc_pclmul_available() ? "yes" : "no") << endl;
+	cout << left << setw(20) << "Algorithm" << right << setw(8) << "Bytes";
+	cout << setw(12) << "Bytewise" << setw(12) << "Sliced" << setw(12) << "PCLMUL" << "  [MB/s]" << endl;
+
+	for (size_t len : { 64, 256, 2048, 65536 }) {
+		ByteVector data(len);
+		for (size_t i = 0; i < len; i++)
+			data[i] = rand() % 256;
+
+		for (const auto& [name, algo] : CRCAlgorithms::algorithms) {
+			switch (algo.width) {
+			case 8: benchmark<uint8_t, 8>(name, algo, data); break;
+			case 16: benchmark<uint16_t, 16>(name, algo, data); break;
+			case 24: benchmark<uint32_t, 24>(name, algo, data); break;
+			case 32: benchmark<uint32_t, 32>(name, algo, data); break;
+			}
+		}
+		cout << endl;
+	}
+
+	return 0;
+}
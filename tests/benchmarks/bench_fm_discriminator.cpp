@@ -0,0 +1,68 @@
+/*
+ * Benchmark quadrature FM discriminator throughput.
+ * Compares std::arg (libm atan2f) to the polynomial atan2 with scalar, SSE and AVX2 kernels.
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+
+#include "suo.hpp"
+#include "modem/fm_discriminator.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+template<typename Func>
+static double throughput(size_t len, Func func) {
+	const unsigned int rounds = (32 << 20) / len;
+	auto start = chrono::steady_clock::now();
+	for (unsigned int i = 0; i < rounds; i++)
+		func();
+	auto end = chrono::steady_clock::now();
+	return (double)rounds * len / chrono::duration<double>(end - start).count() / 1e6;
+}
+
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+
+	const char* kernel_names[] = { "scalar", "SSE", "AVX2" };
+	cout << "Best kernel: " << kernel_names[fm_kernel_available()] << endl;
+	cout << right << setw(8) << "Samples" << setw(12) << "libm";
+	for (int kernel = FMKernelScalar; kernel <= fm_kernel_available(); kernel++)
+		cout << setw(12) << kernel_names[kernel];
+	cout << "  [Msamples/s]" << endl;
+
+	mt19937 rng(1);
+	normal_distribution<float> dist(0.0f, 1.0f);
+
+	for (size_t len : { 64, 1024, 16384 }) {
+		SampleVector samples;
+		samples.reserve(len);
+		for (size_t i = 0; i < len; i++)
+			samples.push_back(Sample(dist(rng), dist(rng)));
+		vector<float> out(len);
+		Sample prev = 1.0f;
+
+		double libm_speed = throughput(len, [&]() {
+			for (size_t i = 0; i < len; i++) {
+				out[i] = arg(conj(prev) * samples[i]);
+				prev = samples[i];
+			}
+		});
+		cout << setw(8) << len << fixed << setprecision(1) << setw(12) << libm_speed;
+
+		for (int kernel = FMKernelScalar; kernel <= fm_kernel_available(); kernel++) {
+			fm_kernel = (FMKernel)kernel;
+			double speed = throughput(len, [&]() { fm_discriminate(samples.data(), len, out.data(), prev); });
+			cout << setw(12) << speed;
+		}
+		cout << endl;
+		fm_kernel = fm_kernel_available();
+	}
+
+	return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Benchmark the streaming JSON frame serializer against nlohmann's DOM.
+ */
+#include <iostream>
+#include <chrono>
+#include <variant>
+
+#include "suo.hpp"
+#include "json.hpp"
+
+using namespace std;
+using namespace suo;
+using json = nlohmann::json;
+
+
+/* Reference serializer building the full DOM (previous implementation) */
+static string serialize_dom(const Frame& frame) {
+	json dict = json::object();
+	dict["id"] = frame.id;
+	json meta_dict = json::object();
+	for (auto metadata : frame.metadata)
+		std::visit([&](auto const& a) { meta_dict[metadata.first] = a; }, metadata.second);
+	dict["metadata"] = meta_dict;
+	dict["timestamp"] = frame.timestamp;
+	string hex;
+	for (Byte b : frame.data) {
+		char buf[3];
+		snprintf(buf, sizeof(buf), "%02x", b);
+		hex += buf;
+	}
+	dict["data"] = hex;
+	return dict.dump();
+}
+
+
+template<typename Func>
+static double measure(const char* name, unsigned int rounds, Func func) {
+	auto start = chrono::steady_clock::now();
+	for (unsigned int i = 0; i < rounds; i++)
+		func();
+	auto end = chrono::steady_clock::now();
+	double us = chrono::duration<double, micro>(end - start).count() / rounds;
+	cout << name << ": " << us << " us/frame" << endl;
+	return us;
+}
+
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+
+	const unsigned int rounds = 100000;
+
+	Frame frame;
+	frame.id = 1234;
+	frame.timestamp = 1680000000000;
+	frame.data.resize(256);
+	for (size_t i = 0; i < frame.size(); i++)
+		frame.data[i] = rand() % 256;
+	frame.setMetadata("rssi", -87.5f);
+	frame.setMetadata("cfo", 1234.5f);
+	frame.setMetadata("sync_errors", 1);
+	frame.setMetadata("golay_coded", 1);
+	frame.setMetadata("timestamp", getCurrentISOTimestamp());
+
+	size_t total = 0;
+	string buffer;
+	double dom = measure("Serialize DOM", rounds, [&]() { total += serialize_dom(frame).size(); });
+	double fast = measure("Serialize streaming", rounds, [&]() { frame.serialize_to_json(buffer); total += buffer.size(); });
+	cout << "Serialization speedup: " << (dom / fast) << "x" << endl;
+
+	Frame parsed;
+	dom = measure("Parse DOM", rounds, [&]() { total += json::parse(buffer).size(); });
+	fast = measure("Parse SAX", rounds, [&]() { Frame::deserialize_from_json(buffer, parsed); total += parsed.size(); });
+	cout << "Parsing speedup: " << (dom / fast) << "x" << endl;
+
+	return (total == 0);
+}
@@ -0,0 +1,68 @@
+/*
+ * Benchmark complex Gaussian noise generation throughput.
+ * Compares std::normal_distribution and liquid-dsp's randnf to GaussianNoise with scalar and AVX2 kernels.
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+
+#include <liquid/liquid.h>
+
+#include "suo.hpp"
+#include "misc/gaussian_noise.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+template<typename Func>
+static double throughput(size_t len, Func func) {
+	const unsigned int rounds = (16 << 20) / len;
+	auto start = chrono::steady_clock::now();
+	for (unsigned int i = 0; i < rounds; i++)
+		func();
+	auto end = chrono::steady_clock::now();
+	return (double)rounds * len / chrono::duration<double>(end - start).count() / 1e6;
+}
+
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+
+	const char* kernel_names[] = { "scalar", "AVX2" };
+	cout << "Best kernel: " << kernel_names[noise_kernel_available()] << endl;
+	cout << right << setw(8) << "Samples" << setw(12) << "std" << setw(12) << "liquid";
+	for (int kernel = NoiseKernelScalar; kernel <= noise_kernel_available(); kernel++)
+		cout << setw(12) << kernel_names[kernel];
+	cout << "  [Msamples/s]" << endl;
+
+	mt19937 rng(1);
+	normal_distribution<float> dist(0.0f, 1.0f);
+	GaussianNoise noise(1);
+
+	for (size_t len : { 64, 1024, 16384 }) {
+		SampleVector samples(len);
+
+		double std_speed = throughput(len, [&]() {
+			for (size_t i = 0; i < len; i++)
+				samples[i] += 0.1f * Sample(dist(rng), dist(rng));
+		});
+		double liquid_speed = throughput(len, [&]() {
+			for (size_t i = 0; i < len; i++)
+				samples[i] += 0.1f * Sample(randnf(), randnf());
+		});
+		cout << setw(8) << len << fixed << setprecision(1) << setw(12) << std_speed << setw(12) << liquid_speed;
+
+		for (int kernel = NoiseKernelScalar; kernel <= noise_kernel_available(); kernel++) {
+			noise_kernel = (NoiseKernel)kernel;
+			double speed = throughput(len, [&]() { noise.add(samples, 0.1f); });
+			cout << setw(12) << speed;
+		}
+		cout << endl;
+		noise_kernel = noise_kernel_available();
+	}
+
+	return 0;
+}
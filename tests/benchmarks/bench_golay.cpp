@@ -0,0 +1,131 @@
+/*
+ * Benchmark Golay(24,12) decoding throughput.
+ * Compares the algebraic decoder to the syndrome lookup table decoder
+ * and the soft decision Chase decoder.
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <bit>
+
+#include "suo.hpp"
+#include "coding/golay24.hpp"
+#include "framing/utils.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+/* Algebraic decoder (Morelos-Zaragoza, Section 2.2.3) as the baseline */
+static const uint32_t H[12] = { 0x8008ed, 0x4001db, 0x2003b5, 0x100769, 0x80ed1, 0x40da3,
+                                0x20b47,  0x1068f,  0x8d1d,   0x4a3b,   0x2477,  0x1ffe };
+
+static int algebraic_decode(uint32_t* data)
+{
+	const uint32_t r = *data;
+	uint32_t s = 0, q = 0, e;
+
+	for (int i = 0; i < 12; i++)
+		s = (s << 1) | bit_parity(H[i] & r);
+
+	if (std::popcount(s) <= 3) {
+		e = s << 12;
+		goto done;
+	}
+	for (int i = 0; i < 12; i++) {
+		if (std::popcount(s ^ (H[i] & 0xfff)) <= 2) {
+			e = ((s ^ (H[i] & 0xfff)) << 12) | (1 << (11 - i));
+			goto done;
+		}
+	}
+	for (int i = 0; i < 12; i++)
+		q = (q << 1) | bit_parity((H[i] & 0xfff) & s);
+	if (std::popcount(q) <= 3) {
+		e = q;
+		goto done;
+	}
+	for (int i = 0; i < 12; i++) {
+		if (std::popcount(q ^ (H[i] & 0xfff)) <= 2) {
+			e = (1 << (23 - i)) | (q ^ (H[i] & 0xfff));
+			goto done;
+		}
+	}
+	return -1;
+
+done:
+	*data = r ^ e;
+	return std::popcount(e);
+}
+
+
+template<typename Func>
+static double throughput(size_t count, Func func) {
+	const unsigned int rounds = (16 << 20) / count;
+	auto start = chrono::steady_clock::now();
+	int sink = 0;
+	for (unsigned int i = 0; i < rounds; i++)
+		sink += func();
+	auto end = chrono::steady_clock::now();
+	if (sink == 0x12345678)
+		cout << " ";
+	return (double)rounds * count / chrono::duration<double>(end - start).count() / 1e6;
+}
+
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+
+	/* Random codewords with 0-4 bit errors */
+	const size_t count = 4096;
+	vector<uint32_t> received(count);
+	vector<float> llrs(24 * count);
+	for (size_t i = 0; i < count; i++) {
+		uint32_t word = rand() & 0xFFF;
+		encode_golay24(&word);
+		uint32_t error = 0;
+		for (int e = rand() % 5; e > 0; e--)
+			error |= 1 << (rand() % 24);
+		received[i] = word ^ error;
+		for (int b = 0; b < 24; b++) {
+			const float reliability = ((error >> (23 - b)) & 1) ? 0.3f : 1.0f;
+			llrs[24 * i + b] = ((received[i] >> (23 - b)) & 1) ? reliability : -reliability;
+		}
+	}
+
+	double algebraic_speed = throughput(count, [&]() {
+		int sum = 0;
+		for (size_t i = 0; i < count; i++) {
+			uint32_t word = received[i];
+			sum += algebraic_decode(&word);
+		}
+		return sum;
+	});
+
+	double table_speed = throughput(count, [&]() {
+		int sum = 0;
+		for (size_t i = 0; i < count; i++) {
+			uint32_t word = received[i];
+			sum += decode_golay24(&word);
+		}
+		return sum;
+	});
+
+	double soft_speed = throughput(count, [&]() {
+		int sum = 0;
+		for (size_t i = 0; i < count; i++) {
+			uint32_t word;
+			sum += decode_golay24_soft(&llrs[24 * i], &word);
+		}
+		return sum;
+	});
+
+	cout << left << setw(12) << "Decoder" << right << setw(12) << "[Mwords/s]" << endl;
+	cout << fixed << setprecision(2);
+	cout << left << setw(12) << "Algebraic" << right << setw(12) << algebraic_speed << endl;
+	cout << left << setw(12) << "Table" << right << setw(12) << table_speed << endl;
+	cout << left << setw(12) << "Soft" << right << setw(12) << soft_speed << endl;
+
+	return 0;
+}
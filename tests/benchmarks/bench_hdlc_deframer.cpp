@@ -0,0 +1,63 @@
+/*
+ * Benchmark HDLC deframer throughput.
+ * Compares the bit-by-bit state machine to the byte-at-a-time table engine.
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+#include "suo.hpp"
+#include "framing/hdlc_deframer.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+template<typename Func>
+static double throughput(size_t bits, Func func) {
+	const unsigned int rounds = 20;
+	auto start = chrono::steady_clock::now();
+	for (unsigned int i = 0; i < rounds; i++)
+		func();
+	auto end = chrono::steady_clock::now();
+	return (double)rounds * bits / chrono::duration<double>(end - start).count() / 1e6;
+}
+
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+
+	/* Random bits mostly keep the deframer hunting for flags like a noisy channel */
+	const size_t len = 1 << 20;
+	SymbolVector symbols(len);
+	for (size_t i = 0; i < len; i++)
+		symbols[i] = rand() & 1;
+
+	cout << left << setw(10) << "Mode" << right << setw(12) << "Bitwise" << setw(12) << "Bytewise" << "  [Mbit/s]" << endl;
+
+	for (HDLCMode mode : { Uncoded, NRZI, G3RUH }) {
+		HDLCDeframer::Config conf;
+		conf.mode = mode;
+		conf.minimum_frame_length = 8;
+		HDLCDeframer deframer(conf);
+
+		double bitwise_speed = throughput(len, [&]() {
+			for (Symbol bit : symbols)
+				deframer.sinkSymbol(bit, 0);
+		});
+
+		double bytewise_speed = throughput(len, [&]() {
+			for (size_t i = 0; i < len; i += 1024) {
+				SymbolVector chunk(symbols.begin() + i, symbols.begin() + i + 1024);
+				deframer.sinkSymbols(chunk, 0);
+			}
+		});
+
+		const char* names[] = { "Uncoded", "NRZI", "G3RUH" };
+		cout << left << setw(10) << names[mode] << right << fixed << setprecision(1);
+		cout << setw(12) << bitwise_speed << setw(12) << bytewise_speed << endl;
+	}
+
+	return 0;
+}
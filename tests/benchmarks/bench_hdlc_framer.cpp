@@ -0,0 +1,64 @@
+/*
+ * Benchmark HDLC framer throughput for large AX.25 sized bursts.
+ * Measures the packed encoder and sourcing the symbols from the generator.
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+#include "suo.hpp"
+#include "framing/hdlc_framer.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+
+	Frame frame;
+	frame.data.resize(256);
+	for (Byte& byte : frame.data)
+		byte = rand() & 0xFF;
+
+	const unsigned int rounds = 20000;
+	cout << left << setw(10) << "Mode" << right << setw(12) << "Packed" << setw(12) << "Generator" << "  [Mbit/s]" << endl;
+
+	for (HDLCMode mode : { Uncoded, NRZI, G3RUH }) {
+		HDLCFramer::Config conf;
+		conf.mode = mode;
+		conf.preamble_length = 32;
+		conf.trailer_length = 4;
+		HDLCFramer framer(conf);
+		framer.sourceFrame.connect([&](Frame& out, Timestamp now) { (void)now; out = frame; });
+
+		ByteVector packed;
+		size_t bits = 0;
+		auto start = chrono::steady_clock::now();
+		for (unsigned int i = 0; i < rounds; i++)
+			bits += framer.encodeFrame(frame, packed);
+		auto end = chrono::steady_clock::now();
+		double packed_speed = bits / chrono::duration<double>(end - start).count() / 1e6;
+
+		SymbolVector symbols;
+		symbols.reserve(4096);
+		bits = 0;
+		start = chrono::steady_clock::now();
+		for (unsigned int i = 0; i < rounds; i++) {
+			SymbolGenerator gen = framer.generateSymbols(0);
+			while (gen.running()) {
+				gen.sourceSymbols(symbols);
+				bits += symbols.size();
+			}
+		}
+		end = chrono::steady_clock::now();
+		double generator_speed = bits / chrono::duration<double>(end - start).count() / 1e6;
+
+		const char* names[] = { "Uncoded", "NRZI", "G3RUH" };
+		cout << left << setw(10) << names[mode] << right << fixed << setprecision(1);
+		cout << setw(12) << packed_speed << setw(12) << generator_speed << endl;
+	}
+
+	return 0;
+}
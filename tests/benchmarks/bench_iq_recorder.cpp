@@ -0,0 +1,61 @@
+/*
+ * Benchmark the IQ recorder from the receiver's point of view.
+ * Feeds 4096 sample buffers paced to the given sample rate (default 10 Msps) for 10 seconds
+ * and reports the time spent inside sinkSamples, the sustained disk rate and the dropped samples.
+ *
+ * Usage: bench_iq_recorder [filename] [CF32|CS16] [sample rate]
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include "suo.hpp"
+#include "signal-io/iq_recorder.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+int main(int argc, char** argv) {
+	IQRecorder::Config conf;
+	conf.filename = (argc > 1) ? argv[1] : "/tmp/bench_iq_recorder";
+	conf.format = (argc > 2) ? argv[2] : "CS16";
+	conf.sample_rate = (argc > 3) ? atof(argv[3]) : 10e6;
+	const double duration = 10.0; // [s]
+	const size_t buffer_len = 4096;
+
+	SampleVector samples(buffer_len);
+	for (size_t i = 0; i < buffer_len; i++)
+		samples[i] = polar(0.5f, 0.01f * i);
+
+	IQRecorder recorder(conf);
+	cout << "Recording to " << conf.filename << " as " << conf.format << (recorder.usingDirectIO() ? " with O_DIRECT" : " without O_DIRECT") << endl;
+
+	vector<double> latencies;
+	const size_t buffers = duration * conf.sample_rate / buffer_len;
+	latencies.reserve(buffers);
+
+	auto start = chrono::steady_clock::now();
+	for (size_t b = 0; b < buffers; b++) {
+		/* Pace like a real receiver */
+		this_thread::sleep_until(start + chrono::nanoseconds((int64_t)(1e9 * b * buffer_len / conf.sample_rate)));
+
+		const Timestamp now = (Timestamp)(1e9 * b * buffer_len / conf.sample_rate);
+		auto t0 = chrono::steady_clock::now();
+		recorder.sinkSamples(samples, now);
+		latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+	}
+	recorder.close();
+	const double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	sort(latencies.begin(), latencies.end());
+	cout << fixed << setprecision(2);
+	cout << "sinkSamples median " << latencies[latencies.size() / 2] << " us, 99.9% "
+		<< latencies[latencies.size() * 999 / 1000] << " us, max " << latencies.back() << " us" << endl;
+	cout << "Written " << recorder.getWrittenBytes() / 1e6 << " MB at " << recorder.getWrittenBytes() / elapsed / 1e6 << " MB/s" << endl;
+	cout << "Recorded " << recorder.getRecordedSamples() << " samples, dropped " << recorder.getDroppedSamples() << endl;
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Benchmark the per-symbol hop between blocks.
+ * Compares runtime wiring (Port::connect_member) to the compile-time pipeline() wiring
+ * on a symbol source -> HDLCDeframer -> frame sink chain and on a trivial symbol counter.
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+#include "suo.hpp"
+#include "pipeline.hpp"
+#include "framing/hdlc_framer.hpp"
+#include "framing/hdlc_deframer.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+/* Replays a precomputed bit stream like a demodulator would */
+struct SymbolSource {
+	Port<Symbol, Timestamp> sinkSymbol;
+
+	void run(const SymbolVector& bits, unsigned int rounds) {
+		Timestamp now = 0;
+		for (unsigned int r = 0; r < rounds; r++)
+			for (Symbol bit: bits)
+				sinkSymbol.emit(bit, now++);
+	}
+};
+
+/* Cheapest possible sink to measure the hop itself */
+class SymbolCounter : public Block {
+public:
+	void sinkSymbol(Symbol bit, Timestamp) { ones += bit; count++; }
+	uint64_t ones = 0, count = 0;
+};
+
+class FrameCounter : public Block {
+public:
+	void sinkFrame(const Frame& frame, Timestamp) { frames++; bytes += frame.data.size(); }
+	uint64_t frames = 0, bytes = 0;
+};
+
+
+template<typename Func>
+static double symbol_rate(size_t symbols, Func func) {
+	auto start = chrono::steady_clock::now();
+	func();
+	auto end = chrono::steady_clock::now();
+	return symbols / chrono::duration<double>(end - start).count() / 1e6;
+}
+
+
+int main()
+{
+	/* Generate a bit stream of HDLC frames */
+	HDLCFramer::Config framer_conf;
+	framer_conf.append_crc = true;
+	HDLCFramer framer(framer_conf);
+
+	SymbolVector bits;
+	for (unsigned int i = 0; i < 64; i++) {
+		Frame frame(128);
+		for (unsigned int j = 0; j < 100; j++)
+			frame.data.push_back(rand() & 0xFF);
+		framer.sourceFrame.connect([&](Frame& f, Timestamp) { f = frame; });
+
+		SymbolVector out;
+		out.reserve(4096);
+		SymbolGenerator gen = framer.generateSymbols(0);
+		while (gen.running()) {
+			gen.sourceSymbols(out);
+			bits.insert(bits.end(), out.begin(), out.end());
+		}
+		framer.sourceFrame.disconnect_all();
+	}
+
+	const unsigned int rounds = 200;
+	const size_t total = bits.size() * rounds;
+
+	cout << "Bit stream: " << bits.size() << " bits, " << rounds << " rounds" << endl;
+	cout << fixed << setprecision(1);
+
+	/* Trivial hop */
+	{
+		SymbolSource source;
+		SymbolCounter counter;
+		source.sinkSymbol.connect_member(&counter, &SymbolCounter::sinkSymbol);
+		double dynamic_rate = symbol_rate(total, [&]() { source.run(bits, rounds); });
+
+		SymbolSource static_source;
+		SymbolCounter static_counter;
+		pipeline(static_source, static_counter);
+		double static_rate = symbol_rate(total, [&]() { static_source.run(bits, rounds); });
+
+		if (counter.ones != static_counter.ones)
+			cerr << "Mismatch!" << endl;
+
+		cout << "Counter sink:       dynamic " << setw(7) << dynamic_rate << " Msym/s   static " << setw(7) << static_rate << " Msym/s  ";
+		cout << "(" << setprecision(2) << static_rate / dynamic_rate << "x)" << setprecision(1) << endl;
+	}
+
+	/* Demodulator -> deframer -> frame sink */
+	{
+		SymbolSource source;
+		HDLCDeframer::Config deframer_conf;
+		deframer_conf.mode = framer_conf.mode;
+		deframer_conf.maximum_frame_length = 256;
+		deframer_conf.minimum_frame_length = 8;
+		HDLCDeframer deframer(deframer_conf);
+		FrameCounter frames;
+		source.sinkSymbol.connect_member(&deframer, &HDLCDeframer::sinkSymbol);
+		deframer.sinkFrame.connect_member(&frames, &FrameCounter::sinkFrame);
+		double dynamic_rate = symbol_rate(total, [&]() { source.run(bits, rounds); });
+
+		SymbolSource static_source;
+		HDLCDeframer static_deframer(deframer_conf);
+		FrameCounter static_frames;
+		pipeline(static_source, static_deframer, static_frames);
+		double static_rate = symbol_rate(total, [&]() { static_source.run(bits, rounds); });
+
+		if (frames.frames != static_frames.frames || frames.bytes != static_frames.bytes)
+			cerr << "Mismatch!" << endl;
+
+		cout << "HDLC deframer:      dynamic " << setw(7) << dynamic_rate << " Msym/s   static " << setw(7) << static_rate << " Msym/s  ";
+		cout << "(" << setprecision(2) << static_rate / dynamic_rate << "x)" << setprecision(1);
+		cout << "  " << static_frames.frames << " frames" << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * Benchmark PSK demodulator throughput for BPSK, QPSK and 8PSK.
+ * The input is random noise at 4 samples per symbol so that the whole chain
+ * (front-end, resampler, AGC, matched filter, symbol sync and Costas loop) is exercised.
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+
+#include "suo.hpp"
+#include "modem/demod_psk.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+
+	const float symbol_rate = 1e6;
+	const size_t block_size = 16384;
+
+	mt19937 rng(1);
+	normal_distribution<float> dist(0.0f, 1.0f);
+	SampleVector samples;
+	samples.reserve(block_size);
+	for (size_t i = 0; i < block_size; i++)
+		samples.push_back(Sample(dist(rng), dist(rng)));
+
+	cout << right << setw(6) << "Bits" << setw(14) << "Msymbols/s" << endl;
+	for (unsigned int bits_per_symbol = 1; bits_per_symbol <= 3; bits_per_symbol++) {
+		PSKDemodulator::Config conf;
+		conf.sample_rate = 4 * symbol_rate;
+		conf.symbol_rate = symbol_rate;
+		conf.center_frequency = 0;
+		conf.bits_per_symbol = bits_per_symbol;
+		conf.samples_per_symbol = 4;
+
+		PSKDemodulator demod(conf);
+		size_t symbols = 0;
+		demod.sinkSymbol.connect([&](Symbol symbol, Timestamp now) {
+			(void)symbol;
+			(void)now;
+			symbols++;
+		});
+
+		const unsigned int rounds = (64 << 20) / block_size;
+		Timestamp now = 0;
+		auto start = chrono::steady_clock::now();
+		for (unsigned int i = 0; i < rounds; i++) {
+			demod.sinkSamples(samples, now);
+			now += (Timestamp)(1e9 * block_size / conf.sample_rate);
+		}
+		auto end = chrono::steady_clock::now();
+
+		double speed = symbols / chrono::duration<double>(end - start).count() / 1e6;
+		cout << setw(6) << bits_per_symbol << fixed << setprecision(2) << setw(14) << speed << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,198 @@
+#include <iostream>
+#include <random>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <suo.hpp>
+#include <coding/convolutional_encoder.hpp>
+#include <framing/utils.hpp>
+
+
+using namespace std;
+using namespace suo;
+
+
+class ConvolutionalTest: public CppUnit::TestFixture
+{
+private:
+
+	/* Bit-by-bit reference encoder */
+	static SymbolVector reference_encode(const ConvolutionalConfig& conf, const SymbolVector& input) {
+		SymbolVector output;
+		uint32_t shift_register = 0;
+		for (size_t n = 0; n < input.size(); n++) {
+			shift_register = (shift_register << 1) | input[n];
+			for (unsigned int j = 0; j < conf.rate; j++) {
+				if (conf.puncturing.empty() == false && conf.puncturing[j][n % conf.puncturing[j].size()] == 0)
+					continue;
+				output.push_back(bit_parity(shift_register & abs(conf.polys[j])) ^ (conf.polys[j] < 0));
+			}
+		}
+		return output;
+	}
+
+public:
+
+	/* Impulse response of the CCSDS r=1/2 k=7 code */
+	void run_impulse_test()
+	{
+		ConvolutionalEncoder encoder(ConvolutionCodes::CCSDS_1_2_7);
+		SymbolVector input(8, 0), output;
+		input[0] = 1;
+		encoder.encode(input, output);
+
+		const SymbolVector expected = {
+			1, 0,  1, 1,  1, 0,  1, 0,  0, 1,  0, 0,  1, 0,  0, 1
+		};
+		CPPUNIT_ASSERT(output == expected);
+	}
+
+	/* Table driven encoder matches the reference for all codes */
+	void run_reference_test()
+	{
+		mt19937 rng(1234);
+		for (const ConvolutionalConfig* conf : {
+				&ConvolutionCodes::AX5043, &ConvolutionCodes::TI_CC11xx,
+				&ConvolutionCodes::CCSDS_1_2_7, &ConvolutionCodes::CCSDS_2_3_7,
+				&ConvolutionCodes::CCSDS_3_4_7, &ConvolutionCodes::CCSDS_4_5_7,
+				&ConvolutionCodes::CCSDS_5_6_7, &ConvolutionCodes::CCSDS_1_3_7 }) {
+
+			SymbolVector input(1000 + rng() % 100);
+			for (Symbol& bit : input)
+				bit = rng() & 1;
+			const SymbolVector expected = reference_encode(*conf, input);
+
+			/* Whole input at once */
+			ConvolutionalEncoder encoder(*conf);
+			SymbolVector output;
+			encoder.encode(input, output);
+			CPPUNIT_ASSERT(output == expected);
+
+			/* Odd sized chunks continue the state */
+			encoder.reset();
+			output.clear();
+			for (size_t i = 0; i < input.size(); ) {
+				const size_t n = min<size_t>(1 + rng() % 20, input.size() - i);
+				encoder.encode(SymbolVector(input.begin() + i, input.begin() + i + n), output);
+				i += n;
+			}
+			CPPUNIT_ASSERT(output == expected);
+
+			/* Packed bytes */
+			ByteVector bytes(input.size() / 8);
+			for (size_t i = 0; i < bytes.size(); i++)
+				for (size_t j = 0; j < 8; j++)
+					bytes[i] = (bytes[i] << 1) | input[8 * i + j];
+			encoder.reset();
+			output.clear();
+			encoder.encode(bytes.data(), bytes.size(), output);
+			CPPUNIT_ASSERT(output == reference_encode(*conf, SymbolVector(input.begin(), input.begin() + 8 * bytes.size())));
+		}
+	}
+
+	/* Sourcing encoded symbols in small blocks */
+	void run_source_test()
+	{
+		SymbolVector input(100);
+		for (size_t i = 0; i < input.size(); i++)
+			input[i] = (i * 7 / 3) & 1;
+		const SymbolVector expected = reference_encode(ConvolutionCodes::CCSDS_3_4_7, input);
+
+		ConvolutionalEncoder encoder(ConvolutionCodes::CCSDS_3_4_7);
+		bool sourced = false;
+		encoder.sourceUncodedSymbols.connect([&](SymbolVector& symbols, Timestamp now) {
+			if (!sourced)
+				symbols.insert(symbols.end(), input.begin(), input.end());
+			sourced = true;
+		});
+
+		SymbolVector output, block;
+		block.reserve(16);
+		do {
+			block.clear();
+			encoder.sourceSymbols(block, 0);
+			output.insert(output.end(), block.begin(), block.end());
+		} while (block.empty() == false);
+
+		CPPUNIT_ASSERT(output == expected);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.75, encoder.real_rate(), 1e-9);
+	}
+
+	/* Tables follow the contents of the configuration, not its address */
+	void run_modified_config_test()
+	{
+		SymbolVector input(8, 0), first, second;
+		input[0] = 1;
+
+		ConvolutionalConfig conf = ConvolutionCodes::CCSDS_1_2_7;
+		{
+			ConvolutionalEncoder encoder(conf);
+			encoder.encode(input, first);
+		}
+
+		conf.polys[0] = -conf.polys[0];
+		ConvolutionalEncoder encoder(conf);
+		encoder.encode(input, second);
+
+		CPPUNIT_ASSERT(second == reference_encode(conf, input));
+		unsigned int differing = 0;
+		for (size_t i = 0; i < first.size(); i++)
+			differing += (first[i] != second[i]);
+		CPPUNIT_ASSERT_EQUAL(8u, differing);
+	}
+
+	/* The encoder keeps its own copy of the configuration */
+	void run_config_lifetime_test()
+	{
+		SymbolVector input(64), output;
+		for (size_t i = 0; i < input.size(); i++)
+			input[i] = (i * 7 + 3) % 5 < 2;
+
+		auto conf = std::make_unique<ConvolutionalConfig>(ConvolutionCodes::CCSDS_3_4_7);
+		const SymbolVector expected = reference_encode(*conf, input);
+		ConvolutionalEncoder encoder(*conf);
+		conf.reset();
+
+		encoder.encode(input, output);
+		CPPUNIT_ASSERT(output == expected);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.75, encoder.real_rate(), 1e-9);
+	}
+
+	void run_invalid_test()
+	{
+		ConvolutionalConfig conf = ConvolutionCodes::CCSDS_2_3_7;
+		conf.puncturing[1].push_back(1);
+		CPPUNIT_ASSERT_THROW(conf.validate(), SuoError);
+
+		conf = ConvolutionCodes::CCSDS_1_2_7;
+		conf.k = 5;
+		CPPUNIT_ASSERT_THROW(conf.validate(), SuoError);
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("ConvolutionalTest");
+		suite->addTest(new CppUnit::TestCaller<ConvolutionalTest>("Impulse response", &ConvolutionalTest::run_impulse_test));
+		suite->addTest(new CppUnit::TestCaller<ConvolutionalTest>("Reference encoder", &ConvolutionalTest::run_reference_test));
+		suite->addTest(new CppUnit::TestCaller<ConvolutionalTest>("Source symbols", &ConvolutionalTest::run_source_test));
+		suite->addTest(new CppUnit::TestCaller<ConvolutionalTest>("Modified config", &ConvolutionalTest::run_modified_config_test));
+		suite->addTest(new CppUnit::TestCaller<ConvolutionalTest>("Config lifetime", &ConvolutionalTest::run_config_lifetime_test));
+		suite->addTest(new CppUnit::TestCaller<ConvolutionalTest>("Invalid config", &ConvolutionalTest::run_invalid_test));
+		return suite;
+	}
+
+};
+
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(ConvolutionalTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
@@ -75,6 +75,91 @@ public:
 		CPPUNIT_ASSERT_EQUAL(0x765E7680U, crc_posix.calculate(data));
 	}
 
+	void run_compile_time_test()
+	{
+		/* Tables of the predefined algorithms are constant expressions */
+		static_assert(CRC16::preset_tables<CRCAlgorithms::CRC16_X25>.slices[0][1] == 0x1189);
+		static_assert(CRC32::preset_tables<CRCAlgorithms::CRC32>.slices[0][1] == 0x77073096);
+		static_assert(CRC16::findPresetTables(CRCAlgorithms::CRC16_HDLC) == &CRC16::preset_tables<CRCAlgorithms::CRC16_X25>);
+
+		ByteVector data = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+		CPPUNIT_ASSERT_EQUAL((uint16_t)0x906E, CRCDigest<CRCAlgorithms::CRC16_X25>::calculate(data));
+		CPPUNIT_ASSERT_EQUAL(0xCBF43926U, CRCDigest<CRCAlgorithms::CRC32>::calculate(data));
+		CPPUNIT_ASSERT_EQUAL(0xC25A56U, CRCDigest<CRCAlgorithms::CRC24_BLE>::calculate(data));
+		CPPUNIT_ASSERT_EQUAL((uint8_t)0xF4, CRCDigest<CRCAlgorithms::CRC8>::calculate(data));
+
+		/* Digest updated in pieces */
+		CRCDigest<CRCAlgorithms::CRC16_CCITT_FALSE> digest;
+		digest.update(&data[0], 4);
+		digest.update(&data[4], 5);
+		CPPUNIT_ASSERT_EQUAL((uint16_t)0x29B1, digest.finalize());
+
+		/* Custom algorithm uses the runtime generated tables */
+		const CRCAlgorithm crc32c = { 32, 0x1EDC6F41, 0xFFFFFFFF, true, true, 0xFFFFFFFF };
+		CPPUNIT_ASSERT(CRC32::findPresetTables(crc32c) == nullptr);
+		CPPUNIT_ASSERT_EQUAL(0xE3069283U, CRC32(crc32c).calculate(data));
+	}
+
+	/* Bit-by-bit reference implementation */
+	static uint32_t reference_crc(const CRCAlgorithm& algo, const ByteVector& data)
+	{
+		const uint64_t top = 1ULL << (algo.width - 1);
+		const uint64_t mask = (top << 1) - 1;
+		uint64_t reg = algo.init;
+		for (Byte byte : data) {
+			if (algo.refIn)
+				byte = reverse_bits((uint8_t)byte);
+			for (int i = 7; i >= 0; i--) {
+				bool bit = ((byte >> i) & 1) ^ ((reg & top) != 0);
+				reg = (reg << 1) & mask;
+				if (bit)
+					reg ^= algo.poly;
+			}
+		}
+		if (algo.refOut)
+			reg = reverse_bits((uint32_t)reg) >> (32 - algo.width);
+		return (reg ^ algo.xorOut) & mask;
+	}
+
+	template<typename CRCType>
+	void check_long_buffers(const CRCAlgorithm& algo)
+	{
+		CRCType crc(algo);
+		for (size_t len = 0; len < 1200; len += 1 + len / 8) {
+			ByteVector data(len);
+			for (size_t i = 0; i < len; i++)
+				data[i] = rand() % 256;
+			const uint32_t expected = reference_crc(algo, data);
+
+			/* Slicing-by-8 tables */
+			crc_use_pclmul = false;
+			CPPUNIT_ASSERT_EQUAL(expected, (uint32_t)crc.calculate(data));
+
+			/* Carry-less multiplication folding (if available) */
+			crc_use_pclmul = crc_pclmul_available();
+			CPPUNIT_ASSERT_EQUAL(expected, (uint32_t)crc.calculate(data));
+
+			/* Split updates */
+			const size_t split = len / 3;
+			auto value = crc.update(crc.init(), &data[0], split);
+			value = crc.update(value, &data[split], len - split);
+			CPPUNIT_ASSERT_EQUAL(expected, (uint32_t)crc.finalize(value));
+		}
+	}
+
+	void run_long_buffer_test()
+	{
+		for (const auto& [name, algo] : CRCAlgorithms::algorithms) {
+			switch (algo.width) {
+			case 8: check_long_buffers<CRC8>(algo); break;
+			case 16: check_long_buffers<CRC16>(algo); break;
+			case 24: check_long_buffers<CRC24>(algo); break;
+			case 32: check_long_buffers<CRC32>(algo); break;
+			default: CPPUNIT_FAIL("Unexpected CRC width");
+			}
+		}
+	}
+
 	static CppUnit::Test* suite()
 	{
 		CppUnit::TestSuite* suite = new CppUnit::TestSuite("CRCTest");
@@ -82,6 +167,8 @@ public:
 		//suite->addTest(new CppUnit::TestCaller<CRCTest>("CRC-8", &CRCTest::run_crc8_test));
 		suite->addTest(new CppUnit::TestCaller<CRCTest>("CRC-16", &CRCTest::run_crc16_test));
 		suite->addTest(new CppUnit::TestCaller<CRCTest>("CRC-32", &CRCTest::run_crc32_test));
+		suite->addTest(new CppUnit::TestCaller<CRCTest>("Compile-time tables", &CRCTest::run_compile_time_test));
+		suite->addTest(new CppUnit::TestCaller<CRCTest>("Long buffers", &CRCTest::run_long_buffer_test));
 		return suite;
 	}
 	
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <bit> // popcount
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <suo.hpp>
+#include <coding/golay24.hpp>
+
+
+using namespace std;
+using namespace suo;
+
+
+class Golay24Test: public CppUnit::TestFixture
+{
+private:
+
+	void check_pattern(uint32_t correct, uint32_t errors, bool correctable)
+	{
+		uint32_t data = correct;
+		CPPUNIT_ASSERT_EQUAL(0, encode_golay24(&data));
+		data ^= errors;
+		if (correctable) {
+			CPPUNIT_ASSERT_EQUAL(std::popcount(errors), decode_golay24(&data));
+			CPPUNIT_ASSERT_EQUAL(correct, data & 0xFFF);
+		}
+		else {
+			CPPUNIT_ASSERT(decode_golay24(&data) < 0);
+		}
+	}
+
+public:
+
+	/* All weight 1-3 error patterns are corrected and weight 4 patterns detected */
+	void run_hard_decoding_test()
+	{
+		for (uint32_t i = 0; i < 24; i++) {
+			check_pattern(0xA5C, 1 << i, true);
+			for (uint32_t j = i + 1; j < 24; j++) {
+				check_pattern(0x3E1, (1 << i) | (1 << j), true);
+				for (uint32_t k = j + 1; k < 24; k++) {
+					check_pattern(0x7B2, (1 << i) | (1 << j) | (1 << k), true);
+					if (k + 1 < 24)
+						check_pattern(0x7B2, (1 << i) | (1 << j) | (1 << k) | (1 << (k + 1)), false);
+				}
+			}
+		}
+	}
+
+	/* 5 hard errors on unreliable bits are beyond the hard decoder but not the Chase decoder */
+	void run_soft_decoding_test()
+	{
+		uint32_t codeword = 0x5A5;
+		encode_golay24(&codeword);
+		const uint32_t soft_errors = 0x810411;
+		float llr[24];
+		for (int i = 0; i < 24; i++) {
+			const uint32_t mask = 1 << (23 - i);
+			const float reliability = (soft_errors & mask) ? 0.2f : 1.0f;
+			llr[i] = ((codeword ^ soft_errors) & mask) ? reliability : -reliability;
+		}
+
+		uint32_t hard = codeword ^ soft_errors;
+		CPPUNIT_ASSERT(decode_golay24(&hard) < 0 || hard != codeword);
+
+		uint32_t soft = 0;
+		CPPUNIT_ASSERT_EQUAL(5, decode_golay24_soft(llr, &soft));
+		CPPUNIT_ASSERT_EQUAL(codeword, soft);
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("Golay24Test");
+		suite->addTest(new CppUnit::TestCaller<Golay24Test>("Hard decoding", &Golay24Test::run_hard_decoding_test));
+		suite->addTest(new CppUnit::TestCaller<Golay24Test>("Soft decoding", &Golay24Test::run_soft_decoding_test));
+		return suite;
+	}
+
+};
+
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(Golay24Test::suite());
+	runner.run();
+	return 0;
+}
+#endif
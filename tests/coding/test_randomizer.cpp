@@ -0,0 +1,115 @@
+#include <iostream>
+#include <random>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <suo.hpp>
+#include <coding/randomizer.hpp>
+
+
+using namespace std;
+using namespace suo;
+
+
+class RandomizerTest: public CppUnit::TestFixture
+{
+public:
+
+	/* Generated sequences match the predefined tables */
+	void run_sequence_test()
+	{
+		Randomizer tm(RandomizerAlgorithms::CCSDS_TM);
+		CPPUNIT_ASSERT_EQUAL((size_t)255, tm.period());
+		for (size_t i = 0; i < ccsds_randomizer_len; i++)
+			CPPUNIT_ASSERT_EQUAL(ccsds_tm_randomizer[i], tm.byte(i));
+
+		Randomizer pn9(RandomizerAlgorithms::PN9);
+		CPPUNIT_ASSERT_EQUAL((size_t)511, pn9.period());
+		for (size_t i = 0; i < pn9_randomizer_len; i++)
+			CPPUNIT_ASSERT_EQUAL(pn9_randomizer[i], pn9.byte(i));
+
+		/* CCSDS 231.0-B: 1111 1111 0011 1001 1001 1110 0101 1010 0110 1000 */
+		Randomizer tc(RandomizerAlgorithms::CCSDS_TC);
+		CPPUNIT_ASSERT_EQUAL((uint8_t)0xFF, tc.byte(0));
+		CPPUNIT_ASSERT_EQUAL((uint8_t)0x39, tc.byte(1));
+		CPPUNIT_ASSERT_EQUAL((uint8_t)0x9E, tc.byte(2));
+		CPPUNIT_ASSERT_EQUAL((uint8_t)0x5A, tc.byte(3));
+		CPPUNIT_ASSERT_EQUAL((uint8_t)0x68, tc.byte(4));
+	}
+
+	/* In place XOR of long buffers from any offset */
+	void run_apply_test()
+	{
+		mt19937 rng(1234);
+		Randomizer randomizer(RandomizerAlgorithms::PN9);
+		const ByteVector reference = Randomizer::generate(RandomizerAlgorithms::PN9, 4000);
+
+		for (size_t offset : { 0, 1, 7, 510, 511, 1000 }) {
+			for (size_t len : { 0, 1, 9, 100, 511, 3000 }) {
+				ByteVector data(len);
+				for (Byte& b : data)
+					b = rng();
+				ByteVector original = data;
+
+				randomizer.apply(data, offset);
+				for (size_t i = 0; i < len; i++)
+					CPPUNIT_ASSERT_EQUAL((uint8_t)(original[i] ^ reference[offset + i]), data[i]);
+
+				randomizer.apply(data, offset);
+				CPPUNIT_ASSERT(data == original);
+			}
+		}
+	}
+
+	/* Bit and byte serial streams give the same sequence */
+	void run_stream_test()
+	{
+		for (const RandomizerAlgorithm* algo : { &RandomizerAlgorithms::CCSDS_TM, &RandomizerAlgorithms::PN9 }) {
+			Randomizer randomizer(*algo);
+			Randomizer::Stream bytes = randomizer.stream();
+			Randomizer::Stream bits = randomizer.stream();
+			for (size_t i = 0; i < 600; i++) {
+				const uint8_t seq = bytes.next(0);
+				CPPUNIT_ASSERT_EQUAL(randomizer.byte(i), seq);
+				for (unsigned int j = 0; j < 8; j++) {
+					const unsigned int shift = algo->msb_first ? (7 - j) : j;
+					CPPUNIT_ASSERT_EQUAL((Symbol)((seq >> shift) & 1), bits.nextBit(0));
+				}
+			}
+		}
+	}
+
+	void run_invalid_test()
+	{
+		RandomizerAlgorithm algo = RandomizerAlgorithms::CCSDS_TM;
+		algo.init = 0;
+		CPPUNIT_ASSERT_THROW(Randomizer randomizer(algo), SuoError);
+		algo.init = 0x1FF;
+		CPPUNIT_ASSERT_THROW(Randomizer randomizer(algo), SuoError);
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("RandomizerTest");
+		suite->addTest(new CppUnit::TestCaller<RandomizerTest>("Sequences", &RandomizerTest::run_sequence_test));
+		suite->addTest(new CppUnit::TestCaller<RandomizerTest>("Apply", &RandomizerTest::run_apply_test));
+		suite->addTest(new CppUnit::TestCaller<RandomizerTest>("Stream", &RandomizerTest::run_stream_test));
+		suite->addTest(new CppUnit::TestCaller<RandomizerTest>("Invalid", &RandomizerTest::run_invalid_test));
+		return suite;
+	}
+
+};
+
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(RandomizerTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
@@ -12,10 +12,9 @@ using namespace std;
 using namespace suo;
 
 
-void bpsk_golay_test() {
+void bpsk_golay_batch(float SNRdB, unsigned int frames, CounterRNG& rng, Stats& stats) {
 
-	srand(time(nullptr));
-	Timestamp now = time(nullptr) % 0xFFFFFF;
+	Timestamp now = 10000;
 
 	SampleVector samples;
 	samples.reserve(80000);
@@ -34,6 +33,7 @@ void bpsk_golay_test() {
 
 	GolayFramer framer(framer_conf);
 	RandomFrameGenerator frame_gen(64);
+	frame_gen.set_seed(rng.next());
 	framer.sourceFrame.connect_member(&frame_gen, &RandomFrameGenerator::source_frame);
 
 
@@ -44,6 +44,7 @@ void bpsk_golay_test() {
 	mod_conf.center_frequency = 10e3;
 	mod_conf.ramp_up_duration = 3;
 	mod_conf.ramp_down_duration = 3;
+	mod_conf.differential = true;
 
 	PSKModulator mod(mod_conf);
 	mod.generateSymbols.connect_member(&framer, &GolayFramer::generateSymbols);
@@ -59,10 +60,10 @@ void bpsk_golay_test() {
 
 	GolayDeframer deframer(deframer_conf);
 	Frame received_frame;
-	deframer.sinkFrame.connect([&](Frame& frame, Timestamp now) {
+	deframer.sinkFrame.connect([&](const Frame& frame, Timestamp now) {
 		(void)now;
 		received_frame = frame;
-    });
+	});
 
 	/* Construct demodulator */
 	PSKDemodulator::Config demod_conf;
@@ -70,78 +71,62 @@ void bpsk_golay_test() {
 	demod_conf.symbol_rate = mod_conf.symbol_rate + symbol_rate_offset;
 	demod_conf.center_frequency = mod_conf.center_frequency + frequency_offset;
 	demod_conf.samples_per_symbol = 8;
+	demod_conf.differential = mod_conf.differential;
 
 	PSKDemodulator demod(demod_conf);
 	demod.sinkSymbol.connect_member(&deframer, &GolayDeframer::sinkSymbol);
 	deframer.syncDetected.connect_member(&demod, &PSKDemodulator::lockReceiver);
 
 
-
-	float             SNRdB_min = 0.0f;   // signal-to-noise ratio (minimum)
-	float             SNRdB_max = 20.0f;  // signal-to-noise ratio (maximum)
-	unsigned int      num_snr = 21;     // number of SNR steps
-	unsigned int      num_packet_trials = 800;    // number of trials
-
 	float signal_bandwidth = mod_conf.sample_rate;
-	float SNRdB_step = (SNRdB_max - SNRdB_min) / (num_snr - 1);
-
+	float noise_std = powf(10.0f, -SNRdB / 20.0f); // noise standard deviation
+	noise_std /= (signal_bandwidth / mod_conf.sample_rate);
 
 	SampleGenerator sample_gen;
-	EbN0Log log("gmsk_cont_golay");
-
-
-	for (unsigned int s = 0; s < num_snr; s++) {
-
 
-		Timestamp time = 10000;
+	for (unsigned int f = 0; f < frames; f++) {
 
-		float SNRdB = SNRdB_min + s * SNRdB_step; // SNR in dB for this round
-		float noise_std = powf(10.0f, -SNRdB / 20.0f); // noise standard deviation
-		noise_std /= (signal_bandwidth / mod_conf.sample_rate);
+		// Feed some noise to demodulator
+		generate_noise(samples, noise_std, int(0.5 * mod_conf.sample_rate) + rng.next() % 1000, rng);
+		demod.sinkSamples(samples, now);
 
-		Stats stats;
+		// Modulate the signal
+		samples.clear();
+		sample_gen = mod.generateSamples(now);
+		sample_gen.sourceSamples(samples);
 
-		while (stats.total_bit_errors < 50000) {
+		received_frame.clear();
 
-			// Feed some noise to demodulator
-			generate_noise(samples, noise_std, int(0.5 * mod_conf.sample_rate) + rand() % 1000);
-			demod.sinkSamples(samples, time);
+		// Demodulate the signal
+		add_noise(samples, noise_std, rng);
+		delay_signal(rng.uniform(), samples);
+		demod.sinkSamples(samples, now);
 
-			// Modulate the signal
-			samples.clear();
-			sample_gen = mod.generateSamples(now);
-			sample_gen.sourceSamples(samples);
-
-			received_frame.clear();
-
-			// Demodulate the signal
-			add_noise(samples, noise_std);
-			delay_signal(randuf(0.0f, 1.0f), samples);
-			demod.sinkSamples(samples, time);
+		// Feed more noise to demodulator
+		generate_noise(samples, noise_std, 2000, rng);
+		demod.sinkSamples(samples, now);
 
+		// Assert the transmit and received frames
+		if (received_frame.empty() == false)
+			count_bit_errors(stats, frame_gen.latest_frame(), received_frame);
+		else
+			count_lost_frame(stats, frame_gen.latest_frame());
+	}
 
-			// Feed more noise to demodulator
-			generate_noise(samples, noise_std, 2000);
-			demod.sinkSamples(samples, now);
+}
 
-			// Assert the transmit and received frames
-			if (received_frame.empty() == false) {
-				count_bit_errors(stats, frame_gen.latest_frame(), received_frame);
-			}
-			else {
-				stats.total_bit_errors += 8 * frame_gen.latest_frame().size();
-				stats.total_bits += 8 * frame_gen.latest_frame().size();
-			}
 
-			//cout << stats.total_bit_errors << " " << stats.total_bits << endl;
-		}
+void bpsk_golay_test() {
 
-		cout << endl;
-		cout << "             SNR: " << SNRdB << " dB" << endl;
-		cout << stats;
+	EbN0Sweep::Config sweep_conf;
+	sweep_conf.snr_min = 0.0f;
+	sweep_conf.snr_max = 20.0f;
+	sweep_conf.num_snr = 21;
+	sweep_conf.target_frame_errors = 200;
 
-		log.push_results(SNRdB, stats);
-	}
+	EbN0Sweep sweep(sweep_conf);
+	EbN0Log log("bpsk_golay");
+	sweep.run(&bpsk_golay_batch, log);
 
 }
 
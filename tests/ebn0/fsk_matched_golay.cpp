@@ -15,19 +15,14 @@ using namespace suo;
 #define MAX_SAMPLES 200000
 
 
-void fsk_matched_golay_test()
-{		
-	const float frequency_offset = 0.f;
-
-	srand(time(nullptr));
-	Timestamp now = rand() & 0xFFFFFF;
+void fsk_matched_golay_batch(float SNRdB, unsigned int frames, CounterRNG& rng, Stats& stats) {
 
+	const float frequency_offset = 0.f;
+	Timestamp now = 10000;
 
-	Stats stats;
 	SampleVector samples;
-	Frame transmit_frame;
+	samples.reserve(MAX_SAMPLES);
 	Frame received_frame;
-	samples.resize(MAX_SAMPLES);
 
 	/* Contruct framer */
 	GolayFramer::Config framer_conf;
@@ -40,6 +35,7 @@ void fsk_matched_golay_test()
 
 	GolayFramer framer(framer_conf);
 	RandomFrameGenerator frame_gen(64);
+	frame_gen.set_seed(rng.next());
 	framer.sourceFrame.connect_member(&frame_gen, &RandomFrameGenerator::source_frame);
 
 	/* Contruct modulator */
@@ -66,7 +62,7 @@ void fsk_matched_golay_test()
 	deframer_conf.use_rs = framer_conf.use_rs;
 
 	GolayDeframer deframer(deframer_conf);
-	deframer.sinkFrame.connect([&](Frame& frame, Timestamp now) {
+	deframer.sinkFrame.connect([&](const Frame& frame, Timestamp now) {
 		(void)now;
 		received_frame = frame;
 	});
@@ -83,64 +79,59 @@ void fsk_matched_golay_test()
 	demod.sinkSymbol.connect_member(&deframer, &GolayDeframer::sinkSymbol);
 	deframer.syncDetected.connect_member(&demod, &FSKMatchedFilterDemodulator::lockReceiver);
 
-
-	float             SNRdB_min         = 0.0f;   // signal-to-noise ratio (minimum)
-	float             SNRdB_max         = 20.0f;  // signal-to-noise ratio (maximum)
-	unsigned int      num_snr           = 21;     // number of SNR steps
-	unsigned int      num_packet_trials = 800;    // number of trials
-
 	float signal_bandwidth = mod_conf.sample_rate;
-	float SNRdB_step = (SNRdB_max - SNRdB_min) / (num_snr - 1);
-
+	float noise_std = powf(10.0f, -SNRdB / 20.0f); // noise standard deviation
+	noise_std /= (signal_bandwidth / mod_conf.sample_rate);
 
 	SampleGenerator sample_gen;
-	EbN0Log log("gmsk_cont_golay");
-
 
-	for (unsigned int s = 0; s < num_snr; s++) {
+	for (unsigned int f = 0; f < frames; f++) {
 
+		// Feed some noise to demodulator
+		generate_noise(samples, noise_std, int(0.5 * mod_conf.sample_rate) + rng.next() % 1000, rng);
+		demod.sinkSamples(samples, now);
 
-		Timestamp time = 10000;
+		// Modulate the signal
+		samples.clear();
+		sample_gen = mod.generateSamples(now);
+		sample_gen.sourceSamples(samples);
 
-		float SNRdB = SNRdB_min + s * SNRdB_step; // SNR in dB for this round
-		float noise_std = powf(10.0f, -SNRdB / 20.0f); // noise standard deviation
-		noise_std /= (signal_bandwidth / mod_conf.sample_rate);
+		received_frame.clear();
 
-		Stats stats;
+		// Add imparities (noise and fractional delay)
+		add_noise(samples, noise_std, rng);
+		delay_signal(rng.uniform(), samples);
+		demod.sinkSamples(samples, now);
 
-		while (stats.total_bit_errors < 50000) {
+		// Feed more noise to demodulator
+		generate_noise(samples, noise_std, 2000, rng);
+		demod.sinkSamples(samples, now);
 
-			// Feed some noise to demodulator
-			generate_noise(samples, noise_std, int(0.5 * mod_conf.sample_rate) + rand() % 1000);
-			demod.sinkSamples(samples, time);
-
-			// Modulate the signal
-			samples.clear();
-
-			mod.sourceSamples(samples, now);
+		// Assert the transmit and received frames
+		if (received_frame.empty() == false)
+			count_bit_errors(stats, frame_gen.latest_frame(), received_frame);
+		else
+			count_lost_frame(stats, frame_gen.latest_frame());
+	}
 
-			// Add imparities (noise and fractional delay)
-			add_noise(samples, noise_std);
-			delay_signal(randuf(0.0f, 1.0f), samples);
-			demod.sinkSamples(samples, now);
+}
 
-			// Feed more noise to demodulator
-			generate_noise(samples, noise_std, 100 + rand() % 1000);
-			demod.sinkSamples(samples, now);
 
-		}
+void fsk_matched_golay_test() {
 
-		cout << endl;
-		cout << "             SNR: " << SNRdB << " dB" << endl;
-		cout << stats;
+	EbN0Sweep::Config sweep_conf;
+	sweep_conf.snr_min = 0.0f;
+	sweep_conf.snr_max = 20.0f;
+	sweep_conf.num_snr = 21;
+	sweep_conf.target_frame_errors = 200;
 
-		log.push_results(SNRdB, stats);
-	}
+	EbN0Sweep sweep(sweep_conf);
+	EbN0Log log("fsk_matched_golay");
+	sweep.run(&fsk_matched_golay_batch, log);
 
 }
 
 
-
 #ifndef COMBINED_EBNO_TEST
 int main(int argc, char** argv)
 {
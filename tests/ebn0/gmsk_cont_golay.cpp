@@ -12,10 +12,9 @@ using namespace std;
 using namespace suo;
 
 
-void gmsk_cont_golay_test() {
+void gmsk_cont_golay_batch(float SNRdB, unsigned int frames, CounterRNG& rng, Stats& stats) {
 
-	srand(time(nullptr));
-	Timestamp now = time(nullptr) % 0xFFFFFF;
+	Timestamp now = 10000;
 
 	SampleVector samples;
 	samples.reserve(80000);
@@ -35,6 +34,7 @@ void gmsk_cont_golay_test() {
 	GolayFramer framer(framer_conf);
 
 	RandomFrameGenerator frame_gen(64);
+	frame_gen.set_seed(rng.next());
 	framer.sourceFrame.connect_member(&frame_gen, &RandomFrameGenerator::source_frame);
 
 
@@ -61,7 +61,7 @@ void gmsk_cont_golay_test() {
 
 	GolayDeframer deframer(deframer_conf);
 	Frame received_frame;
-	deframer.sinkFrame.connect([&](Frame& frame, Timestamp now) { 
+	deframer.sinkFrame.connect([&](const Frame& frame, Timestamp now) { 
 		(void)now;
 		received_frame = frame;
 		//cout << received_frame(Frame::PrintData | Frame::PrintMetadata | Frame::PrintColored);
@@ -92,69 +92,55 @@ void gmsk_cont_golay_test() {
 	deframer.syncDetected.connect_member(&demod, &GMSKDemodulator::lockReceiver);
 #endif
 
-
-	float             SNRdB_min         = 0.0f;   // signal-to-noise ratio (minimum)
-	float             SNRdB_max         = 20.0f;  // signal-to-noise ratio (maximum)
-	unsigned int      num_snr           = 21;     // number of SNR steps
-	unsigned int      num_packet_trials = 800;    // number of trials
-
 	float signal_bandwidth = mod_conf.sample_rate;
-	float SNRdB_step = (SNRdB_max - SNRdB_min) / (num_snr - 1);
+	float noise_std = powf(10.0f, -SNRdB / 20.0f); // noise standard deviation
+	noise_std /= (signal_bandwidth / mod_conf.sample_rate);
 
 	SampleGenerator sample_gen;
-	EbN0Log log("gmsk_cont_golay");
-
-
-	for (unsigned int s = 0; s < num_snr; s++) {
 
-		Timestamp time = 10000;
+	for (unsigned int f = 0; f < frames; f++) {
 
-		float SNRdB = SNRdB_min + s * SNRdB_step; // SNR in dB for this round
-		float noise_std = powf(10.0f, -SNRdB/20.0f); // noise standard deviation
-		noise_std /= (signal_bandwidth / mod_conf.sample_rate);
+		// Feed some noise to demodulator
+		generate_noise(samples, noise_std, int(0.5 * mod_conf.sample_rate) + rng.next() % 1000, rng);
+		demod.sinkSamples(samples, now);
 
-		Stats stats;
+		// Modulate the signal
+		samples.clear();
+		sample_gen = mod.generateSamples(now);
+		sample_gen.sourceSamples(samples);
 
-		while (stats.total_bit_errors < 50000) {
+		received_frame.clear();
 
-			// Feed some noise to demodulator
-			generate_noise(samples, noise_std, int(0.5 * mod_conf.sample_rate) + rand() % 1000);
-			demod.sinkSamples(samples, time);
+		// Add imparities (noise and fractional delay)
+		add_noise(samples, noise_std, rng);
+		delay_signal(rng.uniform(), samples);
+		demod.sinkSamples(samples, now);
 
-			// Modulate the signal
-			samples.clear();
-			sample_gen = mod.generateSamples(now);
-			sample_gen.sourceSamples(samples);
+		// Feed more noise to demodulator
+		generate_noise(samples, noise_std, 2000, rng);
+		demod.sinkSamples(samples, now);
 
-			received_frame.clear();
-
-			// Demodulate the signal
-			add_noise(samples, noise_std);
-			delay_signal(randuf(0.0f, 1.0f), samples);
-			demod.sinkSamples(samples, time);
+		// Assert the transmit and received frames
+		if (received_frame.empty() == false)
+			count_bit_errors(stats, frame_gen.latest_frame(), received_frame);
+		else
+			count_lost_frame(stats, frame_gen.latest_frame());
+	}
 
-			// Feed more noise to demodulator
-			generate_noise(samples, noise_std, 2000);
-			demod.sinkSamples(samples, now);
+}
 
-			// Assert the transmit and received frames
-			if (received_frame.empty() == false) {
-				count_bit_errors(stats, frame_gen.latest_frame(), received_frame);
-			}
-			else {
-				stats.total_bit_errors += 8 * frame_gen.latest_frame().size();
-				stats.total_bits += 8 * frame_gen.latest_frame().size();
-			}
 
-			//cout << stats.total_bit_errors << " " << stats.total_bits << endl;
-		}
+void gmsk_cont_golay_test() {
 
-		cout << endl;
-		cout << "             SNR: " << SNRdB << " dB" << endl;
-		cout << stats;
+	EbN0Sweep::Config sweep_conf;
+	sweep_conf.snr_min = 0.0f;
+	sweep_conf.snr_max = 20.0f;
+	sweep_conf.num_snr = 21;
+	sweep_conf.target_frame_errors = 200;
 
-		log.push_results(SNRdB, stats);
-	}
+	EbN0Sweep sweep(sweep_conf);
+	EbN0Log log("gmsk_cont_golay");
+	sweep.run(&gmsk_cont_golay_batch, log);
 
 }
 
@@ -58,6 +58,7 @@ public:
 		mod_conf.center_frequency = 0e3;
 		mod_conf.ramp_up_duration = 3;
 		mod_conf.ramp_down_duration = 3;
+		mod_conf.differential = true;
 
 		PSKModulator mod(mod_conf);
 		mod.generateSymbols.connect_member(&framer, &GolayFramer::generateSymbols);
@@ -93,6 +94,7 @@ public:
 		demod_conf.symbol_rate = mod_conf.symbol_rate;
 		demod_conf.center_frequency = mod_conf.center_frequency + frequency_offset;
 		demod_conf.samples_per_symbol = 8;
+		demod_conf.differential = mod_conf.differential;
 
 		PSKDemodulator demod(demod_conf);
 		demod.sinkSymbol.connect_member(&deframer, &GolayDeframer::sinkSymbol);
@@ -0,0 +1,176 @@
+#include <iostream>
+#include <cmath>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+
+#include "suo.hpp"
+#include "generators.hpp"
+#include "signal-io/channel_emulator.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class ChannelEmulatorTest : public CppUnit::TestFixture
+{
+private:
+
+	/* Run the emulator and collect all the output */
+	SampleVector run(ChannelEmulator& emulator, unsigned int buffers) {
+		SampleVector received;
+		int id = emulator.sinkSamples.connect([&](const SampleVector& samples, Timestamp now) {
+			CPPUNIT_ASSERT_EQUAL(samples.timestamp, now);
+			received.insert(received.end(), samples.begin(), samples.end());
+		});
+		for (unsigned int i = 0; i < buffers; i++)
+			emulator.step();
+		emulator.sinkSamples.disconnect(id);
+		return received;
+	}
+
+public:
+
+	void testNoise()
+	{
+		ChannelEmulator::Config conf;
+		conf.sample_rate = 100e3;
+		conf.snr = 10.0f;
+		ChannelEmulator emulator(conf);
+
+		SampleVector received = run(emulator, 100);
+		CPPUNIT_ASSERT_EQUAL((size_t)100 * conf.buffer_len, received.size());
+		CPPUNIT_ASSERT_EQUAL((uint64_t)received.size(), emulator.getSampleCount());
+		CPPUNIT_ASSERT_EQUAL((uint64_t)0, emulator.getBurstCount());
+		CPPUNIT_ASSERT_EQUAL((Timestamp)(1e9 * received.size() / conf.sample_rate), emulator.getTime());
+
+		double power = 0;
+		for (const Sample& s: received)
+			power += norm(s);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.1, power / received.size(), 0.002);
+
+		/* Same seed gives the same stream after reset */
+		emulator.reset();
+		SampleVector again = run(emulator, 100);
+		CPPUNIT_ASSERT(again == received);
+	}
+
+	void testBursts()
+	{
+		ChannelEmulator::Config conf;
+		conf.sample_rate = 100e3;
+		conf.buffer_len = 1000;
+		conf.snr = INFINITY;
+		conf.burst_gap = 0.01f;
+		ChannelEmulator emulator(conf);
+
+		/* 1500 samples long bursts of constant signal */
+		SampleVector burst(1500, 1.0f);
+		emulator.generateSamples.connect([&](Timestamp now) {
+			(void)now;
+			return generator_from_vector(burst);
+		});
+
+		SampleVector received = run(emulator, 250); // 2.5 seconds
+
+		/* Count the bursts and check their lengths from the signal */
+		unsigned int bursts = 0, len = 0;
+		for (size_t i = 0; i < received.size(); i++) {
+			if (abs(received[i]) > 0.5f) {
+				len++;
+			}
+			else if (len > 0) {
+				CPPUNIT_ASSERT(abs((int)len - 1500) <= 2);
+				bursts++;
+				len = 0;
+			}
+		}
+
+		// Burst starts at buffer boundary after 15 ms burst + 10 ms gap
+		const unsigned int expected = 250 / 3;
+		CPPUNIT_ASSERT(abs((int)bursts - (int)expected) <= 1);
+		CPPUNIT_ASSERT(abs((int)emulator.getBurstCount() - (int)expected) <= 1);
+	}
+
+	void testFrequencyOffset()
+	{
+		ChannelEmulator::Config conf;
+		conf.sample_rate = 100e3;
+		conf.snr = INFINITY;
+		conf.frequency_offset = 1000.0f;
+		conf.doppler_rate = -500.0f; // Hz/s
+		conf.max_frequency_offset = 1000.0f;
+		ChannelEmulator emulator(conf);
+
+		SampleVector burst(1000000, 1.0f);
+		emulator.generateSamples.connect([&](Timestamp now) {
+			(void)now;
+			return generator_from_vector(burst);
+		});
+
+		SampleVector received = run(emulator, 200);
+
+		/* Instantaneous frequency follows the ramp. First samples are the interpolator's delay. */
+		for (size_t i = 3; i < received.size(); i += 997) {
+			const float frequency = arg(received[i] * conj(received[i - 1])) * conf.sample_rate / (2 * M_PI);
+			const float expected = max(-1000.0f, 1000.0f - 500.0f * i / conf.sample_rate);
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, frequency, 1.0);
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, abs(received[i]), 1e-3);
+		}
+	}
+
+	void testClockOffset()
+	{
+		ChannelEmulator::Config conf;
+		conf.sample_rate = 100e3;
+		conf.snr = INFINITY;
+		conf.clock_offset = 200.0f;
+		ChannelEmulator emulator(conf);
+
+		/* Slow tone whose phase tells the transmitter time */
+		const float tone = 100.0f;
+		SampleVector burst;
+		for (size_t i = 0; i < 400000; i++)
+			burst.push_back(polar(1.0f, (float)fmod(2 * M_PI * tone * i / conf.sample_rate, 2 * M_PI)));
+		emulator.generateSamples.connect([&](Timestamp now) {
+			(void)now;
+			return generator_from_vector(burst);
+		});
+
+		/* Fast transmitter clock gives less received samples for the burst */
+		const unsigned int buffers = 97;
+		SampleVector received = run(emulator, buffers);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(buffers * conf.buffer_len / (1 + 200e-6), received.size(), 2.0);
+
+		/* Received tone is shifted in frequency by the clock offset */
+		double rotation = 0;
+		for (size_t i = 1; i < received.size(); i++)
+			rotation += arg(received[i] * conj(received[i - 1]));
+		const double frequency = rotation / (received.size() - 1) * conf.sample_rate / (2 * M_PI);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(tone * (1 + 200e-6), frequency, 1e-3);
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("ChannelEmulatorTest");
+		suite->addTest(new CppUnit::TestCaller<ChannelEmulatorTest>("Noise", &ChannelEmulatorTest::testNoise));
+		suite->addTest(new CppUnit::TestCaller<ChannelEmulatorTest>("Bursts", &ChannelEmulatorTest::testBursts));
+		suite->addTest(new CppUnit::TestCaller<ChannelEmulatorTest>("FrequencyOffset", &ChannelEmulatorTest::testFrequencyOffset));
+		suite->addTest(new CppUnit::TestCaller<ChannelEmulatorTest>("ClockOffset", &ChannelEmulatorTest::testClockOffset));
+		return suite;
+	}
+
+};
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(ChannelEmulatorTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <cmath>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+
+#include "suo.hpp"
+#include "modem/decimating_frontend.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class DecimatingFrontendTest : public CppUnit::TestFixture
+{
+private:
+
+	/* Feed a tone through the front-end and return the output power in dB after the filters have settled */
+	float measureGain(DecimatingFrontend& frontend, float sample_rate, float tone_frequency, size_t block_size = 1000) {
+		frontend.reset();
+
+		SampleVector input, output;
+		input.reserve(block_size);
+		double power = 0.0;
+		size_t n = 0, power_samples = 0;
+		for (unsigned int block = 0; block < 50; block++) {
+			input.clear();
+			for (size_t i = 0; i < block_size; i++, n++)
+				input.push_back(polar(1.0f, (float)fmod(2 * M_PI * tone_frequency * n / sample_rate, 2 * M_PI)));
+
+			frontend.execute(input, output);
+			if (block < 10)
+				continue;
+			for (const Sample& s: output)
+				power += norm(s);
+			power_samples += output.size();
+		}
+		return 10 * log10(power / power_samples);
+	}
+
+public:
+
+	void testDecimation() {
+		// 1 Msps to 4 samples per symbol at 9600 baud
+		DecimatingFrontend frontend(1e6, 38400, 30e3);
+		CPPUNIT_ASSERT_EQUAL(16U, frontend.getDecimation());
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(62500.0, frontend.getOutputRate(), 1e-3);
+
+		// No room for decimation
+		DecimatingFrontend frontend2(50e3, 38400, 30e3);
+		CPPUNIT_ASSERT_EQUAL(1U, frontend2.getDecimation());
+
+		// Output length follows the decimation also with uneven block lengths
+		SampleVector input(1001, Sample(1.0f, 0.0f)), output;
+		size_t total = 0;
+		for (unsigned int i = 0; i < 16; i++) {
+			frontend.execute(input, output);
+			total += output.size();
+		}
+		CPPUNIT_ASSERT(total == 16 * 1001 / 16 || total == 16 * 1001 / 16 + 1);
+	}
+
+	void testFrequencyResponse() {
+		const float sample_rate = 1e6, center = 100e3;
+		DecimatingFrontend frontend(sample_rate, 38400, 30e3);
+		frontend.setFrequency(center);
+
+		// Signal band is passed without attenuation
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, measureGain(frontend, sample_rate, center), 0.1);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, measureGain(frontend, sample_rate, center + 14e3), 0.1);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, measureGain(frontend, sample_rate, center - 14e3, 333), 0.1);
+
+		// Signals which would alias on top of the signal band are attenuated
+		CPPUNIT_ASSERT(measureGain(frontend, sample_rate, center + 60e3) < -55.0f);
+		CPPUNIT_ASSERT(measureGain(frontend, sample_rate, center - 300e3) < -55.0f);
+		CPPUNIT_ASSERT(measureGain(frontend, sample_rate, center + 250e3, 777) < -55.0f);
+	}
+
+	void testDelay() {
+		const float sample_rate = 1e6;
+		DecimatingFrontend frontend(sample_rate, 38400, 30e3);
+
+		// Impulse comes out after the group delay
+		const size_t impulse = 1600;
+		SampleVector input(4000, 0.0f), output;
+		input[impulse] = 1.0f;
+		frontend.execute(input, output);
+
+		size_t peak = 0;
+		for (size_t i = 0; i < output.size(); i++)
+			if (abs(output[i]) > abs(output[peak]))
+				peak = i;
+		const float peak_time = peak / frontend.getOutputRate() - impulse / sample_rate;
+		CPPUNIT_ASSERT(frontend.getDelay() > 0.0f);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(frontend.getDelay(), peak_time, 0.5f / frontend.getOutputRate());
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("DecimatingFrontendTest");
+		suite->addTest(new CppUnit::TestCaller<DecimatingFrontendTest>("Decimation", &DecimatingFrontendTest::testDecimation));
+		suite->addTest(new CppUnit::TestCaller<DecimatingFrontendTest>("FrequencyResponse", &DecimatingFrontendTest::testFrequencyResponse));
+		suite->addTest(new CppUnit::TestCaller<DecimatingFrontendTest>("Delay", &DecimatingFrontendTest::testDelay));
+		return suite;
+	}
+
+};
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(DecimatingFrontendTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <cmath>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include "suo.hpp"
+#include "utils.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class EbN0SweepTest: public CppUnit::TestFixture
+{
+private:
+
+	/* Uncoded BPSK over AWGN, one byte per frame */
+	static void bpsk_batch(float snr, unsigned int frames, CounterRNG& rng, Stats& stats) {
+		const float noise_std = powf(10.0f, -snr / 20.0f);
+		for (unsigned int f = 0; f < frames; f++) {
+			Frame transmitted, received;
+			transmitted.data.push_back(rng.byte());
+			Byte byte = 0;
+			for (int i = 7; i >= 0; i--) {
+				float x = ((transmitted.data[0] >> i) & 1) ? 1.0f : -1.0f;
+				byte = (byte << 1) | (x + noise_std * rng.normal() > 0);
+			}
+			received.data.push_back(byte);
+			count_bit_errors(stats, transmitted, received);
+		}
+	}
+
+	EbN0Sweep::Config conf;
+
+public:
+
+	void setUp() {
+		conf.snr_min = 0.0f;
+		conf.snr_max = 6.0f;
+		conf.num_snr = 4;
+		conf.seed = 1234;
+		conf.target_frame_errors = 100;
+		conf.batch_size = 16;
+		conf.verbose = false;
+	}
+
+	/* EbN0 sweep results depend only on the seed */
+	void test_determinism() {
+		conf.threads = 1;
+		vector<Stats> serial = EbN0Sweep(conf).run(bpsk_batch);
+		conf.threads = 8;
+		vector<Stats> parallel = EbN0Sweep(conf).run(bpsk_batch);
+
+		CPPUNIT_ASSERT_EQUAL((size_t)4, serial.size());
+		for (unsigned int s = 0; s < serial.size(); s++) {
+			CPPUNIT_ASSERT_EQUAL(serial[s].frame_errors, parallel[s].frame_errors);
+			CPPUNIT_ASSERT_EQUAL(serial[s].total_frames, parallel[s].total_frames);
+			CPPUNIT_ASSERT_EQUAL(serial[s].total_bit_errors, parallel[s].total_bit_errors);
+			CPPUNIT_ASSERT(serial[s].frame_errors >= conf.target_frame_errors);
+			CPPUNIT_ASSERT(serial[s].frame_errors < conf.target_frame_errors + conf.batch_size);
+			CPPUNIT_ASSERT_EQUAL(0U, serial[s].total_frames % conf.batch_size);
+		}
+
+		// BER of BPSK at 0 dB Es/N0 (per real dimension) is Q(1) ~ 0.159
+		CPPUNIT_ASSERT(fabs(serial[0].ber() - 0.159) < 0.03);
+		CPPUNIT_ASSERT(serial[3].ber() < serial[0].ber());
+
+		// Different seed gives different realization
+		conf.seed = 4321;
+		vector<Stats> other = EbN0Sweep(conf).run(bpsk_batch);
+		CPPUNIT_ASSERT(other[0].total_bit_errors != serial[0].total_bit_errors || other[0].total_frames != serial[0].total_frames);
+	}
+
+	/* Points without errors would never finish without the frame limit */
+	void test_config() {
+		conf.max_frames = 0;
+		CPPUNIT_ASSERT_THROW(EbN0Sweep{conf}, SuoError);
+	}
+
+	/* Random frames come from the seeded CounterRNG stream */
+	void test_random_frames() {
+		RandomFrameGenerator a(8, 80), b(8, 80), c(8, 80);
+		a.set_seed(1234, 1);
+		b.set_seed(1234, 1);
+		c.set_seed(1234, 2);
+
+		bool differs = false;
+		for (unsigned int i = 0; i < 10; i++) {
+			Frame fa, fb, fc;
+			a.source_frame(fa, 0);
+			b.source_frame(fb, 0);
+			c.source_frame(fc, 0);
+			CPPUNIT_ASSERT(fa.size() >= 8 && fa.size() <= 80);
+			CPPUNIT_ASSERT(fa.data == fb.data);
+			differs |= (fa.data != fc.data);
+		}
+		CPPUNIT_ASSERT(differs);
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("EbN0SweepTest");
+		suite->addTest(new CppUnit::TestCaller<EbN0SweepTest>("Determinism", &EbN0SweepTest::test_determinism));
+		suite->addTest(new CppUnit::TestCaller<EbN0SweepTest>("Config", &EbN0SweepTest::test_config));
+		suite->addTest(new CppUnit::TestCaller<EbN0SweepTest>("Random frames", &EbN0SweepTest::test_random_frames));
+		return suite;
+	}
+
+};
+
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(EbN0SweepTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
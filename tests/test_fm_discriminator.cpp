@@ -0,0 +1,116 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+
+#include "suo.hpp"
+#include "modem/fm_discriminator.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class FMDiscriminatorTest : public CppUnit::TestFixture
+{
+private:
+	mt19937 rng;
+
+public:
+
+	void setUp() {
+		rng.seed(5678);
+	}
+
+	void tearDown() {
+		fm_kernel = fm_kernel_available();
+	}
+
+	void testAtan2Accuracy()
+	{
+		/* Random points of varying magnitude and the special values */
+		normal_distribution<float> dist(0.0f, 1.0f);
+		vector<float> x, y;
+		for (size_t i = 0; i < 100000; i++) {
+			float scale = powf(10.0f, (int)(i % 10) - 5);
+			x.push_back(scale * dist(rng));
+			y.push_back(scale * dist(rng));
+		}
+		const float special[] = { 0.0f, -0.0f, 1.0f, -1.0f, 1e-30f, -1e30f };
+		for (float a: special) {
+			for (float b: special) {
+				x.push_back(a);
+				y.push_back(b);
+			}
+		}
+
+		vector<float> out(x.size());
+		for (int kernel = FMKernelScalar; kernel <= fm_kernel_available(); kernel++) {
+			fm_kernel = (FMKernel)kernel;
+			fast_atan2f(y.data(), x.data(), out.data(), x.size());
+
+			float max_error = 0.0f;
+			for (size_t i = 0; i < x.size(); i++) {
+				max_error = max(max_error, abs(out[i] - atan2f(y[i], x[i])));
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(fast_atan2f(y[i], x[i]), out[i], 1e-6); // Same as the scalar version
+			}
+			CPPUNIT_ASSERT(max_error < 2e-5f);
+		}
+	}
+
+	void testDiscriminator()
+	{
+		/* CPFSK signal with random amplitude and frequency deviation of +-0.3 rad/sample */
+		uniform_real_distribution<float> amplitude(0.1f, 10.0f);
+		const size_t len = 1001;
+		SampleVector samples;
+		samples.reserve(len);
+		vector<float> deviation;
+		float phase = 0.5f;
+		for (size_t i = 0; i < len; i++) {
+			deviation.push_back((rng() & 1) ? 0.3f : -0.3f);
+			phase += deviation.back();
+			samples.push_back(polar(amplitude(rng), phase));
+		}
+
+		for (int kernel = FMKernelScalar; kernel <= fm_kernel_available(); kernel++) {
+			fm_kernel = (FMKernel)kernel;
+
+			/* Process in uneven buffers to test the continuation */
+			vector<float> out(len);
+			Sample prev = polar(1.0f, 0.5f);
+			for (size_t i = 0; i < len; i += 97)
+				fm_discriminate(&samples[i], min<size_t>(97, len - i), &out[i], prev, 2.0f);
+
+			CPPUNIT_ASSERT(prev == samples.back());
+			for (size_t i = 0; i < len; i++) {
+				const Sample ref_prev = (i == 0) ? polar(1.0f, 0.5f) : samples[i - 1];
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0f * arg(conj(ref_prev) * samples[i]), out[i], 1e-4);
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0f * deviation[i], out[i], 1e-3);
+			}
+		}
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("FMDiscriminatorTest");
+		suite->addTest(new CppUnit::TestCaller<FMDiscriminatorTest>("Atan2Accuracy", &FMDiscriminatorTest::testAtan2Accuracy));
+		suite->addTest(new CppUnit::TestCaller<FMDiscriminatorTest>("Discriminator", &FMDiscriminatorTest::testDiscriminator));
+		return suite;
+	}
+
+};
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(FMDiscriminatorTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
@@ -0,0 +1,144 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+
+#include "suo.hpp"
+#include "modem/frequency_acquisition.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class FrequencyAcquisitionTest : public CppUnit::TestFixture
+{
+private:
+	mt19937 rng;
+
+	/* Generate noisy CPFSK signal: random bits + sync pattern + random bits */
+	SampleVector generateSignal(const FrequencyAcquisition::Config& conf, float frequency_offset, float noise_std, size_t lead_bits) {
+		const float sps = conf.sample_rate / conf.symbol_rate;
+		vector<bool> bits;
+		for (size_t i = 0; i < lead_bits; i++)
+			bits.push_back(rng() & 1);
+		for (unsigned int i = 0; i < conf.sync_pattern_len; i++)
+			bits.push_back((conf.sync_pattern >> (conf.sync_pattern_len - 1 - i)) & 1);
+		for (size_t i = 0; i < 200; i++)
+			bits.push_back(rng() & 1);
+
+		normal_distribution<float> noise(0.0f, noise_std / sqrtf(2.0f));
+		const float carrier = pi2f * (conf.center_frequency + frequency_offset) / conf.sample_rate;
+		const float initial_phase = pi2f * (rng() % 1000) / 1000.0f;
+		const size_t len = bits.size() * sps;
+
+		SampleVector samples;
+		samples.reserve(len);
+		float phase = 0.0f;
+		for (size_t i = 0; i < len; i++) {
+			phase += (bits[i / sps] ? 1.0f : -1.0f) * M_PI * conf.modindex / sps;
+			samples.push_back(polar(1.0f, initial_phase + phase + carrier * i) + Sample(noise(rng), noise(rng)));
+		}
+		return samples;
+	}
+
+	void runAcquisition(unsigned int threads, float frequency_offset, float noise_std) {
+		FrequencyAcquisition::Config conf;
+		conf.sample_rate = 200e3;
+		conf.symbol_rate = 9600;
+		conf.center_frequency = 10e3;
+		conf.max_offset = 40e3;
+		conf.threads = threads;
+		FrequencyAcquisition acq(conf);
+
+		unsigned int detections = 0;
+		float detected_offset = 0.0f;
+		acq.setFrequencyOffset.connect([&](float offset) {
+			detections++;
+			detected_offset = offset;
+		});
+
+		SampleVector signal = generateSignal(conf, frequency_offset, noise_std, 100 + rng() % 100);
+
+		/* Feed in buffers */
+		Timestamp now = 0;
+		const size_t buffer_len = 4096;
+		SampleVector buffer(buffer_len);
+		for (size_t i = 0; i < signal.size(); i += buffer_len) {
+			buffer.clear();
+			for (size_t j = i; j < min(signal.size(), i + buffer_len); j++)
+				buffer.push_back(signal[j]);
+			acq.sinkSamples(buffer, now);
+			now += buffer.size() * 1e9 / conf.sample_rate;
+		}
+
+		// Resolution is a fraction of the FFT bin width (~20 Hz)
+		CPPUNIT_ASSERT_EQUAL(1U, detections);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(frequency_offset, detected_offset, 50.0);
+	}
+
+public:
+
+	void setUp() {
+		rng.seed(1234);
+	}
+
+	/* Offsets well beyond the demodulator's AFC range (+-0.5 symbol rate) */
+	void testLargeOffsets() {
+		runAcquisition(1, 0.0f, 0.3f);
+		runAcquisition(1, 23456.0f, 0.3f);
+		runAcquisition(1, -31111.0f, 0.3f);
+	}
+
+	/* Result must not depend on the number of worker threads */
+	void testThreads() {
+		runAcquisition(4, 12345.0f, 0.5f);
+		runAcquisition(3, -7777.0f, 0.5f);
+	}
+
+	/* Pure noise should not trigger a detection */
+	void testNoise() {
+		FrequencyAcquisition::Config conf;
+		conf.sample_rate = 200e3;
+		FrequencyAcquisition acq(conf);
+
+		unsigned int detections = 0;
+		acq.setFrequencyOffset.connect([&](float) { detections++; });
+
+		normal_distribution<float> noise(0.0f, 1.0f);
+		SampleVector buffer(4096);
+		Timestamp now = 0;
+		for (unsigned int i = 0; i < 50; i++) {
+			buffer.clear();
+			for (unsigned int j = 0; j < 4096; j++)
+				buffer.push_back(Sample(noise(rng), noise(rng)));
+			acq.sinkSamples(buffer, now);
+			now += 4096 * 1e9 / conf.sample_rate;
+		}
+		CPPUNIT_ASSERT_EQUAL(0U, detections);
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("FrequencyAcquisitionTest");
+		suite->addTest(new CppUnit::TestCaller<FrequencyAcquisitionTest>("LargeOffsets", &FrequencyAcquisitionTest::testLargeOffsets));
+		suite->addTest(new CppUnit::TestCaller<FrequencyAcquisitionTest>("Threads", &FrequencyAcquisitionTest::testThreads));
+		suite->addTest(new CppUnit::TestCaller<FrequencyAcquisitionTest>("Noise", &FrequencyAcquisitionTest::testNoise));
+		return suite;
+	}
+
+};
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(FrequencyAcquisitionTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
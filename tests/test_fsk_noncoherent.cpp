@@ -0,0 +1,133 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+
+#include "suo.hpp"
+#include "modem/demod_fsk_noncoherent.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class FSKNoncoherentTest : public CppUnit::TestFixture
+{
+private:
+	mt19937 rng;
+
+	const float sample_rate = 200e3;
+	const float symbol_rate = 9600;
+
+	/* Run M-FSK with a random timing offset and frequency error through the demodulator */
+	void runDemodulator(unsigned int bits_per_symbol, float modindex, float snr) {
+		const unsigned int constellation_size = 1 << bits_per_symbol;
+		const float frequency_error = 0.05f * modindex * symbol_rate;
+
+		FSKNoncoherentDemodulator::Config conf;
+		conf.sample_rate = sample_rate;
+		conf.symbol_rate = symbol_rate;
+		conf.center_frequency = 20e3;
+		conf.modindex = modindex;
+		conf.bits_per_symbol = bits_per_symbol;
+		conf.samples_per_symbol = 16;
+		FSKNoncoherentDemodulator demod(conf);
+
+		vector<Symbol> received;
+		vector<SoftSymbol> soft;
+		demod.sinkSymbol.connect([&](Symbol symbol, Timestamp now) {
+			(void)now;
+			received.push_back(symbol);
+		});
+		demod.sinkSoftSymbol.connect([&](SoftSymbol symbol, Timestamp now) {
+			(void)now;
+			soft.push_back(symbol);
+		});
+
+		/* Continuous phase M-FSK with rectangular pulses */
+		uniform_int_distribution<unsigned int> random_symbol(0, constellation_size - 1);
+		normal_distribution<float> noise(0.0f, powf(10.0f, -snr / 20.0f) * sqrtf(0.5f * sample_rate / symbol_rate));
+		vector<Symbol> transmitted(2000);
+		SampleVector signal;
+		double phase = 0.0, t = uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+		const float sps = sample_rate / symbol_rate;
+		for (size_t i = 0; i < transmitted.size(); i++) {
+			transmitted[i] = random_symbol(rng);
+			const double frequency = conf.center_frequency + frequency_error + (transmitted[i] - 0.5 * (constellation_size - 1)) * modindex * symbol_rate;
+			for (; t < (i + 1) * sps; t += 1) {
+				signal.push_back(polar(1.0f, (float)phase) + Sample(noise(rng), noise(rng)));
+				phase = fmod(phase + 2 * M_PI * frequency / sample_rate, 2 * M_PI);
+			}
+		}
+
+		for (size_t i = 0; i < signal.size(); i += 1234) {
+			SampleVector block(signal.begin() + i, signal.begin() + min(signal.size(), i + 1234));
+			demod.sinkSamples(block, 0);
+		}
+
+		CPPUNIT_ASSERT(received.size() > transmitted.size() - 10);
+		CPPUNIT_ASSERT_EQUAL(received.size() * bits_per_symbol, soft.size());
+
+		/* Find the alignment after the acquisition and count the symbol errors */
+		size_t best_errors = received.size();
+		for (int offset = -4; offset <= 4; offset++) {
+			size_t errors = 0;
+			for (size_t i = 100; i < received.size() - 10; i++)
+				errors += (received[i] != transmitted[i + offset]);
+			best_errors = min(best_errors, errors);
+		}
+		CPPUNIT_ASSERT(best_errors < 5);
+
+		/* Soft bits agree with the hard decisions */
+		for (size_t i = 100; i < received.size() - 10; i++)
+			for (unsigned int bit = 0; bit < bits_per_symbol; bit++)
+				CPPUNIT_ASSERT_EQUAL((received[i] >> (bits_per_symbol - 1 - bit)) & 1, (soft[i * bits_per_symbol + bit] > 0) ? 1 : 0);
+	}
+
+public:
+
+	void setUp() {
+		rng.seed(1234);
+	}
+
+	void test2FSK() { runDemodulator(1, 1.0f, 14.0f); }
+	void test4FSK() { runDemodulator(2, 1.0f, 14.0f); }
+	void test8FSK() { runDemodulator(3, 1.0f, 15.0f); }
+	void testHalfModindex() { runDemodulator(2, 0.5f, 16.0f); }
+
+	void testInvalidConfig() {
+		FSKNoncoherentDemodulator::Config conf;
+		conf.modindex = 0.3f; // Tones not on any bin
+		CPPUNIT_ASSERT_THROW(FSKNoncoherentDemodulator demod(conf), SuoError);
+
+		conf.modindex = 1.0f;
+		conf.timing_phases = 3;
+		CPPUNIT_ASSERT_THROW(FSKNoncoherentDemodulator demod(conf), SuoError);
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("FSKNoncoherentTest");
+		suite->addTest(new CppUnit::TestCaller<FSKNoncoherentTest>("2FSK", &FSKNoncoherentTest::test2FSK));
+		suite->addTest(new CppUnit::TestCaller<FSKNoncoherentTest>("4FSK", &FSKNoncoherentTest::test4FSK));
+		suite->addTest(new CppUnit::TestCaller<FSKNoncoherentTest>("8FSK", &FSKNoncoherentTest::test8FSK));
+		suite->addTest(new CppUnit::TestCaller<FSKNoncoherentTest>("HalfModindex", &FSKNoncoherentTest::testHalfModindex));
+		suite->addTest(new CppUnit::TestCaller<FSKNoncoherentTest>("InvalidConfig", &FSKNoncoherentTest::testInvalidConfig));
+		return suite;
+	}
+
+};
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(FSKNoncoherentTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
@@ -0,0 +1,122 @@
+#include <iostream>
+#include <cmath>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+
+#include "suo.hpp"
+#include "misc/gaussian_noise.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class GaussianNoiseTest : public CppUnit::TestFixture
+{
+public:
+
+	void tearDown() {
+		noise_kernel = noise_kernel_available();
+	}
+
+	void testStatistics()
+	{
+		const size_t len = 1000000;
+		const float noise_std = 2.0f;
+
+		for (int kernel = NoiseKernelScalar; kernel <= noise_kernel_available(); kernel++) {
+			noise_kernel = (NoiseKernel)kernel;
+
+			GaussianNoise noise(1234);
+			SampleVector samples;
+			noise.generate(samples, len, noise_std);
+			CPPUNIT_ASSERT_EQUAL(len, samples.size());
+
+			/* Moments of the real and imaginary parts */
+			double mean = 0, power = 0, fourth = 0, cross = 0;
+			size_t tail = 0;
+			for (const Sample& s: samples) {
+				mean += s.real() + s.imag();
+				power += norm(s);
+				fourth += pow(s.real(), 4) + pow(s.imag(), 4);
+				cross += s.real() * s.imag();
+				tail += (abs(s.real()) > 3 * noise_std * M_SQRT1_2);
+			}
+			const double var = power / (2 * len);
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, mean / (2 * len), 0.005);
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(noise_std * noise_std, power / len, 0.02);
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, fourth / (2 * len) / (var * var), 0.03); // Kurtosis
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, cross / len, 0.01);
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0027, (double)tail / len, 0.0003); // P(|x| > 3 sigma)
+		}
+	}
+
+	void testReproducibility()
+	{
+		const size_t len = 10007;
+
+		/* Reference from the scalar kernel in one buffer */
+		noise_kernel = NoiseKernelScalar;
+		GaussianNoise reference_noise(99);
+		SampleVector reference;
+		reference_noise.generate(reference, len, 0.5f);
+
+		for (int kernel = NoiseKernelScalar; kernel <= noise_kernel_available(); kernel++) {
+			noise_kernel = (NoiseKernel)kernel;
+
+			/* Uneven buffers must give exactly the same samples */
+			GaussianNoise noise(99);
+			SampleVector samples(len, 0.0f);
+			for (size_t i = 0; i < len; i += 13 + i % 29)
+				noise.add(&samples[i], min<size_t>(13 + i % 29, len - i), 0.5f);
+			for (size_t i = 0; i < len; i++)
+				CPPUNIT_ASSERT(samples[i] == reference[i]);
+
+			/* Reseeding restarts the sequence */
+			noise.seed(99);
+			noise.generate(samples, len, 0.5f);
+			CPPUNIT_ASSERT(samples == reference);
+
+			noise.seed(100);
+			noise.generate(samples, len, 0.5f);
+			CPPUNIT_ASSERT(samples[0] != reference[0]);
+		}
+	}
+
+	void testEsN0()
+	{
+		/* Unit power signal with 4 samples per symbol at Es/N0 = 10 dB */
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(sqrt(0.4), GaussianNoise::esn0ToStd(10.0f, 4.0f), 1e-6);
+
+		GaussianNoise noise(7);
+		SampleVector samples(200000, 0.0f);
+		noise.addEsN0(samples, 10.0f, 4.0f);
+		double power = 0;
+		for (const Sample& s: samples)
+			power += norm(s);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.4, power / samples.size(), 0.01);
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("GaussianNoiseTest");
+		suite->addTest(new CppUnit::TestCaller<GaussianNoiseTest>("Statistics", &GaussianNoiseTest::testStatistics));
+		suite->addTest(new CppUnit::TestCaller<GaussianNoiseTest>("Reproducibility", &GaussianNoiseTest::testReproducibility));
+		suite->addTest(new CppUnit::TestCaller<GaussianNoiseTest>("EsN0", &GaussianNoiseTest::testEsN0));
+		return suite;
+	}
+
+};
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(GaussianNoiseTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
@@ -40,7 +40,7 @@ public:
 		unsynced = false;
 	}
 
-	void dummy_frame_sink(Frame &frame, Timestamp _now) {
+	void dummy_frame_sink(const Frame &frame, Timestamp _now) {
 		(void)_now;
 		//cout << "dummy_frame_sink" << endl;
 		received_frame = frame;
@@ -92,7 +92,7 @@ public:
 		
 		/* Encode frame to bits */
 		symbols.clear();
-		framer.sourceSymbols(symbols, now);
+		framer.generateSymbols(now).sourceSymbols(symbols);
 		cout << "Output symbols: " << symbols.size() << endl;
 		CPPUNIT_ASSERT(symbols.size() == total_symbols);
 
@@ -166,6 +166,73 @@ public:
 
 	}
 
+	/* Uncorrectable header and payload errors are reported by frameFailed */
+	void testDecodeFailures()
+	{
+		GolayFramer::Config framer_conf;
+		framer_conf.preamble_len = 64;
+		framer_conf.syncword = 0xdeadbeef;
+		framer_conf.syncword_len = 32;
+		framer_conf.use_viterbi = false;
+		framer_conf.use_randomizer = true;
+		framer_conf.use_rs = true;
+
+		GolayFramer framer(framer_conf);
+		framer.sourceFrame.connect_member(this, &GolayFramingTest::dummy_frame_source);
+
+		transmit_frame.clear();
+		transmit_frame.data.resize(100);
+		for (size_t i = 0; i < transmit_frame.data.size(); i++)
+			transmit_frame.data[i] = random_byte();
+
+		GolayDeframer::Config deframer_conf;
+		deframer_conf.syncword = framer_conf.syncword;
+		deframer_conf.syncword_len = framer_conf.syncword_len;
+		deframer_conf.sync_threshold = 3;
+		deframer_conf.use_viterbi = false;
+		deframer_conf.use_randomizer = true;
+		deframer_conf.use_rs = true;
+
+		GolayDeframer deframer(deframer_conf);
+		deframer.sinkFrame.connect_member(this, &GolayFramingTest::dummy_frame_sink);
+
+		vector<string> failures;
+		Timestamp sync_timestamp = 0;
+		deframer.frameFailed.connect([&](const Frame& frame, Timestamp _now) {
+			(void)_now;
+			failures.push_back(get<string>(frame.metadata.at("decode_failure")));
+			sync_timestamp = get<Timestamp>(frame.metadata.at("sync_timestamp"));
+		});
+
+		const size_t header = framer_conf.preamble_len + framer_conf.syncword_len;
+		for (int corrupt = 0; corrupt < 2; corrupt++) {
+			symbols.clear();
+			framer.generateSymbols(now).sourceSymbols(symbols);
+
+			if (corrupt == 0) {
+				for (size_t i = 0; i < 4; i++) // Golay code corrects only 3 errors
+					symbols[header + 5 * i] ^= 1;
+			}
+			else {
+				for (size_t i = 0; i < 20; i++) // RS corrects only 16 bytes
+					symbols[header + 24 + 8 * i] ^= 1;
+			}
+
+			received_frame.clear();
+			const Timestamp start = now;
+			for (size_t i = 0; i < symbols.size(); i++)
+				deframer.sinkSymbol(symbols[i], now++);
+			for (size_t i = 0; i < 100; i++)
+				deframer.sinkSymbol(random_bit(), now++);
+
+			CPPUNIT_ASSERT(received_frame.empty());
+			CPPUNIT_ASSERT_EQUAL((size_t)corrupt + 1, failures.size());
+			CPPUNIT_ASSERT_EQUAL(start + header - 1, sync_timestamp);
+		}
+		CPPUNIT_ASSERT_EQUAL(string("golay"), failures[0]);
+		CPPUNIT_ASSERT_EQUAL(string("rs"), failures[1]);
+	}
+
 	void testGenerator()
 	{
 		// Source tavuja pienissä palasissa
@@ -176,6 +243,7 @@ public:
 	{
 		CppUnit::TestSuite* suite = new CppUnit::TestSuite("GolayFramingTest");
 		suite->addTest(new CppUnit::TestCaller<GolayFramingTest>("basicTest", &GolayFramingTest::basicTest));
+		suite->addTest(new CppUnit::TestCaller<GolayFramingTest>("Decode failures", &GolayFramingTest::testDecodeFailures));
 		return suite;
 	}
 
@@ -3,6 +3,7 @@
 #include <ctime> // time()
 #include <cstring> // memcmp
 #include <memory>
+#include <random>
 
 #include <cppunit/TestFixture.h>
 #include <cppunit/TestAssert.h>
@@ -19,6 +20,202 @@ using namespace std;
 using namespace suo;
 
 
+/*
+ * Verbatim copy of the original bit-serial HDLC deframer state machine
+ * (including its G3RUH descrambler) used as the oracle for the optimized deframer.
+ * Metrics and metadata are left out.
+ */
+class BaselineHDLCDeframer
+{
+public:
+	enum State {
+		WaitingSync = 0,
+		ReceivingFrame,
+		Trailer,
+	};
+
+	explicit BaselineHDLCDeframer(const HDLCDeframer::Config& conf) :
+		conf(conf)
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		syncDetected.emit(false, 0);
+		state = WaitingSync;
+		shift = 0;
+		bit_idx = 0;
+		frame.clear();
+
+		last_bit = 0;
+		scrambler = 0;
+		stuffing_counter = 0;
+	}
+
+	void sinkSymbol(Symbol bit, Timestamp now)
+	{
+		bit = descramble_bit(bit);
+
+		switch (state)
+		{
+		case WaitingSync:
+			findStartFlag(bit, now);
+			break;
+		case ReceivingFrame:
+			receivingFrame(bit, now);
+			break;
+		case Trailer:
+			receivingTrailer(bit, now);
+			break;
+		}
+	}
+
+	Port<const Frame&, Timestamp> sinkFrame;
+	Port<bool, Timestamp> syncDetected;
+
+private:
+	Symbol descramble_bit(Symbol bit)
+	{
+		if (conf.mode == G3RUH) {
+			/* G3RUH descrambler */
+			unsigned int lfsr_hi = (scrambler & 1);
+			unsigned int lfsr_lo = ((scrambler >> 5) & 1);
+			unsigned int descrambled_bit = (bit ^ (lfsr_hi ^ lfsr_lo)) != 0;
+
+			scrambler = (scrambler >> 1);
+
+			if (bit != 0)
+				scrambler |= 0x00010000;
+
+			bit = descrambled_bit;
+
+			/* NRZI decode */
+			Symbol new_bit = (bit != last_bit) ? 0 : 1;
+			last_bit = bit;
+			return new_bit;
+		}
+		else if (conf.mode == NRZI) {
+			/* NRZI decode */
+			Symbol new_bit = (bit != last_bit) ? 0 : 1;
+			last_bit = bit;
+			return new_bit;
+		}
+		else
+			return bit;
+	}
+
+	void findStartFlag(Symbol bit, Timestamp now)
+	{
+		// More than 5 continious 1's have been received.
+		if (stuffing_counter == 6 && bit == 0) {
+			// Start/end flag!
+			syncDetected.emit(true, now);
+
+			state = ReceivingFrame;
+			frame.clear();
+			shift = 0;
+			stuffing_counter = 0;
+			bit_idx = 0;
+		}
+		stuffing_counter = bit ? (stuffing_counter + 1) : 0;
+	}
+
+	void receivingFrame(Symbol bit, Timestamp now)
+	{
+		if (stuffing_counter >= 5) {
+			// More than 5 continious 1's have been received.
+
+			if (bit == 1) {
+				// 6th 1 breaks the stuffing rule. End flag detected!
+
+				if (frame.data.size() < conf.minimum_frame_length) {
+					// Repeated start flag
+					bit_idx = 0;
+					shift = 0;
+					frame.data.clear();
+					return;
+				}
+
+				syncDetected.emit(false, now);
+
+				if (conf.check_crc) {
+					const size_t len = frame.data.size() - 2;
+					const uint16_t received_crc = (frame.data[len] << 8) | frame.data[len + 1];
+					const uint16_t calculated_crc = crc16_ccitt(&frame.data[0], len);
+
+					if (received_crc == calculated_crc) {
+						frame.data.resize(len); // Remove CRC
+						sinkFrame.emit(frame, now);
+					}
+				}
+				else {
+					sinkFrame.emit(frame, now);
+				}
+
+				silence_counter = 0;
+				state = Trailer;
+				return;
+			}
+			else {
+				// More than 6 ones!
+				// Unstuff the stuffing bit
+				stuffing_counter = 0;
+			}
+		}
+		else {
+			stuffing_counter = bit ? (stuffing_counter + 1) : 0;
+
+			shift = (0xFF & (shift << 1)) | bit;
+			bit_idx++;
+
+			if (bit_idx >= 8) {
+				frame.data.push_back(shift);
+				bit_idx = 0;
+				shift = 0;
+
+				// Too long frame
+				if (frame.data.size() > conf.maximum_frame_length) {
+					syncDetected.emit(false, now);
+					reset();
+				}
+			}
+		}
+	}
+
+	void receivingTrailer(Symbol bit, Timestamp now)
+	{
+		if (stuffing_counter >= 5) {
+			stuffing_counter = 0;
+			silence_counter = 0;
+			return;
+		}
+		else {
+			stuffing_counter = 0;
+		}
+
+		stuffing_counter = bit ? (stuffing_counter + 1) : 0;
+		silence_counter++;
+
+		if (silence_counter >= conf.minimum_silence) {
+			state = WaitingSync;
+		}
+	}
+
+	HDLCDeframer::Config conf;
+
+	State state;
+	unsigned int shift;
+	unsigned int bit_idx;
+	unsigned int silence_counter;
+	Frame frame;
+
+	Symbol last_bit;
+	uint32_t scrambler;
+	unsigned int stuffing_counter;
+};
+
+
 class HDLCFramingTest : public CppUnit::TestFixture
 {
 private:
@@ -74,7 +271,7 @@ public:
 		HDLCDeframer deframer(deframer_conf);
 
 		Frame received_frame;
-		deframer.sinkFrame.connect([&](Frame& frame, Timestamp now) {
+		deframer.sinkFrame.connect([&](const Frame& frame, Timestamp now) {
 			(void) now;
 			received_frame = frame;
 		});
@@ -158,7 +355,7 @@ public:
 		HDLCDeframer deframer(deframer_conf);
 
 		Frame received_frame;
-		deframer.sinkFrame.connect([&](Frame& frame, Timestamp now) {
+		deframer.sinkFrame.connect([&](const Frame& frame, Timestamp now) {
 			received_frame = frame;
 		});
 
@@ -201,6 +398,61 @@ public:
 		//CPPUNIT_ASSERT(dunno->frames_detected == 1);
 	}
 
+	/* Frames with CRC mismatch are reported by frameFailed */
+	void crcFailureTest() {
+		HDLCFramer::Config framer_conf;
+		framer_conf.mode = HDLCMode::Uncoded;
+		framer_conf.preamble_length = 10;
+		framer_conf.trailer_length = 2;
+		framer_conf.append_crc = true;
+		HDLCFramer framer(framer_conf);
+
+		/* Alternating bits so that a flipped bit doesn't change the bit stuffing */
+		framer.sourceFrame.connect([&](Frame& frame, Timestamp now) {
+			frame.clear();
+			frame.data.assign(32, 0x55);
+		});
+
+		SymbolVector symbols;
+		symbols.reserve(1024);
+		SymbolGenerator symbol_gen = framer.generateSymbols(now);
+		symbol_gen.sourceSymbols(symbols);
+
+		/* Flip a one bit in the middle of the payload */
+		size_t i = 8 * (framer_conf.preamble_length + 8);
+		while (symbols[i] == 0)
+			i++;
+		symbols[i] = 0;
+
+		HDLCDeframer::Config deframer_conf;
+		deframer_conf.mode = framer_conf.mode;
+		deframer_conf.check_crc = true;
+		deframer_conf.maximum_frame_length = 256;
+		deframer_conf.minimum_frame_length = 8;
+		deframer_conf.minimum_silence = 5;
+		HDLCDeframer deframer(deframer_conf);
+
+		bool received = false;
+		deframer.sinkFrame.connect([&](const Frame& frame, Timestamp now) {
+			received = true;
+		});
+
+		Frame failed_frame;
+		deframer.frameFailed.connect([&](const Frame& frame, Timestamp now) {
+			failed_frame = frame;
+		});
+
+		for (size_t i = 0; i < symbols.size(); i++)
+			deframer.sinkSymbol(symbols[i], now++);
+		for (size_t i = 0; i < 100; i++)
+			deframer.sinkSymbol(random_bit(), now++);
+
+		CPPUNIT_ASSERT(received == false);
+		CPPUNIT_ASSERT_EQUAL((size_t)34, failed_frame.data.size());
+		CPPUNIT_ASSERT(get<string>(failed_frame.metadata.at("decode_failure")) == "crc");
+		CPPUNIT_ASSERT(failed_frame.metadata.count("sync_timestamp") == 1);
+	}
+
 	void testMissingZeroInSync() {
 		// Testaa että "jaettu nolla" preamblessa toimii  011111101111110
 
@@ -241,7 +493,7 @@ public:
 		HDLCDeframer deframer(deframer_conf);
 
 		Frame received_frame;
-		deframer.sinkFrame.connect([&](Frame& frame, Timestamp now) {
+		deframer.sinkFrame.connect([&](const Frame& frame, Timestamp now) {
 			received_frame = frame;
 		});
 
@@ -379,14 +631,196 @@ public:
 	}
 
 
+	/*
+	 * Differential test: Feed the same bit stream to the baseline bit-serial deframer (oracle)
+	 * and to the optimized deframer bit-by-bit, as symbol chunks and as packed byte chunks.
+	 * Frames and sync events must be identical.
+	 */
+	void runDifferential(HDLCMode mode, bool check_crc) {
+		mt19937 rng(1234 + mode);
+		bernoulli_distribution bit_error(0.002);
+
+		HDLCFramer::Config framer_conf;
+		framer_conf.mode = mode;
+		framer_conf.preamble_length = 4;
+		framer_conf.trailer_length = 2;
+		framer_conf.append_crc = true;
+		HDLCFramer framer(framer_conf);
+
+		RandomFrameGenerator frame_generator(8, 80);
+		frame_generator.set_seed(rng());
+		framer.sourceFrame.connect_member(&frame_generator, &RandomFrameGenerator::source_frame);
+
+		/* Frames separated by random bits with occasional bit errors */
+		SymbolVector stream;
+		for (unsigned int f = 0; f < 50; f++) {
+			for (unsigned int i = rng() % 100; i > 0; i--)
+				stream.push_back(rng() & 1);
+
+			framer.reset();
+			SymbolVector symbols;
+			symbols.reserve(2048);
+			SymbolGenerator gen = framer.generateSymbols(now);
+			gen.sourceSymbols(symbols);
+			for (Symbol s : symbols)
+				stream.push_back(s ^ ((f % 3 == 0) ? bit_error(rng) : 0));
+		}
+		while (stream.size() % 8 != 0)
+			stream.push_back(rng() & 1);
+
+		HDLCDeframer::Config deframer_conf;
+		deframer_conf.mode = mode;
+		deframer_conf.check_crc = check_crc;
+		deframer_conf.minimum_frame_length = 8;
+		deframer_conf.maximum_frame_length = 64; // Some of the frames are too long
+		deframer_conf.minimum_silence = 5;
+
+		BaselineHDLCDeframer reference(deframer_conf);
+		HDLCDeframer bit_deframer(deframer_conf), symbol_deframer(deframer_conf), byte_deframer(deframer_conf);
+
+		typedef vector<ByteVector> Frames;
+		typedef vector<pair<bool, Timestamp>> Syncs;
+		Frames reference_frames, bit_frames, symbol_frames, byte_frames;
+		Syncs reference_syncs, bit_syncs, symbol_syncs, byte_syncs;
+		auto record = [](auto& deframer, Frames& frames, Syncs& syncs) {
+			deframer.sinkFrame.connect([&](const Frame& frame, Timestamp now) {
+				frames.push_back(frame.data);
+			});
+			deframer.syncDetected.connect([&](bool sync, Timestamp now) {
+				syncs.emplace_back(sync, now);
+			});
+		};
+		record(reference, reference_frames, reference_syncs);
+		record(bit_deframer, bit_frames, bit_syncs);
+		record(symbol_deframer, symbol_frames, symbol_syncs);
+		record(byte_deframer, byte_frames, byte_syncs);
+
+		/* Random chunks of whole bytes so that all paths see the same timestamps */
+		size_t pos = 0;
+		while (pos < stream.size()) {
+			const size_t len = min(stream.size() - pos, 8 * (size_t)(rng() % 40));
+			SymbolVector chunk(stream.begin() + pos, stream.begin() + pos + len);
+			ByteVector packed(len / 8, 0);
+			for (size_t i = 0; i < len; i++)
+				packed[i / 8] |= chunk[i] << (7 - i % 8);
+
+			for (Symbol bit : chunk) {
+				reference.sinkSymbol(bit, now);
+				bit_deframer.sinkSymbol(bit, now);
+			}
+			symbol_deframer.sinkSymbols(chunk, now);
+			byte_deframer.sinkBytes(packed, now);
+			pos += len;
+			now++;
+		}
+
+		CPPUNIT_ASSERT(reference_frames.size() > 10);
+		CPPUNIT_ASSERT(reference_frames == bit_frames);
+		CPPUNIT_ASSERT(reference_syncs == bit_syncs);
+		CPPUNIT_ASSERT(reference_frames == symbol_frames);
+		CPPUNIT_ASSERT(reference_syncs == symbol_syncs);
+		CPPUNIT_ASSERT(reference_frames == byte_frames);
+		CPPUNIT_ASSERT(reference_syncs == byte_syncs);
+	}
+
+	/*
+	 * Reference bit-by-bit HDLC encoder for checking the table driven framer
+	 */
+	static SymbolVector referenceEncode(HDLCMode mode, const ByteVector& data, unsigned int preamble, unsigned int trailer) {
+		SymbolVector bits;
+		for (unsigned int i = 0; i < preamble; i++)
+			for (int b = 7; b >= 0; b--)
+				bits.push_back((0x7E >> b) & 1);
+		unsigned int ones = 0;
+		for (Byte byte : data) {
+			for (int b = 7; b >= 0; b--) {
+				const Symbol bit = (byte >> b) & 1;
+				bits.push_back(bit);
+				ones = bit ? (ones + 1) : 0;
+				if (ones == 5) {
+					bits.push_back(0);
+					ones = 0;
+				}
+			}
+		}
+		for (unsigned int i = 0; i < trailer; i++)
+			for (int b = 7; b >= 0; b--)
+				bits.push_back((0x7E >> b) & 1);
+
+		Symbol last_bit = 0;
+		unsigned int scrambler = 0;
+		for (Symbol& bit : bits) {
+			if (mode == NRZI || mode == G3RUH) {
+				if (bit == 0)
+					last_bit = !last_bit;
+				bit = last_bit;
+			}
+			if (mode == G3RUH) {
+				bit ^= (scrambler & 1) ^ ((scrambler >> 5) & 1);
+				scrambler = (scrambler >> 1) | (bit << 16);
+			}
+		}
+		return bits;
+	}
+
+	void testPackedEncoding() {
+		mt19937 rng(4321);
+		for (HDLCMode mode : { HDLCMode::Uncoded, HDLCMode::NRZI, HDLCMode::G3RUH }) {
+			HDLCFramer::Config framer_conf;
+			framer_conf.mode = mode;
+			framer_conf.preamble_length = 3;
+			framer_conf.trailer_length = 2;
+			framer_conf.append_crc = true;
+			HDLCFramer framer(framer_conf);
+
+			for (unsigned int n = 0; n < 20; n++) {
+				Frame frame;
+				frame.data.resize(1 + rng() % 100);
+				for (Byte& byte : frame.data)
+					byte = (n % 2) ? 0xFF : (rng() & 0xFF); // Plenty of stuffing
+
+				ByteVector data = frame.data;
+				uint16_t crc = crc16_ccitt(&data[0], data.size());
+				data.push_back(crc >> 8);
+				data.push_back(crc & 0xFF);
+				SymbolVector expected = referenceEncode(mode, data, 3, 2);
+
+				ByteVector packed;
+				const size_t nbits = framer.encodeFrame(frame, packed);
+				CPPUNIT_ASSERT_EQUAL(expected.size(), nbits);
+				CPPUNIT_ASSERT_EQUAL((nbits + 7) / 8, packed.size());
+				for (size_t i = 0; i < nbits; i++)
+					CPPUNIT_ASSERT_EQUAL(expected[i], (Symbol)((packed[i / 8] >> (7 - i % 8)) & 1));
+
+				/* Generator yields the same symbols */
+				framer.sourceFrame.disconnect_all();
+				framer.sourceFrame.connect([&](Frame& out, Timestamp now) { out = frame; });
+				SymbolVector symbols;
+				symbols.reserve(2048);
+				SymbolGenerator gen = framer.generateSymbols(now);
+				gen.sourceSymbols(symbols);
+				CPPUNIT_ASSERT(symbols == expected);
+			}
+		}
+	}
+
+	void testByteEngineUncoded() { runDifferential(HDLCMode::Uncoded, false); }
+	void testByteEngineNRZI() { runDifferential(HDLCMode::NRZI, true); }
+	void testByteEngineG3RUH() { runDifferential(HDLCMode::G3RUH, true); }
+
 	static CppUnit::Test* suite()
 	{
 		CppUnit::TestSuite* suite = new CppUnit::TestSuite("HDLCFramingTest");
 		suite->addTest(new CppUnit::TestCaller<HDLCFramingTest>("Basic test", &HDLCFramingTest::basicTest));
 		suite->addTest(new CppUnit::TestCaller<HDLCFramingTest>("CRC test", &HDLCFramingTest::crcTest));
+		suite->addTest(new CppUnit::TestCaller<HDLCFramingTest>("CRC failure test", &HDLCFramingTest::crcFailureTest));
 		suite->addTest(new CppUnit::TestCaller<HDLCFramingTest>("Missing zero in sync", &HDLCFramingTest::testMissingZeroInSync));
 		suite->addTest(new CppUnit::TestCaller<HDLCFramingTest>("Generating in small chunks", &HDLCFramingTest::testGeneratingInSmallChunks));
 		suite->addTest(new CppUnit::TestCaller<HDLCFramingTest>("Generating with iterator", &HDLCFramingTest::testGeneratingWithIterator));
+		suite->addTest(new CppUnit::TestCaller<HDLCFramingTest>("Packed encoding", &HDLCFramingTest::testPackedEncoding));
+		suite->addTest(new CppUnit::TestCaller<HDLCFramingTest>("Byte engine Uncoded", &HDLCFramingTest::testByteEngineUncoded));
+		suite->addTest(new CppUnit::TestCaller<HDLCFramingTest>("Byte engine NRZI", &HDLCFramingTest::testByteEngineNRZI));
+		suite->addTest(new CppUnit::TestCaller<HDLCFramingTest>("Byte engine G3RUH", &HDLCFramingTest::testByteEngineG3RUH));
 		return suite;
 	}
 
@@ -0,0 +1,161 @@
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+
+#include "suo.hpp"
+#include "signal-io/iq_recorder.hpp"
+#include "signal-io/sigmf.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class IQRecorderTest : public CppUnit::TestFixture
+{
+private:
+	string filename;
+
+	static Sample signal(size_t i) {
+		return polar(0.5f, (float)(0.001 * i));
+	}
+
+	static SampleVector buffer(size_t first, size_t len) {
+		SampleVector samples(len);
+		for (size_t i = 0; i < len; i++)
+			samples[i] = signal(first + i);
+		return samples;
+	}
+
+	static off_t fileSize(const string& path) {
+		struct stat st;
+		CPPUNIT_ASSERT(stat(path.c_str(), &st) == 0);
+		return st.st_size;
+	}
+
+	/* Read the recording back and check that the samples are the original */
+	void verify(size_t expected, float tolerance) {
+		SigMFReader::Config conf;
+		conf.filename = filename;
+		SigMFReader reader(conf);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)expected, reader.getSampleCount());
+
+		size_t index = 0;
+		reader.sinkSamples.connect([&](const SampleVector& samples, Timestamp now) {
+			CPPUNIT_ASSERT_EQUAL((Timestamp)(index * 1000), now);
+			for (const Sample& s: samples) {
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0f, abs(s - signal(index)), tolerance);
+				index++;
+			}
+		});
+		reader.execute();
+		CPPUNIT_ASSERT_EQUAL(expected, index);
+	}
+
+public:
+
+	void setUp() {
+		filename = "/tmp/suo_test_iq_recorder_" + to_string(getpid());
+	}
+
+	void tearDown() {
+		remove((filename + ".sigmf-data").c_str());
+		remove((filename + ".sigmf-meta").c_str());
+	}
+
+	void testRecord(const string& format, size_t sample_size, float tolerance)
+	{
+		/* Odd lengths so that the buffers wrap around the ring and the last chunk is partial */
+		const size_t len = 1013, buffers = 977;
+		{
+			IQRecorder::Config conf;
+			conf.filename = filename;
+			conf.format = format;
+			conf.sample_rate = 1e6;
+			conf.ring_size = 1 << 20;
+			conf.chunk_size = 64 << 10;
+			IQRecorder recorder(conf);
+
+			for (size_t b = 0; b < buffers; b++) {
+				/* Keep the producer at most half a ring ahead so that the test doesn't depend on the disk speed */
+				while (recorder.getRecordedSamples() * sample_size - recorder.getWrittenBytes() > conf.ring_size / 2)
+					usleep(100);
+				recorder.sinkSamples(buffer(b * len, len), b * len * 1000);
+			}
+			recorder.close();
+
+			CPPUNIT_ASSERT_EQUAL((uint64_t)0, recorder.getDroppedSamples());
+			CPPUNIT_ASSERT_EQUAL((uint64_t)(len * buffers), recorder.getRecordedSamples());
+			CPPUNIT_ASSERT_EQUAL((uint64_t)(len * buffers * sample_size), recorder.getWrittenBytes());
+		}
+
+		CPPUNIT_ASSERT_EQUAL((off_t)(len * buffers * sample_size), fileSize(filename + ".sigmf-data"));
+		verify(len * buffers, tolerance);
+	}
+
+	void testRecordCF32() {
+		testRecord("CF32", 8, 0.0f);
+	}
+
+	void testRecordCS16() {
+		testRecord("CS16", 4, 1e-4f);
+	}
+
+	void testDropped()
+	{
+		IQRecorder::Config conf;
+		conf.filename = filename;
+		conf.sample_rate = 1e6;
+		conf.ring_size = 16384;
+		conf.chunk_size = 4096;
+		{
+			IQRecorder recorder(conf);
+			recorder.sinkSamples(buffer(0, 600), 0);
+			usleep(50000);
+			recorder.sinkSamples(buffer(600, 3000), 600000); // Larger than the ring
+			recorder.sinkSamples(buffer(3600, 600), 3600000);
+			usleep(50000);
+			recorder.sinkSamples(buffer(4200, 600), 4200000);
+			recorder.close();
+
+			CPPUNIT_ASSERT_EQUAL((uint64_t)3000, recorder.getDroppedSamples());
+			CPPUNIT_ASSERT_EQUAL((uint64_t)1800, recorder.getRecordedSamples());
+		}
+
+		/* Samples after the drop are in their own capture with the right timestamp */
+		SigMFReader::Config reader_conf;
+		reader_conf.filename = filename;
+		SigMFReader reader(reader_conf);
+		CPPUNIT_ASSERT_EQUAL((size_t)2, reader.getCaptures().size());
+		CPPUNIT_ASSERT_EQUAL((uint64_t)600, reader.getCaptures()[1].sample_start);
+		CPPUNIT_ASSERT_EQUAL((Timestamp)3600000, reader.getCaptures()[1].timestamp);
+		CPPUNIT_ASSERT_EQUAL((Timestamp)4799000, reader.sampleTimestamp(1799));
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("IQRecorderTest");
+		suite->addTest(new CppUnit::TestCaller<IQRecorderTest>("RecordCF32", &IQRecorderTest::testRecordCF32));
+		suite->addTest(new CppUnit::TestCaller<IQRecorderTest>("RecordCS16", &IQRecorderTest::testRecordCS16));
+		suite->addTest(new CppUnit::TestCaller<IQRecorderTest>("Dropped", &IQRecorderTest::testDropped));
+		return suite;
+	}
+
+};
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(IQRecorderTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
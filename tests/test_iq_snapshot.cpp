@@ -0,0 +1,254 @@
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+
+#include "suo.hpp"
+#include "signal-io/iq_snapshot.hpp"
+#include "signal-io/sigmf.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class IQSnapshotTest : public CppUnit::TestFixture
+{
+private:
+	string prefix;
+	IQSnapshot::Config conf;
+	Timestamp now;
+
+	static Sample signal(size_t i) {
+		return polar(0.5f, (float)(0.001 * i));
+	}
+
+	/* Feed 10 ms buffers until the given time */
+	void feed(IQSnapshot& snapshot, Timestamp until) {
+		const size_t len = 1000;
+		SampleVector samples(len);
+		while (now < until) {
+			const size_t first = now / 10000;
+			for (size_t i = 0; i < len; i++)
+				samples[i] = signal(first + i);
+			snapshot.sinkSamples(samples, now);
+			now += len * 10000;
+		}
+	}
+
+	/* Check that the snapshot contains the original samples */
+	void verify(SigMFReader& reader) {
+		size_t total = 0;
+		reader.sinkSamples.connect([&](const SampleVector& samples, Timestamp timestamp) {
+			for (size_t i = 0; i < samples.size(); i++)
+				CPPUNIT_ASSERT(abs(samples[i] - signal(timestamp / 10000 + i)) < 1e-6f);
+			total += samples.size();
+		});
+		reader.execute();
+		CPPUNIT_ASSERT_EQUAL((size_t)reader.getSampleCount(), total);
+	}
+
+public:
+
+	void setUp() {
+		prefix = "/tmp/suo_test_iq_snapshot_" + to_string(getpid());
+		conf = IQSnapshot::Config();
+		conf.filename_prefix = prefix;
+		conf.sample_rate = 100e3;
+		conf.pre_trigger = 0.05f;
+		conf.post_trigger = 0.1f;
+		conf.history_buffers = 32;
+		now = 0;
+	}
+
+	void tearDown() {
+		for (int i = 0; i < 4; i++) {
+			remove((prefix + "_" + to_string(i) + ".sigmf-data").c_str());
+			remove((prefix + "_" + to_string(i) + ".sigmf-meta").c_str());
+		}
+	}
+
+	void testWindow()
+	{
+		{
+			IQSnapshot snapshot(conf);
+			feed(snapshot, 200000000);
+			snapshot.syncDetected(true, 203000000);
+			feed(snapshot, 500000000);
+			snapshot.flush();
+			CPPUNIT_ASSERT_EQUAL((uint64_t)1, snapshot.getSnapshotCount());
+		}
+
+		SigMFReader::Config reader_conf;
+		reader_conf.filename = prefix + "_0";
+		SigMFReader reader(reader_conf);
+
+		/* 50 ms before and 100 ms after the trigger */
+		CPPUNIT_ASSERT_EQUAL((uint64_t)15000, reader.getSampleCount());
+		CPPUNIT_ASSERT_EQUAL((size_t)1, reader.getCaptures().size());
+		CPPUNIT_ASSERT_EQUAL((Timestamp)153000000, reader.getCaptures()[0].timestamp);
+
+		CPPUNIT_ASSERT_EQUAL((size_t)1, reader.getAnnotations().size());
+		CPPUNIT_ASSERT_EQUAL(string("sync"), reader.getAnnotations()[0].label);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)5000, reader.getAnnotations()[0].sample_start);
+		verify(reader);
+	}
+
+	void testTriggers()
+	{
+		{
+			IQSnapshot snapshot(conf);
+			feed(snapshot, 100000000);
+
+			/* Sync and the failed frame are merged to one snapshot */
+			Frame frame(16);
+			frame.data.assign(16, 0xAA);
+			frame.setMetadata("sync_timestamp", (Timestamp)100000000);
+			frame.setMetadata("completed_timestamp", (Timestamp)130000000);
+			frame.setMetadata("decode_failure", string("golay"));
+			snapshot.syncDetected(true, 100000000);
+			feed(snapshot, 140000000);
+			snapshot.frameFailed(frame, 130000000);
+
+			/* Successful frame later doesn't trigger by default */
+			feed(snapshot, 600000000);
+			frame.setMetadata("sync_timestamp", (Timestamp)600000000);
+			snapshot.sinkFrame(frame, 630000000);
+
+			/* Frame inside a sync triggered window is annotated */
+			feed(snapshot, 800000000);
+			snapshot.syncDetected(true, 800000000);
+			feed(snapshot, 840000000);
+			frame.setMetadata("sync_timestamp", (Timestamp)800000000);
+			frame.setMetadata("completed_timestamp", (Timestamp)830000000);
+			snapshot.sinkFrame(frame, 830000000);
+			feed(snapshot, 1000000000);
+
+			snapshot.flush();
+			CPPUNIT_ASSERT_EQUAL((uint64_t)2, snapshot.getSnapshotCount());
+			CPPUNIT_ASSERT_EQUAL((uint64_t)0, snapshot.getDroppedCount());
+		}
+
+		SigMFReader::Config reader_conf;
+		reader_conf.filename = prefix + "_0";
+		SigMFReader first(reader_conf);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)15000, first.getSampleCount());
+		CPPUNIT_ASSERT_EQUAL((size_t)2, first.getAnnotations().size());
+		const SigMFAnnotation& failure = first.getAnnotations()[1];
+		CPPUNIT_ASSERT_EQUAL(string("failure"), failure.label);
+		CPPUNIT_ASSERT_EQUAL(string("golay"), failure.comment);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)5000, failure.sample_start);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)3000, failure.sample_count);
+		Frame decoded = Frame::deserialize_from_json(failure.frame);
+		CPPUNIT_ASSERT(decoded.data == ByteVector(16, 0xAA));
+		verify(first);
+
+		reader_conf.filename = prefix + "_1";
+		SigMFReader second(reader_conf);
+		CPPUNIT_ASSERT_EQUAL((Timestamp)750000000, second.getCaptures()[0].timestamp);
+		CPPUNIT_ASSERT_EQUAL((size_t)2, second.getAnnotations().size());
+		CPPUNIT_ASSERT_EQUAL(string("frame"), second.getAnnotations()[1].label);
+		verify(second);
+	}
+
+	void testWriterBusy()
+	{
+		/* Only one snapshot can wait at a time and the history is shorter than the window */
+		conf.max_pending = 1;
+		conf.history_buffers = 8;
+		{
+			IQSnapshot snapshot(conf);
+			for (int i = 0; i < 3; i++) {
+				feed(snapshot, now + 100000000);
+				snapshot.syncDetected(true, now);
+			}
+			snapshot.flush();
+			CPPUNIT_ASSERT(snapshot.getSnapshotCount() + snapshot.getDroppedCount() == 3);
+			CPPUNIT_ASSERT(snapshot.getSnapshotCount() >= 1);
+			CPPUNIT_ASSERT_EQUAL(snapshot.getSnapshotCount(), snapshot.getTruncatedCount());
+		}
+
+		/* Snapshot contains only the buffers still in the history */
+		SigMFReader::Config reader_conf;
+		reader_conf.filename = prefix + "_0";
+		SigMFReader reader(reader_conf);
+		CPPUNIT_ASSERT(reader.getSampleCount() <= 8000);
+		verify(reader);
+	}
+
+	void testFrameAnnotation()
+	{
+		{
+			IQSnapshot snapshot(conf);
+			feed(snapshot, 100000000);
+			snapshot.syncDetected(true, 100000000);
+
+			/* Frame near the end of the window doesn't extend it */
+			Frame frame(16);
+			frame.setMetadata("sync_timestamp", (Timestamp)180000000);
+			feed(snapshot, 190000000);
+			snapshot.sinkFrame(frame, 190000000);
+			feed(snapshot, 400000000);
+
+			snapshot.flush();
+			CPPUNIT_ASSERT_EQUAL((uint64_t)1, snapshot.getSnapshotCount());
+		}
+
+		SigMFReader::Config reader_conf;
+		reader_conf.filename = prefix + "_0";
+		SigMFReader reader(reader_conf);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)15000, reader.getSampleCount());
+		CPPUNIT_ASSERT_EQUAL((size_t)2, reader.getAnnotations().size());
+		CPPUNIT_ASSERT_EQUAL(string("frame"), reader.getAnnotations()[1].label);
+	}
+
+	void testTruncated()
+	{
+		/* History of 80 ms doesn't cover the 150 ms window */
+		conf.history_buffers = 8;
+		{
+			IQSnapshot snapshot(conf);
+			feed(snapshot, 100000000);
+			snapshot.syncDetected(true, 100000000);
+			feed(snapshot, 400000000);
+			snapshot.flush();
+			CPPUNIT_ASSERT_EQUAL((uint64_t)1, snapshot.getSnapshotCount());
+			CPPUNIT_ASSERT_EQUAL((uint64_t)1, snapshot.getTruncatedCount());
+		}
+
+		/* Saved before the buffer at the start of the window was overwritten */
+		SigMFReader::Config reader_conf;
+		reader_conf.filename = prefix + "_0";
+		SigMFReader reader(reader_conf);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)8000, reader.getSampleCount());
+		CPPUNIT_ASSERT_EQUAL((Timestamp)50000000, reader.getCaptures()[0].timestamp);
+		verify(reader);
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("IQSnapshotTest");
+		suite->addTest(new CppUnit::TestCaller<IQSnapshotTest>("Window", &IQSnapshotTest::testWindow));
+		suite->addTest(new CppUnit::TestCaller<IQSnapshotTest>("Triggers", &IQSnapshotTest::testTriggers));
+		suite->addTest(new CppUnit::TestCaller<IQSnapshotTest>("WriterBusy", &IQSnapshotTest::testWriterBusy));
+		suite->addTest(new CppUnit::TestCaller<IQSnapshotTest>("FrameAnnotation", &IQSnapshotTest::testFrameAnnotation));
+		suite->addTest(new CppUnit::TestCaller<IQSnapshotTest>("Truncated", &IQSnapshotTest::testTruncated));
+		return suite;
+	}
+
+};
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(IQSnapshotTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
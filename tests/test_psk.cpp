@@ -0,0 +1,186 @@
+#include <iostream>
+#include <cmath>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <suo.hpp>
+#include <modem/mod_psk.hpp>
+#include <modem/demod_psk.hpp>
+
+#include "utils.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+/*
+ * PSKModulator -> PSKDemodulator loopback for BPSK, QPSK and 8PSK
+ */
+class PSKTest : public CppUnit::TestFixture
+{
+private:
+	const float sample_rate = 76800;
+	const float symbol_rate = 9600;
+	const size_t num_symbols = 4000;
+	const size_t settle_symbols = 400; // Symbols skipped while the loops settle
+
+	static unsigned int gray_encode(unsigned int x) { return x ^ (x >> 1); }
+	static unsigned int gray_decode(unsigned int x) {
+		for (unsigned int s = x >> 1; s != 0; s >>= 1)
+			x ^= s;
+		return x;
+	}
+
+	static SymbolGenerator yield_symbols(const SymbolVector& symbols) {
+		co_yield symbols;
+	}
+
+	/* Modulate the symbols, rotate the carrier phase, add noise and demodulate */
+	SymbolVector loopback(unsigned int bits_per_symbol, bool differential, const SymbolVector& symbols, float phase, float noise_std, CounterRNG& rng)
+	{
+		PSKModulator::Config mod_conf;
+		mod_conf.sample_rate = sample_rate;
+		mod_conf.symbol_rate = symbol_rate;
+		mod_conf.center_frequency = 0;
+		mod_conf.bits_per_symbol = bits_per_symbol;
+		mod_conf.differential = differential;
+
+		PSKModulator mod(mod_conf);
+		mod.generateSymbols.connect([&](Timestamp now) {
+			(void)now;
+			return yield_symbols(symbols);
+		});
+
+		PSKDemodulator::Config demod_conf;
+		demod_conf.sample_rate = sample_rate;
+		demod_conf.symbol_rate = symbol_rate;
+		demod_conf.center_frequency = 0;
+		demod_conf.bits_per_symbol = bits_per_symbol;
+		demod_conf.differential = differential;
+
+		PSKDemodulator demod(demod_conf);
+		SymbolVector received;
+		demod.sinkSymbol.connect([&](Symbol symbol, Timestamp now) {
+			(void)now;
+			received.push_back(symbol);
+		});
+
+		SampleVector samples, block;
+		block.reserve(4096);
+		SampleGenerator sample_gen = mod.generateSamples(0);
+		while (sample_gen.running()) {
+			sample_gen.sourceSamples(block);
+			samples.insert(samples.end(), block.begin(), block.end());
+		}
+		CPPUNIT_ASSERT(samples.size() >= num_symbols * sample_rate / symbol_rate);
+
+		const Sample rotation = polar(1.0f, phase);
+		for (Sample& s: samples)
+			s *= rotation;
+		if (noise_std > 0)
+			add_noise(samples, noise_std, rng);
+
+		demod.sinkSamples(samples, 0);
+		return received;
+	}
+
+	/* Find the lag between sent and received symbols and count the bit errors after the settling */
+	static Stats compare(const SymbolVector& expected, const SymbolVector& received, size_t settle) {
+		int best_lag = 0;
+		size_t best_matches = 0;
+		for (int lag = -32; lag <= 32; lag++) {
+			size_t matches = 0;
+			for (size_t i = settle; i < settle + 200; i++)
+				if (i + lag < received.size() && expected[i] == received[i + lag])
+					matches++;
+			if (matches > best_matches) {
+				best_matches = matches;
+				best_lag = lag;
+			}
+		}
+
+		Stats stats;
+		for (size_t i = settle; i < expected.size() - 8; i++) {
+			CPPUNIT_ASSERT(i + best_lag < received.size());
+			stats.total_bit_errors += __builtin_popcount(expected[i] ^ received[i + best_lag]);
+		}
+		return stats;
+	}
+
+	/* Approximate bit error rate of Gray coded coherent M-PSK */
+	static double theoretical_ber(unsigned int bits_per_symbol, float esn0) {
+		const unsigned int M = 1 << bits_per_symbol;
+		const double q = 0.5 * erfc(sqrt(esn0) * sin(M_PI / M));
+		return (M == 2) ? q : 2 * q / bits_per_symbol;
+	}
+
+	void runOrder(unsigned int bits_per_symbol)
+	{
+		const unsigned int M = 1 << bits_per_symbol;
+		const float sector = 2 * M_PI / M;
+		CounterRNG rng(1234, bits_per_symbol);
+
+		SymbolVector symbols;
+		for (size_t i = 0; i < num_symbols; i++)
+			symbols.push_back(rng.next() % M);
+
+		/* Gray mapping: Symbols come out as they went in */
+		SymbolVector received = loopback(bits_per_symbol, false, symbols, 0.0f, 0.0f, rng);
+		CPPUNIT_ASSERT_EQUAL(0U, compare(symbols, received, settle_symbols).total_bit_errors);
+
+		/* Phase ambiguity: Carrier rotated by one constellation step locks one step off.
+		 * Gray coding makes every symbol differ only by one bit. */
+		received = loopback(bits_per_symbol, false, symbols, sector + 0.1f, 0.0f, rng);
+		SymbolVector rotated;
+		for (Symbol s: symbols) {
+			rotated.push_back(gray_encode((gray_decode(s) + 1) % M));
+			CPPUNIT_ASSERT_EQUAL(1, __builtin_popcount(s ^ rotated.back()));
+		}
+		CPPUNIT_ASSERT_EQUAL(0U, compare(rotated, received, settle_symbols).total_bit_errors);
+
+		/* Differential coding resolves the ambiguity */
+		received = loopback(bits_per_symbol, true, symbols, sector + 0.1f, 0.0f, rng);
+		CPPUNIT_ASSERT_EQUAL(0U, compare(symbols, received, settle_symbols).total_bit_errors);
+
+		/* Bit error rate at fixed SNR. Differential decoding roughly doubles the errors. */
+		const float esn0_db[] = { 6.0f, 8.0f, 13.0f };
+		const float esn0 = pow(10.0f, esn0_db[bits_per_symbol - 1] / 10.0f);
+		const float noise_std = sqrt(sample_rate / symbol_rate / esn0);
+		received = loopback(bits_per_symbol, true, symbols, 0.5f, noise_std, rng);
+		Stats stats = compare(symbols, received, settle_symbols);
+		stats.total_bits = (num_symbols - settle_symbols - 8) * bits_per_symbol;
+		const double ber = stats.ber(), expected = 2 * theoretical_ber(bits_per_symbol, esn0);
+		cout << M << "-PSK Es/N0 " << esn0_db[bits_per_symbol - 1] << " dB: BER " << ber << ", theoretical " << expected << endl;
+		CPPUNIT_ASSERT(ber < 2 * expected);
+	}
+
+public:
+
+	void testBPSK() { runOrder(1); }
+	void testQPSK() { runOrder(2); }
+	void test8PSK() { runOrder(3); }
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("PSKTest");
+		suite->addTest(new CppUnit::TestCaller<PSKTest>("BPSK loopback", &PSKTest::testBPSK));
+		suite->addTest(new CppUnit::TestCaller<PSKTest>("QPSK loopback", &PSKTest::testQPSK));
+		suite->addTest(new CppUnit::TestCaller<PSKTest>("8PSK loopback", &PSKTest::test8PSK));
+		return suite;
+	}
+
+};
+
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(PSKTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
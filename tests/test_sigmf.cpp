@@ -0,0 +1,215 @@
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+
+#include "suo.hpp"
+#include "signal-io/sigmf.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class SigMFTest : public CppUnit::TestFixture
+{
+private:
+	string filename;
+
+	/* Test signal with sample index encoded in the phase */
+	static Sample signal(size_t i) {
+		return polar(0.5f, (float)(0.001 * i));
+	}
+
+	void record(SigMFWriter& writer, size_t first, size_t buffers, size_t len, Timestamp start, double sample_ns) {
+		SampleVector samples(len);
+		for (size_t b = 0; b < buffers; b++) {
+			for (size_t i = 0; i < len; i++)
+				samples[i] = signal(first + b * len + i);
+			writer.sinkSamples(samples, start + (Timestamp)llround(b * len * sample_ns));
+		}
+	}
+
+public:
+
+	void setUp() {
+		filename = "/tmp/suo_test_sigmf_" + to_string(getpid());
+	}
+
+	void tearDown() {
+		remove((filename + ".sigmf-data").c_str());
+		remove((filename + ".sigmf-meta").c_str());
+	}
+
+	void testRoundTrip(const string& datatype, float tolerance)
+	{
+		const Timestamp start = 123456789;
+		{
+			SigMFWriter::Config conf;
+			conf.filename = filename;
+			conf.datatype = datatype;
+			conf.sample_rate = 250e3;
+			conf.center_frequency = 437e6;
+			conf.epoch = 1700000000000000000;
+			SigMFWriter writer(conf);
+			record(writer, 0, 10, 1000, start, 4000);
+			CPPUNIT_ASSERT_EQUAL((uint64_t)10000, writer.getSampleCount());
+		}
+
+		SigMFReader::Config conf;
+		conf.filename = filename + ".sigmf-meta";
+		conf.buffer_len = 768;
+		SigMFReader reader(conf);
+		CPPUNIT_ASSERT_EQUAL(datatype, reader.getDatatype());
+		CPPUNIT_ASSERT_EQUAL(250e3, reader.getSampleRate());
+		CPPUNIT_ASSERT_EQUAL((uint64_t)10000, reader.getSampleCount());
+		CPPUNIT_ASSERT_EQUAL((size_t)1, reader.getCaptures().size());
+		CPPUNIT_ASSERT_EQUAL(437e6, reader.getCaptures()[0].frequency);
+		CPPUNIT_ASSERT_EQUAL((Timestamp)1700000000000000000 + start, reader.getCaptures()[0].datetime);
+
+		size_t index = 0;
+		reader.sinkSamples.connect([&](const SampleVector& samples, Timestamp now) {
+			CPPUNIT_ASSERT_EQUAL(samples.timestamp, now);
+			CPPUNIT_ASSERT_EQUAL(start + (Timestamp)(index * 4000), now);
+			for (const Sample& s: samples) {
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0f, abs(s - signal(index)), tolerance);
+				index++;
+			}
+		});
+		reader.execute();
+		CPPUNIT_ASSERT_EQUAL((size_t)10000, index);
+	}
+
+	void testRoundTripCF32() {
+		testRoundTrip("cf32_le", 0.0f);
+	}
+
+	void testRoundTripCI16() {
+		testRoundTrip("ci16_le", 1e-4f);
+	}
+
+	void testCaptures()
+	{
+		{
+			SigMFWriter::Config conf;
+			conf.filename = filename;
+			conf.sample_rate = 1e6;
+			SigMFWriter writer(conf);
+			record(writer, 0, 5, 1000, 1000000, 1000);
+			record(writer, 5000, 5, 1000, 50000000, 1000); // Samples lost
+			CPPUNIT_ASSERT_EQUAL((uint64_t)5500, writer.sampleIndex(50500000));
+		}
+
+		SigMFReader::Config conf;
+		conf.filename = filename;
+		conf.buffer_len = 4096;
+		SigMFReader reader(conf);
+		CPPUNIT_ASSERT_EQUAL((size_t)2, reader.getCaptures().size());
+		CPPUNIT_ASSERT_EQUAL((uint64_t)5000, reader.getCaptures()[1].sample_start);
+		CPPUNIT_ASSERT_EQUAL((Timestamp)50000000, reader.getCaptures()[1].timestamp);
+		CPPUNIT_ASSERT_EQUAL((Timestamp)5999000, reader.sampleTimestamp(4999));
+		CPPUNIT_ASSERT_EQUAL((Timestamp)50000000, reader.sampleTimestamp(5000));
+
+		/* Buffers don't span over the capture boundary */
+		vector<pair<Timestamp, size_t>> buffers;
+		reader.sinkSamples.connect([&](const SampleVector& samples, Timestamp now) {
+			buffers.push_back({ now, samples.size() });
+		});
+		reader.execute();
+		CPPUNIT_ASSERT_EQUAL((size_t)4, buffers.size());
+		CPPUNIT_ASSERT_EQUAL((Timestamp)1000000, buffers[0].first);
+		CPPUNIT_ASSERT_EQUAL((size_t)904, buffers[1].second);
+		CPPUNIT_ASSERT_EQUAL((Timestamp)50000000, buffers[2].first);
+		CPPUNIT_ASSERT_EQUAL((Timestamp)54096000, buffers[3].first);
+	}
+
+	void testSegments()
+	{
+		const double sample_rate = 100e3;
+		Frame frame(16);
+		{
+			SigMFWriter::Config conf;
+			conf.filename = filename;
+			conf.sample_rate = sample_rate;
+			conf.annotation_duration = 0.01f;
+			SigMFWriter writer(conf);
+			record(writer, 0, 100, 1000, 0, 10000);
+
+			/* Frames are annotated from their syncword */
+			frame.data.assign(16, 0xAB);
+			frame.setMetadata("sync_timestamp", (Timestamp)200000000); // 20000 samples
+			writer.sinkFrame(frame, 300000000);
+			frame.setMetadata("sync_timestamp", (Timestamp)700000000);
+			writer.sinkFrame(frame, 800000000);
+			frame.setMetadata("sync_timestamp", (Timestamp)705000000); // Overlaps with the previous
+			writer.sinkFrame(frame, 805000000);
+		}
+
+		SigMFReader::Config conf;
+		conf.filename = filename;
+		conf.segment_label = "frame";
+		conf.segment_margin = 0.005f;
+		SigMFReader reader(conf);
+
+		const vector<SigMFAnnotation>& annotations = reader.getAnnotations();
+		CPPUNIT_ASSERT_EQUAL((size_t)3, annotations.size());
+		CPPUNIT_ASSERT_EQUAL((uint64_t)20000, annotations[0].sample_start);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)1000, annotations[0].sample_count);
+		Frame decoded = Frame::deserialize_from_json(annotations[0].frame);
+		CPPUNIT_ASSERT(decoded.data == frame.data);
+
+		auto segments = reader.getSegments();
+		CPPUNIT_ASSERT_EQUAL((size_t)2, segments.size());
+		CPPUNIT_ASSERT_EQUAL((uint64_t)19500, segments[0].first);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)2000, segments[0].second);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)69500, segments[1].first);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)2500, segments[1].second);
+
+		/* Replayed segments have the original timestamps */
+		size_t total = 0;
+		reader.sinkSamples.connect([&](const SampleVector& samples, Timestamp now) {
+			const size_t index = now / 10000;
+			CPPUNIT_ASSERT(abs(samples[0] - signal(index)) < 1e-6f);
+			total += samples.size();
+		});
+		reader.execute();
+		CPPUNIT_ASSERT_EQUAL((size_t)4500, total);
+	}
+
+	void testDatetime()
+	{
+		const Timestamp t = 1700000000123456789;
+		const string str = sigmf_format_datetime(t);
+		CPPUNIT_ASSERT_EQUAL(string("2023-11-14T22:13:20.123456789Z"), str);
+		CPPUNIT_ASSERT_EQUAL(t, sigmf_parse_datetime(str));
+		CPPUNIT_ASSERT_EQUAL((Timestamp)1700000000500000000, sigmf_parse_datetime("2023-11-14T22:13:20.5Z"));
+		CPPUNIT_ASSERT_EQUAL((Timestamp)1700000000000000000, sigmf_parse_datetime("2023-11-14T22:13:20Z"));
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("SigMFTest");
+		suite->addTest(new CppUnit::TestCaller<SigMFTest>("RoundTripCF32", &SigMFTest::testRoundTripCF32));
+		suite->addTest(new CppUnit::TestCaller<SigMFTest>("RoundTripCI16", &SigMFTest::testRoundTripCI16));
+		suite->addTest(new CppUnit::TestCaller<SigMFTest>("Captures", &SigMFTest::testCaptures));
+		suite->addTest(new CppUnit::TestCaller<SigMFTest>("Segments", &SigMFTest::testSegments));
+		suite->addTest(new CppUnit::TestCaller<SigMFTest>("Datetime", &SigMFTest::testDatetime));
+		return suite;
+	}
+
+};
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(SigMFTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+
+#include "suo.hpp"
+#include "modem/energy_squelch.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class SquelchTest : public CppUnit::TestFixture
+{
+private:
+	mt19937 rng;
+
+public:
+
+	void setUp() {
+		rng.seed(4321);
+	}
+
+	void burstTest()
+	{
+		EnergySquelch::Config conf;
+		conf.sample_rate = 100e3;
+		conf.block_size = 100;
+		conf.pretrigger_time = 0.005;
+		conf.hang_time = 0.002;
+		EnergySquelch squelch(conf);
+
+		const Timestamp sample_ns = 1e9 / conf.sample_rate;
+		const size_t burst_start = 60000, burst_len = 20000, total_len = 150000;
+
+		/* Collect the gated output */
+		vector<pair<Timestamp, size_t>> segments; // (first sample time, length)
+		size_t tone_samples = 0;
+		squelch.gatedSamples.connect([&](const SampleVector& samples, Timestamp now) {
+			if (!segments.empty() && segments.back().first + segments.back().second * sample_ns == now)
+				segments.back().second += samples.size();
+			else
+				segments.push_back(make_pair(now, samples.size()));
+			for (const Sample& s: samples)
+				if (abs(s) > 2.0f)
+					tone_samples++;
+		});
+
+		unsigned int opened = 0, closed = 0;
+		squelch.squelchChanged.connect([&](bool open, Timestamp) {
+			if (open) opened++; else closed++;
+		});
+
+		/* Noise + strong burst + noise */
+		normal_distribution<float> noise(0.0f, 0.1f);
+		SampleVector buffer(1000);
+		for (size_t i = 0; i < total_len; i += buffer.capacity()) {
+			buffer.clear();
+			for (size_t j = i; j < i + buffer.capacity(); j++) {
+				Sample s(noise(rng), noise(rng));
+				if (j >= burst_start && j < burst_start + burst_len)
+					s += polar(5.0f, 0.01f * j);
+				buffer.push_back(s);
+			}
+			squelch.sinkSamples(buffer, i * sample_ns);
+		}
+
+		CPPUNIT_ASSERT_EQUAL(1U, opened);
+		CPPUNIT_ASSERT_EQUAL(1U, closed);
+		CPPUNIT_ASSERT_EQUAL((size_t)1, segments.size());
+		CPPUNIT_ASSERT(squelch.isOpen() == false);
+
+		// Every burst sample was passed including the pre-trigger samples before it
+		const size_t first_sample = segments[0].first / sample_ns;
+		const size_t pretrigger = conf.pretrigger_time * conf.sample_rate;
+		CPPUNIT_ASSERT_EQUAL(burst_len, tone_samples);
+		CPPUNIT_ASSERT(first_sample <= burst_start - pretrigger + conf.block_size);
+		CPPUNIT_ASSERT(first_sample >= burst_start - pretrigger - conf.block_size);
+		CPPUNIT_ASSERT(first_sample + segments[0].second >= burst_start + burst_len);
+
+		// Only a small fraction of the samples is passed to the demodulator
+		CPPUNIT_ASSERT(squelch.dutyCycle() > (float)burst_len / total_len);
+		CPPUNIT_ASSERT(squelch.dutyCycle() < 0.2f);
+	}
+
+	void noiseTest()
+	{
+		EnergySquelch::Config conf;
+		conf.sample_rate = 100e3;
+		EnergySquelch squelch(conf);
+
+		size_t passed = 0;
+		squelch.gatedSamples.connect([&](const SampleVector& samples, Timestamp) { passed += samples.size(); });
+
+		/* Slowly varying noise level should not open the squelch */
+		normal_distribution<float> noise(0.0f, 1.0f);
+		SampleVector buffer(1000);
+		for (size_t i = 0; i < 500; i++) {
+			float level = 1.0f + 0.5f * sinf(i * 0.01f);
+			buffer.clear();
+			for (size_t j = 0; j < buffer.capacity(); j++)
+				buffer.push_back(level * Sample(noise(rng), noise(rng)));
+			squelch.sinkSamples(buffer, 0);
+		}
+
+		CPPUNIT_ASSERT_EQUAL((size_t)0, passed);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, squelch.dutyCycle(), 1e-9);
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("SquelchTest");
+		suite->addTest(new CppUnit::TestCaller<SquelchTest>("Burst", &SquelchTest::burstTest));
+		suite->addTest(new CppUnit::TestCaller<SquelchTest>("Noise", &SquelchTest::noiseTest));
+		return suite;
+	}
+
+};
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(SquelchTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
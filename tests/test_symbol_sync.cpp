@@ -0,0 +1,157 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+
+#include "suo.hpp"
+#include "modem/symbol_sync.hpp"
+
+using namespace std;
+using namespace suo;
+
+
+class SymbolSyncTest : public CppUnit::TestFixture
+{
+private:
+	mt19937 rng;
+
+	const float samples_per_symbol = 4.3f;
+	const float timing_offset = 1.7f;
+
+	/* Raised cosine pulse spanning two symbols */
+	static float pulse(float t) {
+		return (fabs(t) < 1.0f) ? 0.5f * (1.0f + cosf(M_PI * t)) : 0.0f;
+	}
+
+	/* Generate noisy pulse train. Symbol k is centered at k * samples_per_symbol + timing_offset. */
+	template<typename T>
+	vector<T> generateSignal(const vector<T>& symbols) {
+		const size_t len = symbols.size() * samples_per_symbol + 20;
+		normal_distribution<float> noise(0.0f, 0.1f);
+		vector<T> signal(len);
+		for (size_t n = 0; n < len; n++) {
+			const long first = max(0L, (long)ceilf((n - timing_offset) / samples_per_symbol - 1));
+			for (long k = first; k < (long)symbols.size() && k * samples_per_symbol + timing_offset < n + samples_per_symbol; k++)
+				signal[n] += symbols[k] * pulse((n - k * samples_per_symbol - timing_offset) / samples_per_symbol);
+			if constexpr (is_same<T, Sample>::value)
+				signal[n] = 3.0f * (signal[n] + Sample(noise(rng), noise(rng)));
+			else
+				signal[n] = 3.0f * (signal[n] + noise(rng));
+		}
+		return signal;
+	}
+
+	/* Run the synchronizer in uneven buffers and check the decisions and timing after the acquisition */
+	template<typename T>
+	void runSync(const typename SymbolSync<T>::Config& conf, const vector<T>& symbols) {
+		const vector<T> signal = generateSignal(symbols);
+		SymbolSync<T> sync(conf);
+
+		vector<T> synced;
+		vector<float> positions;
+		size_t checked = 0, errors = 0;
+		float max_timing_error = 0.0f;
+		for (size_t i = 0; i < signal.size(); i += 333) {
+			sync.execute(&signal[i], min<size_t>(333, signal.size() - i), synced, positions);
+			CPPUNIT_ASSERT_EQUAL(synced.size(), positions.size());
+			if (i < signal.size() / 3)
+				continue;
+
+			for (size_t j = 0; j < synced.size(); j++) {
+				/* Find the transmitted symbol from the reported position */
+				const float position = i + positions[j];
+				const long k = lroundf((position - timing_offset) / samples_per_symbol);
+				if (k < 0 || k >= (long)symbols.size())
+					continue;
+				checked++;
+				max_timing_error = max(max_timing_error, abs(position - (k * samples_per_symbol + timing_offset)));
+				if (real(synced[j] * conj(symbols[k])) < 0)
+					errors++;
+			}
+		}
+
+		CPPUNIT_ASSERT(checked > symbols.size() / 2);
+		CPPUNIT_ASSERT_EQUAL((size_t)0, errors);
+		CPPUNIT_ASSERT(max_timing_error < 0.5f);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(samples_per_symbol, sync.getSamplesPerSymbol(), 0.02);
+	}
+
+	vector<float> randomSymbols(size_t len) {
+		vector<float> symbols;
+		for (size_t i = 0; i < len; i++)
+			symbols.push_back((rng() & 1) ? 1.0f : -1.0f);
+		return symbols;
+	}
+
+public:
+
+	void setUp() {
+		rng.seed(2468);
+	}
+
+	void testGardner() {
+		SymbolSync<float>::Config conf;
+		conf.detector = SymbolSync<float>::Gardner;
+		conf.samples_per_symbol = 1.005f * samples_per_symbol; // Initial rate error
+		conf.bandwidth = 0.02f;
+		runSync<float>(conf, randomSymbols(3000));
+	}
+
+	void testMuellerMuller() {
+		SymbolSync<float>::Config conf;
+		conf.detector = SymbolSync<float>::MuellerMuller;
+		conf.samples_per_symbol = 0.995f * samples_per_symbol;
+		conf.bandwidth = 0.01f;
+		runSync<float>(conf, randomSymbols(3000));
+	}
+
+	void testPolyphase() {
+		SymbolSync<float>::Config conf;
+		conf.detector = SymbolSync<float>::Polyphase;
+		conf.samples_per_symbol = samples_per_symbol;
+		conf.bandwidth = 0.02f;
+		const int half_len = 2 * samples_per_symbol;
+		for (int n = -half_len; n <= half_len; n++)
+			conf.filter.push_back(pulse(n / samples_per_symbol) / samples_per_symbol);
+		runSync<float>(conf, randomSymbols(3000));
+	}
+
+	void testComplex() {
+		/* QPSK symbols */
+		vector<Sample> symbols;
+		for (size_t i = 0; i < 3000; i++)
+			symbols.push_back(Sample((rng() & 1) ? 1.0f : -1.0f, (rng() & 1) ? 1.0f : -1.0f));
+
+		SymbolSync<Sample>::Config conf;
+		conf.detector = SymbolSync<Sample>::Gardner;
+		conf.samples_per_symbol = samples_per_symbol;
+		conf.bandwidth = 0.02f;
+		runSync<Sample>(conf, symbols);
+	}
+
+	static CppUnit::Test* suite()
+	{
+		CppUnit::TestSuite* suite = new CppUnit::TestSuite("SymbolSyncTest");
+		suite->addTest(new CppUnit::TestCaller<SymbolSyncTest>("Gardner", &SymbolSyncTest::testGardner));
+		suite->addTest(new CppUnit::TestCaller<SymbolSyncTest>("MuellerMuller", &SymbolSyncTest::testMuellerMuller));
+		suite->addTest(new CppUnit::TestCaller<SymbolSyncTest>("Polyphase", &SymbolSyncTest::testPolyphase));
+		suite->addTest(new CppUnit::TestCaller<SymbolSyncTest>("Complex", &SymbolSyncTest::testComplex));
+		return suite;
+	}
+
+};
+
+#ifndef COMBINED_TEST
+int main(int argc, char** argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(SymbolSyncTest::suite());
+	runner.run();
+	return 0;
+}
+#endif
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <bit> // popcount
+#include <thread>
 
 #include <cppunit/TestFixture.h>
 #include <cppunit/TestAssert.h>
@@ -10,11 +11,56 @@
 #include "suo.hpp"
 #include "framing/utils.hpp"
 #include "coding/golay24.hpp"
+#include "misc/metrics.hpp"
+#include "tracer.hpp"
+#include "pipeline.hpp"
+
+#include "json.hpp"
 
 using namespace std;
 using namespace suo;
 
 
+/* Dummy block for the tracing test */
+struct TraceTestBlock {
+	unsigned int calls = 0;
+	void sinkValue(int value) { calls += value; }
+};
+
+/* Dummy blocks for the pipeline test */
+struct PipelineSource {
+	Port<Symbol, Timestamp> sinkSymbol;
+	Port<SoftSymbol, Timestamp> sinkSoftSymbol;
+};
+
+class PipelineBytePacker : public Block {
+public:
+	void sinkSymbol(Symbol bit, Timestamp now) {
+		frame.data.push_back(bit);
+		if (frame.data.size() == 4) {
+			sinkFrame.emit(frame, now);
+			frame.clear();
+		}
+	}
+	void sinkSoftSymbol(SoftSymbol, Timestamp) { soft_symbols++; }
+
+	Port<const Frame&, Timestamp> sinkFrame;
+	Frame frame;
+	unsigned int soft_symbols = 0;
+};
+
+class PipelineFrameSink : public Block {
+public:
+	void sinkFrame(const Frame& frame, Timestamp) { frames++; bytes += frame.data.size(); }
+	unsigned int frames = 0, bytes = 0;
+};
+
+static_assert(pipeline_detail::SymbolLink<PipelineSource, PipelineBytePacker>);
+static_assert(pipeline_detail::FrameLink<PipelineBytePacker, PipelineFrameSink>);
+static_assert(pipeline_detail::SymbolLink<PipelineSource, PipelineFrameSink> == false); // Only the Block's default sink
+static_assert(pipeline_detail::FrameLink<PipelineSource, PipelineFrameSink> == false);
+
+
 class FrameTest: public CppUnit::TestFixture
 {
 private:
@@ -122,6 +168,66 @@ public:
 	}
 
 
+	/* Reference serializer building the full nlohmann DOM */
+	static std::string reference_json(const Frame& frame) {
+		nlohmann::json dict = nlohmann::json::object();
+		dict["id"] = frame.id;
+		nlohmann::json meta_dict = nlohmann::json::object();
+		for (auto metadata : frame.metadata)
+			std::visit([&](auto const& a) { meta_dict[metadata.first] = a; }, metadata.second);
+		dict["metadata"] = meta_dict;
+		dict["timestamp"] = frame.timestamp;
+		std::string hex;
+		for (Byte b : frame.data) {
+			char buf[3];
+			snprintf(buf, sizeof(buf), "%02x", b);
+			hex += buf;
+		}
+		dict["data"] = hex;
+		return dict.dump();
+	}
+
+	/* Compare the streaming JSON serializer against nlohmann's DOM output */
+	void json_serialization_test() {
+
+		std::string buffer;
+		for (unsigned int round = 0; round < 1000; round++) {
+
+			Frame frame;
+			frame.id = rand();
+			frame.timestamp = ((Timestamp)rand() << 32) | rand();
+			frame.data.resize(rand() % 256);
+			for (size_t i = 0; i < frame.size(); i++)
+				frame.data[i] = rand() % 256;
+
+			frame.setMetadata("int", -rand());
+			frame.setMetadata("unsigned", (unsigned int)rand());
+			frame.setMetadata("float", (float)rand() / RAND_MAX - 0.5f);
+			frame.setMetadata("double", 1e-3 * rand());
+			frame.setMetadata("timestamp", frame.timestamp);
+			frame.setMetadata("string", std::string("\"esc\\aped\"\n\t\x01 \xc3\xa4"));
+
+			frame.serialize_to_json(buffer);
+			CPPUNIT_ASSERT_EQUAL(reference_json(frame), buffer);
+
+			Frame parsed = Frame::deserialize_from_json(buffer);
+			CPPUNIT_ASSERT(parsed.id == frame.id);
+			CPPUNIT_ASSERT(parsed.timestamp == frame.timestamp);
+			CPPUNIT_ASSERT(parsed.data == frame.data);
+			CPPUNIT_ASSERT(parsed.metadata.size() == frame.metadata.size());
+			CPPUNIT_ASSERT(std::get<std::string>(parsed.metadata["string"]) == std::get<std::string>(frame.metadata["string"]));
+			CPPUNIT_ASSERT(std::get<float>(parsed.metadata["float"]) == std::get<float>(frame.metadata["float"]));
+		}
+
+		/* Unknown fields are ignored and missing data makes a control frame */
+		Frame frame = Frame::deserialize_from_json("{\"extra\":{\"a\":[1,{\"b\":2}]},\"id\":7,\"timestamp\":5}");
+		CPPUNIT_ASSERT(frame.id == 7);
+		CPPUNIT_ASSERT(frame.timestamp == 5);
+		CPPUNIT_ASSERT((frame.flags & Frame::Flags::has_timestamp) == Frame::Flags::has_timestamp);
+		CPPUNIT_ASSERT((frame.flags & Frame::Flags::control_frame) == Frame::Flags::control_frame);
+	}
+
+
 	void test_bit_operations() {
 
 		/*
@@ -234,15 +340,151 @@ public:
 	}
 
 
+	/* Test performance counters and the Prometheus formatting */
+	void test_metrics() {
+		MetricsRegistry registry;
+		MetricLabels handle = registry.blockLabels("TestBlock");
+		const string labels = handle.str();
+		CPPUNIT_ASSERT_EQUAL(string("block=\"TestBlock\",instance=\"0\""), labels);
+		CPPUNIT_ASSERT_EQUAL(string("block=\"TestBlock\",instance=\"1\""), registry.blockLabels("TestBlock").str());
+
+		Counter& counter = registry.counter("suo_test_total", "Test counter", labels);
+		CPPUNIT_ASSERT(&counter == &registry.counter("suo_test_total", "Test counter", labels));
+		Histogram& histogram = registry.histogram("suo_test_ns", "Test histogram", labels, { 10, 100 });
+
+		// Disabled metrics are not updated
+		metrics_enabled = false;
+		counter.inc(5);
+		histogram.observe(1);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)0, counter.value());
+		CPPUNIT_ASSERT_EQUAL((uint64_t)0, histogram.snapshot().count);
+
+		// Updates from multiple threads are summed
+		metrics_enabled = true;
+		vector<thread> threads;
+		for (unsigned int t = 0; t < 4; t++)
+			threads.emplace_back([&]() {
+				for (unsigned int i = 0; i < 1000; i++)
+					counter.inc();
+			});
+		for (thread& t: threads)
+			t.join();
+		CPPUNIT_ASSERT_EQUAL((uint64_t)4000, counter.value());
+
+		histogram.observe(5);
+		histogram.observe(10);
+		histogram.observe(50);
+		histogram.observe(500);
+		Histogram::Snapshot snap = histogram.snapshot();
+		CPPUNIT_ASSERT_EQUAL((size_t)3, snap.buckets.size());
+		CPPUNIT_ASSERT_EQUAL((uint64_t)2, snap.buckets[0]);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)3, snap.buckets[1]);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)4, snap.buckets[2]);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)4, snap.count);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(565.0, snap.sum, 1e-9);
+
+		const string text = registry.formatPrometheus();
+		CPPUNIT_ASSERT(text.find("# TYPE suo_test_total counter\n") != string::npos);
+		CPPUNIT_ASSERT(text.find("suo_test_total{" + labels + "} 4000\n") != string::npos);
+		CPPUNIT_ASSERT(text.find("suo_test_ns_bucket{" + labels + ",le=\"100\"} 3\n") != string::npos);
+		CPPUNIT_ASSERT(text.find("suo_test_ns_bucket{" + labels + ",le=\"+Inf\"} 4\n") != string::npos);
+		CPPUNIT_ASSERT(text.find("suo_test_ns_count{" + labels + "} 4\n") != string::npos);
+
+		// Metric name cannot change its type
+		CPPUNIT_ASSERT_THROW(registry.histogram("suo_test_total", "", labels), SuoError);
+		metrics_enabled = false;
+
+		// Series of a destroyed block are removed
+		{
+			MetricLabels other = registry.blockLabels("TestBlock");
+			registry.counter("suo_test_total", "Test counter", other).inc();
+			CPPUNIT_ASSERT(registry.formatPrometheus().find(other.str()) != string::npos);
+		}
+		CPPUNIT_ASSERT(registry.formatPrometheus().find("instance=\"2\"") == string::npos);
+		handle = MetricLabels();
+		CPPUNIT_ASSERT_EQUAL(string(), registry.formatPrometheus());
+	}
+
+
+	/* Test timeline tracing of port emissions */
+	void test_tracing() {
+		TraceTestBlock block;
+		Port<int> port;
+		port.connect_member(&block, &TraceTestBlock::sinkValue);
+
+		// Nothing is recorded while tracing is disabled
+		Tracer& tracer = Tracer::getDefault();
+		port.emit(1);
+		CPPUNIT_ASSERT_EQUAL(1U, block.calls);
+
+		tracer.start(4);
+		for (int i = 0; i < 10; i++)
+			port.emit(1);
+		thread([&]() { port.emit(1); }).join();
+		tracer.stop();
+		port.emit(1);
+		CPPUNIT_ASSERT_EQUAL(13U, block.calls);
+
+		// The ring buffer keeps only the latest events of each thread
+		nlohmann::json trace = nlohmann::json::parse(tracer.formatChromeTrace());
+		unsigned int events = 0, threads = 0;
+		for (const auto& ev: trace["traceEvents"]) {
+			if (ev["ph"] == "M") {
+				threads++;
+				continue;
+			}
+			CPPUNIT_ASSERT_EQUAL(string("X"), ev["ph"].get<string>());
+			CPPUNIT_ASSERT_EQUAL(string("TraceTestBlock"), ev["name"].get<string>());
+			CPPUNIT_ASSERT(ev["dur"].get<double>() >= 0.0);
+			events++;
+		}
+		CPPUNIT_ASSERT_EQUAL(2U, threads);
+		CPPUNIT_ASSERT_EQUAL(5U, events);
+
+		tracer.clear();
+		CPPUNIT_ASSERT_EQUAL(string("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[]}\n"), tracer.formatChromeTrace());
+	}
+
+
+	/* Test compile-time pipeline composition */
+	void test_pipeline() {
+		PipelineSource source;
+		PipelineBytePacker packer;
+		PipelineFrameSink sink;
+		pipeline(source, packer, sink);
+
+		// Static connections coexist with runtime connections
+		unsigned int runtime_calls = 0;
+		source.sinkSymbol.connect([&](Symbol, Timestamp) { runtime_calls++; });
+
+		for (unsigned int i = 0; i < 10; i++)
+			source.sinkSymbol.emit(i & 1, i);
+		source.sinkSoftSymbol.emit(0.5, 0);
+
+		CPPUNIT_ASSERT_EQUAL(10U, runtime_calls);
+		CPPUNIT_ASSERT_EQUAL(2U, sink.frames);
+		CPPUNIT_ASSERT_EQUAL(8U, sink.bytes);
+		CPPUNIT_ASSERT_EQUAL((size_t)2, packer.frame.data.size());
+
+		// Soft symbols are linked only when there's no hard symbol link
+		CPPUNIT_ASSERT_EQUAL(0U, packer.soft_symbols);
+	}
+
+
+
 	static CppUnit::Test* suite()
 	{
 		CppUnit::TestSuite* suite = new CppUnit::TestSuite("FrameTest");
 		suite->addTest(new CppUnit::TestCaller<FrameTest>("Metadata", &FrameTest::testMetadata));
 		suite->addTest(new CppUnit::TestCaller<FrameTest>("JSON parsing", &FrameTest::json_parsing_test));
+		suite->addTest(new CppUnit::TestCaller<FrameTest>("JSON serialization", &FrameTest::json_serialization_test));
 		//suite->addTest(new CppUnit::TestCaller<FrameTest>("Bit operations", &FrameTest::test_bit_operations));
 		suite->addTest(new CppUnit::TestCaller<FrameTest>("Bit Parity Test", &FrameTest::test_bit_parity));
 		suite->addTest(new CppUnit::TestCaller<FrameTest>("Bit Reverse Test", &FrameTest::test_reverse_bits));
 		suite->addTest(new CppUnit::TestCaller<FrameTest>("Golay24 Test", &FrameTest::test_golay24));
+		suite->addTest(new CppUnit::TestCaller<FrameTest>("Metrics Test", &FrameTest::test_metrics));
+		suite->addTest(new CppUnit::TestCaller<FrameTest>("Tracing Test", &FrameTest::test_tracing));
+		suite->addTest(new CppUnit::TestCaller<FrameTest>("Pipeline Test", &FrameTest::test_pipeline));
 		return suite;
 	}
 
@@ -1,6 +1,10 @@
 #include "utils.hpp"
 #include <iostream>
+#include <thread>
+#include <mutex>
+#include <exception>
 #include <liquid/liquid.h>
+#include "misc/gaussian_noise.hpp"
 
 using namespace std;
 using namespace suo;
@@ -21,9 +25,22 @@ double Stats::ber() const {
 	return ((double)total_bit_errors / (double)total_bits);
 }
 
+double Stats::fer() const {
+	return ((double)frame_errors / (double)total_frames);
+}
+
+Stats& Stats::operator+=(const Stats& other) {
+	frame_errors += other.frame_errors;
+	total_frames += other.total_frames;
+	total_bit_errors += other.total_bit_errors;
+	total_bits += other.total_bits;
+	return *this;
+}
+
 std::ostream& suo::operator<<(std::ostream& _stream, const Stats& stats) {
 	std::ostream stream(_stream.rdbuf());
 	stream << "    Total frames: " << stats.total_frames << endl;
+	stream << "    Frame errors: " << stats.frame_errors << endl;
 	stream << "Total bit errors: " << stats.total_bit_errors << endl;
 	stream << "      Total bits: " << stats.total_bits << endl;
 	stream << "             BER: " << scientific << stats.ber() << endl;
@@ -31,16 +48,66 @@ std::ostream& suo::operator<<(std::ostream& _stream, const Stats& stats) {
 } 
 
 
+/* SplitMix64 finalizer */
+static inline uint64_t mix64(uint64_t z) {
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+CounterRNG::CounterRNG(uint64_t seed, uint64_t stream, uint64_t substream) :
+	counter(0), spare(0.0f), has_spare(false)
+{
+	key = mix64(mix64(mix64(seed) + stream) + substream);
+}
+
+uint64_t CounterRNG::next() {
+	return mix64(key + 0x9E3779B97F4A7C15ULL * ++counter);
+}
+
+float CounterRNG::uniform() {
+	return (next() >> 40) * 0x1.0p-24f;
+}
+
+float CounterRNG::normal() {
+	if (has_spare) {
+		has_spare = false;
+		return spare;
+	}
+
+	/* Box-Muller transform */
+	const uint64_t r = next();
+	const float u1 = ((r >> 40) + 1) * 0x1.0p-24f; // (0, 1]
+	const float u2 = (r & 0xFFFFFF) * 0x1.0p-24f;  // [0, 1)
+	const float mag = sqrtf(-2.0f * logf(u1));
+	spare = mag * sinf(2 * M_PIf * u2);
+	has_spare = true;
+	return mag * cosf(2 * M_PIf * u2);
+}
+
+
+/* Noise generator of the thread for the unseeded functions. Seeded from rand() so that srand() applies. */
+static GaussianNoise& thread_noise() {
+	static thread_local GaussianNoise noise(((uint64_t)rand() << 32) ^ rand());
+	return noise;
+}
+
 void suo::generate_noise(SampleVector& samples, float noise_std, unsigned int noise_samples) {
-	samples.clear();
-	samples.resize(noise_samples);
-	for (unsigned i = 0; i < noise_samples; i++)
-		cawgn(&samples[i], noise_std);
+	thread_noise().generate(samples, noise_samples, noise_std);
+}
+
+void suo::generate_noise(SampleVector& samples, float noise_std, unsigned int noise_samples, CounterRNG& rng) {
+	GaussianNoise noise(rng.next());
+	noise.generate(samples, noise_samples, noise_std);
 }
 
 void suo::add_noise(SampleVector& samples, float noise_std) {
-	for (unsigned i = 0; i < samples.size(); i++)
-		samples[i] += noise_std * Complex(randnf(), randnf()) * M_SQRT1_2f;
+	thread_noise().add(samples, noise_std);
+}
+
+void suo::add_noise(SampleVector& samples, float noise_std, CounterRNG& rng) {
+	GaussianNoise noise(rng.next());
+	noise.add(samples, noise_std);
 }
 
 void suo::delay_signal(float delay, SampleVector& samples)
@@ -70,6 +137,17 @@ void suo::count_bit_errors(Stats& stats, const Frame& transmit_frame, const Fram
 		bit_errors += __builtin_popcountll(transmit_frame[i] ^ received_frame[i]);
 	stats.total_bit_errors += bit_errors;
 	stats.total_bits += 8 * data_len;
+	stats.total_frames++;
+	if (bit_errors != 0 || transmit_frame.size() != received_frame.size())
+		stats.frame_errors++;
+}
+
+void suo::count_lost_frame(Stats& stats, const Frame& transmit_frame)
+{
+	stats.total_bit_errors += 8 * transmit_frame.size();
+	stats.total_bits += 8 * transmit_frame.size();
+	stats.total_frames++;
+	stats.frame_errors++;
 }
 
 
@@ -89,8 +167,141 @@ void EbN0Log::push_results(float snr, const Stats& stats) {
 }
 
 
+EbN0Sweep::Config::Config() {
+	snr_min = 0.0f;
+	snr_max = 20.0f;
+	num_snr = 21;
+	seed = 1;
+	target_frame_errors = 100;
+	max_frames = 100000;
+	batch_size = 50;
+	threads = 0;
+	verbose = true;
+}
+
+
+EbN0Sweep::EbN0Sweep(const Config& _conf) :
+	conf(_conf)
+{
+	if (conf.num_snr == 0)
+		throw SuoError("EbN0Sweep: No SNR points");
+	if (conf.batch_size == 0)
+		throw SuoError("EbN0Sweep: Zero batch size");
+	if (conf.max_frames == 0)
+		throw SuoError("EbN0Sweep: Zero max frames"); // Error free points would never finish
+	if (conf.threads == 0)
+		conf.threads = max(1u, std::thread::hardware_concurrency());
+}
+
+
+float EbN0Sweep::snr(unsigned int index) const {
+	if (conf.num_snr == 1)
+		return conf.snr_min;
+	return conf.snr_min + index * (conf.snr_max - conf.snr_min) / (conf.num_snr - 1);
+}
+
+
+std::vector<Stats> EbN0Sweep::run(const BatchFunction& batch) {
+
+	struct Point {
+		Stats stats;                        // Accumulated statistics of the merged batches
+		vector<Stats> batches;              // Results of the batches waiting to be merged
+		vector<bool> ready;
+		unsigned int dispatched = 0;        // Number of batches handed to the workers
+		unsigned int merged = 0;            // Number of batches accumulated to stats
+		bool finished = false;
+	};
+
+	vector<Point> points(conf.num_snr);
+	mutex lock;
+	exception_ptr error;
+
+	auto worker = [&]() {
+		unique_lock<mutex> guard(lock);
+		while (error == nullptr) {
+
+			/* Pick the unfinished point with least batches in flight */
+			Point* point = nullptr;
+			unsigned int s = 0;
+			for (unsigned int i = 0; i < points.size(); i++) {
+				if (points[i].finished)
+					continue;
+				if (point == nullptr || points[i].dispatched - points[i].merged < point->dispatched - point->merged) {
+					point = &points[i];
+					s = i;
+				}
+			}
+			if (point == nullptr)
+				break;
+
+			const unsigned int b = point->dispatched++;
+			guard.unlock();
+
+			Stats stats;
+			try {
+				CounterRNG rng(conf.seed, s, b);
+				batch(snr(s), conf.batch_size, rng, stats);
+			}
+			catch (...) {
+				guard.lock();
+				error = current_exception();
+				break;
+			}
+
+			guard.lock();
+			if (point->finished)
+				continue;
+
+			if (point->batches.size() <= b) {
+				point->batches.resize(b + 1);
+				point->ready.resize(b + 1, false);
+			}
+			point->batches[b] = stats;
+			point->ready[b] = true;
+
+			/* Merge the batches in order and check the stopping rule after each one */
+			while (point->merged < point->ready.size() && point->ready[point->merged]) {
+				point->stats += point->batches[point->merged++];
+				if ((conf.target_frame_errors > 0 && point->stats.frame_errors >= conf.target_frame_errors) ||
+					point->stats.total_frames >= conf.max_frames) {
+					point->finished = true;
+					break;
+				}
+			}
+
+			if (point->finished && conf.verbose) {
+				cout << endl;
+				cout << "             SNR: " << snr(s) << " dB" << endl;
+				cout << point->stats;
+			}
+		}
+	};
+
+	vector<thread> threads;
+	for (unsigned int i = 0; i < conf.threads; i++)
+		threads.emplace_back(worker);
+	for (thread& t : threads)
+		t.join();
+
+	if (error)
+		rethrow_exception(error);
+
+	vector<Stats> results;
+	for (const Point& point : points)
+		results.push_back(point.stats);
+	return results;
+}
+
+
+void EbN0Sweep::run(const BatchFunction& batch, EbN0Log& log) {
+	vector<Stats> results = run(batch);
+	for (unsigned int s = 0; s < results.size(); s++)
+		log.push_results(snr(s), results[s]);
+}
+
+
 RandomFrameGenerator::RandomFrameGenerator(unsigned int frame_len) :
-	random_generator(time(nullptr)),
+	rng(time(nullptr)),
 	frame_min_len(frame_len),
 	frame_max_len(frame_len),
 	frame_count(-1),
@@ -99,7 +310,7 @@ RandomFrameGenerator::RandomFrameGenerator(unsigned int frame_len) :
 { }
 
 RandomFrameGenerator::RandomFrameGenerator(unsigned int frame_min_len, unsigned int frame_max_len) :
-	random_generator(time(nullptr)),
+	rng(time(nullptr)),
 	frame_min_len(frame_min_len),
 	frame_max_len(frame_max_len),
 	frame_count(-1),
@@ -107,8 +318,8 @@ RandomFrameGenerator::RandomFrameGenerator(unsigned int frame_min_len, unsigned
 	verbose(false)
 { }
 
-void RandomFrameGenerator::set_seed(unsigned int seed) {
-	random_generator.seed(seed);
+void RandomFrameGenerator::set_seed(uint64_t seed, uint64_t stream) {
+	rng = CounterRNG(seed, stream);
 }
 
 void RandomFrameGenerator::set_release_time(Timestamp time) {
@@ -134,16 +345,13 @@ void RandomFrameGenerator::source_frame(Frame& frame_out, Timestamp now) {
 	if (frame_count > 0)
 		frame_count--;
 
-	std::uniform_int_distribution<> frame_len_distrib(frame_min_len, frame_max_len);
-	std::uniform_int_distribution<> byte_distrib(0, 255);
-
-	unsigned int frame_len = frame_len_distrib(random_generator);
+	unsigned int frame_len = frame_min_len + rng.next() % (frame_max_len - frame_min_len + 1);
 
 	frame.clear();
 	frame.timestamp = now;
 	frame.data.resize(frame_len);
 	for (size_t i = 0; i < frame_len; i++)
-		frame.data[i] = byte_distrib(random_generator);
+		frame.data[i] = rng.byte();
 
 	if (verbose)
 		cout << frame(Frame::PrintData | Frame::PrintColored);
@@ -3,6 +3,7 @@
 #include "suo.hpp"
 #include <fstream>
 #include <random>
+#include <functional>
 
 namespace suo {
 
@@ -11,6 +12,9 @@ struct Stats {
 
 	void clear();
 	double ber() const;
+	double fer() const;
+
+	Stats& operator+=(const Stats& other);
 
 	unsigned int frame_errors;
 	unsigned int total_frames;
@@ -20,14 +24,51 @@ struct Stats {
 
 std::ostream& operator<<(std::ostream& stream, const Stats& stats);;
 
+/*
+ * Unseeded helpers for the unit tests, drawing from rand().
+ * Not for EbN0 sweeps: use the batch's CounterRNG (rng.bit(), rng.byte()) there.
+ */
 inline Bit random_bit() { return (unsigned int)rand() & 1; }
 inline Byte random_byte() { return (unsigned int)rand() & 0xff; }
 
+
+/*
+ * Counter based random number generator for reproducible simulations.
+ * The n:th output of the stream is a hash of the key (seed + stream indices)
+ * and n, so every stream is independent of the others and of the order
+ * or the thread in which the streams are consumed.
+ */
+class CounterRNG {
+public:
+	explicit CounterRNG(uint64_t seed, uint64_t stream = 0, uint64_t substream = 0);
+
+	uint64_t next();
+
+	/* Uniformly distributed float in range [0, 1) */
+	float uniform();
+
+	/* Normally distributed float with zero mean and unit variance */
+	float normal();
+
+	Bit bit() { return next() & 1; }
+	Byte byte() { return next() & 0xff; }
+
+private:
+	uint64_t key;
+	uint64_t counter;
+	float spare;
+	bool has_spare;
+};
+
+
 void generate_noise(SampleVector& samples, float noise_std, unsigned int noise_samples);
+void generate_noise(SampleVector& samples, float noise_std, unsigned int noise_samples, CounterRNG& rng);
 void add_noise(SampleVector& samples, float noise_std);
+void add_noise(SampleVector& samples, float noise_std, CounterRNG& rng);
 void delay_signal(float delay, SampleVector& samples);
 
 void count_bit_errors(Stats& stats, const Frame& transmit_frame, const Frame& received_frame);
+void count_lost_frame(Stats& stats, const Frame& transmit_frame);
 
 
 class EbN0Log
@@ -40,12 +81,83 @@ private:
 };
 
 
+/*
+ * Monte-Carlo EbN0 sweep.
+ *
+ * The SNR points are simulated in batches of frames on a pool of threads.
+ * Every batch builds its own link and gets its own random stream keyed by
+ * (seed, SNR index, batch index). The batches of an SNR point are accumulated
+ * in order and the point is finished after the batch which reaches the target
+ * number of frame errors (or the maximum number of frames). Batches simulated
+ * past that are discarded, so the results depend only on the seed and not on
+ * the number of threads or their scheduling.
+ */
+class EbN0Sweep
+{
+public:
+	struct Config {
+		Config();
+
+		/* SNR range in dB */
+		float snr_min;
+		float snr_max;
+		unsigned int num_snr;
+
+		/* Seed for all random streams */
+		uint64_t seed;
+
+		/* Finish a SNR point after this many frame errors */
+		unsigned int target_frame_errors;
+
+		/* ... or after this many frames. Must be non-zero. */
+		unsigned int max_frames;
+
+		/* Number of frames simulated by one batch */
+		unsigned int batch_size;
+
+		/* Number of worker threads. 0 for one per hardware thread. */
+		unsigned int threads;
+
+		/* Print the results of each point when it is finished */
+		bool verbose;
+	};
+
+	/*
+	 * Simulate a batch of frames at given SNR.
+	 * Args:
+	 *   snr: SNR in dB
+	 *   frames: Number of frames to simulate
+	 *   rng: Random stream of the batch. All randomness must be drawn from here.
+	 *   stats: Statistics to be accumulated
+	 */
+	typedef std::function<void(float snr, unsigned int frames, CounterRNG& rng, Stats& stats)> BatchFunction;
+
+	explicit EbN0Sweep(const Config& conf = Config());
+
+	/* Run the sweep and return the statistics for each SNR point */
+	std::vector<Stats> run(const BatchFunction& batch);
+
+	/* Run the sweep and write the results to the log in SNR order */
+	void run(const BatchFunction& batch, EbN0Log& log);
+
+	float snr(unsigned int index) const;
+
+private:
+	Config conf;
+};
+
+
 
+/*
+ * Source of random frames drawn from a CounterRNG stream.
+ * Seeded with the current time unless set_seed() is called,
+ * so EbN0 sweeps must seed it from the batch's random stream.
+ */
 class RandomFrameGenerator {
 public:
 	explicit RandomFrameGenerator(unsigned int frame_len);
 	RandomFrameGenerator(unsigned int frame_min_len, unsigned int frame_max_len);
-	void set_seed(unsigned int seed);
+	void set_seed(uint64_t seed, uint64_t stream = 0);
 	void source_frame(Frame& frame, Timestamp _now);
 	void set_release_time(Timestamp time);
 	void set_verbose(bool v);
@@ -54,7 +166,7 @@ public:
 	const Frame& latest_frame() const { return frame; } 
 
 private:
-	std::mt19937 random_generator;
+	CounterRNG rng;
 	unsigned int frame_min_len, frame_max_len;
 	int frame_count;
 	Timestamp release_time;